@@ -0,0 +1,203 @@
+#include "bench_runner.h"
+#include "monotonic_clock.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::string jsonEscape(const std::string &s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+void printUsage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " [options]\n"
+              << "  --filter TEXT      run benchmarks whose name contains TEXT\n"
+              << "  --min-time S       seconds per repetition (default 0.2)\n"
+              << "  --repetitions N    repetitions per benchmark, median reported (default 5)\n"
+              << "  --json PATH        write the JSON report to PATH (default stdout)\n"
+              << "  --list             list benchmark names and exit\n";
+}
+
+} // namespace
+
+void BenchRunner::add(std::string name, std::string unit, Factory factory) {
+    m_entries.push_back({std::move(name), std::move(unit), std::move(factory)});
+}
+
+void BenchRunner::setContext(std::string key, std::string value) {
+    m_context.emplace_back(std::move(key), std::move(value));
+}
+
+bool BenchRunner::parseArgs(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--list") {
+            m_options.list = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc) {
+            printUsage(argv[0]);
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "--filter") {
+            m_options.filter = value;
+        } else if (arg == "--min-time") {
+            m_options.minTime = std::max(0.001, std::atof(value));
+        } else if (arg == "--repetitions") {
+            m_options.repetitions = std::max(1, std::atoi(value));
+        } else if (arg == "--json") {
+            m_options.jsonPath = value;
+        } else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+BenchRunner::Result BenchRunner::measure(const std::string &name, const std::string &unit,
+                                         const Body &body) const {
+    Result result;
+    result.name = name;
+    result.unit = unit;
+
+    // Calibrate (this also serves as the warm-up)
+    const uint64_t minNs = static_cast<uint64_t>(m_options.minTime * 1e9);
+    uint64_t iterations = 1;
+    for (;;) {
+        uint64_t start = monotonicNanos();
+        body(iterations);
+        uint64_t elapsed = monotonicNanos() - start;
+        if (elapsed >= minNs || iterations >= (uint64_t(1) << 40)) break;
+        // Jump close to the target once the timing is meaningful
+        if (elapsed > minNs / 100) {
+            iterations = std::max(iterations + 1, uint64_t(double(iterations) * 1.2 * minNs / elapsed));
+        } else {
+            iterations *= 10;
+        }
+    }
+    result.iterations = iterations;
+
+    std::vector<std::pair<double, Work>> runs;
+    for (int rep = 0; rep < m_options.repetitions; ++rep) {
+        uint64_t start = monotonicNanos();
+        Work work = body(iterations);
+        uint64_t elapsed = monotonicNanos() - start;
+        runs.emplace_back(double(elapsed) / double(iterations), std::move(work));
+        result.nsPerOp.push_back(runs.back().first);
+    }
+
+    std::vector<size_t> order(runs.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return runs[a].first < runs[b].first; });
+    const auto &median = runs[order[order.size() / 2]];
+    result.medianNsPerOp = median.first;
+    result.minNsPerOp = runs[order.front()].first;
+    result.work = median.second;
+
+    const double seconds = median.first * double(iterations) / 1e9;
+    if (seconds > 0.0) {
+        result.itemsPerSec = double(result.work.items) / seconds;
+        result.bytesPerSec = double(result.work.bytes) / seconds;
+    }
+    return result;
+}
+
+std::string BenchRunner::toJson(const std::vector<Result> &results) const {
+    char buf[512];
+    std::string out = "{\n  \"schema\": 1,\n";
+
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    std::snprintf(buf, sizeof(buf),
+                  "  \"context\": {\n    \"timestamp\": %lld,\n    \"host\": \"%s\",\n"
+                  "    \"cpus\": %u,\n    \"min_time_s\": %.3f,\n    \"repetitions\": %d",
+                  (long long)std::time(nullptr), jsonEscape(host).c_str(),
+                  std::thread::hardware_concurrency(), m_options.minTime, m_options.repetitions);
+    out += buf;
+    for (const auto &kv : m_context) {
+        out += ",\n    \"" + jsonEscape(kv.first) + "\": \"" + jsonEscape(kv.second) + "\"";
+    }
+    out += "\n  },\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        std::snprintf(buf, sizeof(buf),
+                      "%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"iterations\": %llu, "
+                      "\"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, "
+                      "\"items_per_sec\": %.1f, \"bytes_per_sec\": %.1f, \"runs_ns_per_op\": [",
+                      i ? "," : "", jsonEscape(r.name).c_str(), jsonEscape(r.unit).c_str(),
+                      (unsigned long long)r.iterations, r.medianNsPerOp, r.minNsPerOp,
+                      r.itemsPerSec, r.bytesPerSec);
+        out += buf;
+        for (size_t j = 0; j < r.nsPerOp.size(); ++j) {
+            std::snprintf(buf, sizeof(buf), "%s%.3f", j ? ", " : "", r.nsPerOp[j]);
+            out += buf;
+        }
+        out += "], \"counters\": {";
+        for (size_t j = 0; j < r.work.counters.size(); ++j) {
+            std::snprintf(buf, sizeof(buf), "%s\"%s\": %.15g", j ? ", " : "",
+                          jsonEscape(r.work.counters[j].first).c_str(), r.work.counters[j].second);
+            out += buf;
+        }
+        out += "}}";
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+int BenchRunner::run() {
+    if (m_options.list) {
+        for (const Entry &e : m_entries) std::cout << e.name << "\n";
+        return 0;
+    }
+
+    std::vector<Result> results;
+    std::fprintf(stderr, "%-32s %14s %16s %14s\n", "benchmark", "ns/op", "items/s", "MB/s");
+    for (const Entry &e : m_entries) {
+        if (!m_options.filter.empty() && e.name.find(m_options.filter) == std::string::npos) continue;
+        Body body = e.factory();
+        if (!body) {
+            std::fprintf(stderr, "%-32s skipped (setup failed)\n", e.name.c_str());
+            continue;
+        }
+        results.push_back(measure(e.name, e.unit, body));
+        const Result &r = results.back();
+        std::fprintf(stderr, "%-32s %14.1f %16.0f %14.2f\n", r.name.c_str(), r.medianNsPerOp,
+                     r.itemsPerSec, r.bytesPerSec / 1e6);
+    }
+
+    std::string json = toJson(results);
+    if (m_options.jsonPath == "-") {
+        std::cout << json;
+    } else {
+        std::ofstream file(m_options.jsonPath);
+        if (!(file << json)) {
+            std::cerr << "Cannot write " << m_options.jsonPath << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
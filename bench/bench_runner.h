@@ -0,0 +1,75 @@
+#ifndef BENCH_RUNNER_H
+#define BENCH_RUNNER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal self-calibrating benchmark runner. Each benchmark is registered as
+// a factory so its setup only runs when it is selected; the factory returns
+// the timed body, which performs `iterations` operations and reports what it
+// processed. Iterations double until one run takes --min-time, then the run
+// is repeated and the median is reported, so a noisy repetition does not
+// move the result.
+class BenchRunner {
+public:
+    struct Work {
+        uint64_t items = 0;   // frames, updates, paints... per the benchmark's unit
+        uint64_t bytes = 0;   // input bytes, when throughput in bytes is meaningful
+        std::vector<std::pair<std::string, double>> counters; // extra per-run facts
+    };
+
+    using Body = std::function<Work(uint64_t iterations)>;
+    using Factory = std::function<Body()>;
+
+    struct Options {
+        std::string filter;        // substring of the benchmark name
+        double minTime = 0.2;      // seconds per repetition
+        int repetitions = 5;
+        std::string jsonPath = "-"; // "-" = stdout
+        bool list = false;
+    };
+
+    struct Result {
+        std::string name;
+        std::string unit;
+        uint64_t iterations = 0;
+        std::vector<double> nsPerOp;  // one per repetition
+        double medianNsPerOp = 0.0;
+        double minNsPerOp = 0.0;
+        double itemsPerSec = 0.0;
+        double bytesPerSec = 0.0;
+        Work work;                    // from the median repetition
+    };
+
+    void add(std::string name, std::string unit, Factory factory);
+
+    // Extra key/value pairs for the report's "context" object
+    void setContext(std::string key, std::string value);
+
+    // Parses --filter, --min-time, --repetitions, --json, --list.
+    // Returns false (after printing usage) on a bad argument.
+    bool parseArgs(int argc, char **argv);
+
+    // Runs the selected benchmarks, prints a table to stderr and the JSON
+    // report to the --json destination. Returns the process exit code.
+    int run();
+
+private:
+    Result measure(const std::string &name, const std::string &unit, const Body &body) const;
+    std::string toJson(const std::vector<Result> &results) const;
+
+    struct Entry {
+        std::string name;
+        std::string unit;
+        Factory factory;
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<std::pair<std::string, std::string>> m_context;
+    Options m_options;
+};
+
+#endif // BENCH_RUNNER_H
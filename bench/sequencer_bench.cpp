@@ -0,0 +1,410 @@
+// Benchmarks for the ingest and display pipeline.
+// Usage: sequencer_bench [--filter parser] [--json results.json]
+//
+// Everything runs on synthetic, seeded input and the offscreen Qt platform,
+// so results are comparable between machines and releases without hardware
+// or a display.
+
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "bench_runner.h"
+#include "beat_grid_widget.h"
+#include "capture_file.h"
+#include "ingest_thread.h"
+#include "monotonic_clock.h"
+#include "pitch_graph_widget.h"
+#include "replay_source.h"
+#include "sequencer_model.h"
+#include "uart_parser.h"
+
+namespace {
+
+constexpr int NUM_BEATS = 16;
+constexpr uint32_t SEED = 0x5e9;
+
+void appendFrame(std::vector<uint8_t> &out, uint8_t type, const uint8_t *payload, size_t len) {
+    size_t start = out.size();
+    out.resize(start + len + 4);
+    out.resize(start + UARTParser::encodeFrame(type, payload, len, out.data() + start));
+}
+
+// Roughly `bytes` of well-formed traffic in `format`: mostly edits, with the
+// playhead advancing and a SYNC (or snapshot) once per period
+std::vector<uint8_t> syntheticStream(UARTParser::Format format, size_t bytes) {
+    std::mt19937 rng(SEED);
+    std::uniform_int_distribution<int> beatDist(0, NUM_BEATS - 1);
+    std::uniform_int_distribution<int> pitchDist(0, SequencerModel::MAX_PITCH);
+    std::vector<uint8_t> out;
+    out.reserve(bytes + 64);
+    uint8_t pattern[NUM_BEATS] = {};
+    int position = 0;
+
+    for (uint64_t n = 0; out.size() < bytes; ++n) {
+        bool tick = n % 4 == 3;
+        int beat = beatDist(rng);
+        int pitch = pitchDist(rng);
+        switch (format) {
+        case UARTParser::Format::Text: {
+            char line[32];
+            int len = tick ? std::snprintf(line, sizeof(line), "BEAT %d %d\n", position, pattern[position])
+                           : (n & 1) ? std::snprintf(line, sizeof(line), "BEAT %d %d\n", beat, pitch)
+                                     : std::snprintf(line, sizeof(line), "%d%d%d%d%d%d%d\n",
+                                                     (beat >> 3) & 1, (beat >> 2) & 1, (beat >> 1) & 1,
+                                                     beat & 1, (pitch >> 2) & 1, (pitch >> 1) & 1, pitch & 1);
+            out.insert(out.end(), line, line + len);
+            if (tick && position == NUM_BEATS - 1) out.push_back(0xFF);
+            break;
+        }
+        case UARTParser::Format::Raw:
+            if (tick && position == NUM_BEATS - 1) {
+                out.push_back(0xFF);
+            } else {
+                out.push_back(uint8_t((pitch << 4) | beat));
+            }
+            break;
+        case UARTParser::Format::Framed:
+            if (tick) {
+                uint8_t payload[2 + NUM_BEATS / 2] = {uint8_t((position + 1) % NUM_BEATS), NUM_BEATS};
+                if (payload[0] == 0) {
+                    for (int i = 0; i < NUM_BEATS; i += 2) {
+                        payload[2 + i / 2] = uint8_t((pattern[i + 1] << 4) | pattern[i]);
+                    }
+                    appendFrame(out, UARTParser::FRAME_SNAPSHOT, payload, sizeof(payload));
+                } else {
+                    appendFrame(out, UARTParser::FRAME_TICK, payload, 2);
+                }
+            } else {
+                uint8_t payload[2] = {uint8_t(beat), uint8_t(pitch)};
+                appendFrame(out, UARTParser::FRAME_EDIT, payload, 2);
+            }
+            break;
+        }
+        if (tick) {
+            position = (position + 1) % NUM_BEATS;
+        } else {
+            pattern[beat] = uint8_t(pitch);
+        }
+    }
+    return out;
+}
+
+// Decode throughput, fed in serial-read-sized pieces into a live model
+BenchRunner::Factory parserBench(UARTParser::Format format) {
+    return [format]() -> BenchRunner::Body {
+        auto stream = std::make_shared<std::vector<uint8_t>>(syntheticStream(format, 1 << 20));
+        return [stream, format](uint64_t iterations) {
+            SequencerModel model(NUM_BEATS);
+            UARTParser parser(&model, format);
+            constexpr size_t READ_SIZE = 4096;
+            for (uint64_t it = 0; it < iterations; ++it) {
+                for (size_t off = 0; off < stream->size(); off += READ_SIZE) {
+                    parser.feed(stream->data() + off, std::min(READ_SIZE, stream->size() - off));
+                }
+            }
+            const auto &c = parser.counters();
+            BenchRunner::Work work;
+            work.items = c.frames;
+            work.bytes = c.bytes;
+            work.counters = {{"syncs", double(c.syncs)},
+                             {"errors", double(c.malformed + c.outOfRange + c.crcErrors)}};
+            return work;
+        };
+    };
+}
+
+// Pre-drawn random edits so the RNG stays out of the timed loop
+struct EditTable {
+    static constexpr size_t SIZE = 4096;
+    std::vector<std::pair<int, int>> edits;
+    EditTable() : edits(SIZE) {
+        std::mt19937 rng(SEED);
+        for (auto &e : edits) e = {int(rng() % NUM_BEATS), int(rng() % (SequencerModel::MAX_PITCH + 1))};
+    }
+    const std::pair<int, int> &operator[](uint64_t i) const { return edits[i % SIZE]; }
+};
+
+BenchRunner::Body modelSetPitchBench() {
+    auto table = std::make_shared<EditTable>();
+    return [table](uint64_t iterations) {
+        SequencerModel model(NUM_BEATS);
+        uint64_t commits = 0, beatCallbacks = 0;
+        model.onPitchesChanged = [&](const SequencerModel::PitchChange &) { ++commits; };
+        model.onBeatPitchChanged = [&](int, int) { ++beatCallbacks; };
+        for (uint64_t i = 0; i < iterations; ++i) {
+            model.setBeatPitch((*table)[i].first, (*table)[i].second);
+        }
+        BenchRunner::Work work;
+        work.items = iterations;
+        work.counters = {{"commits", double(commits)}, {"beat_callbacks", double(beatCallbacks)}};
+        return work;
+    };
+}
+
+// One snapshot's worth of edits plus a playhead move per transaction
+BenchRunner::Body modelBatchBench() {
+    auto table = std::make_shared<EditTable>();
+    return [table](uint64_t iterations) {
+        SequencerModel model(NUM_BEATS);
+        uint64_t commits = 0, beatCallbacks = 0, moves = 0;
+        model.onPitchesChanged = [&](const SequencerModel::PitchChange &) { ++commits; };
+        model.onBeatPitchChanged = [&](int, int) { ++beatCallbacks; };
+        model.onBeatChanged = [&](int) { ++moves; };
+        uint64_t edit = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            SequencerModel::Batch batch(model);
+            for (int b = 0; b < NUM_BEATS; ++b, ++edit) model.setBeatPitch(b, table->edits[edit % EditTable::SIZE].second);
+            model.setCurrentBeat(int(i % NUM_BEATS));
+        }
+        BenchRunner::Work work;
+        work.items = iterations;
+        work.counters = {{"commits", double(commits)}, {"beat_callbacks", double(beatCallbacks)},
+                         {"beat_moves", double(moves)}};
+        return work;
+    };
+}
+
+// Whole-state compare of two 256-beat sequences a few edits apart, as a
+// snapshot consumer does to find what to repaint
+BenchRunner::Body modelDiffBench() {
+    auto table = std::make_shared<EditTable>();
+    return [table](uint64_t iterations) {
+        SequencerModel::Pitches a, b;
+        std::mt19937 rng(SEED);
+        for (int i = 0; i < SequencerModel::MAX_BEATS; ++i) a.setPitch(i, int(rng() % (SequencerModel::MAX_PITCH + 1)));
+        b = a;
+        uint64_t changed = 0, active = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            const auto &edit = (*table)[i];
+            b.setPitch(edit.first * (SequencerModel::MAX_BEATS / NUM_BEATS), edit.second);
+            changed += b.diff(a).count();
+            active += uint64_t(b.activeCount());
+        }
+        BenchRunner::Work work;
+        work.items = iterations;
+        work.bytes = iterations * 2 * sizeof(SequencerModel::Pitches);
+        work.counters = {{"changed_beats", double(changed)}, {"active_beats", double(active)}};
+        return work;
+    };
+}
+
+BenchRunner::Body modelTickBench() {
+    return [](uint64_t iterations) {
+        SequencerModel model(NUM_BEATS);
+        uint64_t moves = 0;
+        model.onBeatChanged = [&](int) { ++moves; };
+        for (uint64_t i = 0; i < iterations; ++i) model.setCurrentBeat(int(i % NUM_BEATS));
+        BenchRunner::Work work;
+        work.items = iterations;
+        work.counters = {{"beat_moves", double(moves)}};
+        return work;
+    };
+}
+
+constexpr int GRAPH_WIDTH = 1200;
+constexpr int GRAPH_HEIGHT = 240;
+
+// Live view: append one sample and paint the frame, as the GUI does per event
+BenchRunner::Body pitchGraphLiveBench() {
+    auto canvas = std::make_shared<PitchGraphCanvas>();
+    auto image = std::make_shared<QImage>(GRAPH_WIDTH, GRAPH_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+    canvas->resize(GRAPH_WIDTH, GRAPH_HEIGHT);
+    auto table = std::make_shared<EditTable>();
+    for (uint64_t i = 0; i < 10000; ++i) canvas->addPitchSample((*table)[i].second, int(i % NUM_BEATS));
+    canvas->render(image.get());
+    return [canvas, image, table](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            canvas->addPitchSample((*table)[i].second, int(i % NUM_BEATS));
+            canvas->render(image.get());
+        }
+        BenchRunner::Work work;
+        work.items = iterations;
+        work.counters = {{"samples", double(canvas->sampleCount())}};
+        return work;
+    };
+}
+
+// History view: the whole of a one-million-sample session on screen
+BenchRunner::Body pitchGraphHistoryBench() {
+    auto canvas = std::make_shared<PitchGraphCanvas>();
+    auto image = std::make_shared<QImage>(GRAPH_WIDTH, GRAPH_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+    canvas->resize(GRAPH_WIDTH, GRAPH_HEIGHT);
+    auto table = std::make_shared<EditTable>();
+    for (uint64_t i = 0; i < 1000000; ++i) canvas->addPitchSample((*table)[i].second, int(i % NUM_BEATS));
+    canvas->setViewEnd(double(canvas->sampleCount()) - 1.0);  // stop following the tail
+    canvas->zoom(1e9, GRAPH_WIDTH);                           // clamps to the whole session
+    return [canvas, image](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) canvas->render(image.get());
+        BenchRunner::Work work;
+        work.items = iterations;
+        work.counters = {{"samples", double(canvas->sampleCount())},
+                         {"samples_per_pixel", canvas->samplesPerPixel()}};
+        return work;
+    };
+}
+
+// A model edit and playhead move followed by a full repaint of the grid
+BenchRunner::Body beatGridBench() {
+    struct State {
+        SequencerModel model{NUM_BEATS};
+        BeatGridWidget grid{&model};
+        QImage image;
+        EditTable table;
+    };
+    auto state = std::make_shared<State>();
+    state->grid.resize(state->grid.sizeHint());
+    state->image = QImage(state->grid.size(), QImage::Format_ARGB32_Premultiplied);
+    state->model.onPitchesChanged = [s = state.get()](const SequencerModel::PitchChange &change) {
+        s->grid.beatsChanged(change.dirty);
+    };
+    state->model.onBeatChanged = [s = state.get()](int beat) { s->grid.setCurrentBeat(beat); };
+    return [state](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            {
+                SequencerModel::Batch batch(state->model);
+                state->model.setBeatPitch(state->table[i].first, state->table[i].second);
+                state->model.setCurrentBeat(int(i % NUM_BEATS));
+            }
+            state->grid.render(&state->image);
+        }
+        BenchRunner::Work work;
+        work.items = iterations;
+        work.counters = {{"width", double(state->image.width())}, {"height", double(state->image.height())}};
+        return work;
+    };
+}
+
+std::string tempCapturePath() {
+    const char *dir = std::getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/sequencer_bench_" + std::to_string(getpid()) + ".seqcap";
+}
+
+// A capture of the framed synthetic stream in read-sized records, 10 us apart
+bool writeSyntheticCapture(const std::string &path, size_t bytes) {
+    std::vector<uint8_t> stream = syntheticStream(UARTParser::Format::Framed, bytes);
+    CaptureWriter writer;
+    if (!writer.open(path, UARTParser::Format::Framed)) return false;
+    constexpr size_t RECORD = 64;
+    uint64_t ts = monotonicNanos();
+    for (size_t off = 0; off < stream.size(); off += RECORD, ts += 10000) {
+        writer.append(ts, stream.data() + off, std::min(RECORD, stream.size() - off));
+    }
+    writer.close();
+    return !writer.failed();
+}
+
+// mmap reader -> parser -> model on one thread: the decode cost of a replay
+BenchRunner::Body captureDecodeBench() {
+    std::string path = tempCapturePath();
+    if (!writeSyntheticCapture(path, 4 << 20)) return nullptr;
+    auto reader = std::make_shared<CaptureReader>();
+    bool opened = reader->open(path);
+    unlink(path.c_str());  // the mapping keeps it alive
+    if (!opened) return nullptr;
+    return [reader](uint64_t iterations) {
+        SequencerModel model(NUM_BEATS);
+        UARTParser parser(&model, reader->format());
+        uint64_t records = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            reader->rewind();
+            CaptureReader::Record record;
+            while (reader->next(record)) {
+                parser.setSourceTimestamp(record.timestampNs);
+                parser.feed(record.data, record.size);
+                ++records;
+            }
+        }
+        BenchRunner::Work work;
+        work.items = parser.counters().frames;
+        work.bytes = parser.counters().bytes;
+        work.counters = {{"records", double(records)}};
+        return work;
+    };
+}
+
+// The full live path at replay speed 0: feeder thread -> socket -> I/O
+// thread (ring buffer, parser, SPSC queue) -> this thread draining into the
+// model, as the GUI does per frame
+BenchRunner::Body replayIngestBench() {
+    auto path = std::make_shared<std::string>(tempCapturePath());
+    if (!writeSyntheticCapture(*path, 4 << 20)) return nullptr;
+    // The file is removed when the last copy of the body goes away
+    std::shared_ptr<void> cleanup(nullptr, [path](void *) { unlink(path->c_str()); });
+    return [path, cleanup](uint64_t iterations) {
+        BenchRunner::Work work;
+        uint64_t dropped = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            ReplaySource replay;
+            if (!replay.open(*path)) break;
+            int fd = replay.start(0);
+            if (fd < 0) break;
+            IngestThread ingest(fd, replay.format(), true);
+            if (!ingest.start()) break;
+
+            SequencerModel model(NUM_BEATS);
+            IngestEvent event;
+            for (;;) {
+                bool done = ingest.finished();
+                SequencerModel::Batch batch(model);
+                while (ingest.tryPop(event)) {
+                    ++work.items;
+                    if (event.kind == IngestEvent::Kind::Pitch) {
+                        model.setBeatPitch(event.beat, event.pitch);
+                    } else if (event.kind == IngestEvent::Kind::CurrentBeat) {
+                        model.setCurrentBeat(event.beat);
+                    }
+                }
+                if (done) break;
+                std::this_thread::yield();
+            }
+            ingest.stop();
+            replay.stop();
+            work.bytes += ingest.bytesRead();
+            dropped += ingest.droppedEvents();
+        }
+        work.counters = {{"dropped_events", double(dropped)}};
+        return work;
+    };
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    // Render without a display unless the caller picked a platform
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    BenchRunner runner;
+    if (!runner.parseArgs(argc, argv)) return 1;
+    runner.setContext("qt_version", qVersion());
+    runner.setContext("qpa_platform", QApplication::platformName().toStdString());
+#ifdef __VERSION__
+    runner.setContext("compiler", __VERSION__);
+#endif
+#ifdef SEQ_BENCH_BUILD_TYPE
+    runner.setContext("build_type", SEQ_BENCH_BUILD_TYPE);
+#endif
+
+    runner.add("parser.text", "frames", parserBench(UARTParser::Format::Text));
+    runner.add("parser.raw", "frames", parserBench(UARTParser::Format::Raw));
+    runner.add("parser.framed", "frames", parserBench(UARTParser::Format::Framed));
+    runner.add("model.set_pitch", "updates", modelSetPitchBench);
+    runner.add("model.batch16", "transactions", modelBatchBench);
+    runner.add("model.current_beat", "moves", modelTickBench);
+    runner.add("model.diff256", "diffs", modelDiffBench);
+    runner.add("render.pitch_graph_live", "paints", pitchGraphLiveBench);
+    runner.add("render.pitch_graph_history", "paints", pitchGraphHistoryBench);
+    runner.add("render.beat_grid", "paints", beatGridBench);
+    runner.add("e2e.capture_decode", "frames", captureDecodeBench);
+    runner.add("e2e.replay_ingest", "events", replayIngestBench);
+    return runner.run();
+}
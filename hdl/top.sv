@@ -4,8 +4,15 @@
 `include "rotary_encoder.sv"
 `include "seven_segment.sv"
 `include "uart_tx.sv"
+`include "uart_framer.sv"
 
-module top(
+module top #(
+    // 1-3 Mbaud are exact divisors of the 12 MHz clock; match the GUI setting
+    parameter BAUD_RATE = 1_000_000,
+    // The board's oscillator. Simulation may lower it (with BAUD_RATE) to
+    // cover many periods quickly; beat and UART timing scale with it.
+    parameter CLK_FREQ = 12_000_000
+)(
     input logic clk,
     input logic _39a, 
     input logic _38b, 
@@ -37,7 +44,6 @@ module top(
     localparam PERIOD = 4;
     localparam NUM_BEATS = 16;
     localparam BEATS_BUFFER = $clog2(NUM_BEATS);
-    localparam CLK_FREQ = 12_000_000; // 12 MHz
     // Instantiate model
     logic [7:0] data_in;
     logic [NUM_BEATS*4-1:0] beats; // 64 bit register: 16 beats x 4 bits each (pitch)
@@ -83,7 +89,7 @@ module top(
         .clk(clk),
         .beats(beats),
         .beat_count(beat_count),
-        .pwm_out(_48b),
+        .pwm_out(_48b)
     );
 
     seven_segment u_seven_segment (
@@ -106,22 +112,41 @@ module top(
     end
     // UART signals
     logic button_pressed_prev = 0;
-    logic tx_valid = 0;
+    logic tx_valid;
     logic uart_sig;
     logic uart_ready;
-    logic [7:0] uart_data;  // Separate register for UART transmission
+    logic [7:0] uart_data;
     
-    // Sync signal: send 0xFF when beat wraps to 0 (end of period)
+    // Beat position changes: a snapshot at the wrap (end of period), a tick otherwise
     logic [BEATS_BUFFER-1:0] beat_count_prev = 0;
-    logic send_sync = 0;
+    logic edit_req = 0;
+    logic tick_req = 0;
+    logic snapshot_req = 0;
+
+    uart_framer #(
+        .NUM_BEATS(NUM_BEATS)
+    ) u_uart_framer (
+        .clk(clk),
+        .rstn(uart_rstn),
+        .edit_req(edit_req),
+        .edit_beat(8'(button_index)),
+        .edit_pitch(rotary_position),
+        .tick_req(tick_req),
+        .snapshot_req(snapshot_req),
+        .beat_count(8'(beat_count)),
+        .beats(beats),
+        .tx_data(uart_data),
+        .tx_valid(tx_valid),
+        .tx_ready(uart_ready)
+    );
 
     uart_tx #(
         .DATA_WIDTH(8),
-        .BAUD_RATE(9600),
+        .BAUD_RATE(BAUD_RATE),
         .CLK_FREQ(CLK_FREQ)
     ) uart_tx_inst (
         .sig(uart_sig),
-        .data(uart_data),  // Use uart_data instead of data_in
+        .data(uart_data),
         .valid(tx_valid),
         .ready(uart_ready),
         .clk(clk),
@@ -134,31 +159,18 @@ module top(
         button_pressed_prev <= button_pressed;
         beat_count_prev <= beat_count;
         
-        // Detect when beat wraps from 15 to 0 (end of period)
-        if (beat_count == 0 && beat_count_prev == NUM_BEATS - 1) begin
-            send_sync <= 1;
-        end else begin
-            send_sync <= 0;
-        end
-        
-        // Priority: sync message, then button data
-        if (send_sync && uart_ready) begin
-            uart_data <= 8'hFF;  // Sync marker: all 1s
-            tx_valid <= 1;
-        end else if (button_pressed) begin
-            // Update sequencer model only on button press
+        // Update sequencer model only on button press
+        if (button_pressed) begin
             data_in <= {rotary_position, button_index};
-            
-            // Send UART only on rising edge
-            if (!button_pressed_prev && uart_ready) begin
-                uart_data <= {rotary_position, button_index};
-                tx_valid <= 1;
-            end else begin
-                tx_valid <= 0;
-            end
-        end else begin
-            tx_valid <= 0;
         end
+
+        // One edit frame per press (rising edge)
+        edit_req <= button_pressed && !button_pressed_prev;
+
+        // The wrap from NUM_BEATS-1 to 0 sends the whole register, so a GUI
+        // that connects late has full state within one period
+        snapshot_req <= (beat_count != beat_count_prev) && (beat_count == 0);
+        tick_req <= (beat_count != beat_count_prev) && (beat_count != 0);
     end
     
     always_ff @(posedge clk) begin
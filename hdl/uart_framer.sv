@@ -0,0 +1,163 @@
+/*
+ Framed UART protocol
+
+ Frame: 0xA5 | type | length | payload[length] | crc8
+   crc8 is CRC-8/ATM (polynomial 0x07, init 0x00) over type, length and
+   payload. The sync byte may also occur inside a frame; receivers confirm
+   a frame by its length and CRC and resynchronise on the next 0xA5.
+
+ Types:
+   0x01 EDIT      beat, pitch                          (button press)
+   0x02 SNAPSHOT  beat_count, NUM_BEATS, beats[7:0], beats[15:8], ...
+                  (whole beats register, little-endian, once per period)
+   0x03 TICK      beat_count, NUM_BEATS                (every other beat change)
+
+ Requests are latched, so one that arrives while a frame is on the wire is
+ sent next. Repeated requests of the same type coalesce to the latest value;
+ the next snapshot repairs anything an overwritten edit missed.
+*/
+
+module uart_framer #(
+    parameter NUM_BEATS = 16
+)(
+    input logic clk,
+    input logic rstn,
+    input logic edit_req,                    // single-cycle request pulses
+    input logic [7:0] edit_beat,
+    input logic [3:0] edit_pitch,
+    input logic tick_req,
+    input logic snapshot_req,
+    input logic [7:0] beat_count,
+    input logic [NUM_BEATS*4-1:0] beats,
+    output logic [7:0] tx_data,              // to uart_tx
+    output logic tx_valid,
+    input logic tx_ready
+);
+    localparam SYNC_BYTE = 8'hA5;
+    localparam TYPE_EDIT = 8'h01;
+    localparam TYPE_SNAPSHOT = 8'h02;
+    localparam TYPE_TICK = 8'h03;
+    localparam REG_BYTES = (NUM_BEATS * 4 + 7) / 8;
+    localparam MAX_FRAME = 3 + 2 + REG_BYTES + 1;   // header, payload, crc
+
+    function automatic logic [7:0] crc8(input logic [7:0] crc, input logic [7:0] data);
+        logic [7:0] c;
+        c = crc ^ data;
+        for (int i = 0; i < 8; i++) begin
+            c = c[7] ? ((c << 1) ^ 8'h07) : (c << 1);
+        end
+        return c;
+    endfunction
+
+    typedef enum logic [1:0] {S_IDLE,    // pick the next pending frame
+                              S_ISSUE,   // hand one byte to uart_tx
+                              S_ACCEPT,  // wait for uart_tx to take it
+                              S_DONE     // wait for uart_tx to finish it
+                              } statetype;
+
+    statetype state = S_IDLE;
+    logic [7:0] frame [0:MAX_FRAME-1];
+    logic [$clog2(MAX_FRAME+1)-1:0] frame_len = 0;
+    logic [$clog2(MAX_FRAME+1)-1:0] index = 0;
+    logic [7:0] crc = 0;
+
+    logic edit_pending = 0;
+    logic tick_pending = 0;
+    logic snapshot_pending = 0;
+    logic [7:0] edit_beat_r = 0;
+    logic [3:0] edit_pitch_r = 0;
+
+    initial begin
+        tx_data = 0;
+        tx_valid = 0;
+    end
+
+    always_ff @(posedge clk) begin
+        if (!rstn) begin
+            state <= S_IDLE;
+            tx_valid <= 0;
+            edit_pending <= 0;
+            tick_pending <= 0;
+            snapshot_pending <= 0;
+        end else begin
+            case (state)
+                S_IDLE: begin
+                    frame[0] <= SYNC_BYTE;
+                    index <= 0;
+                    crc <= 0;
+                    if (edit_pending) begin
+                        frame[1] <= TYPE_EDIT;
+                        frame[2] <= 8'd2;
+                        frame[3] <= edit_beat_r;
+                        frame[4] <= {4'b0, edit_pitch_r};
+                        frame_len <= 6;
+                        edit_pending <= 0;
+                        state <= S_ISSUE;
+                    end else if (snapshot_pending) begin
+                        // Carries the position too, so it replaces a tick
+                        frame[1] <= TYPE_SNAPSHOT;
+                        frame[2] <= 8'(2 + REG_BYTES);
+                        frame[3] <= beat_count;
+                        frame[4] <= 8'(NUM_BEATS);
+                        for (int i = 0; i < REG_BYTES; i++) begin
+                            frame[5 + i] <= 8'(beats >> (i * 8));
+                        end
+                        frame_len <= MAX_FRAME;
+                        snapshot_pending <= 0;
+                        tick_pending <= 0;
+                        state <= S_ISSUE;
+                    end else if (tick_pending) begin
+                        frame[1] <= TYPE_TICK;
+                        frame[2] <= 8'd2;
+                        frame[3] <= beat_count;
+                        frame[4] <= 8'(NUM_BEATS);
+                        frame_len <= 6;
+                        tick_pending <= 0;
+                        state <= S_ISSUE;
+                    end
+                end
+
+                S_ISSUE: begin
+                    if (tx_ready) begin
+                        // Last byte is the CRC of everything after the sync byte
+                        if (index == frame_len - 1) begin
+                            tx_data <= crc;
+                        end else begin
+                            tx_data <= frame[index];
+                            if (index != 0) crc <= crc8(crc, frame[index]);
+                        end
+                        tx_valid <= 1;
+                        state <= S_ACCEPT;
+                    end
+                end
+
+                S_ACCEPT: begin
+                    tx_valid <= 0;
+                    if (!tx_ready) state <= S_DONE;
+                end
+
+                S_DONE: begin
+                    if (tx_ready) begin
+                        if (index == frame_len - 1) begin
+                            state <= S_IDLE;
+                        end else begin
+                            index <= index + 1;
+                            state <= S_ISSUE;
+                        end
+                    end
+                end
+
+                default: state <= S_IDLE;
+            endcase
+
+            // Latch new requests last so they win over the clears above
+            if (edit_req) begin
+                edit_pending <= 1;
+                edit_beat_r <= edit_beat;
+                edit_pitch_r <= edit_pitch;
+            end
+            if (tick_req) tick_pending <= 1;
+            if (snapshot_req) snapshot_pending <= 1;
+        end
+    end
+endmodule
@@ -11,7 +11,9 @@ module uart_tx
 
     localparam
     LB_DATA_WIDTH    = $clog2(DATA_WIDTH),
-    PULSE_WIDTH      = CLK_FREQ / BAUD_RATE,
+    // Clocks per bit, rounded to nearest. At 12 MHz: 1250 @ 9600,
+    // 12 @ 1 Mbaud, 6 @ 2 Mbaud, 4 @ 3 Mbaud (all exact).
+    PULSE_WIDTH      = (CLK_FREQ + BAUD_RATE / 2) / BAUD_RATE,
     LB_PULSE_WIDTH   = $clog2(PULSE_WIDTH),
     HALF_PULSE_WIDTH = PULSE_WIDTH / 2)
    (
@@ -70,7 +72,7 @@ module uart_tx
               end
               else begin
                  sig_r   <= data_r[data_cnt];
-                 clk_cnt <= PULSE_WIDTH;
+                 clk_cnt <= PULSE_WIDTH - 1;
 
                  if(data_cnt == DATA_WIDTH - 1) begin
                     state <= STT_STOP;
@@ -92,7 +94,7 @@ module uart_tx
               else begin
                  state   <= STT_WAIT;
                  sig_r   <= 1;
-                 clk_cnt <= PULSE_WIDTH + HALF_PULSE_WIDTH;
+                 clk_cnt <= PULSE_WIDTH + HALF_PULSE_WIDTH - 1;
               end
            end
 
@@ -113,7 +115,7 @@ module uart_tx
                  data_r   <= data;
                  ready_r  <= 0;
                  data_cnt <= 0;
-                 clk_cnt  <= PULSE_WIDTH;
+                 clk_cnt  <= PULSE_WIDTH - 1;
               end
            end
 
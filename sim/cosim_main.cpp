@@ -0,0 +1,375 @@
+// Co-simulation of hdl/top.sv: the Verilated design runs against scripted
+// key presses and encoder turns, and the bytes recovered from its UART pin go
+// to a pseudo-terminal the GUI opens like the board's serial port, to a file,
+// and/or through the parser to be checked against the design's own register.
+//
+//   top_cosim --pty                               live, paced to the wall clock
+//   top_cosim_scaled --check --periods 2000 --edits 4   regression, flat out
+//   top_cosim --out run.bin edits.cosim           script, raw bytes to a file
+//   top_cosim_scaled --trace run.trace --periods 50 --edits 8   then: timing_check run.trace
+//
+// Script lines (after '#' is a comment):
+//   wait SECONDS | beats N | periods N
+//   turn PITCH | press BUTTON | set BEAT PITCH | random N
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "monotonic_clock.h"
+#include "pty_device.h"
+#include "sequencer_model.h"
+#include "timing_checker.h"
+#include "top_harness.h"
+#include "uart_parser.h"
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void onStopSignal(int) { g_stop = 1; }
+
+struct CosimOptions {
+    bool pty = false;
+    bool realTime = false;
+    bool check = false;
+    std::string outPath;
+    std::string tracePath;
+    std::string scriptPath;
+    long periods = -1;  // after the script; -1: until interrupted, or none with a script
+    int edits = 0;      // random edits per period
+    uint64_t seed = 1;
+};
+
+void printUsage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " [options] [SCRIPT]\n"
+              << "  --pty            create a pseudo-terminal for the GUI (implies --realtime)\n"
+              << "  --out FILE       write the decoded UART bytes to FILE\n"
+              << "  --trace FILE     write every change of beats, beat_count and the audio and TX\n"
+              << "                   pins to FILE, for timing_check\n"
+              << "  --realtime       pace the simulation to the wall clock\n"
+              << "  --check          decode the bytes and compare every snapshot with the register\n"
+              << "  --periods N      beat periods to run after the script\n"
+              << "  --edits N        random edits per period while they run (default 0)\n"
+              << "  --seed N         seed for random edits (default 1)\n"
+              << "\nThis model runs at " << TopHarness::CLK_HZ << " Hz, " << TopHarness::BAUD_RATE
+              << " baud. Script lines: wait SECONDS, beats N, periods N, turn PITCH,\n"
+              << "press BUTTON, set BEAT PITCH, random N.\n";
+}
+
+bool parseOptions(int argc, char **argv, CosimOptions &opts) {
+    enum { OPT_PTY = 1000, OPT_OUT, OPT_TRACE, OPT_REALTIME, OPT_CHECK, OPT_PERIODS, OPT_EDITS, OPT_SEED, OPT_HELP };
+    static const option longOptions[] = {
+        {"pty", no_argument, nullptr, OPT_PTY},
+        {"out", required_argument, nullptr, OPT_OUT},
+        {"trace", required_argument, nullptr, OPT_TRACE},
+        {"realtime", no_argument, nullptr, OPT_REALTIME},
+        {"check", no_argument, nullptr, OPT_CHECK},
+        {"periods", required_argument, nullptr, OPT_PERIODS},
+        {"edits", required_argument, nullptr, OPT_EDITS},
+        {"seed", required_argument, nullptr, OPT_SEED},
+        {"help", no_argument, nullptr, OPT_HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case OPT_PTY: opts.pty = opts.realTime = true; break;
+        case OPT_OUT: opts.outPath = optarg; break;
+        case OPT_TRACE: opts.tracePath = optarg; break;
+        case OPT_REALTIME: opts.realTime = true; break;
+        case OPT_CHECK: opts.check = true; break;
+        case OPT_PERIODS: opts.periods = std::max(0L, std::atol(optarg)); break;
+        case OPT_EDITS: opts.edits = std::clamp(std::atoi(optarg), 0, 1000); break;
+        case OPT_SEED: opts.seed = std::strtoull(optarg, nullptr, 0); break;
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (optind < argc) opts.scriptPath = argv[optind++];
+    if (optind < argc) {
+        printUsage(argv[0]);
+        return false;
+    }
+    if (opts.periods < 0 && !opts.scriptPath.empty()) opts.periods = 0;
+    return true;
+}
+
+// Drives the harness and carries its bytes to the outputs
+class Cosim {
+public:
+    explicit Cosim(const CosimOptions &opts)
+        : m_opts(opts), m_rng(opts.seed), m_trace(nullptr), m_ptyFd(-1), m_model(TopHarness::NUM_BEATS),
+          m_parser(&m_model, UARTParser::Format::Framed), m_startNs(0), m_written(0), m_dropped(0),
+          m_checked(0), m_mismatches(0), m_unmatched(0) {
+        m_harness.onByte = [this](uint8_t byte, uint64_t) {
+            m_pending.push_back(byte);
+            if (m_opts.check) m_parser.feed(&byte, 1);
+        };
+        if (m_opts.check) {
+            m_harness.onWrap = [this](uint64_t beats) { m_wraps.push_back({beats}); };
+            m_harness.onRegister = [this](uint64_t beats) {
+                if (!m_wraps.empty()) m_wraps.back().push_back(beats);
+            };
+            m_parser.onSync = [this]() { checkSnapshot(); };
+        }
+    }
+
+    ~Cosim() {
+        if (m_ptyFd >= 0) close(m_ptyFd);
+        if (m_trace) std::fclose(m_trace);
+    }
+
+    bool open() {
+        if (!m_opts.outPath.empty()) {
+            m_out.open(m_opts.outPath, std::ios::binary);
+            if (!m_out) {
+                std::cerr << "Cannot write " << m_opts.outPath << "\n";
+                return false;
+            }
+        }
+        if (!m_opts.tracePath.empty()) {
+            m_trace = std::fopen(m_opts.tracePath.c_str(), "w");
+            if (!m_trace) {
+                std::cerr << "Cannot write " << m_opts.tracePath << "\n";
+                return false;
+            }
+            TimingParams params;
+            params.clkFreq = uint32_t(TopHarness::CLK_HZ);
+            params.baudRate = uint32_t(TopHarness::BAUD_RATE);
+            params.numBeats = TopHarness::NUM_BEATS;
+            std::fprintf(m_trace, "# top_cosim trace\n%s\n", TimingChecker::traceHeader(params).c_str());
+            m_harness.onTrace = [this](uint64_t cycle, const char *signal, uint64_t value) {
+                bool hex = std::strcmp(signal, "beats") == 0;
+                std::fprintf(m_trace, hex ? "%llu %s %016llx\n" : "%llu %s %llu\n", (unsigned long long)cycle,
+                             signal, (unsigned long long)value);
+            };
+        }
+        if (m_opts.pty) {
+            std::string slave;
+            std::string error;
+            m_ptyFd = openPty(slave, &error);
+            if (m_ptyFd < 0) {
+                std::cerr << error << "\n";
+                return false;
+            }
+            std::cerr << "Connect the GUI to " << slave << " (framed format)\n";
+            while (!g_stop && ptyPeerClosed(m_ptyFd)) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            fcntl(m_ptyFd, F_SETFL, fcntl(m_ptyFd, F_GETFL) | O_NONBLOCK);
+        }
+        m_startNs = monotonicNanos();
+        return true;
+    }
+
+    // Advance in millisecond slices so the outputs and pacing keep up
+    void advance(uint64_t cycles) {
+        constexpr uint64_t SLICE = std::max<uint64_t>(1, TopHarness::CLK_HZ / 1000);
+        while (cycles > 0 && !g_stop) {
+            uint64_t n = std::min(cycles, SLICE);
+            m_harness.run(n);
+            cycles -= n;
+            flush();
+        }
+    }
+
+    bool set(int beat, int pitch) {
+        if (!m_harness.turnTo(pitch)) return false;
+        m_harness.press(beat);
+        flush();
+        return true;
+    }
+
+    // `count` edits at random beats and pitches, spread over one period
+    void randomEdits(int count) {
+        if (count <= 0) return;
+        uint64_t spacing = TopHarness::PERIOD_CYCLES / uint64_t(count);
+        for (int i = 0; i < count && !g_stop; ++i) {
+            uint64_t before = m_harness.cycle();
+            set(int(m_rng() % TopHarness::NUM_BEATS), 1 + int(m_rng() % 8));
+            uint64_t spent = m_harness.cycle() - before;
+            if (spent < spacing) advance(m_rng() % (2 * (spacing - spent)));
+        }
+    }
+
+    bool runScript(std::istream &in) {
+        std::string line;
+        int lineNo = 0;
+        while (!g_stop && std::getline(in, line)) {
+            ++lineNo;
+            line = line.substr(0, line.find('#'));
+            std::istringstream words(line);
+            std::string command;
+            if (!(words >> command)) continue;
+            double a = 0.0, b = 0.0;
+            bool ok = bool(words >> a);
+            if (command == "set") ok = ok && (words >> b);
+            if (ok) {
+                if (command == "wait") {
+                    advance(uint64_t(std::max(0.0, a) * TopHarness::CLK_HZ));
+                } else if (command == "beats") {
+                    advance(uint64_t(std::max(0.0, a)) * TopHarness::BEAT_CYCLES);
+                } else if (command == "periods") {
+                    advance(uint64_t(std::max(0.0, a)) * TopHarness::PERIOD_CYCLES);
+                } else if (command == "turn") {
+                    ok = m_harness.turnTo(int(a));
+                } else if (command == "press") {
+                    ok = a >= 0 && a < TopHarness::NUM_BEATS;
+                    if (ok) m_harness.press(int(a));
+                } else if (command == "set") {
+                    ok = a >= 0 && a < TopHarness::NUM_BEATS && set(int(a), int(b));
+                } else if (command == "random") {
+                    randomEdits(int(a));
+                } else {
+                    ok = false;
+                }
+            }
+            if (!ok) {
+                std::cerr << m_opts.scriptPath << ":" << lineNo << ": cannot run '" << line << "'\n";
+                return false;
+            }
+        }
+        flush();
+        return true;
+    }
+
+    void runPeriods(long periods) {
+        for (long i = 0; (periods < 0 || i < periods) && !g_stop; ++i) {
+            uint64_t end = m_harness.cycle() + TopHarness::PERIOD_CYCLES;
+            randomEdits(m_opts.edits);
+            if (m_harness.cycle() < end) advance(end - m_harness.cycle());
+        }
+        // Let the last frame finish on the wire
+        advance(TopHarness::BEAT_CYCLES);
+    }
+
+    bool report() const {
+        double wall = (monotonicNanos() - m_startNs) / 1e9;
+        double sim = m_harness.seconds();
+        const UartBitDecoder::Counters &uart = m_harness.uartCounters();
+        std::fprintf(stderr, "%llu cycles, %.3f s at %.3f MHz in %.3f s: %.1f Mcycles/s, %.1fx real time\n",
+                     (unsigned long long)m_harness.cycle(), sim, TopHarness::CLK_HZ / 1e6, wall,
+                     wall > 0 ? m_harness.cycle() / wall / 1e6 : 0.0, wall > 0 ? sim / wall : 0.0);
+        std::fprintf(stderr, "%llu bytes on the pin (%llu framing errors, %llu glitches), %llu written, %llu dropped\n",
+                     (unsigned long long)uart.bytes, (unsigned long long)uart.framingErrors,
+                     (unsigned long long)uart.glitches, (unsigned long long)m_written,
+                     (unsigned long long)m_dropped);
+        if (!m_opts.check) return true;
+
+        const UARTParser::Counters &c = m_parser.counters();
+        std::fprintf(stderr, "%llu frames, %llu CRC errors, %llu malformed; %llu snapshots checked, "
+                             "%llu mismatches, %llu without a wrap\n",
+                     (unsigned long long)c.frames, (unsigned long long)c.crcErrors,
+                     (unsigned long long)c.malformed, (unsigned long long)m_checked,
+                     (unsigned long long)m_mismatches, (unsigned long long)m_unmatched);
+        return uart.framingErrors == 0 && c.crcErrors == 0 && c.malformed == 0 && c.outOfRange == 0 &&
+               m_mismatches == 0 && m_unmatched == 0;
+    }
+
+private:
+    void flush() {
+        if (!m_pending.empty()) writePending();
+        if (m_opts.realTime) {
+            uint64_t due = m_startNs + uint64_t(m_harness.seconds() * 1e9);
+            uint64_t now = monotonicNanos();
+            if (due > now) std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+        }
+    }
+
+    void writePending() {
+        if (m_out.is_open()) m_out.write(reinterpret_cast<const char *>(m_pending.data()), std::streamsize(m_pending.size()));
+        if (m_ptyFd >= 0) {
+            // A GUI that falls behind loses bytes, as it would on the wire
+            ssize_t n = ::write(m_ptyFd, m_pending.data(), m_pending.size());
+            if (n < 0) {
+                if (errno != EAGAIN && errno != EINTR) g_stop = 1;  // the GUI went away
+                n = 0;
+            }
+            m_dropped += m_pending.size() - size_t(n);
+        }
+        m_written += m_pending.size();
+        m_pending.clear();
+    }
+
+    // A snapshot decoded. The framer reads the register when the frame gets
+    // the line, which may be after an edit that followed the wrap, so any
+    // value held since the wrap that triggered it will do.
+    void checkSnapshot() {
+        if (m_wraps.empty()) {
+            ++m_unmatched;
+            return;
+        }
+        std::vector<uint64_t> held = std::move(m_wraps.front());
+        m_wraps.pop_front();
+        ++m_checked;
+        uint64_t decoded = m_model.pitches().word(0);
+        if (std::find(held.begin(), held.end(), decoded) == held.end()) {
+            uint64_t expected = held.front();
+            if (++m_mismatches <= 10) {
+                std::fprintf(stderr, "period %llu: decoded %016llx, register %016llx\n",
+                             (unsigned long long)m_checked, (unsigned long long)decoded,
+                             (unsigned long long)expected);
+            }
+        }
+    }
+
+    const CosimOptions &m_opts;
+    TopHarness m_harness;
+    std::mt19937_64 m_rng;
+    std::ofstream m_out;
+    std::FILE *m_trace;
+    int m_ptyFd;
+    std::vector<uint8_t> m_pending;
+
+    SequencerModel m_model;
+    UARTParser m_parser;
+    std::deque<std::vector<uint64_t>> m_wraps;  // register values since each wrap
+
+    uint64_t m_startNs;
+    uint64_t m_written;
+    uint64_t m_dropped;
+    uint64_t m_checked;
+    uint64_t m_mismatches;
+    uint64_t m_unmatched;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    CosimOptions opts;
+    if (!parseOptions(argc, argv, opts)) return 1;
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+
+    std::ifstream script;
+    if (!opts.scriptPath.empty()) {
+        script.open(opts.scriptPath);
+        if (!script) {
+            std::cerr << "Cannot read " << opts.scriptPath << "\n";
+            return 1;
+        }
+    }
+
+    Cosim cosim(opts);
+    if (!cosim.open()) return 1;
+    if (script.is_open() && !cosim.runScript(script)) return 1;
+    cosim.runPeriods(opts.periods);
+    return cosim.report() ? 0 : 1;
+}
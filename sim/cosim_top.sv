@@ -0,0 +1,66 @@
+// Verilator wrapper around hdl/top.sv: board pins under readable names, plus
+// a few internal signals the C++ harness checks against what it decodes.
+
+`include "top.sv"
+
+module cosim_top #(
+    parameter BAUD_RATE = 1_000_000,
+    parameter CLK_FREQ = 12_000_000
+)(
+    input logic clk,
+    input logic [3:0] cols,         // matrix columns, active low
+    output logic [3:0] rows,        // matrix rows, one driven low at a time
+    input logic enc_a,
+    input logic enc_b,
+    input logic enc_button,
+    output logic uart_tx,
+    output logic audio,
+    // Observation only
+    output logic [63:0] beats,
+    output logic [3:0] beat_count,
+    output logic [3:0] rotary_position,
+    output logic button_pressed,
+    output logic [3:0] button_index
+);
+    logic [6:0] segments;
+    logic decimal, led, rgb_r, rgb_g, rgb_b;
+
+    top #(
+        .BAUD_RATE(BAUD_RATE),
+        .CLK_FREQ(CLK_FREQ)
+    ) u_top (
+        .clk(clk),
+        ._39a(cols[0]),
+        ._38b(cols[1]),
+        ._41a(cols[2]),
+        ._42b(cols[3]),
+        ._36b(rows[0]),
+        ._37a(rows[1]),
+        ._29b(rows[2]),
+        ._31b(rows[3]),
+        ._48b(audio),
+        ._9b(segments[4]),
+        ._6a(segments[3]),
+        ._4a(segments[2]),
+        ._2a(decimal),
+        ._0a(segments[6]),
+        ._5a(segments[5]),
+        ._3b(segments[0]),
+        ._49a(segments[1]),
+        ._45a(enc_button),
+        ._44b(enc_b),
+        ._43a(enc_a),
+        ._13b(uart_tx),
+        .LED(led),
+        .RGB_R(rgb_r),
+        .RGB_G(rgb_g),
+        .RGB_B(rgb_b)
+    );
+
+    assign beats = u_top.beats;
+    assign beat_count = u_top.beat_count;
+    assign rotary_position = u_top.rotary_position;
+    assign button_pressed = u_top.button_pressed;
+    assign button_index = u_top.button_index;
+
+endmodule
@@ -0,0 +1,119 @@
+#include "top_harness.h"
+#include "Vcosim_top.h"
+#include "verilated.h"
+
+namespace {
+
+// One full matrix scan: four rows, a set and a read state each, 1200 cycles
+// apiece (button_matrix_controller's debounce_cycles, which does not scale)
+constexpr uint64_t SCAN_CYCLES = 4 * 2 * 1200;
+// Encoder pulses are far slower than the clock on the board too
+constexpr uint64_t ENCODER_CYCLES = 4;
+
+} // namespace
+
+TopHarness::TopHarness()
+    : m_context(std::make_unique<VerilatedContext>()),
+      m_uart(double(CLK_HZ) / double(BAUD_RATE)), m_cycle(0), m_pressed(-1), m_lastBeat(0),
+      m_lastRegister(0), m_lastAudio(false) {
+    m_top = std::make_unique<Vcosim_top>(m_context.get());
+    m_uart.onByte = [this](uint8_t byte, uint64_t start) {
+        if (onByte) onByte(byte, start);
+    };
+    m_top->clk = 0;
+    m_top->cols = 0xF;
+    m_top->enc_a = 0;
+    m_top->enc_b = 0;
+    m_top->enc_button = 0;
+    m_top->eval();
+}
+
+TopHarness::~TopHarness() {
+    m_top->final();
+}
+
+void TopHarness::step() {
+    // The matrix is passive: a closed key pulls its column low only while
+    // its row is the one driven low
+    uint8_t cols = 0xF;
+    if (m_pressed >= 0 && !((m_top->rows >> (m_pressed >> 2)) & 1)) cols &= uint8_t(~(1u << (m_pressed & 3)));
+    m_top->cols = cols;
+
+    m_top->clk = 1;
+    m_top->eval();
+    m_top->clk = 0;
+    m_top->eval();
+    ++m_cycle;
+
+    bool tx = m_top->uart_tx;
+    if (tx != m_uart.level()) {
+        m_uart.edge(m_cycle, tx);
+        if (onTrace) onTrace(m_cycle, "tx", tx);
+    }
+    bool audio = m_top->audio;
+    if (audio != m_lastAudio) {
+        m_lastAudio = audio;
+        if (onTrace) onTrace(m_cycle, "pwm", audio);
+    }
+
+    uint64_t beats = m_top->beats;
+    if (beats != m_lastRegister) {
+        m_lastRegister = beats;
+        if (onRegister) onRegister(beats);
+        if (onTrace) onTrace(m_cycle, "beats", beats);
+    }
+    int beat = m_top->beat_count;
+    if (beat != m_lastBeat) {
+        if (beat == 0 && onWrap) onWrap(beats);
+        if (onTrace) onTrace(m_cycle, "beat", uint64_t(beat));
+        m_lastBeat = beat;
+    }
+}
+
+void TopHarness::run(uint64_t cycles) {
+    for (uint64_t i = 0; i < cycles; ++i) step();
+    m_uart.advance(m_cycle);
+}
+
+void TopHarness::press(int button) {
+    m_pressed = button & 0xF;
+    for (uint64_t i = 0; i < 2 * SCAN_CYCLES && !m_top->button_pressed; ++i) step();
+    m_pressed = -1;
+    for (uint64_t i = 0; i < 2 * SCAN_CYCLES && m_top->button_pressed; ++i) step();
+    m_uart.advance(m_cycle);
+}
+
+void TopHarness::turn(bool up) {
+    // A leads B turning up: B is still low at A's rising edge
+    m_top->enc_b = up ? 0 : 1;
+    run(ENCODER_CYCLES);
+    m_top->enc_a = 1;
+    run(ENCODER_CYCLES);
+    m_top->enc_a = 0;
+    run(ENCODER_CYCLES);
+    m_top->enc_b = 0;
+    run(ENCODER_CYCLES);
+}
+
+bool TopHarness::turnTo(int pitch) {
+    if (pitch < 1 || pitch > 8) return false;
+    int up = (pitch - rotaryPosition() + 8) % 8;
+    if (up <= 4) {
+        for (int i = 0; i < up; ++i) turn(true);
+    } else {
+        for (int i = 0; i < 8 - up; ++i) turn(false);
+    }
+    return rotaryPosition() == pitch;
+}
+
+uint64_t TopHarness::beatsRegister() const {
+    return m_top->beats;
+}
+
+int TopHarness::beatCount() const {
+    return m_top->beat_count;
+}
+
+int TopHarness::rotaryPosition() const {
+    return m_top->rotary_position;
+}
@@ -0,0 +1,72 @@
+#ifndef TOP_HARNESS_H
+#define TOP_HARNESS_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "uart_bit_decoder.h"
+
+class VerilatedContext;
+class Vcosim_top;
+
+// Clock and pin models around the Verilated top: a 4x4 key matrix that
+// closes the pressed key's column while its row is driven, a quadrature
+// encoder, and a UART receiver on the TX pin. Time is counted in cycles of
+// the (possibly scaled) board clock the model was built for.
+class TopHarness {
+public:
+    static constexpr uint64_t CLK_HZ = COSIM_CLK_FREQ;
+    static constexpr uint64_t BAUD_RATE = COSIM_BAUD_RATE;
+    static constexpr int NUM_BEATS = 16;
+    // top.sv: PERIOD seconds per pass over the beats
+    static constexpr uint64_t BEAT_CYCLES = 4 * (CLK_HZ / NUM_BEATS);
+    static constexpr uint64_t PERIOD_CYCLES = BEAT_CYCLES * NUM_BEATS;
+
+    TopHarness();
+    ~TopHarness();
+
+    TopHarness(const TopHarness &) = delete;
+    TopHarness &operator=(const TopHarness &) = delete;
+
+    void run(uint64_t cycles);
+
+    // Hold a key until the matrix scan has seen it, then release it and wait
+    // for the scan to move on: one edit frame per call
+    void press(int button);
+    // Turn the encoder the short way round to `pitch` (1-8; it has no rest)
+    bool turnTo(int pitch);
+
+    uint64_t cycle() const { return m_cycle; }
+    double seconds() const { return double(m_cycle) / double(CLK_HZ); }
+
+    uint64_t beatsRegister() const;
+    int beatCount() const;
+    int rotaryPosition() const;
+
+    const UartBitDecoder::Counters &uartCounters() const { return m_uart.counters(); }
+
+    // Every byte recovered from the TX pin, with the cycle its start bit began
+    std::function<void(uint8_t byte, uint64_t cycle)> onByte;
+    // beat_count wrapped to 0; `beats` is the register at that cycle
+    std::function<void(uint64_t beats)> onWrap;
+    // The beats register took a new value
+    std::function<void(uint64_t beats)> onRegister;
+    // Any change of beats, beat_count, the audio pin or the TX pin, in
+    // TimingChecker's trace terms
+    std::function<void(uint64_t cycle, const char *signal, uint64_t value)> onTrace;
+
+private:
+    void step();
+    void turn(bool up);
+
+    std::unique_ptr<VerilatedContext> m_context;
+    std::unique_ptr<Vcosim_top> m_top;
+    UartBitDecoder m_uart;
+    uint64_t m_cycle;
+    int m_pressed;       // -1: no key down
+    int m_lastBeat;
+    uint64_t m_lastRegister;
+    bool m_lastAudio;
+};
+
+#endif // TOP_HARNESS_H
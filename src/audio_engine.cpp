@@ -0,0 +1,85 @@
+#include "audio_engine.h"
+#include "monotonic_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+
+AudioEngine::AudioEngine(std::unique_ptr<AudioSink> sink, const Config &config)
+    : m_sink(std::move(sink)), m_config(config), m_synth(config.sampleRate),
+      m_stop(false), m_blocks(0), m_late(0), m_maxRenderNs(0), m_rtPriority(false),
+      m_sinkFailed(false) {
+    m_config.blockFrames = std::clamp(m_config.blockFrames, 16, 8192);
+    m_synth.setGain(m_config.gain);
+}
+
+AudioEngine::~AudioEngine() {
+    stop();
+}
+
+uint64_t AudioEngine::latencyNs() const {
+    return uint64_t(m_config.blockFrames) * 1000000000ull / uint64_t(std::max(1, m_config.sampleRate));
+}
+
+bool AudioEngine::start(std::string *error) {
+    if (isRunning()) return true;
+    if (!m_sink->open(m_config.sampleRate, 1, error)) return false;
+    m_block.assign(size_t(m_config.blockFrames), 0.0f);
+    m_stop = false;
+    m_thread = std::thread(&AudioEngine::run, this);
+    return true;
+}
+
+void AudioEngine::stop() {
+    if (!isRunning()) return;
+    m_stop = true;
+    m_thread.join();
+    m_sink->close();
+}
+
+void AudioEngine::run() {
+    sched_param param = {};
+    param.sched_priority = std::min(sched_get_priority_max(SCHED_FIFO), 70);
+    m_rtPriority = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+
+    const bool pace = m_config.realTime && !m_sink->paced();
+    const uint64_t blockNs = latencyNs();
+    uint64_t blockIndex = 0;
+    uint64_t epoch = monotonicNanos();
+
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        uint64_t renderStart = monotonicNanos();
+        if (m_pattern.update()) m_synth.setPattern(m_pattern.current());
+        m_synth.render(m_block.data(), m_config.blockFrames);
+        uint64_t renderNs = monotonicNanos() - renderStart;
+        if (renderNs > m_maxRenderNs.load(std::memory_order_relaxed)) {
+            m_maxRenderNs.store(renderNs, std::memory_order_relaxed);
+        }
+
+        if (!m_sink->write(m_block.data(), m_config.blockFrames)) {
+            m_sinkFailed = true;
+            break;
+        }
+        m_blocks.fetch_add(1, std::memory_order_relaxed);
+        ++blockIndex;
+
+        if (pace) {
+            // Block deadlines sit on a fixed grid, so sleep jitter does not
+            // accumulate; falling more than a block behind is counted, and
+            // the grid restarts rather than bursting to catch up
+            uint64_t deadline = epoch + blockIndex * blockNs;
+            uint64_t now = monotonicNanos();
+            if (now > deadline + blockNs) {
+                m_late.fetch_add(1, std::memory_order_relaxed);
+                epoch = now;
+                blockIndex = 0;
+                continue;
+            }
+            timespec ts;
+            ts.tv_sec = time_t(deadline / 1000000000ull);
+            ts.tv_nsec = long(deadline % 1000000000ull);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef AUDIO_ENGINE_H
+#define AUDIO_ENGINE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio_sink.h"
+#include "pwm_synth.h"
+#include "triple_buffer.h"
+
+// Plays the pattern through a PwmSynth on a dedicated thread. The producer
+// (GUI thread, a session reactor) hands over whole patterns with
+// setPattern(), which never blocks; the audio thread picks up the newest
+// one at the start of each block. Block size bounds the added latency:
+// 128 frames at 48 kHz is 2.7 ms.
+//
+// The thread asks for SCHED_FIFO and carries on at normal priority if it is
+// refused. Sinks that do not block on a device clock are paced to real time
+// on the monotonic clock, or run flat out with `realTime` off.
+class AudioEngine {
+public:
+    struct Config {
+        int sampleRate = 48000;
+        int blockFrames = 128;
+        bool realTime = true;
+        float gain = 0.25f;
+    };
+
+    AudioEngine(std::unique_ptr<AudioSink> sink, const Config &config);
+    ~AudioEngine();
+
+    AudioEngine(const AudioEngine &) = delete;
+    AudioEngine &operator=(const AudioEngine &) = delete;
+
+    bool start(std::string *error = nullptr);
+    void stop();
+    bool isRunning() const { return m_thread.joinable(); }
+
+    // One producer thread only
+    void setPattern(const SynthPattern &pattern) { m_pattern.publish(pattern); }
+
+    const Config &config() const { return m_config; }
+    AudioSink *sink() const { return m_sink.get(); }
+    uint64_t latencyNs() const;
+
+    // Counters, readable from any thread
+    uint64_t blocks() const { return m_blocks.load(std::memory_order_relaxed); }
+    uint64_t lateBlocks() const { return m_late.load(std::memory_order_relaxed); }
+    uint64_t maxRenderNs() const { return m_maxRenderNs.load(std::memory_order_relaxed); }
+    bool realTimePriority() const { return m_rtPriority.load(std::memory_order_relaxed); }
+    bool sinkFailed() const { return m_sinkFailed.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    std::unique_ptr<AudioSink> m_sink;
+    Config m_config;
+    PwmSynth m_synth;            // audio thread only
+    std::vector<float> m_block;  // sized once in start()
+    TripleBuffer<SynthPattern> m_pattern;
+
+    std::thread m_thread;
+    std::atomic<bool> m_stop;
+    std::atomic<uint64_t> m_blocks;
+    std::atomic<uint64_t> m_late;     // paced blocks finished after their deadline
+    std::atomic<uint64_t> m_maxRenderNs;
+    std::atomic<bool> m_rtPriority;
+    std::atomic<bool> m_sinkFailed;
+};
+
+#endif // AUDIO_ENGINE_H
@@ -0,0 +1,92 @@
+#include "audio_sink.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+void putLE16(uint8_t *p, uint16_t v) {
+    p[0] = uint8_t(v);
+    p[1] = uint8_t(v >> 8);
+}
+
+void putLE32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = uint8_t(v >> (8 * i));
+}
+
+constexpr size_t WAV_HEADER_BYTES = 44;
+
+} // namespace
+
+WavFileSink::WavFileSink(const std::string &path)
+    : m_path(path), m_file(nullptr), m_channels(1), m_frames(0), m_failed(false) {}
+
+WavFileSink::~WavFileSink() {
+    close();
+}
+
+bool WavFileSink::open(int sampleRate, int channels, std::string *error) {
+    close();
+    m_file = std::fopen(m_path.c_str(), "wb");
+    if (!m_file) {
+        if (error) *error = "Cannot create " + m_path + ": " + std::strerror(errno);
+        return false;
+    }
+    m_channels = std::max(1, channels);
+    m_frames = 0;
+    m_failed = false;
+
+    // RIFF/WAVE with a PCM fmt chunk; the two size fields are filled in by close()
+    uint8_t header[WAV_HEADER_BYTES] = {};
+    std::memcpy(header, "RIFF", 4);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    putLE32(header + 16, 16);
+    putLE16(header + 20, 1);  // PCM
+    putLE16(header + 22, uint16_t(m_channels));
+    putLE32(header + 24, uint32_t(sampleRate));
+    putLE32(header + 28, uint32_t(sampleRate * m_channels * 2));
+    putLE16(header + 32, uint16_t(m_channels * 2));
+    putLE16(header + 34, 16);
+    std::memcpy(header + 36, "data", 4);
+    if (std::fwrite(header, 1, sizeof(header), m_file) != sizeof(header)) {
+        if (error) *error = "Cannot write " + m_path;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool WavFileSink::write(const float *samples, int frames) {
+    if (!m_file || m_failed) return false;
+    size_t total = size_t(frames) * size_t(m_channels);
+    while (total > 0) {
+        size_t n = std::min(total, size_t(CONVERT_SAMPLES));
+        // Clamp, scale and round half away from zero; no libm call, so
+        // the loop vectorizes
+        for (size_t i = 0; i < n; ++i) {
+            float s = std::min(1.0f, std::max(-1.0f, samples[i])) * 32767.0f;
+            m_convert[i] = int16_t(s + (s < 0.0f ? -0.5f : 0.5f));
+        }
+        if (std::fwrite(m_convert, sizeof(int16_t), n, m_file) != n) {
+            m_failed = true;
+            return false;
+        }
+        samples += n;
+        total -= n;
+    }
+    m_frames += uint64_t(frames);
+    return true;
+}
+
+void WavFileSink::close() {
+    if (!m_file) return;
+    uint64_t dataBytes = m_frames * uint64_t(m_channels) * 2;
+    uint8_t size[4];
+    putLE32(size, uint32_t(std::min<uint64_t>(dataBytes + WAV_HEADER_BYTES - 8, UINT32_MAX)));
+    if (std::fseek(m_file, 4, SEEK_SET) == 0) std::fwrite(size, 1, 4, m_file);
+    putLE32(size, uint32_t(std::min<uint64_t>(dataBytes, UINT32_MAX)));
+    if (std::fseek(m_file, 40, SEEK_SET) == 0) std::fwrite(size, 1, 4, m_file);
+    if (std::fclose(m_file) != 0) m_failed = true;
+    m_file = nullptr;
+}
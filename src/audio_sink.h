@@ -0,0 +1,65 @@
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Where the audio engine's blocks go. Samples are interleaved floats in
+// [-1, 1]. write() is called on the engine's real-time thread, so sinks
+// must not allocate there.
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+
+    virtual bool open(int sampleRate, int channels, std::string *error = nullptr) = 0;
+    virtual bool write(const float *samples, int frames) = 0;
+    virtual void close() = 0;
+
+    // True if write() blocks on a device clock. Otherwise the engine paces
+    // itself to real time (or runs flat out when asked to).
+    virtual bool paced() const { return false; }
+};
+
+// Discards everything; for CI and for measuring the engine alone
+class NullAudioSink : public AudioSink {
+public:
+    bool open(int, int, std::string * = nullptr) override { return true; }
+    bool write(const float *, int frames) override {
+        m_frames += uint64_t(frames);
+        return true;
+    }
+    void close() override {}
+
+    uint64_t framesWritten() const { return m_frames; }
+
+private:
+    uint64_t m_frames = 0;
+};
+
+// 16-bit PCM WAV file. The header's sizes are patched on close().
+class WavFileSink : public AudioSink {
+public:
+    explicit WavFileSink(const std::string &path);
+    ~WavFileSink() override;
+
+    bool open(int sampleRate, int channels, std::string *error = nullptr) override;
+    bool write(const float *samples, int frames) override;
+    void close() override;
+
+    const std::string &path() const { return m_path; }
+    uint64_t framesWritten() const { return m_frames; }
+    bool failed() const { return m_failed; }
+
+private:
+    static constexpr int CONVERT_SAMPLES = 4096;
+
+    std::string m_path;
+    FILE *m_file;
+    int m_channels;
+    uint64_t m_frames;
+    bool m_failed;
+    int16_t m_convert[CONVERT_SAMPLES];  // float to PCM, reused per write
+};
+
+#endif // AUDIO_SINK_H
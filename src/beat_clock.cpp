@@ -0,0 +1,109 @@
+#include "beat_clock.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Filter gains: alpha corrects phase, beta corrects period. beta ~ alpha^2/(2-alpha)
+// keeps the loop close to critically damped, so serial latency jitter is
+// smoothed over a few periods without overshoot.
+constexpr double ALPHA = 0.3;
+constexpr double BETA = 0.05;
+
+constexpr double OUTLIER_FRACTION = 0.2;  // |error| above this share of a period
+constexpr double SAME_INTERVAL = 0.05;    // intervals this close count as equal
+constexpr double LOCK_FRACTION = 0.01;
+constexpr int LOCK_SYNCS = 3;             // consecutive good SYNCs to report lock
+
+double clampPeriod(double ns) {
+    return std::clamp(ns, double(BeatClock::MIN_PERIOD_NS), double(BeatClock::MAX_PERIOD_NS));
+}
+
+bool plausiblePeriod(uint64_t ns) {
+    return ns >= BeatClock::MIN_PERIOD_NS && ns <= BeatClock::MAX_PERIOD_NS;
+}
+
+bool sameInterval(uint64_t a, uint64_t b) {
+    return std::fabs(double(a) - double(b)) < SAME_INTERVAL * double(a);
+}
+
+} // namespace
+
+BeatClock::BeatClock(int beats, uint64_t periodNs)
+    : m_period(clampPeriod(double(periodNs))), m_anchor(0), m_beats(std::max(1, beats)),
+      m_lastSync(0), m_measured(false), m_locked(false), m_goodSyncs(0), m_intervals{0, 0},
+      m_jitter(0), m_syncs(0) {}
+
+void BeatClock::setNumBeats(int beats) {
+    m_beats = std::max(1, beats);
+}
+
+void BeatClock::setPeriod(uint64_t periodNs) {
+    m_period = clampPeriod(double(periodNs));
+    m_measured = true;  // trust the user until SYNCs say otherwise
+    m_locked = false;
+    m_goodSyncs = 0;
+}
+
+void BeatClock::restart(uint64_t nowNs) {
+    m_anchor = double(nowNs);
+    m_lastSync = 0;
+    m_measured = false;
+    m_locked = false;
+    m_goodSyncs = 0;
+    m_intervals[0] = m_intervals[1] = 0;
+    m_jitter = 0;
+}
+
+void BeatClock::sync(uint64_t timestampNs) {
+    ++m_syncs;
+    double ts = double(timestampNs);
+    uint64_t interval = m_lastSync ? timestampNs - m_lastSync : 0;
+    m_lastSync = timestampNs;
+
+    bool steady = plausiblePeriod(interval) && sameInterval(interval, m_intervals[0]) &&
+                  sameInterval(interval, m_intervals[1]);
+    m_intervals[1] = m_intervals[0];
+    m_intervals[0] = interval;
+
+    // Acquisition: snap the phase, take the period from the first interval.
+    // A steady new interval means the board's tempo changed: start over.
+    if (!m_measured || interval == 0 ||
+        (steady && std::fabs(double(interval) - m_period) > OUTLIER_FRACTION * m_period)) {
+        if (plausiblePeriod(interval)) {
+            m_period = double(interval);
+            m_measured = true;
+        }
+        m_anchor = ts;
+        m_locked = false;
+        m_goodSyncs = 0;
+        return;
+    }
+
+    // Tracking: compare against the nearest predicted period boundary
+    double periods = std::max(1.0, std::round((ts - m_anchor) / m_period));
+    double predicted = m_anchor + periods * m_period;
+    double error = ts - predicted;
+    if (std::fabs(error) > OUTLIER_FRACTION * m_period) return;  // glitch
+
+    m_anchor = predicted + ALPHA * error;
+    m_period = clampPeriod(m_period + BETA * error / periods);
+    m_jitter += (std::fabs(error) - m_jitter) / 8.0;
+
+    m_goodSyncs = std::fabs(error) < LOCK_FRACTION * m_period ? m_goodSyncs + 1 : 0;
+    m_locked = m_goodSyncs >= LOCK_SYNCS;
+}
+
+int BeatClock::beatAt(uint64_t nowNs) const {
+    double phase = (double(nowNs) - m_anchor) / m_period;
+    phase -= std::floor(phase);
+    return std::min(m_beats - 1, static_cast<int>(phase * m_beats));
+}
+
+uint64_t BeatClock::nextBeatAt(uint64_t nowNs) const {
+    double beatLength = m_period / m_beats;
+    double beats = std::floor((double(nowNs) - m_anchor) / beatLength) + 1.0;
+    double next = m_anchor + beats * beatLength;
+    // Rounding can land on `nowNs` itself; never schedule in the past
+    return std::max(nowNs + 1, static_cast<uint64_t>(std::llround(next)));
+}
@@ -0,0 +1,58 @@
+#ifndef BEAT_CLOCK_H
+#define BEAT_CLOCK_H
+
+#include <cstdint>
+
+// Software copy of the FPGA's beat counter. The board sends SYNC (0xFF) once
+// per period; the clock measures the period from successive SYNC arrival
+// times and tracks its phase with an alpha-beta filter (a second-order PLL),
+// so beat boundaries can be computed for any instant on the monotonic clock
+// instead of being counted by a drifting timer.
+//
+// Without SYNCs it free-runs at the configured period. A SYNC far off the
+// prediction is ignored as a glitch; three equal SYNC intervals that disagree
+// with the estimate mean the board changed tempo, and the clock re-acquires.
+class BeatClock {
+public:
+    static constexpr uint64_t MIN_PERIOD_NS = 50000000ull;     // 50 ms
+    static constexpr uint64_t MAX_PERIOD_NS = 60000000000ull;  // 60 s
+
+    explicit BeatClock(int beats = 16, uint64_t periodNs = 4000000000ull);
+
+    // Runtime configuration. Changing the period re-seeds the estimate but
+    // keeps the phase; changing the beat count only rescales beats.
+    void setNumBeats(int beats);
+    int numBeats() const { return m_beats; }
+    void setPeriod(uint64_t periodNs);
+
+    // Anchor beat 0 at `nowNs` and forget any lock
+    void restart(uint64_t nowNs);
+
+    // SYNC observed at `timestampNs` (monotonicNanos of the read)
+    void sync(uint64_t timestampNs);
+
+    int beatAt(uint64_t nowNs) const;
+    // First beat boundary strictly after `nowNs`
+    uint64_t nextBeatAt(uint64_t nowNs) const;
+
+    uint64_t periodNs() const { return static_cast<uint64_t>(m_period); }
+    bool locked() const { return m_locked; }
+    // Smoothed absolute SYNC phase error
+    double jitterNs() const { return m_jitter; }
+    uint64_t syncs() const { return m_syncs; }
+
+private:
+    double m_period;     // estimated period, ns
+    double m_anchor;     // estimated start of some period, ns
+    int m_beats;
+
+    uint64_t m_lastSync;
+    bool m_measured;     // m_period comes from the board, not the config
+    bool m_locked;
+    int m_goodSyncs;
+    uint64_t m_intervals[2];  // previous raw SYNC intervals, newest first
+    double m_jitter;
+    uint64_t m_syncs;
+};
+
+#endif // BEAT_CLOCK_H
@@ -0,0 +1,128 @@
+#include "beat_grid_widget.h"
+#include "ingest_stats.h"
+#include <QPaintEvent>
+#include <QPainter>
+#include <QPen>
+#include <algorithm>
+
+namespace {
+
+// Map pitches 1-8 to musical notes C4-C5
+const char *const NOTE_NAMES[SequencerModel::MAX_PITCH + 1] = {
+    "REST", "C4", "D4", "E4", "F4", "G4", "A5", "B5", "C5"
+};
+
+} // namespace
+
+BeatGridWidget::BeatGridWidget(const SequencerModel *model, QWidget *parent)
+    : QWidget(parent), m_model(model), m_columns(4), m_current(model->currentBeat()),
+      m_restCurrentBrush(QColor("#444")), m_restTextColor("#666"),
+      m_stats(nullptr), m_pendingTimestamp(0) {
+    // HSV colour mapping, computed once: pitch 1-8 map to 8 evenly spaced
+    // hues (0, 45, 90, ... 315 degrees) at high saturation
+    m_brushes[0] = QBrush(QColor("#222"));
+    for (int pitch = 1; pitch <= SequencerModel::MAX_PITCH; ++pitch) {
+        int hue = ((pitch - 1) * 360) / SequencerModel::MAX_PITCH;
+        m_brushes[pitch] = QBrush(QColor::fromHsv(hue, 200, 180));
+    }
+
+    m_font = font();
+    m_font.setPixelSize(20);
+    m_font.setBold(true);
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+}
+
+void BeatGridWidget::setColumns(int columns) {
+    m_columns = std::max(1, columns);
+    updateGeometry();
+    update();
+}
+
+void BeatGridWidget::beatCountChanged() {
+    if (m_current >= m_model->numBeats()) m_current = m_model->currentBeat();
+    updateGeometry();
+    update();
+}
+
+int BeatGridWidget::rows() const {
+    return (m_model->numBeats() + m_columns - 1) / m_columns;
+}
+
+int BeatGridWidget::cellSize() const {
+    int w = (width() - SPACING * (m_columns - 1)) / m_columns;
+    int h = (height() - SPACING * (rows() - 1)) / rows();
+    return std::max(1, std::min(w, h));
+}
+
+QRect BeatGridWidget::cellRect(int beat) const {
+    int size = cellSize();
+    int row = beat / m_columns;
+    int col = beat % m_columns;
+    return QRect(col * (size + SPACING), row * (size + SPACING), size, size);
+}
+
+QSize BeatGridWidget::sizeHint() const {
+    return QSize(m_columns * CELL_SIZE + (m_columns - 1) * SPACING,
+                 rows() * CELL_SIZE + (rows() - 1) * SPACING);
+}
+
+void BeatGridWidget::beatsChanged(const SequencerModel::BeatMask &dirty) {
+    if (dirty.none()) return;
+    for (int i = 0; i < m_model->numBeats(); ++i) {
+        if (dirty.test(i)) update(cellRect(i));
+    }
+}
+
+void BeatGridWidget::setCurrentBeat(int beat) {
+    if (beat == m_current) return;
+    update(cellRect(m_current));
+    m_current = beat;
+    update(cellRect(m_current));
+}
+
+void BeatGridWidget::noteSourceTimestamp(uint64_t ns) {
+    if (ns != 0 && (m_pendingTimestamp == 0 || ns < m_pendingTimestamp)) m_pendingTimestamp = ns;
+}
+
+void BeatGridWidget::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().window());
+    painter.setFont(m_font);
+
+    for (int i = 0; i < m_model->numBeats(); ++i) {
+        if (cellRect(i).intersects(event->rect())) paintCell(painter, i);
+    }
+
+    if (m_stats && m_pendingTimestamp) {
+        m_stats->recordSince(IngestStats::STAGE_GRID_PAINT, m_pendingTimestamp);
+        m_pendingTimestamp = 0;
+    }
+}
+
+void BeatGridWidget::paintCell(QPainter &painter, int beat) {
+    QRect rect = cellRect(beat);
+    int pitch = std::clamp(m_model->getBeatPitch(beat), 0, SequencerModel::MAX_PITCH);
+    bool isCurrent = (beat == m_current);
+
+    const QBrush &fill = (pitch == 0 && isCurrent) ? m_restCurrentBrush : m_brushes[pitch];
+    painter.fillRect(rect, fill);
+
+    if (isCurrent) {
+        // Current beat: yellow border drawn inside the cell
+        QPen pen(Qt::yellow, BORDER);
+        pen.setJoinStyle(Qt::MiterJoin);
+        painter.setPen(pen);
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(rect.adjusted(BORDER / 2, BORDER / 2, -BORDER / 2, -BORDER / 2));
+    }
+
+    QString text = QString::number(beat);
+    if (pitch > 0) {
+        // Don't show REST text to keep it clean
+        text += QString("\n%1").arg(NOTE_NAMES[pitch]);
+    }
+    painter.setPen((pitch > 0 || isCurrent) ? QColor(Qt::white) : m_restTextColor);
+    painter.drawText(rect, Qt::AlignCenter, text);
+}
@@ -0,0 +1,66 @@
+#ifndef BEAT_GRID_WIDGET_H
+#define BEAT_GRID_WIDGET_H
+
+#include <QBrush>
+#include <QColor>
+#include <QFont>
+#include <QWidget>
+#include <array>
+#include "sequencer_model.h"
+
+class IngestStats;
+
+// Paints the beat cells directly from the model. Brushes are computed once
+// per pitch, and only cells whose pitch or current-beat status changed are
+// invalidated, so a beat tick repaints two cells instead of restyling every
+// widget in the grid.
+class BeatGridWidget : public QWidget {
+    Q_OBJECT
+public:
+    explicit BeatGridWidget(const SequencerModel *model, QWidget *parent = nullptr);
+
+    // Cells per row; rows follow from the model's beat count
+    void setColumns(int columns);
+    int columns() const { return m_columns; }
+
+    // Repaint the given beats after a model transaction
+    void beatsChanged(const SequencerModel::BeatMask &dirty);
+    void setCurrentBeat(int beat);
+    // The model's beat count changed: relayout and repaint everything
+    void beatCountChanged();
+
+    // Latency instrumentation: the next paint is timed against the earliest
+    // source timestamp noted since the previous one
+    void setStats(IngestStats *stats) { m_stats = stats; }
+    void noteSourceTimestamp(uint64_t ns);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    int rows() const;
+    int cellSize() const;
+    QRect cellRect(int beat) const;
+    void paintCell(QPainter &painter, int beat);
+
+    static constexpr int CELL_SIZE = 120;  // preferred cell edge in pixels
+    static constexpr int SPACING = 10;
+    static constexpr int BORDER = 4;       // current-beat highlight
+
+    const SequencerModel *m_model;
+    int m_columns;
+    int m_current;
+
+    // Index 0 is the rest colour; 1-8 map the pitches across the hue wheel
+    std::array<QBrush, SequencerModel::MAX_PITCH + 1> m_brushes;
+    QBrush m_restCurrentBrush;
+    QColor m_restTextColor;
+    QFont m_font;
+
+    IngestStats *m_stats;
+    uint64_t m_pendingTimestamp;
+};
+
+#endif // BEAT_GRID_WIDGET_H
@@ -0,0 +1,127 @@
+#include "board_overview_widget.h"
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <algorithm>
+
+namespace {
+
+// Anything a row displays; counters other than these do not repaint it
+bool rowChanged(const BoardSnapshot &a, const BoardSnapshot &b) {
+    return a.id != b.id || a.revision != b.revision || a.current != b.current ||
+           a.beats != b.beats || a.open != b.open || a.capturing != b.capturing ||
+           a.locked != b.locked || a.frames != b.frames || a.errors != b.errors ||
+           a.name != b.name || a.error != b.error;
+}
+
+} // namespace
+
+BoardOverviewWidget::BoardOverviewWidget(QWidget *parent)
+    : QWidget(parent), m_selected(-1), m_restCurrentBrush(QColor("#444")) {
+    // Same hues as BeatGridWidget so a board reads the same in both views
+    m_brushes[0] = QBrush(QColor("#222"));
+    for (int pitch = 1; pitch <= SequencerModel::MAX_PITCH; ++pitch) {
+        int hue = ((pitch - 1) * 360) / SequencerModel::MAX_PITCH;
+        m_brushes[pitch] = QBrush(QColor::fromHsv(hue, 200, 180));
+    }
+
+    m_font = font();
+    m_font.setPixelSize(12);
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
+}
+
+QSize BoardOverviewWidget::sizeHint() const {
+    return QSize(NAME_WIDTH + 16 * CELL_WIDTH + COUNTER_WIDTH + 24,
+                 std::max(1, boardCount()) * ROW_HEIGHT);
+}
+
+QRect BoardOverviewWidget::rowRect(int row) const {
+    return QRect(0, row * ROW_HEIGHT, width(), ROW_HEIGHT);
+}
+
+void BoardOverviewWidget::setSnapshots(std::vector<BoardSnapshot> snapshots) {
+    if (snapshots.size() != m_rows.size()) {
+        m_rows = std::move(snapshots);
+        auto it = std::find_if(m_rows.begin(), m_rows.end(),
+                               [this](const BoardSnapshot &s) { return s.id == m_selected; });
+        if (it == m_rows.end()) m_selected = -1;
+        updateGeometry();
+        update();
+        return;
+    }
+    for (size_t i = 0; i < snapshots.size(); ++i) {
+        if (rowChanged(m_rows[i], snapshots[i])) update(rowRect(static_cast<int>(i)));
+    }
+    m_rows = std::move(snapshots);
+}
+
+void BoardOverviewWidget::mousePressEvent(QMouseEvent *event) {
+    int row = event->pos().y() / ROW_HEIGHT;
+    int id = (row >= 0 && row < boardCount()) ? m_rows[row].id : -1;
+    if (id == m_selected) return;
+    m_selected = id;
+    update();
+    emit boardSelected(id);
+}
+
+void BoardOverviewWidget::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().base());
+    painter.setFont(m_font);
+
+    if (m_rows.empty()) {
+        painter.setPen(palette().color(QPalette::Disabled, QPalette::Text));
+        painter.drawText(rect(), Qt::AlignCenter, "No boards");
+        return;
+    }
+    for (int i = 0; i < boardCount(); ++i) {
+        if (rowRect(i).intersects(event->rect())) paintRow(painter, i);
+    }
+}
+
+void BoardOverviewWidget::paintRow(QPainter &painter, int row) {
+    const BoardSnapshot &s = m_rows[row];
+    QRect rect = rowRect(row);
+    if (s.id == m_selected) painter.fillRect(rect, palette().highlight());
+
+    // Status: green reading, red recording, grey closed
+    QColor status = !s.open ? QColor("#777") : s.capturing ? QColor("#d33") : QColor("#3b3");
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(status);
+    painter.drawEllipse(QRect(rect.left() + 6, rect.center().y() - 4, 8, 8));
+
+    QColor text = s.id == m_selected ? palette().color(QPalette::HighlightedText)
+                                     : palette().color(QPalette::Text);
+    painter.setPen(text);
+    QRect nameRect(rect.left() + 20, rect.top(), NAME_WIDTH - 24, rect.height());
+    painter.drawText(nameRect, Qt::AlignVCenter | Qt::AlignLeft,
+                     painter.fontMetrics().elidedText(QString::fromStdString(s.name), Qt::ElideMiddle,
+                                                      nameRect.width()));
+
+    // Beat strip, squeezed into whatever the name and counters leave over
+    int stripLeft = rect.left() + NAME_WIDTH;
+    int stripWidth = std::max(0, rect.width() - NAME_WIDTH - COUNTER_WIDTH);
+    int cell = s.beats > 0 ? std::min(CELL_WIDTH, stripWidth / s.beats) : 0;
+    if (cell >= 2) {
+        for (int i = 0; i < s.beats; ++i) {
+            int pitch = std::min(s.pitches[i], SequencerModel::MAX_PITCH);
+            bool isCurrent = (i == s.current);
+            QRect cellRect(stripLeft + i * cell, rect.top() + 3, cell - 1, rect.height() - 6);
+            painter.fillRect(cellRect, (pitch == 0 && isCurrent) ? m_restCurrentBrush : m_brushes[pitch]);
+            if (isCurrent) {
+                painter.setPen(Qt::yellow);
+                painter.setBrush(Qt::NoBrush);
+                painter.drawRect(cellRect.adjusted(0, 0, -1, -1));
+            }
+        }
+    }
+
+    QString counters = s.open ? QString("%1 frames  %2 err%3").arg(s.frames).arg(s.errors)
+                                    .arg(s.locked ? "  lock" : "")
+                              : QString::fromStdString(s.error.empty() ? "closed" : s.error);
+    painter.setPen(s.errors > 0 && s.open ? QColor("#d80") : text);
+    painter.drawText(QRect(rect.right() - COUNTER_WIDTH, rect.top(), COUNTER_WIDTH - 6, rect.height()),
+                     Qt::AlignVCenter | Qt::AlignRight, counters);
+}
@@ -0,0 +1,52 @@
+#ifndef BOARD_OVERVIEW_WIDGET_H
+#define BOARD_OVERVIEW_WIDGET_H
+
+#include <QBrush>
+#include <QFont>
+#include <QWidget>
+#include <array>
+#include <vector>
+#include "board_session.h"
+
+// One compact row per board: status, name, a strip of beat cells coloured
+// like BeatGridWidget, and the frame/error counters. Fed whole snapshot lists
+// from the session manager; only rows whose content changed are repainted,
+// so a wall of idle boards costs nothing per refresh.
+class BoardOverviewWidget : public QWidget {
+    Q_OBJECT
+public:
+    explicit BoardOverviewWidget(QWidget *parent = nullptr);
+
+    void setSnapshots(std::vector<BoardSnapshot> snapshots);
+    int boardCount() const { return static_cast<int>(m_rows.size()); }
+
+    // Id of the clicked row, or -1
+    int selectedBoard() const { return m_selected; }
+
+    QSize sizeHint() const override;
+
+signals:
+    void boardSelected(int id);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private:
+    QRect rowRect(int row) const;
+    void paintRow(QPainter &painter, int row);
+
+    static constexpr int ROW_HEIGHT = 22;
+    static constexpr int NAME_WIDTH = 160;
+    static constexpr int COUNTER_WIDTH = 170;
+    static constexpr int CELL_WIDTH = 12;  // preferred, shrinks to fit
+
+    std::vector<BoardSnapshot> m_rows;
+    int m_selected;
+
+    std::array<QBrush, SequencerModel::MAX_PITCH + 1> m_brushes;
+    QBrush m_restCurrentBrush;
+    QFont m_font;
+};
+
+#endif // BOARD_OVERVIEW_WIDGET_H
@@ -0,0 +1,191 @@
+#include "board_session.h"
+#include "capture_file.h"
+#include "monotonic_clock.h"
+#include "replay_source.h"
+#include "serial_device.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// A read per readiness at 1 Mbaud brings in well under this; small enough
+// that hundreds of sessions stay cheap
+constexpr size_t SESSION_BUFFER_BYTES = 16 * 1024;
+
+const char *formatName(UARTParser::Format format) {
+    switch (format) {
+    case UARTParser::Format::Text: return "text";
+    case UARTParser::Format::Raw: return "raw";
+    case UARTParser::Format::Framed: return "framed";
+    }
+    return "unknown";
+}
+
+std::string jsonString(const std::string &s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out + '"';
+}
+
+} // namespace
+
+BoardSession::BoardSession(const Config &config)
+    : m_config(config), m_fd(-1), m_ownsFd(false), m_buffer(SESSION_BUFFER_BYTES),
+      m_model(config.beats), m_parser(&m_model, config.format),
+      m_clock(m_model.numBeats(), config.periodNs), m_revision(0), m_lastReadNs(0) {
+    m_parser.setStats(&m_stats);
+    m_model.setStats(&m_stats);
+
+    m_model.onPitchesChanged = [this](const SequencerModel::PitchChange &) { ++m_revision; };
+    m_model.onBeatChanged = [this](int) { ++m_revision; };
+    m_parser.onSync = [this]() { m_clock.sync(m_parser.sourceTimestamp()); };
+    // The board reports its own length; follow it
+    m_parser.onBeatCount = [this](int beats) {
+        m_model.setNumBeats(beats);
+        m_clock.setNumBeats(m_model.numBeats());
+    };
+    m_clock.restart(monotonicNanos());
+}
+
+BoardSession::~BoardSession() {
+    close();
+}
+
+void BoardSession::attach(int fd, bool ownsFd) {
+    close();
+    m_fd = fd;
+    m_ownsFd = ownsFd;
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    m_parser.reset();
+    m_buffer.clear();
+}
+
+bool BoardSession::openDevice(const std::string &path, int baud, std::string *error) {
+    int fd = openSerialDevice(path, baud, error);
+    if (fd < 0) return false;
+    attach(fd, true);
+    return true;
+}
+
+bool BoardSession::openReplay(const std::string &path, double speed, std::string *error) {
+    auto replay = std::make_unique<ReplaySource>();
+    if (!replay->open(path, error)) return false;
+    int fd = replay->start(speed);
+    if (fd < 0) {
+        if (error) *error = "Failed to start replay of " + path;
+        return false;
+    }
+    attach(fd, true);
+    m_parser.setFormat(replay->format());
+    m_replay = std::move(replay);
+    return true;
+}
+
+void BoardSession::close() {
+    if (m_fd >= 0 && m_ownsFd) ::close(m_fd);
+    m_fd = -1;
+    m_ownsFd = false;
+    if (m_replay) {
+        m_replay->stop();
+        m_replay.reset();
+    }
+    // Keep the configured format for the next source
+    m_parser.setFormat(m_config.format);
+}
+
+bool BoardSession::readAvailable() {
+    if (m_fd < 0) return false;
+    uint64_t readStart = monotonicNanos();
+    ssize_t n = m_buffer.readFrom(m_fd);
+    uint64_t readDone = monotonicNanos();
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EINTR;
+    m_stats.record(IngestStats::STAGE_READ, readDone - readStart);
+    m_stats.addBytes(static_cast<uint64_t>(n));
+    m_lastReadNs = readDone;
+
+    SequencerModel::Batch batch(m_model);
+    m_parser.setSourceTimestamp(readDone);
+    ByteRingBuffer::ConstSpan spans[2];
+    int count = m_buffer.readableSpans(spans);
+    for (int i = 0; i < count; ++i) {
+        if (m_capture) m_capture->append(readDone, spans[i].data, spans[i].size);
+        m_parser.feed(spans[i].data, spans[i].size);
+    }
+    m_buffer.consume(m_buffer.size());
+    return true;
+}
+
+bool BoardSession::startCapture(const std::string &path, std::string *error) {
+    auto capture = std::make_unique<CaptureWriter>();
+    if (!capture->open(path, m_parser.format(), error)) return false;
+    m_capture = std::move(capture);
+    return true;
+}
+
+void BoardSession::stopCapture() {
+    if (!m_capture) return;
+    m_capture->close();
+    m_capture.reset();
+}
+
+void BoardSession::snapshot(BoardSnapshot &out, bool withPitches) const {
+    const UARTParser::Counters &c = m_parser.counters();
+    out.name = m_config.name;
+    out.open = isOpen();
+    out.capturing = m_capture != nullptr;
+    out.format = m_parser.format();
+    out.beats = m_model.numBeats();
+    out.current = m_model.currentBeat();
+    out.revision = m_revision;
+    out.bytes = c.bytes;
+    out.frames = c.frames;
+    out.syncs = c.syncs;
+    out.errors = c.malformed + c.outOfRange + c.crcErrors;
+    out.periodNs = m_clock.periodNs();
+    out.locked = m_clock.locked();
+    out.lastReadNs = m_lastReadNs;
+    if (withPitches) {
+        out.pitches = m_model.pitches();
+    }
+}
+
+std::string BoardSession::stateJson(uint64_t nowNs) const {
+    BoardSnapshot snap;
+    snapshot(snap);
+    return snap.toJson(nowNs);
+}
+
+std::string BoardSnapshot::toJson(uint64_t nowNs) const {
+    // The strings are appended as they are; only the numbers go through buf,
+    // which fits them at their widest
+    char buf[320];
+    std::string out;
+    out.reserve(sizeof(buf) + name.size() + error.size() + beats * 2 + 64);
+
+    std::snprintf(buf, sizeof(buf), "{\"t_ns\":%llu,\"name\":", (unsigned long long)nowNs);
+    out += buf;
+    out += jsonString(name);
+    std::snprintf(buf, sizeof(buf),
+                  ",\"format\":\"%s\",\"open\":%s,\"beats\":%d,\"current\":%d,"
+                  "\"period_ms\":%.3f,\"locked\":%s,\"bytes\":%llu,\"frames\":%llu,\"syncs\":%llu,"
+                  "\"errors\":%llu,\"pitches\":[",
+                  formatName(format), open ? "true" : "false", beats, current, periodNs / 1e6,
+                  locked ? "true" : "false", (unsigned long long)bytes, (unsigned long long)frames,
+                  (unsigned long long)syncs, (unsigned long long)errors);
+    out += buf;
+    for (int i = 0; i < beats; ++i) {
+        if (i) out += ',';
+        out += char('0' + pitches[i]);
+    }
+    out += ']';
+    if (!error.empty()) out += ",\"error\":" + jsonString(error);
+    out += '}';
+    return out;
+}
@@ -0,0 +1,113 @@
+#ifndef BOARD_SESSION_H
+#define BOARD_SESSION_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "beat_clock.h"
+#include "ingest_stats.h"
+#include "ring_buffer.h"
+#include "sequencer_model.h"
+#include "uart_parser.h"
+
+class CaptureWriter;
+class ReplaySource;
+
+// Plain copy of a session's state, for handing to another thread
+struct BoardSnapshot {
+    int id = -1;
+    std::string name;
+    std::string error;      // why the source closed, if it did
+    bool open = false;
+    bool capturing = false;
+    UARTParser::Format format = UARTParser::Format::Framed;
+    int beats = 0;
+    int current = 0;
+    SequencerModel::Pitches pitches;  // packed, 128 bytes
+    uint64_t revision = 0;
+    uint64_t bytes = 0;
+    uint64_t frames = 0;
+    uint64_t syncs = 0;
+    uint64_t errors = 0;
+    uint64_t periodNs = 0;
+    bool locked = false;
+    uint64_t lastReadNs = 0;
+
+    // One-line JSON object
+    std::string toJson(uint64_t nowNs) const;
+};
+
+// Everything one board needs between its byte source and its state, with no
+// UI: ring buffer, decoder, model, beat clock, stats and an optional capture.
+// The session does not wait on its descriptor itself; the owner watches
+// fd() (poll, epoll, a QSocketNotifier) and calls readAvailable() when it is
+// readable, so any number of sessions can share one thread.
+class BoardSession {
+public:
+    struct Config {
+        std::string name;
+        UARTParser::Format format = UARTParser::Format::Framed;
+        int beats = 16;
+        uint64_t periodNs = 4000000000ull;
+    };
+
+    explicit BoardSession(const Config &config);
+    ~BoardSession();
+
+    BoardSession(const BoardSession &) = delete;
+    BoardSession &operator=(const BoardSession &) = delete;
+
+    // Sources. Each replaces the previous one; the descriptor is made
+    // non-blocking.
+    void attach(int fd, bool ownsFd);
+    bool openDevice(const std::string &path, int baud, std::string *error = nullptr);
+    // Format comes from the capture; speed 0 plays as fast as it is read
+    bool openReplay(const std::string &path, double speed, std::string *error = nullptr);
+    void close();
+
+    int fd() const { return m_fd; }
+    bool isOpen() const { return m_fd >= 0; }
+    const std::string &name() const { return m_config.name; }
+
+    // One read and decode. False at end of input or on a read error, after
+    // which the owner should stop watching fd() and close().
+    bool readAvailable();
+
+    // Record everything read from now on
+    bool startCapture(const std::string &path, std::string *error = nullptr);
+    void stopCapture();
+    const CaptureWriter *capture() const { return m_capture.get(); }
+
+    SequencerModel &model() { return m_model; }
+    const SequencerModel &model() const { return m_model; }
+    const UARTParser &parser() const { return m_parser; }
+    IngestStats &stats() { return m_stats; }
+    const BeatClock &clock() const { return m_clock; }
+
+    // Bumped by every model commit that changed something
+    uint64_t revision() const { return m_revision; }
+    uint64_t lastReadNs() const { return m_lastReadNs; }
+
+    // Counters are always copied; the pitches only when `withPitches`
+    void snapshot(BoardSnapshot &out, bool withPitches = true) const;
+    // One-line JSON snapshot of the state and counters
+    std::string stateJson(uint64_t nowNs) const;
+
+private:
+    Config m_config;
+    int m_fd;
+    bool m_ownsFd;
+    std::unique_ptr<ReplaySource> m_replay;
+
+    ByteRingBuffer m_buffer;
+    SequencerModel m_model;
+    UARTParser m_parser;
+    BeatClock m_clock;
+    IngestStats m_stats;
+    std::unique_ptr<CaptureWriter> m_capture;
+
+    uint64_t m_revision;
+    uint64_t m_lastReadNs;
+};
+
+#endif // BOARD_SESSION_H
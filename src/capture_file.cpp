@@ -0,0 +1,246 @@
+#include "capture_file.h"
+#include "monotonic_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+void putVarint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+uint32_t capture::checksum(const uint8_t *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// --- CaptureWriter ---
+
+CaptureWriter::CaptureWriter()
+    : m_fd(-1), m_failed(false), m_chunkRecords(0), m_chunkBase(0),
+      m_lastTimestamp(0), m_bytes(0), m_records(0) {
+    m_chunk.reserve(capture::CHUNK_BYTES + 32);
+}
+
+CaptureWriter::~CaptureWriter() { close(); }
+
+bool CaptureWriter::open(const std::string &path, UARTParser::Format format, std::string *error) {
+    close();
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        if (error) *error = "Failed to open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    capture::FileHeader header{};
+    std::memcpy(header.magic, capture::MAGIC, sizeof(header.magic));
+    header.version = capture::VERSION;
+    header.format = static_cast<uint32_t>(format);
+    header.startNs = monotonicNanos();
+    m_failed = false;
+    m_bytes = m_records = 0;
+    m_chunk.clear();
+    m_chunkRecords = 0;
+    if (!writeAll(&header, sizeof(header))) {
+        if (error) *error = "Failed to write " + path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void CaptureWriter::close() {
+    if (m_fd < 0) return;
+    flush();
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+void CaptureWriter::append(uint64_t timestampNs, const uint8_t *data, size_t len) {
+    if (m_fd < 0 || m_failed || len == 0) return;
+
+    // Varints take at most 10 bytes each
+    if (!m_chunk.empty() && m_chunk.size() + len + 20 > capture::CHUNK_BYTES) flush();
+    if (m_chunkRecords == 0) {
+        m_chunkBase = timestampNs;
+        m_lastTimestamp = timestampNs;
+    }
+
+    putVarint(m_chunk, timestampNs >= m_lastTimestamp ? timestampNs - m_lastTimestamp : 0);
+    putVarint(m_chunk, len);
+    m_chunk.insert(m_chunk.end(), data, data + len);
+    m_lastTimestamp = std::max(m_lastTimestamp, timestampNs);
+    ++m_chunkRecords;
+    ++m_records;
+    m_bytes += len;
+
+    if (m_lastTimestamp - m_chunkBase >= capture::FLUSH_INTERVAL_NS) flush();
+}
+
+bool CaptureWriter::flush() {
+    if (m_fd < 0 || m_failed) return false;
+    if (m_chunkRecords == 0) return true;
+
+    capture::ChunkHeader header{};
+    header.magic = capture::CHUNK_MAGIC;
+    header.payloadBytes = static_cast<uint32_t>(m_chunk.size());
+    header.records = m_chunkRecords;
+    header.checksum = capture::checksum(m_chunk.data(), m_chunk.size());
+    header.baseNs = m_chunkBase;
+
+    bool ok = writeAll(&header, sizeof(header)) && writeAll(m_chunk.data(), m_chunk.size());
+    m_chunk.clear();
+    m_chunkRecords = 0;
+    if (!ok) m_failed = true;
+    return ok;
+}
+
+bool CaptureWriter::writeAll(const void *data, size_t len) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    while (len > 0) {
+        ssize_t n = ::write(m_fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// --- CaptureReader ---
+
+CaptureReader::CaptureReader()
+    : m_base(nullptr), m_size(0), m_format(UARTParser::Format::Raw), m_startNs(0),
+      m_offset(0), m_cursor(nullptr), m_chunkEnd(nullptr), m_chunkRecordsLeft(0),
+      m_timestamp(0), m_truncated(false) {}
+
+CaptureReader::~CaptureReader() { close(); }
+
+bool CaptureReader::open(const std::string &path, std::string *error) {
+    auto fail = [&](const std::string &what) {
+        if (error) *error = what;
+        close();
+        return false;
+    };
+
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return fail("Failed to open " + path + ": " + std::strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(capture::FileHeader))) {
+        ::close(fd);
+        return fail(path + " is not a capture file");
+    }
+    void *mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return fail("Failed to map " + path + ": " + std::strerror(errno));
+    m_base = static_cast<const uint8_t *>(mapping);
+    m_size = static_cast<size_t>(st.st_size);
+    madvise(mapping, m_size, MADV_SEQUENTIAL);
+
+    capture::FileHeader header;
+    std::memcpy(&header, m_base, sizeof(header));
+    if (std::memcmp(header.magic, capture::MAGIC, sizeof(header.magic)) != 0) {
+        return fail(path + " is not a capture file");
+    }
+    if (header.version != capture::VERSION) {
+        return fail(path + ": unsupported capture version " + std::to_string(header.version));
+    }
+    if (header.format > static_cast<uint32_t>(UARTParser::Format::Framed)) {
+        return fail(path + ": unknown input format " + std::to_string(header.format));
+    }
+    m_format = static_cast<UARTParser::Format>(header.format);
+    m_startNs = header.startNs;
+    rewind();
+    return true;
+}
+
+void CaptureReader::close() {
+    if (m_base) munmap(const_cast<uint8_t *>(m_base), m_size);
+    m_base = nullptr;
+    m_size = 0;
+}
+
+void CaptureReader::rewind() {
+    m_offset = sizeof(capture::FileHeader);
+    m_cursor = m_chunkEnd = nullptr;
+    m_chunkRecordsLeft = 0;
+    m_truncated = false;
+}
+
+bool CaptureReader::enterChunk() {
+    if (m_offset == m_size) return false;  // clean end of file
+    if (m_size - m_offset < sizeof(capture::ChunkHeader)) {
+        m_truncated = true;
+        return false;
+    }
+
+    capture::ChunkHeader header;
+    std::memcpy(&header, m_base + m_offset, sizeof(header));
+    const uint8_t *payload = m_base + m_offset + sizeof(header);
+    size_t available = m_size - m_offset - sizeof(header);
+    if (header.magic != capture::CHUNK_MAGIC || header.payloadBytes > available ||
+        capture::checksum(payload, header.payloadBytes) != header.checksum) {
+        m_truncated = true;
+        return false;
+    }
+
+    m_cursor = payload;
+    m_chunkEnd = payload + header.payloadBytes;
+    m_chunkRecordsLeft = header.records;
+    m_timestamp = header.baseNs;
+    m_offset += sizeof(header) + header.payloadBytes;
+    return true;
+}
+
+bool CaptureReader::next(Record &record) {
+    if (!m_base) return false;
+    while (m_chunkRecordsLeft == 0) {
+        if (m_truncated || !enterChunk()) return false;
+    }
+
+    uint64_t delta = 0;
+    uint64_t length = 0;
+    if (!getVarint(m_cursor, m_chunkEnd, delta) || !getVarint(m_cursor, m_chunkEnd, length) ||
+        length > static_cast<uint64_t>(m_chunkEnd - m_cursor)) {
+        m_truncated = true;
+        m_chunkRecordsLeft = 0;
+        return false;
+    }
+
+    m_timestamp += delta;
+    record.timestampNs = m_timestamp;
+    record.data = m_cursor;
+    record.size = static_cast<size_t>(length);
+    m_cursor += length;
+    --m_chunkRecordsLeft;
+    return true;
+}
@@ -0,0 +1,135 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "uart_parser.h"
+
+// Binary capture of raw UART input with arrival timestamps.
+//
+// Layout (little-endian):
+//   file header   "SEQCAP01", u32 version, u32 format, u64 start ns, u64 0
+//   chunk header  u32 'CHNK', u32 payload bytes, u32 records,
+//                 u32 FNV-1a of payload, u64 timestamp of first record
+//   record        varint ns since previous record, varint length, bytes
+//
+// One record is one read() worth of bytes. Chunks are written whole, so a
+// capture cut short by a crash loses at most the chunk being filled.
+namespace capture {
+
+constexpr char MAGIC[8] = {'S', 'E', 'Q', 'C', 'A', 'P', '0', '1'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+constexpr size_t CHUNK_BYTES = 64 * 1024;
+constexpr uint64_t FLUSH_INTERVAL_NS = 1000000000ull; // slow links still hit disk
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;  // UARTParser::Format
+    uint64_t startNs;
+    uint64_t reserved;
+};
+
+struct ChunkHeader {
+    uint32_t magic;
+    uint32_t payloadBytes;
+    uint32_t records;
+    uint32_t checksum;
+    uint64_t baseNs;
+};
+
+static_assert(sizeof(FileHeader) == 32, "capture file header must be packed");
+static_assert(sizeof(ChunkHeader) == 24, "capture chunk header must be packed");
+
+uint32_t checksum(const uint8_t *data, size_t len);
+
+} // namespace capture
+
+class CaptureWriter {
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    // Truncates `path`. Returns false with a message in *error.
+    bool open(const std::string &path, UARTParser::Format format, std::string *error = nullptr);
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+
+    // Buffered; a chunk is written out in one write() once it is full or
+    // older than FLUSH_INTERVAL_NS
+    void append(uint64_t timestampNs, const uint8_t *data, size_t len);
+
+    // Write the partial chunk now
+    bool flush();
+
+    bool failed() const { return m_failed; }
+    uint64_t bytesCaptured() const { return m_bytes; }
+    uint64_t recordsCaptured() const { return m_records; }
+
+private:
+    bool writeAll(const void *data, size_t len);
+
+    int m_fd;
+    bool m_failed;
+    std::vector<uint8_t> m_chunk;
+    uint32_t m_chunkRecords;
+    uint64_t m_chunkBase;
+    uint64_t m_lastTimestamp;
+    uint64_t m_bytes;
+    uint64_t m_records;
+};
+
+// Memory-mapped, zero-copy reader. Records point into the mapping and stay
+// valid until close().
+class CaptureReader {
+public:
+    struct Record {
+        uint64_t timestampNs;
+        const uint8_t *data;
+        size_t size;
+    };
+
+    CaptureReader();
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+
+    bool open(const std::string &path, std::string *error = nullptr);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+
+    UARTParser::Format format() const { return m_format; }
+    uint64_t startNs() const { return m_startNs; }
+    size_t fileSize() const { return m_size; }
+
+    // False at the end of the file or at the first damaged chunk
+    bool next(Record &record);
+    void rewind();
+
+    // Set when reading stopped at a damaged or cut-off chunk
+    bool truncated() const { return m_truncated; }
+
+private:
+    bool enterChunk();
+
+    const uint8_t *m_base;
+    size_t m_size;
+    UARTParser::Format m_format;
+    uint64_t m_startNs;
+
+    size_t m_offset;          // next chunk header
+    const uint8_t *m_cursor;  // inside the current chunk payload
+    const uint8_t *m_chunkEnd;
+    uint32_t m_chunkRecordsLeft;
+    uint64_t m_timestamp;
+    bool m_truncated;
+};
+
+#endif // CAPTURE_FILE_H
@@ -0,0 +1,371 @@
+// Headless ingest daemon: decodes the UART streams of one or many boards into
+// SequencerModels and publishes their state, with the same capture and stats
+// outputs as the GUI but no Qt at all. Boards are serviced by a SessionManager
+// (a few epoll reactor threads); this thread only handles signals and output.
+//
+//   sequencer_daemon --device /dev/ttyUSB1 --capture run.seqcap --state-file /run/seq.json
+//   sequencer_daemon --device /dev/ttyUSB1 --device /dev/ttyUSB2 --threads 2 --state-file /run/seq.json
+//   mock_uart_sender --demo | sequencer_daemon --state-file state.json
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "audio_engine.h"
+#include "board_session.h"
+#include "capture_file.h"
+#include "event_loop.h"
+#include "logger.h"
+#include "monotonic_clock.h"
+#include "session_manager.h"
+
+namespace {
+
+struct DaemonOptions {
+    std::vector<std::string> devices;      // none (and no replays) = stdin
+    int baud = 1000000;
+    std::string format;          // empty = text on stdin, framed on a device
+    std::vector<std::string> replayFiles;
+    double replaySpeed = 1.0;
+    int threads = 1;             // reactor threads; 0 = one per core
+    int beats = 16;
+    double periodSeconds = 4.0;
+    std::string captureFile;
+    std::string statsFile;
+    int statsIntervalMs = 1000;
+    std::string stateFile;
+    int stateIntervalMs = 100;
+    std::string logLevel = "info";
+    std::string logFile;
+    std::string audioOut;        // null or a .wav path; empty = no monitor
+    int audioBlock = 128;
+};
+
+void printUsage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " [options]\n"
+              << "  --device PATH        serial device or pipe to read; repeat for more boards (default: stdin)\n"
+              << "  --baud RATE          serial baud rate (default 1000000)\n"
+              << "  --format F           text, raw or framed (default: text on stdin, framed on a device)\n"
+              << "  --replay FILE        play back a capture file as a board; repeatable\n"
+              << "  --replay-speed N     replay speed multiplier, or 'max' (default 1)\n"
+              << "  --threads N          reactor threads servicing the boards, 0 = one per core (default 1)\n"
+              << "  --beats N            beats per period until the board reports its own (default 16)\n"
+              << "  --period S           nominal period in seconds until SYNC locks the clock (default 4)\n"
+              << "  --capture FILE       record everything read to a capture file (FILE-N per board when several)\n"
+              << "  --stats-file FILE    append pipeline stats as JSON lines\n"
+              << "  --stats-interval MS  interval between stats lines (default 1000)\n"
+              << "  --state-file FILE    keep the current state in FILE: an object, or an array for several boards\n"
+              << "  --state-interval MS  minimum interval between state updates (default 100)\n"
+              << "  --log-level L        trace, debug, info, warn, error (default info)\n"
+              << "  --log-file FILE      write log records to FILE instead of stdout\n"
+              << "  --audio-out OUT      play the first board through the PWM synth into OUT: null or FILE.wav\n"
+              << "  --audio-block N      audio block size in frames at 48 kHz (default 128)\n";
+}
+
+bool parseOptions(int argc, char **argv, DaemonOptions &opts) {
+    enum {
+        OPT_DEVICE = 1000, OPT_BAUD, OPT_FORMAT, OPT_REPLAY, OPT_REPLAY_SPEED, OPT_THREADS, OPT_BEATS,
+        OPT_PERIOD, OPT_CAPTURE, OPT_STATS_FILE, OPT_STATS_INTERVAL, OPT_STATE_FILE,
+        OPT_STATE_INTERVAL, OPT_LOG_LEVEL, OPT_LOG_FILE, OPT_AUDIO_OUT, OPT_AUDIO_BLOCK, OPT_HELP
+    };
+    static const option longOptions[] = {
+        {"device", required_argument, nullptr, OPT_DEVICE},
+        {"baud", required_argument, nullptr, OPT_BAUD},
+        {"format", required_argument, nullptr, OPT_FORMAT},
+        {"replay", required_argument, nullptr, OPT_REPLAY},
+        {"replay-speed", required_argument, nullptr, OPT_REPLAY_SPEED},
+        {"threads", required_argument, nullptr, OPT_THREADS},
+        {"beats", required_argument, nullptr, OPT_BEATS},
+        {"period", required_argument, nullptr, OPT_PERIOD},
+        {"capture", required_argument, nullptr, OPT_CAPTURE},
+        {"stats-file", required_argument, nullptr, OPT_STATS_FILE},
+        {"stats-interval", required_argument, nullptr, OPT_STATS_INTERVAL},
+        {"state-file", required_argument, nullptr, OPT_STATE_FILE},
+        {"state-interval", required_argument, nullptr, OPT_STATE_INTERVAL},
+        {"log-level", required_argument, nullptr, OPT_LOG_LEVEL},
+        {"log-file", required_argument, nullptr, OPT_LOG_FILE},
+        {"audio-out", required_argument, nullptr, OPT_AUDIO_OUT},
+        {"audio-block", required_argument, nullptr, OPT_AUDIO_BLOCK},
+        {"help", no_argument, nullptr, OPT_HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case OPT_DEVICE: opts.devices.push_back(optarg); break;
+        case OPT_BAUD: opts.baud = std::max(1200, std::atoi(optarg)); break;
+        case OPT_FORMAT: opts.format = optarg; break;
+        case OPT_REPLAY: opts.replayFiles.push_back(optarg); break;
+        case OPT_REPLAY_SPEED:
+            if (std::strcmp(optarg, "max") == 0) {
+                opts.replaySpeed = 0.0;
+            } else {
+                opts.replaySpeed = std::atof(optarg);
+                if (opts.replaySpeed <= 0) {
+                    std::cerr << "Invalid replay speed: " << optarg << "\n";
+                    return false;
+                }
+            }
+            break;
+        case OPT_THREADS: opts.threads = std::clamp(std::atoi(optarg), 0, 64); break;
+        case OPT_BEATS: opts.beats = std::clamp(std::atoi(optarg), 1, SequencerModel::MAX_BEATS); break;
+        case OPT_PERIOD:
+            opts.periodSeconds = std::clamp(std::atof(optarg), BeatClock::MIN_PERIOD_NS / 1e9,
+                                            BeatClock::MAX_PERIOD_NS / 1e9);
+            break;
+        case OPT_CAPTURE: opts.captureFile = optarg; break;
+        case OPT_STATS_FILE: opts.statsFile = optarg; break;
+        case OPT_STATS_INTERVAL: opts.statsIntervalMs = std::max(10, std::atoi(optarg)); break;
+        case OPT_STATE_FILE: opts.stateFile = optarg; break;
+        case OPT_STATE_INTERVAL: opts.stateIntervalMs = std::max(1, std::atoi(optarg)); break;
+        case OPT_LOG_LEVEL: opts.logLevel = optarg; break;
+        case OPT_LOG_FILE: opts.logFile = optarg; break;
+        case OPT_AUDIO_OUT: opts.audioOut = optarg; break;
+        case OPT_AUDIO_BLOCK: opts.audioBlock = std::clamp(std::atoi(optarg), 16, 8192); break;
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (optind < argc) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+bool parseFormat(const std::string &name, UARTParser::Format &format) {
+    if (name == "text") format = UARTParser::Format::Text;
+    else if (name == "raw") format = UARTParser::Format::Raw;
+    else if (name == "framed") format = UARTParser::Format::Framed;
+    else return false;
+    return true;
+}
+
+// Readers of the state file never see a partial write
+bool writeFileAtomically(const std::string &path, const std::string &contents) {
+    std::string tmp = path + ".tmp";
+    FILE *f = std::fopen(tmp.c_str(), "w");
+    if (!f) return false;
+    bool ok = std::fwrite(contents.data(), 1, contents.size(), f) == contents.size();
+    ok = (std::fclose(f) == 0) && ok;
+    return ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+// run.seqcap -> run-2.seqcap
+std::string numberedPath(const std::string &path, int n) {
+    size_t slash = path.rfind('/');
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = path.size();
+    return path.substr(0, dot) + "-" + std::to_string(n) + path.substr(dot);
+}
+
+// Tag a stats line with its board: {"board":"name",...}
+std::string boardStatsLine(const std::string &name, const std::string &json) {
+    if (json.empty()) return json;
+    std::string tagged = "{\"board\":\"";
+    for (char c : name) {
+        if (c == '"' || c == '\\') tagged += '\\';
+        tagged += c;
+    }
+    return tagged + "\"," + json.substr(1);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    DaemonOptions opts;
+    if (!parseOptions(argc, argv, opts)) return 1;
+
+    // Signals arrive through the loop; block them before any thread starts
+    EventLoop loop;
+    if (!loop.isValid()) {
+        std::cerr << "Cannot create event loop: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    loop.watchSignals({SIGINT, SIGTERM}, [&loop](int signum) {
+        LOG_INFO_MSG("[Signal] Caught signal {}, shutting down", signum);
+        loop.stop();
+    });
+    std::signal(SIGPIPE, SIG_IGN);
+
+    static const char *const levelNames[] = {"trace", "debug", "info", "warn", "error"};
+    auto level = std::find(std::begin(levelNames), std::end(levelNames), opts.logLevel);
+    if (level == std::end(levelNames)) {
+        std::cerr << "Unknown log level: " << opts.logLevel << "\n";
+        return 1;
+    }
+    Logger::instance().setLevel(static_cast<LogLevel>(level - std::begin(levelNames)));
+    if (!opts.logFile.empty() && !Logger::instance().setOutputFile(opts.logFile)) {
+        std::cerr << "Cannot open log file: " << opts.logFile << "\n";
+        return 1;
+    }
+
+    bool useStdin = opts.devices.empty() && opts.replayFiles.empty();
+    BoardSession::Config config;
+    config.format = useStdin ? UARTParser::Format::Text : UARTParser::Format::Framed;
+    if (!opts.format.empty() && !parseFormat(opts.format, config.format)) {
+        std::cerr << "Unknown format: " << opts.format << " (text, raw or framed)\n";
+        return 1;
+    }
+    config.beats = opts.beats;
+    config.periodNs = static_cast<uint64_t>(opts.periodSeconds * 1e9);
+
+    SessionManager boards(opts.threads);
+    std::string error;
+    auto added = [&](int id) {
+        if (id < 0) std::cerr << error << "\n";
+        return id >= 0;
+    };
+    for (const std::string &device : opts.devices) {
+        config.name = device;
+        if (!added(boards.addDevice(config, device, opts.baud, &error))) return 1;
+    }
+    for (const std::string &replay : opts.replayFiles) {
+        config.name = replay;
+        if (!added(boards.addReplay(config, replay, opts.replaySpeed, &error))) return 1;
+    }
+    if (useStdin) {
+        config.name = "stdin";
+        boards.addFd(config, STDIN_FILENO, false);
+    }
+
+    std::vector<int> ids = boards.boardIds();
+    if (!opts.captureFile.empty()) {
+        for (size_t i = 0; i < ids.size(); ++i) {
+            std::string path = ids.size() == 1 ? opts.captureFile : numberedPath(opts.captureFile, int(i) + 1);
+            if (!boards.startCapture(ids[i], path, &error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+        }
+    }
+
+    FILE *statsFile = nullptr;
+    auto writeStats = [&]() {
+        uint64_t now = monotonicNanos();
+        BoardSnapshot snap;
+        for (int id : ids) {
+            std::string line = boards.statsJson(id, now);
+            if (line.empty() || !boards.snapshot(id, snap)) continue;
+            if (ids.size() > 1) line = boardStatsLine(snap.name, line);
+            line += '\n';
+            std::fwrite(line.data(), 1, line.size(), statsFile);
+        }
+        std::fflush(statsFile);
+    };
+    if (!opts.statsFile.empty()) {
+        statsFile = std::fopen(opts.statsFile.c_str(), "a");
+        if (!statsFile) {
+            std::cerr << "Cannot open stats file: " << opts.statsFile << "\n";
+            return 1;
+        }
+        loop.addTimer(uint64_t(opts.statsIntervalMs) * 1000000, writeStats);
+    }
+
+    // State is rewritten at most once per interval, and only after a change
+    std::vector<uint64_t> publishedRevisions;
+    auto publishState = [&]() {
+        if (opts.stateFile.empty()) return;
+        std::vector<BoardSnapshot> snaps = boards.snapshots();
+        std::vector<uint64_t> revisions;
+        for (const BoardSnapshot &snap : snaps) revisions.push_back(snap.revision * 2 + snap.open);
+        if (revisions == publishedRevisions) return;
+        publishedRevisions = std::move(revisions);
+
+        uint64_t now = monotonicNanos();
+        std::string json = snaps.size() == 1 ? snaps[0].toJson(now) : "[";
+        if (snaps.size() != 1) {
+            for (size_t i = 0; i < snaps.size(); ++i) {
+                if (i) json += ',';
+                json += snaps[i].toJson(now);
+            }
+            json += ']';
+        }
+        json += '\n';
+        if (!writeFileAtomically(opts.stateFile, json)) {
+            LOG_WARN_MSG("[State] Cannot write {}", opts.stateFile);
+        }
+    };
+    if (!opts.stateFile.empty()) {
+        publishState();
+        loop.addTimer(uint64_t(opts.stateIntervalMs) * 1000000, publishState);
+    }
+
+    // Monitor: the first board through a software copy of the board's voice
+    std::unique_ptr<AudioEngine> audio;
+    if (!opts.audioOut.empty()) {
+        std::unique_ptr<AudioSink> sink;
+        if (opts.audioOut == "null") sink = std::make_unique<NullAudioSink>();
+        else sink = std::make_unique<WavFileSink>(opts.audioOut);
+        AudioEngine::Config audioConfig;
+        audioConfig.blockFrames = opts.audioBlock;
+        audio = std::make_unique<AudioEngine>(std::move(sink), audioConfig);
+        int monitored = ids.front();
+        boards.onBoardChanged = [&audio, monitored](const BoardSnapshot &snap) {
+            if (snap.id != monitored) return;
+            SynthPattern pattern;
+            pattern.pitches = snap.pitches;
+            pattern.beats = snap.beats;
+            pattern.periodNs = snap.periodNs;
+            pattern.syncSerial = snap.syncs;
+            audio->setPattern(pattern);
+        };
+        if (!audio->start(&error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        LOG_INFO_MSG("[Audio] Monitoring {} into {} ({} ms blocks{})", boards.snapshots().front().name,
+                     opts.audioOut, audio->latencyNs() / 1e6,
+                     audio->realTimePriority() ? ", SCHED_FIFO" : "");
+    }
+
+    // Exit once every source has ended
+    boards.onBoardClosed = [&](int) {
+        loop.post([&]() {
+            if (boards.openBoardCount() == 0) loop.stop();
+        });
+    };
+
+    LOG_INFO_MSG("=== FPGA Sequencer daemon ===");
+    LOG_INFO_MSG("Reading {} board(s) on {} reactor thread(s) ({} beats, {}s period)", ids.size(),
+                 boards.threadCount(), opts.beats, opts.periodSeconds);
+
+    bool ok = boards.start();
+    if (!ok) {
+        LOG_ERROR_MSG("[Ingest] Cannot start reactors: {}", std::strerror(errno));
+    } else {
+        ok = loop.run();
+        if (!ok) LOG_ERROR_MSG("[Ingest] Event loop failed: {}", std::strerror(errno));
+    }
+    // Closes whatever is still open, captures included
+    boards.stop();
+    if (audio) {
+        audio->stop();
+        LOG_INFO_MSG("[Audio] {} blocks, {} late, max render {} us{}", audio->blocks(),
+                     audio->lateBlocks(), audio->maxRenderNs() / 1e3,
+                     audio->sinkFailed() ? " (sink write error)" : "");
+    }
+
+    publishState();
+    BoardSnapshot snap;
+    for (int id : ids) {
+        if (!boards.snapshot(id, snap)) continue;
+        LOG_INFO_MSG("[Ingest] {}: {} bytes, {} frames, {} syncs, {} errors", snap.name, snap.bytes,
+                     snap.frames, snap.syncs, snap.errors);
+    }
+    if (statsFile) {
+        writeStats();
+        std::fclose(statsFile);
+    }
+    Logger::instance().shutdown();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#include "deadline_timer.h"
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// std::chrono::steady_clock is CLOCK_MONOTONIC on Linux, so monotonicNanos()
+// values can be used directly as absolute deadlines.
+DeadlineTimer::DeadlineTimer()
+    : m_fd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) {}
+
+DeadlineTimer::~DeadlineTimer() {
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+bool DeadlineTimer::arm(uint64_t deadlineNs) {
+    if (m_fd < 0) return false;
+    if (deadlineNs == 0) deadlineNs = 1;  // all-zero would disarm
+    itimerspec spec = {};
+    spec.it_value.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ull);
+    spec.it_value.tv_nsec = static_cast<long>(deadlineNs % 1000000000ull);
+    return timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+}
+
+void DeadlineTimer::disarm() {
+    if (m_fd < 0) return;
+    itimerspec spec = {};
+    timerfd_settime(m_fd, 0, &spec, nullptr);
+}
+
+uint64_t DeadlineTimer::acknowledge() {
+    uint64_t expirations = 0;
+    if (m_fd < 0 || ::read(m_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return 0;
+    return expirations;
+}
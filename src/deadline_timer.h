@@ -0,0 +1,33 @@
+#ifndef DEADLINE_TIMER_H
+#define DEADLINE_TIMER_H
+
+#include <cstdint>
+
+// One-shot timer with an absolute nanosecond deadline on the monotonic clock
+// (the base of monotonicNanos()), exposed as a file descriptor so it can be
+// watched by poll() or a QSocketNotifier. Unlike a millisecond QTimer
+// interval, the deadline does not accumulate rounding from one beat to the
+// next.
+class DeadlineTimer {
+public:
+    DeadlineTimer();
+    ~DeadlineTimer();
+
+    DeadlineTimer(const DeadlineTimer &) = delete;
+    DeadlineTimer &operator=(const DeadlineTimer &) = delete;
+
+    bool isValid() const { return m_fd >= 0; }
+    int fd() const { return m_fd; }
+
+    // Fire once at `deadlineNs`; a deadline in the past fires immediately
+    bool arm(uint64_t deadlineNs);
+    void disarm();
+
+    // Clear the readable state after firing; returns the expiration count
+    uint64_t acknowledge();
+
+private:
+    int m_fd;
+};
+
+#endif // DEADLINE_TIMER_H
@@ -0,0 +1,172 @@
+#include "event_loop.h"
+#include "deadline_timer.h"
+#include "monotonic_clock.h"
+#include <cerrno>
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+namespace {
+
+// epoll user data: generation in the high half, descriptor in the low half
+uint64_t pack(int fd, uint32_t generation) {
+    return (uint64_t(generation) << 32) | uint32_t(fd);
+}
+
+} // namespace
+
+EventLoop::EventLoop()
+    : m_epollFd(epoll_create1(EPOLL_CLOEXEC)),
+      m_wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      m_signalFd(-1), m_stopRequested(false), m_generation(0), m_nextTimerId(1) {
+    if (m_epollFd >= 0 && m_wakeFd >= 0) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = pack(m_wakeFd, 0);
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+    }
+}
+
+EventLoop::~EventLoop() {
+    m_timers.clear();
+    if (m_signalFd >= 0) ::close(m_signalFd);
+    if (m_wakeFd >= 0) ::close(m_wakeFd);
+    if (m_epollFd >= 0) ::close(m_epollFd);
+}
+
+bool EventLoop::addFd(int fd, uint32_t events, FdCallback callback) {
+    if (fd < 0 || m_handlers.count(fd)) return false;
+    uint32_t generation = ++m_generation;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = pack(fd, generation);
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) return false;
+    m_handlers[fd] = {generation, std::make_shared<FdCallback>(std::move(callback))};
+    return true;
+}
+
+bool EventLoop::modifyFd(int fd, uint32_t events) {
+    auto it = m_handlers.find(fd);
+    if (it == m_handlers.end()) return false;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = pack(fd, it->second.generation);
+    return epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::removeFd(int fd) {
+    if (m_handlers.erase(fd) == 0) return;
+    // Fails harmlessly if the descriptor was already closed
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EventLoop::addTimer(uint64_t intervalNs, std::function<void()> callback) {
+    if (intervalNs == 0) return -1;
+    auto timer = std::make_unique<DeadlineTimer>();
+    if (!timer->isValid()) return -1;
+
+    int id = m_nextTimerId++;
+    int fd = timer->fd();
+    uint64_t next = monotonicNanos() + intervalNs;
+    if (!timer->arm(next) || !addFd(fd, EPOLLIN, [this, id](uint32_t) { fireTimer(id); })) return -1;
+    m_timers[id] = {std::move(timer), intervalNs, next, std::move(callback)};
+    return id;
+}
+
+void EventLoop::removeTimer(int id) {
+    auto it = m_timers.find(id);
+    if (it == m_timers.end()) return;
+    removeFd(it->second.timer->fd());
+    m_timers.erase(it);
+}
+
+void EventLoop::fireTimer(int id) {
+    auto it = m_timers.find(id);
+    if (it == m_timers.end()) return;
+    Timer &t = it->second;
+    t.timer->acknowledge();
+
+    // Next deadline on the original grid, skipping any we slept through
+    uint64_t now = monotonicNanos();
+    t.nextNs += t.intervalNs;
+    if (t.nextNs <= now) t.nextNs += ((now - t.nextNs) / t.intervalNs + 1) * t.intervalNs;
+    t.timer->arm(t.nextNs);
+
+    // The callback may remove this timer, so it must not be used afterwards
+    auto callback = t.callback;
+    callback();
+}
+
+bool EventLoop::watchSignals(std::initializer_list<int> signals, std::function<void(int)> callback) {
+    if (m_signalFd >= 0) return false;
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int sig : signals) sigaddset(&mask, sig);
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) != 0) return false;
+
+    m_signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (m_signalFd < 0) return false;
+    return addFd(m_signalFd, EPOLLIN, [this, callback = std::move(callback)](uint32_t) {
+        signalfd_siginfo info;
+        while (::read(m_signalFd, &info, sizeof(info)) == ssize_t(sizeof(info))) {
+            callback(int(info.ssi_signo));
+        }
+    });
+}
+
+bool EventLoop::run() {
+    constexpr int MAX_EVENTS = 64;
+    epoll_event events[MAX_EVENTS];
+    while (!m_stopRequested) {
+        int n = epoll_wait(m_epollFd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        for (int i = 0; i < n && !m_stopRequested; ++i) {
+            int fd = int(uint32_t(events[i].data.u64));
+            uint32_t generation = uint32_t(events[i].data.u64 >> 32);
+            if (fd == m_wakeFd) {
+                uint64_t value;
+                while (::read(m_wakeFd, &value, sizeof(value)) > 0) {}
+                runPosted();
+                continue;
+            }
+            // Removed (or removed and reused) by an earlier handler in this batch
+            auto it = m_handlers.find(fd);
+            if (it == m_handlers.end() || it->second.generation != generation) continue;
+            auto callback = it->second.callback;
+            (*callback)(events[i].events);
+        }
+    }
+    m_stopRequested = false;
+    return true;
+}
+
+void EventLoop::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_postMutex);
+        m_posted.push_back(std::move(task));
+    }
+    uint64_t one = 1;
+    ssize_t ignored = ::write(m_wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void EventLoop::runPosted() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_postMutex);
+        tasks.swap(m_posted);
+    }
+    for (auto &task : tasks) task();
+}
+
+void EventLoop::stop() {
+    m_stopRequested = true;
+    uint64_t one = 1;
+    ssize_t ignored = ::write(m_wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
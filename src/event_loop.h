@@ -0,0 +1,87 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class DeadlineTimer;
+
+// Single-threaded epoll reactor for the headless tools. Descriptors, periodic
+// timers (timerfd) and signals (signalfd) are all dispatched to callbacks on
+// the thread that calls run(), so no callback needs locking. Handlers may add
+// or remove descriptors, including their own, while being dispatched. Other
+// threads hand work to the loop with post().
+class EventLoop {
+public:
+    using FdCallback = std::function<void(uint32_t events)>;  // EPOLLIN, EPOLLHUP...
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    bool isValid() const { return m_epollFd >= 0 && m_wakeFd >= 0; }
+
+    // Level-triggered; `events` is a mask of EPOLLIN/EPOLLOUT
+    bool addFd(int fd, uint32_t events, FdCallback callback);
+    bool modifyFd(int fd, uint32_t events);
+    void removeFd(int fd);
+    size_t fdCount() const { return m_handlers.size(); }
+
+    // Fires every `intervalNs` on the monotonic clock without accumulating
+    // drift; missed expirations are coalesced. Returns an id for
+    // removeTimer(), or -1.
+    int addTimer(uint64_t intervalNs, std::function<void()> callback);
+    void removeTimer(int id);
+
+    // Blocks the given signals and delivers them through the loop instead of
+    // an async handler. Call before starting any other thread so they
+    // inherit the mask.
+    bool watchSignals(std::initializer_list<int> signals, std::function<void(int)> callback);
+
+    // Run `task` on the loop thread at its next wakeup. Safe from any thread;
+    // tasks run in the order posted.
+    void post(std::function<void()> task);
+
+    // Dispatch until stop(), which may come before run(). Returns false if
+    // epoll_wait failed.
+    bool run();
+    // Safe from any thread and from a signal handler
+    void stop();
+
+private:
+    struct Handler {
+        uint32_t generation;
+        std::shared_ptr<FdCallback> callback;  // kept alive while it runs
+    };
+    struct Timer {
+        std::unique_ptr<DeadlineTimer> timer;
+        uint64_t intervalNs;
+        uint64_t nextNs;
+        std::function<void()> callback;
+    };
+
+    void fireTimer(int id);
+    void runPosted();
+
+    int m_epollFd;
+    int m_wakeFd;    // eventfd written by stop() and post()
+    int m_signalFd;
+    std::atomic<bool> m_stopRequested;
+    uint32_t m_generation;  // tells a reused descriptor from a removed one
+    std::unordered_map<int, Handler> m_handlers;
+    std::unordered_map<int, Timer> m_timers;
+    int m_nextTimerId;
+
+    std::mutex m_postMutex;
+    std::vector<std::function<void()>> m_posted;
+};
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,45 @@
+#include "ingest_stats.h"
+#include "monotonic_clock.h"
+#include <cstdio>
+
+const char *IngestStats::stageName(Stage stage) {
+    switch (stage) {
+    case STAGE_READ: return "read";
+    case STAGE_DECODE: return "decode";
+    case STAGE_MODEL: return "model";
+    case STAGE_GRID_PAINT: return "grid_paint";
+    case STAGE_GRAPH_PAINT: return "graph_paint";
+    default: return "unknown";
+    }
+}
+
+void IngestStats::recordSince(Stage stage, uint64_t sourceTimestampNs) {
+    if (sourceTimestampNs == 0) return;
+    uint64_t now = monotonicNanos();
+    record(stage, now > sourceTimestampNs ? now - sourceTimestampNs : 0);
+}
+
+std::string IngestStats::toJsonLine(uint64_t timestampNs) const {
+    char buf[256];
+    std::string out;
+    out.reserve(160 + NUM_STAGES * 96);
+
+    std::snprintf(buf, sizeof(buf),
+                  "{\"t_ns\":%llu,\"bytes\":%llu,\"frames\":%llu,\"errors\":%llu,\"drops\":%llu,\"stages\":{",
+                  (unsigned long long)timestampNs, (unsigned long long)bytes(),
+                  (unsigned long long)frames(), (unsigned long long)errors(),
+                  (unsigned long long)drops());
+    out += buf;
+
+    for (int i = 0; i < NUM_STAGES; ++i) {
+        const LatencyHistogram &h = m_stages[i];
+        std::snprintf(buf, sizeof(buf),
+                      "%s\"%s\":{\"count\":%llu,\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+                      i ? "," : "", stageName(static_cast<Stage>(i)),
+                      (unsigned long long)h.count(), h.percentile(0.50) / 1e3,
+                      h.percentile(0.99) / 1e3, h.max() / 1e3);
+        out += buf;
+    }
+    out += "}}";
+    return out;
+}
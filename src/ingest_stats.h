@@ -0,0 +1,54 @@
+#ifndef INGEST_STATS_H
+#define INGEST_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "latency_histogram.h"
+
+// Pipeline observability shared by the ingest, model and paint stages.
+// Latencies are measured from the moment the read syscall returned the bytes
+// (the source timestamp, monotonicNanos()), so each stage reports the
+// end-to-end delay up to that point rather than its own duration. The read
+// stage is the exception: it is the duration of the syscall itself.
+class IngestStats {
+public:
+    enum Stage {
+        STAGE_READ,        // read()/readv() duration
+        STAGE_DECODE,      // frame decoded by UARTParser
+        STAGE_MODEL,       // SequencerModel transaction committed
+        STAGE_GRID_PAINT,  // BeatGridWidget finished painting the change
+        STAGE_GRAPH_PAINT, // PitchGraphCanvas finished painting the change
+        NUM_STAGES
+    };
+
+    static const char *stageName(Stage stage);
+
+    void record(Stage stage, uint64_t ns) { m_stages[stage].record(ns); }
+    // Latency from a source timestamp to now; ignored when unknown (0)
+    void recordSince(Stage stage, uint64_t sourceTimestampNs);
+    const LatencyHistogram &stage(Stage stage) const { return m_stages[stage]; }
+
+    void addBytes(uint64_t n) { m_bytes.fetch_add(n, std::memory_order_relaxed); }
+    void addFrames(uint64_t n) { m_frames.fetch_add(n, std::memory_order_relaxed); }
+    void addErrors(uint64_t n) { m_errors.fetch_add(n, std::memory_order_relaxed); }
+    void addDrops(uint64_t n) { m_drops.fetch_add(n, std::memory_order_relaxed); }
+
+    uint64_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+    uint64_t frames() const { return m_frames.load(std::memory_order_relaxed); }
+    uint64_t errors() const { return m_errors.load(std::memory_order_relaxed); }
+    uint64_t drops() const { return m_drops.load(std::memory_order_relaxed); }
+
+    // One JSON object (no trailing newline) with counters and per-stage
+    // count/p50/p99/max in microseconds
+    std::string toJsonLine(uint64_t timestampNs) const;
+
+private:
+    LatencyHistogram m_stages[NUM_STAGES];
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_errors{0};
+    std::atomic<uint64_t> m_drops{0};
+};
+
+#endif // INGEST_STATS_H
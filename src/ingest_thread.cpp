@@ -0,0 +1,113 @@
+#include "ingest_thread.h"
+#include "monotonic_clock.h"
+#include "ingest_stats.h"
+#include "capture_file.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+IngestThread::IngestThread(int fd, UARTParser::Format format, bool ownsFd, IngestStats *stats)
+    : m_fd(fd), m_ownsFd(ownsFd), m_format(format), m_wakePipe{-1, -1}, m_stats(stats),
+      m_parser(nullptr, format), m_readTimestamp(0), m_capture(nullptr) {
+    m_parser.setStats(stats);
+    m_parser.onBeatReceived = [this](int beat, int pitch) {
+        publish({IngestEvent::Kind::Pitch, uint8_t(beat), uint8_t(pitch), m_readTimestamp});
+    };
+    m_parser.onCurrentBeat = [this](int beat) {
+        publish({IngestEvent::Kind::CurrentBeat, uint8_t(beat), 0, m_readTimestamp});
+    };
+    m_parser.onSync = [this]() {
+        publish({IngestEvent::Kind::Sync, 0, 0, m_readTimestamp});
+    };
+    m_parser.onBeatCount = [this](int beats) {
+        publish({IngestEvent::Kind::BeatCount, uint8_t(beats), 0, m_readTimestamp});
+    };
+}
+
+IngestThread::~IngestThread() {
+    stop();
+    if (m_ownsFd && m_fd >= 0) ::close(m_fd);
+}
+
+bool IngestThread::start() {
+    if (m_thread.joinable()) return true;
+    if (pipe(m_wakePipe) != 0) return false;
+    fcntl(m_wakePipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(m_wakePipe[1], F_SETFD, FD_CLOEXEC);
+    m_finished.store(false, std::memory_order_release);
+    m_thread = std::thread(&IngestThread::run, this);
+    return true;
+}
+
+void IngestThread::stop() {
+    if (!m_thread.joinable()) return;
+    char wake = 1;
+    (void)!write(m_wakePipe[1], &wake, 1);
+    m_thread.join();
+    ::close(m_wakePipe[0]);
+    ::close(m_wakePipe[1]);
+    m_wakePipe[0] = m_wakePipe[1] = -1;
+}
+
+void IngestThread::setCapture(CaptureWriter *capture) {
+    std::lock_guard<std::mutex> lock(m_captureMutex);
+    m_capture = capture;
+    m_capturing.store(capture != nullptr, std::memory_order_relaxed);
+}
+
+void IngestThread::run() {
+    pollfd fds[2] = {
+        {m_fd, POLLIN, 0},
+        {m_wakePipe[0], POLLIN, 0},
+    };
+
+    for (;;) {
+        int ready = poll(fds, 2, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break; // stop() requested
+
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            uint64_t before = monotonicNanos();
+            ssize_t n = m_buffer.readFrom(m_fd);
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+            if (n <= 0) break; // EOF or device gone
+
+            m_readTimestamp = monotonicNanos();
+            m_parser.setSourceTimestamp(m_readTimestamp);
+            if (m_stats) {
+                m_stats->record(IngestStats::STAGE_READ, m_readTimestamp - before);
+                m_stats->addBytes(static_cast<uint64_t>(n));
+            }
+            ByteRingBuffer::ConstSpan spans[2];
+            int count = m_buffer.readableSpans(spans);
+            if (m_capturing.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(m_captureMutex);
+                for (int i = 0; m_capture && i < count; ++i) {
+                    m_capture->append(m_readTimestamp, spans[i].data, spans[i].size);
+                }
+            }
+            for (int i = 0; i < count; ++i) {
+                m_parser.feed(spans[i].data, spans[i].size);
+            }
+            m_buffer.consume(m_buffer.size());
+
+            m_bytesRead.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            m_malformed.store(m_parser.counters().malformed + m_parser.counters().outOfRange,
+                              std::memory_order_relaxed);
+        }
+    }
+    m_finished.store(true, std::memory_order_release);
+}
+
+void IngestThread::publish(const IngestEvent &event) {
+    if (m_queue.tryPush(event)) {
+        m_eventsQueued.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        if (m_stats) m_stats->addDrops(1);
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef INGEST_THREAD_H
+#define INGEST_THREAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "ring_buffer.h"
+#include "spsc_queue.h"
+#include "uart_parser.h"
+
+class IngestStats;
+class CaptureWriter;
+
+// Decoded update handed from the I/O thread to the GUI thread
+struct IngestEvent {
+    enum class Kind : uint8_t { Pitch, CurrentBeat, Sync, BeatCount };
+    Kind kind;
+    uint8_t beat;   // BeatCount: the board's beat count, 0 meaning 256
+    uint8_t pitch;
+    uint64_t timestampNs; // monotonicNanos() when the bytes were read
+};
+
+// Reads and decodes one file descriptor on a dedicated thread and publishes
+// the results through a lock-free SPSC queue. The GUI drains the queue once
+// per frame, so a slow repaint no longer delays draining the device. When the
+// queue is full, events are dropped and counted rather than blocking the
+// reader.
+class IngestThread {
+public:
+    using EventQueue = SpscQueue<IngestEvent, 4096>;
+
+    // `stats` is optional and must outlive the thread
+    IngestThread(int fd, UARTParser::Format format, bool ownsFd, IngestStats *stats = nullptr);
+    ~IngestThread();
+
+    IngestThread(const IngestThread &) = delete;
+    IngestThread &operator=(const IngestThread &) = delete;
+
+    bool start();
+    void stop();
+
+    UARTParser::Format format() const { return m_format; }
+
+    // Record every read into `capture` (nullptr to stop). Safe while running;
+    // once this returns the thread no longer touches the previous writer.
+    void setCapture(CaptureWriter *capture);
+
+    // GUI thread only
+    bool tryPop(IngestEvent &event) { return m_queue.tryPop(event); }
+
+    uint64_t bytesRead() const { return m_bytesRead.load(std::memory_order_relaxed); }
+    uint64_t eventsQueued() const { return m_eventsQueued.load(std::memory_order_relaxed); }
+    uint64_t droppedEvents() const { return m_droppedEvents.load(std::memory_order_relaxed); }
+    uint64_t malformedFrames() const { return m_malformed.load(std::memory_order_relaxed); }
+    bool finished() const { return m_finished.load(std::memory_order_acquire); }
+
+private:
+    void run();
+    void publish(const IngestEvent &event);
+
+    int m_fd;
+    bool m_ownsFd;
+    UARTParser::Format m_format;
+    int m_wakePipe[2];
+    IngestStats *m_stats;
+    std::thread m_thread;
+
+    // Touched only by the I/O thread
+    ByteRingBuffer m_buffer;
+    UARTParser m_parser;
+    uint64_t m_readTimestamp;
+
+    EventQueue m_queue;
+
+    std::mutex m_captureMutex;  // held per read, never per byte
+    CaptureWriter *m_capture;
+    std::atomic<bool> m_capturing{false};
+
+    std::atomic<uint64_t> m_bytesRead{0};
+    std::atomic<uint64_t> m_eventsQueued{0};
+    std::atomic<uint64_t> m_droppedEvents{0};
+    std::atomic<uint64_t> m_malformed{0};
+    std::atomic<bool> m_finished{false};
+};
+
+#endif // INGEST_THREAD_H
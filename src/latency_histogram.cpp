@@ -0,0 +1,60 @@
+#include "latency_histogram.h"
+#include <cmath>
+
+int LatencyHistogram::bucketIndex(uint64_t ns) {
+    if (ns < SUB_BUCKETS) return static_cast<int>(ns);
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - SUB_BUCKET_BITS;
+    int sub = static_cast<int>((ns >> shift) & (SUB_BUCKETS - 1));
+    return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) return static_cast<uint64_t>(index);
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS);
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    m_buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t prev = m_max.load(std::memory_order_relaxed);
+    while (ns > prev && !m_max.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto &bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const {
+    // Sum the buckets rather than trusting m_count, which may be ahead of
+    // them while another thread is recording
+    uint64_t total = 0;
+    for (const auto &bucket : m_buckets) total += bucket.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * total));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t bound = bucketUpperBound(i);
+            uint64_t mx = max();
+            return (mx != 0 && bound > mx) ? mx : bound;
+        }
+    }
+    return max();
+}
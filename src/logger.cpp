@@ -0,0 +1,206 @@
+#include "logger.h"
+#include "monotonic_clock.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(5);
+constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+
+const char *levelTag(int level) {
+    switch (level) {
+    case LOG_TRACE: return "TRACE";
+    case LOG_DEBUG: return "DEBUG";
+    case LOG_INFO: return "INFO ";
+    case LOG_WARN: return "WARN ";
+    case LOG_ERROR: return "ERROR";
+    default: return "?    ";
+    }
+}
+
+} // namespace
+
+Logger &Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : m_level(LOG_INFO), m_startNs(monotonicNanos()), m_out(stdout) {
+    m_writer = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    shutdown();
+    if (m_out && m_out != stdout && m_out != stderr) std::fclose(m_out);
+}
+
+bool Logger::setOutputFile(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "a");
+    if (!file) return false;
+    // Flush what was queued for the old sink first
+    std::lock_guard<std::mutex> lock(m_outMutex);
+    std::FILE *old = m_out;
+    if (old) std::fflush(old);
+    m_out = file;
+    if (old && old != stdout && old != stderr) std::fclose(old);
+    return true;
+}
+
+void Logger::shutdown() {
+    if (!m_running.exchange(false)) return;
+    if (m_writer.joinable()) m_writer.join();
+    drain();
+}
+
+void Logger::begin(LogRecord &record, LogLevel level, const char *format) {
+    record.timestampNs = monotonicNanos();
+    record.format = format;
+    record.level = static_cast<uint8_t>(level);
+    record.argCount = 0;
+    record.blobUsed = 0;
+}
+
+void Logger::encodeBlob(LogRecord &record, LogRecord::ArgType type, const char *data, size_t len) {
+    uint8_t index = record.argCount++;
+    size_t room = LogRecord::BLOB_SIZE - record.blobUsed;
+    bool truncated = len > room;
+    if (truncated) {
+        len = room;
+        instance().m_truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::memcpy(record.blob + record.blobUsed, data, len);
+    record.types[index] = type;
+    record.values[index].blob.offset = record.blobUsed;
+    record.values[index].blob.length = static_cast<uint8_t>(len);
+    record.values[index].blob.truncated = truncated;
+    record.blobUsed += static_cast<uint8_t>(len);
+}
+
+void Logger::logHex(LogLevel level, const char *format, const uint8_t *data, size_t len) {
+    // Long dumps are split into one record per blob-sized chunk
+    for (size_t pos = 0; pos < len; pos += LogRecord::BLOB_SIZE) {
+        LogRecord record;
+        begin(record, level, format);
+        encodeBlob(record, LogRecord::ARG_HEX, reinterpret_cast<const char *>(data + pos),
+                   std::min<size_t>(LogRecord::BLOB_SIZE, len - pos));
+        submit(record);
+    }
+}
+
+void Logger::submit(const LogRecord &record) {
+    if (!localBuffer().queue.tryPush(record)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+Logger::ThreadBuffer &Logger::localBuffer() {
+    // The registry keeps the buffer alive after its thread exits so the
+    // writer can still drain it.
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [this] {
+        auto created = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        m_buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+void Logger::run() {
+    while (m_running.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(DRAIN_INTERVAL);
+        drain();
+    }
+}
+
+void Logger::drain() {
+    // Copy the list, so a thread's first record never waits on the writing
+    {
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        m_draining = m_buffers;
+    }
+    LogRecord record;
+    for (auto &buffer : m_draining) {
+        while (buffer->queue.tryPop(record)) m_pending.push_back(record);
+    }
+    m_draining.clear();
+
+    // A buffer held only by the registry belongs to a thread that has
+    // exited; nothing can push to it any more, so once empty it goes
+    {
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(),
+                                       [](const std::shared_ptr<ThreadBuffer> &buffer) {
+                                           if (buffer.use_count() != 1) return false;
+                                           std::atomic_thread_fence(std::memory_order_acquire);
+                                           return buffer->queue.sizeApprox() == 0;
+                                       }),
+                        m_buffers.end());
+    }
+
+    std::lock_guard<std::mutex> lock(m_outMutex);
+    if (m_pending.empty() || !m_out) {
+        m_pending.clear();
+        return;
+    }
+
+    // Interleave threads in timestamp order
+    std::stable_sort(m_pending.begin(), m_pending.end(),
+                     [](const LogRecord &a, const LogRecord &b) { return a.timestampNs < b.timestampNs; });
+    for (const LogRecord &pending : m_pending) {
+        format(pending, m_line);
+        std::fwrite(m_line.data(), 1, m_line.size(), m_out);
+    }
+    std::fflush(m_out);
+    m_pending.clear();
+}
+
+void Logger::format(const LogRecord &record, std::string &out) const {
+    out.clear();
+    char stamp[32];
+    uint64_t elapsed = record.timestampNs > m_startNs ? record.timestampNs - m_startNs : 0;
+    int n = std::snprintf(stamp, sizeof(stamp), "%10.6f %s ", elapsed / 1e9, levelTag(record.level));
+    out.append(stamp, n);
+
+    int arg = 0;
+    for (const char *p = record.format; *p; ++p) {
+        if (p[0] != '{' || p[1] != '}') {
+            out.push_back(*p);
+            continue;
+        }
+        ++p;
+        if (arg >= record.argCount) continue;
+
+        const LogRecord::Value &value = record.values[arg];
+        char number[32];
+        switch (record.types[arg]) {
+        case LogRecord::ARG_INT:
+            out.append(number, std::snprintf(number, sizeof(number), "%lld",
+                                             static_cast<long long>(value.i)));
+            break;
+        case LogRecord::ARG_UINT:
+            out.append(number, std::snprintf(number, sizeof(number), "%llu",
+                                             static_cast<unsigned long long>(value.u)));
+            break;
+        case LogRecord::ARG_DOUBLE:
+            out.append(number, std::snprintf(number, sizeof(number), "%g", value.d));
+            break;
+        case LogRecord::ARG_STR:
+            out.append(record.blob + value.blob.offset, value.blob.length);
+            if (value.blob.truncated) out.append("…");
+            break;
+        case LogRecord::ARG_HEX:
+            for (int i = 0; i < value.blob.length; ++i) {
+                uint8_t byte = static_cast<uint8_t>(record.blob[value.blob.offset + i]);
+                if (i > 0) out.push_back(' ');
+                out.push_back(HEX_DIGITS[byte >> 4]);
+                out.push_back(HEX_DIGITS[byte & 0x0F]);
+            }
+            break;
+        }
+        ++arg;
+    }
+    out.push_back('\n');
+}
@@ -0,0 +1,179 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "spsc_queue.h"
+
+enum LogLevel : int {
+    LOG_TRACE = 0,  // per-byte dumps; opt-in
+    LOG_DEBUG,      // per-event messages
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR,
+    LOG_OFF
+};
+
+// Levels below this are compiled out entirely. Configure with
+// -DSEQ_LOG_MIN_LEVEL=<n> (the cache variable in src/CMakeLists.txt).
+#ifndef SEQ_LOG_MIN_LEVEL
+#define SEQ_LOG_MIN_LEVEL 0
+#endif
+
+// Fixed-size binary log record. Arguments are stored by value (strings are
+// copied into the inline blob) and only formatted by the writer thread.
+// Strings that do not fit are cut and printed with a trailing "…".
+struct LogRecord {
+    static constexpr int MAX_ARGS = 6;
+    static constexpr int BLOB_SIZE = 64;
+
+    enum ArgType : uint8_t { ARG_INT, ARG_UINT, ARG_DOUBLE, ARG_STR, ARG_HEX };
+
+    uint64_t timestampNs;
+    const char *format;  // string literal with {} placeholders
+    uint8_t level;
+    uint8_t argCount;
+    uint8_t blobUsed;
+    uint8_t types[MAX_ARGS];
+    union Value {
+        int64_t i;
+        uint64_t u;
+        double d;
+        struct {
+            uint8_t offset;
+            uint8_t length;
+            bool truncated;
+        } blob;
+    } values[MAX_ARGS];
+    char blob[BLOB_SIZE];
+};
+
+// Asynchronous logger. Each thread appends records to its own lock-free
+// SPSC buffer. A background writer drains all buffers every few
+// milliseconds, orders the records by timestamp, formats them and writes
+// them out. The logging thread never formats and never does I/O: when its
+// buffer is full the record is dropped and counted. Its only lock is the
+// registry's, on its first record, and the writer holds that just long
+// enough to copy the buffer list.
+class Logger {
+public:
+    static Logger &instance();
+
+    ~Logger();
+
+    void setLevel(LogLevel level) { m_level.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return static_cast<LogLevel>(m_level.load(std::memory_order_relaxed)); }
+    bool enabled(LogLevel level) const { return level >= m_level.load(std::memory_order_relaxed); }
+
+    // Defaults to stdout; returns false if the file cannot be opened
+    bool setOutputFile(const std::string &path);
+
+    // Drain and write everything logged so far, then stop the writer
+    void shutdown();
+
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    // String arguments cut to fit a record
+    uint64_t truncated() const { return m_truncated.load(std::memory_order_relaxed); }
+
+    template <typename... Args>
+    void log(LogLevel level, const char *format, const Args &...args) {
+        static_assert(sizeof...(Args) <= LogRecord::MAX_ARGS, "too many log arguments");
+        LogRecord record;
+        begin(record, level, format);
+        (encode(record, args), ...);
+        submit(record);
+    }
+
+    // Hex dump of raw bytes; `format` has one {} for the bytes. Long dumps
+    // are split across several records.
+    void logHex(LogLevel level, const char *format, const uint8_t *data, size_t len);
+
+private:
+    struct ThreadBuffer {
+        SpscQueue<LogRecord, 1024> queue;
+    };
+
+    Logger();
+
+    static void begin(LogRecord &record, LogLevel level, const char *format);
+    static void encodeBlob(LogRecord &record, LogRecord::ArgType type, const char *data, size_t len);
+
+    template <typename T>
+    static void encode(LogRecord &record, const T &value) {
+        uint8_t index = record.argCount++;
+        if constexpr (std::is_same_v<T, bool>) {
+            record.types[index] = LogRecord::ARG_UINT;
+            record.values[index].u = value ? 1 : 0;
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            record.types[index] = LogRecord::ARG_INT;
+            record.values[index].i = value;
+        } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+            record.types[index] = LogRecord::ARG_UINT;
+            record.values[index].u = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            record.types[index] = LogRecord::ARG_DOUBLE;
+            record.values[index].d = value;
+        } else {
+            --record.argCount;
+            std::string_view text(value);
+            encodeBlob(record, LogRecord::ARG_STR, text.data(), text.size());
+        }
+    }
+
+    void submit(const LogRecord &record);
+    ThreadBuffer &localBuffer();
+    void run();
+    void drain();
+    void format(const LogRecord &record, std::string &out) const;
+
+    std::atomic<int> m_level;
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_truncated{0};
+    std::atomic<bool> m_running{true};
+    uint64_t m_startNs;
+
+    // Taken once per thread, and by the writer to copy the list and to drop
+    // the buffers of threads that have exited once they are empty
+    std::mutex m_registryMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+
+    std::mutex m_outMutex;  // guards m_out: held while writing, not while logging
+    std::FILE *m_out;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_draining;  // writer thread only
+    std::vector<LogRecord> m_pending;  // writer thread only
+    std::string m_line;                // writer thread only
+    std::thread m_writer;
+};
+
+#define SEQ_LOG(level, ...)                                                   \
+    do {                                                                      \
+        if constexpr ((level) >= SEQ_LOG_MIN_LEVEL) {                         \
+            if (Logger::instance().enabled(level))                            \
+                Logger::instance().log((level), __VA_ARGS__);                 \
+        }                                                                     \
+    } while (0)
+
+#define LOG_TRACE_HEX(format, data, len)                                      \
+    do {                                                                      \
+        if constexpr (LOG_TRACE >= SEQ_LOG_MIN_LEVEL) {                       \
+            if (Logger::instance().enabled(LOG_TRACE))                        \
+                Logger::instance().logHex(LOG_TRACE, (format), (data), (len)); \
+        }                                                                     \
+    } while (0)
+
+#define LOG_TRACE_MSG(...) SEQ_LOG(LOG_TRACE, __VA_ARGS__)
+#define LOG_DEBUG_MSG(...) SEQ_LOG(LOG_DEBUG, __VA_ARGS__)
+#define LOG_INFO_MSG(...) SEQ_LOG(LOG_INFO, __VA_ARGS__)
+#define LOG_WARN_MSG(...) SEQ_LOG(LOG_WARN, __VA_ARGS__)
+#define LOG_ERROR_MSG(...) SEQ_LOG(LOG_ERROR, __VA_ARGS__)
+
+#endif // LOGGER_H
@@ -1,7 +1,10 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <algorithm>
 #include <csignal>
 #include <iostream>
 #include "mainwindow.h"
+#include "logger.h"
 
 // Global pointer to QApplication for signal handler
 QApplication *g_app = nullptr;
@@ -21,10 +24,98 @@ int main(int argc, char **argv) {
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
     
-    MainWindow w;
+    QCommandLineParser parser;
+    parser.setApplicationDescription("FPGA Sequencer Visualizer");
+    parser.addHelpOption();
+    QCommandLineOption ioThreadOption("io-thread",
+        "Read and decode UART input on a dedicated thread.");
+    parser.addOption(ioThreadOption);
+    QCommandLineOption historyOption("history-mb",
+        "Memory budget for the pitch graph history (default 4).", "MB", "4");
+    parser.addOption(historyOption);
+    QCommandLineOption statsFileOption("stats-file",
+        "Append pipeline latency stats as JSON lines to <file>.", "file");
+    parser.addOption(statsFileOption);
+    QCommandLineOption statsIntervalOption("stats-interval",
+        "Interval between stats lines in ms (default 1000).", "ms", "1000");
+    parser.addOption(statsIntervalOption);
+    QCommandLineOption beatsOption("beats",
+        "Beats per period; must match the board's NUM_BEATS (default 16).", "n", "16");
+    parser.addOption(beatsOption);
+    QCommandLineOption periodOption("period",
+        "Nominal period in seconds until SYNC markers lock the clock (default 4).", "s", "4");
+    parser.addOption(periodOption);
+    QCommandLineOption baudOption("baud",
+        "Serial baud rate; must match BAUD_RATE in hdl/top.sv (default 1000000).", "rate", "1000000");
+    parser.addOption(baudOption);
+    QCommandLineOption replayOption("replay",
+        "Play back a capture file through the normal ingest path.", "file");
+    parser.addOption(replayOption);
+    QCommandLineOption replaySpeedOption("replay-speed",
+        "Replay speed multiplier, or 'max' for as fast as possible (default 1).", "speed", "1");
+    parser.addOption(replaySpeedOption);
+    QCommandLineOption boardOption("board",
+        "Add a board to the overview: a serial device, pipe or .seqcap capture (repeatable).", "path");
+    parser.addOption(boardOption);
+    QCommandLineOption audioOutOption("audio-out",
+        "Play the pattern through a copy of the board's PWM voice into <out>: null or a .wav file.", "out");
+    parser.addOption(audioOutOption);
+    QCommandLineOption patternsOption("patterns",
+        "Browse the patterns in <file>: a .seqbank bank, a pattern list or a capture.", "file");
+    parser.addOption(patternsOption);
+    QCommandLineOption logLevelOption("log-level",
+        "Minimum log level: trace, debug, info, warn, error (default info).", "level", "info");
+    parser.addOption(logLevelOption);
+    QCommandLineOption logFileOption("log-file",
+        "Write log records to <file> instead of stdout.", "file");
+    parser.addOption(logFileOption);
+    parser.process(app);
+
+    const QString levelName = parser.value(logLevelOption).toLower();
+    const QStringList levelNames = {"trace", "debug", "info", "warn", "error"};
+    int level = levelNames.indexOf(levelName);
+    if (level < 0) {
+        std::cerr << "Unknown log level: " << levelName.toStdString() << "\n";
+        return 1;
+    }
+    Logger::instance().setLevel(static_cast<LogLevel>(level));
+    if (parser.isSet(logFileOption) &&
+        !Logger::instance().setOutputFile(parser.value(logFileOption).toStdString())) {
+        std::cerr << "Cannot open log file: " << parser.value(logFileOption).toStdString() << "\n";
+        return 1;
+    }
+
+    GuiOptions options;
+    options.ioThread = parser.isSet(ioThreadOption);
+    options.historyBudget = static_cast<size_t>(
+        std::max(1, parser.value(historyOption).toInt())) * 1024 * 1024;
+    options.statsFile = parser.value(statsFileOption);
+    options.statsIntervalMs = std::max(10, parser.value(statsIntervalOption).toInt());
+    options.numBeats = std::clamp(parser.value(beatsOption).toInt(), 1, SequencerModel::MAX_BEATS);
+    options.periodSeconds = std::clamp(parser.value(periodOption).toDouble(),
+                                       BeatClock::MIN_PERIOD_NS / 1e9, BeatClock::MAX_PERIOD_NS / 1e9);
+    options.baudRate = std::max(1200, parser.value(baudOption).toInt());
+    options.replayFile = parser.value(replayOption);
+    if (parser.value(replaySpeedOption).toLower() == "max") {
+        options.replaySpeed = 0.0;
+    } else {
+        bool ok = false;
+        options.replaySpeed = parser.value(replaySpeedOption).toDouble(&ok);
+        if (!ok || options.replaySpeed <= 0) {
+            std::cerr << "Invalid replay speed: " << parser.value(replaySpeedOption).toStdString() << "\n";
+            return 1;
+        }
+    }
+
+    options.boards = parser.values(boardOption);
+    options.audioOut = parser.value(audioOutOption);
+    options.patternFile = parser.value(patternsOption);
+
+    MainWindow w(options);
     w.show();
     
     int result = app.exec();
     g_app = nullptr;
+    Logger::instance().shutdown();
     return result;
 }
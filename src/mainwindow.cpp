@@ -2,68 +2,166 @@
 #include "sequencer_model.h"
 #include "uart_parser.h"
 #include "pitch_graph_widget.h"
+#include "beat_grid_widget.h"
+#include "serial_device.h"
+#include "stats_panel.h"
+#include "board_overview_widget.h"
+#include "monotonic_clock.h"
+#include "logger.h"
 
 #include <QPushButton>
 #include <QComboBox>
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QGridLayout>
 #include <QGroupBox>
 #include <QSocketNotifier>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QFile>
-#include <QTextStream>
+#include <QFileInfo>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QSignalBlocker>
 #ifdef HAVE_QSERIALPORT
 #include <QSerialPortInfo>
 #endif
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <unistd.h>
-#include <iostream>
 
-MainWindow::MainWindow(QWidget *parent) 
+MainWindow::MainWindow(const GuiOptions &options, QWidget *parent) 
     : QMainWindow(parent), m_isConnected(false), m_pitchGraph(nullptr), 
-      m_beatTimer(nullptr), m_stdinNotifier(nullptr) {
+      m_beatTimer(nullptr),
+      m_clock(options.numBeats, static_cast<uint64_t>(options.periodSeconds * 1e9)),
+      m_beatNotifier(nullptr), m_options(options), m_statsPanel(nullptr),
+      m_statsDumpTimer(nullptr), m_drainTimer(nullptr),
+      m_ingestLabel(nullptr), m_lastDropped(0), m_stdinNotifier(nullptr),
+      m_replayNotifier(nullptr), m_replayFd(-1), m_replayFramesStart(0),
+      m_boardOverview(nullptr), m_removeBoardBtn(nullptr), m_boardsTimer(nullptr),
+      m_loadBtn(nullptr), m_patternSpin(nullptr), m_patternFind(nullptr), m_patternLabel(nullptr),
+      m_similarMetric(nullptr), m_similarBtn(nullptr), m_similarResults(nullptr),
+      m_reconnectTimer(nullptr),
+      m_syncSerial(0) {
     
     setWindowTitle("FPGA Sequencer Visualizer");
     resize(1200, 600);  // Wider window for side-by-side layout
     
-    m_model = std::make_unique<SequencerModel>(NUM_BEATS);
+    m_model = std::make_unique<SequencerModel>(m_options.numBeats);
     m_parser = std::make_unique<UARTParser>(m_model.get());
+    m_model->setStats(&m_stats);
+    m_parser->setStats(&m_stats);
     
     buildUI();
 
     // Model callbacks - set AFTER buildUI() so widgets exist
     m_model->onBeatChanged = [this](int beat) {
-        updateBeatDisplay(beat);
+        m_beatGrid->noteSourceTimestamp(m_model->sourceTimestamp());
+        m_beatGrid->setCurrentBeat(beat);
         if (m_pitchGraph) {
             int pitch = m_model->getBeatPitch(beat);
             if (pitch > 0) {
+                m_pitchGraph->noteSourceTimestamp(m_model->sourceTimestamp());
                 m_pitchGraph->addPitchSample(pitch, beat);
             }
         }
     };
 
-    m_model->onBeatPitchChanged = [this](int beat, int pitch) {
-        std::cout << "[GUI] Beat " << beat << " → Pitch " << pitch << "\n";
-        updateBeatDisplay(m_model->currentBeat());
+    m_parser->onSync = [this]() {
+        LOG_DEBUG_MSG("[Serial] SYNC: Period completed, resetting to beat 0");
+        uint64_t timestamp = m_parser->sourceTimestamp();
+        onClockSync(timestamp ? timestamp : monotonicNanos());
     };
 
-    // Beat timer: Use calculated MS_PER_BEAT
+    // Framed snapshots and ticks carry the board's NUM_BEATS
+    m_parser->onBeatCount = [this](int beats) { applyBoardBeatCount(beats); };
+
+    m_model->onBeatCountChanged = [this](int) {
+        m_beatGrid->beatCountChanged();
+        updateMonitor();
+    };
+
+    // One notification per transaction, however many beats it touched
+    m_model->onPitchesChanged = [this](const SequencerModel::PitchChange &change) {
+        if (Logger::instance().enabled(LOG_DEBUG)) {
+            for (int i = 0; i < m_model->numBeats(); ++i) {
+                if (change.dirty.test(i)) {
+                    LOG_DEBUG_MSG("[GUI] Beat {} → Pitch {}", i, change.after[i]);
+                }
+            }
+        }
+        m_beatGrid->noteSourceTimestamp(m_model->sourceTimestamp());
+        m_beatGrid->beatsChanged(change.dirty);
+        updateMonitor();
+    };
+
+    // Beat transitions are scheduled at the clock's next boundary on the
+    // monotonic clock, not counted off a fixed interval
     m_beatTimer = new QTimer(this);
+    m_beatTimer->setSingleShot(true);
+    m_beatTimer->setTimerType(Qt::PreciseTimer);
     connect(m_beatTimer, &QTimer::timeout, this, &MainWindow::onTimerTick);
-    m_beatTimer->start(MS_PER_BEAT);
+    if (m_beatDeadline.isValid()) {
+        m_beatNotifier = new QSocketNotifier(m_beatDeadline.fd(), QSocketNotifier::Read, this);
+        connect(m_beatNotifier, &QSocketNotifier::activated, this, &MainWindow::onTimerTick);
+    }
+    uint64_t now = monotonicNanos();
+    m_clock.restart(now);
+    scheduleNextBeat(now);
+
+    // Periodic machine-readable stats dump
+    if (!m_options.statsFile.isEmpty()) {
+        m_statsFile.setFileName(m_options.statsFile);
+        if (m_statsFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            m_statsDumpTimer = new QTimer(this);
+            connect(m_statsDumpTimer, &QTimer::timeout, this, &MainWindow::onStatsDumpTimer);
+            m_statsDumpTimer->start(m_options.statsIntervalMs);
+        } else {
+            LOG_WARN_MSG("[Stats] Cannot open {}", m_options.statsFile.toStdString());
+        }
+    }
+
+    // Drain decoded events from the I/O thread once per frame (~60 Hz)
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setInterval(16);
+    connect(m_drainTimer, &QTimer::timeout, this, &MainWindow::onDrainTimer);
 
     // Listen on stdin for testing (mock UART)
     m_stdinNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
     connect(m_stdinNotifier, &QSocketNotifier::activated, this, &MainWindow::onStdinReady);
+    if (m_options.ioThread) {
+        m_stdinNotifier->setEnabled(false);
+        startIngestThread(STDIN_FILENO, UARTParser::Format::Text, false);
+    }
+    if (!m_options.replayFile.isEmpty()) {
+        startReplay(m_options.replayFile, m_options.replaySpeed);
+    }
+    if (!m_options.audioOut.isEmpty()) startMonitor(m_options.audioOut);
+    if (!m_options.patternFile.isEmpty()) openPatterns(m_options.patternFile);
+#ifdef HAVE_QSERIALPORT
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setInterval(1000);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &MainWindow::onReconnectTimer);
+    m_portWatcher = std::make_unique<PortWatcher>();
+    m_portWatcher->onPortsChanged = [this](const std::vector<SerialPortInfo> &ports) {
+        QMetaObject::invokeMethod(this, [this, ports]() { onPortsListed(ports); }, Qt::QueuedConnection);
+    };
+    if (!m_portWatcher->start()) LOG_WARN_MSG("[Ports] Cannot start the port watcher");
+#endif
+    for (const QString &board : m_options.boards) {
+        addBoard(board, UARTParser::Format::Framed, m_options.baudRate);
+    }
 
-    std::cout << "=== FPGA Sequencer GUI ===\n";
-    std::cout << "Timing: " << NUM_BEATS << " beats in " << PERIOD << "s = " 
-              << BEATS_PER_SECOND << " BPS (" << MS_PER_BEAT << "ms per beat)\n";
-    std::cout << "Listening on stdin for UART messages.\n";
-    std::cout << "Protocol: BEAT <index> <pitch>\n";
-    std::cout << "  pitch: 0=off, 1-7=pitch values\n\n";
+    LOG_INFO_MSG("=== FPGA Sequencer GUI ===");
+    LOG_INFO_MSG("Timing: {} beats in {}s, locking to SYNC when present",
+                 m_clock.numBeats(), m_clock.periodNs() / 1e9);
+    LOG_INFO_MSG("Listening on stdin for UART messages{}",
+                 m_options.ioThread ? " (I/O thread)." : ".");
+    LOG_INFO_MSG("Protocol: BEAT <index> <pitch>");
+    LOG_INFO_MSG("  pitch: 0=off, 1-7=pitch values");
 }
 
 void MainWindow::buildUI() {
@@ -82,6 +180,9 @@ void MainWindow::buildUI() {
     auto *controlLayout = new QHBoxLayout(controlGroup);
     
     m_portCombo = new QComboBox(controlGroup);
+    // A device path can be typed in, e.g. the pty of mock_uart_sender --pty
+    m_portCombo->setEditable(true);
+    m_portCombo->setInsertPolicy(QComboBox::NoInsert);
     
     QPushButton *refreshBtn = new QPushButton("Refresh", controlGroup);
     connect(refreshBtn, &QPushButton::clicked, this, &MainWindow::refreshSerialPorts);
@@ -92,43 +193,151 @@ void MainWindow::buildUI() {
     m_statusLabel = new QLabel("Disconnected (using stdin)", controlGroup);
     m_statusLabel->setStyleSheet("color: #888;");
     
+    // Framed is what top.sv sends; raw bytes are older bitstreams, text
+    // lines are for mock senders
+    m_formatCombo = new QComboBox(controlGroup);
+    m_formatCombo->addItem("Framed", static_cast<int>(UARTParser::Format::Framed));
+    m_formatCombo->addItem("Raw bytes (legacy)", static_cast<int>(UARTParser::Format::Raw));
+    m_formatCombo->addItem("Text lines", static_cast<int>(UARTParser::Format::Text));
+
+    m_baudCombo = new QComboBox(controlGroup);
+    for (int baud : {9600, 115200, 230400, 460800, 921600, 1000000, 2000000, 3000000}) {
+        m_baudCombo->addItem(QString::number(baud), baud);
+    }
+    int baudIndex = m_baudCombo->findData(m_options.baudRate);
+    if (baudIndex < 0) {
+        m_baudCombo->addItem(QString::number(m_options.baudRate), m_options.baudRate);
+        baudIndex = m_baudCombo->count() - 1;
+    }
+    m_baudCombo->setCurrentIndex(baudIndex);
+    
+    // Ports are filled in by the watcher once listed, off this thread
+    m_portCombo->addItem("(Mock stdin for testing)");
+#ifndef HAVE_QSERIALPORT
     refreshSerialPorts();
+#endif
     
     controlLayout->addWidget(new QLabel("Port:"));
     controlLayout->addWidget(m_portCombo);
+    controlLayout->addWidget(m_formatCombo);
+    controlLayout->addWidget(m_baudCombo);
     controlLayout->addWidget(refreshBtn);
     controlLayout->addWidget(m_connectBtn);
     controlLayout->addWidget(m_statusLabel);
+
+    m_ingestLabel = new QLabel(controlGroup);
+    m_ingestLabel->setVisible(m_options.ioThread);
+    controlLayout->addWidget(m_ingestLabel);
     controlLayout->addStretch();
     
     leftLayout->addWidget(controlGroup);
 
+    // === Capture / Replay ===
+    auto *captureGroup = new QGroupBox("Capture && Replay", leftPanel);
+    auto *captureLayout = new QHBoxLayout(captureGroup);
+    m_captureBtn = new QPushButton("Start Capture...", captureGroup);
+    connect(m_captureBtn, &QPushButton::clicked, this, &MainWindow::onCaptureClicked);
+    m_replayBtn = new QPushButton("Replay...", captureGroup);
+    connect(m_replayBtn, &QPushButton::clicked, this, &MainWindow::onReplayClicked);
+    m_replaySpeedCombo = new QComboBox(captureGroup);
+    m_replaySpeedCombo->addItem("1x", 1.0);
+    m_replaySpeedCombo->addItem("4x", 4.0);
+    m_replaySpeedCombo->addItem("16x", 16.0);
+    m_replaySpeedCombo->addItem("Max", 0.0);
+    m_captureLabel = new QLabel(captureGroup);
+    m_captureLabel->setStyleSheet("color: #888;");
+    captureLayout->addWidget(m_captureBtn);
+    captureLayout->addWidget(m_replayBtn);
+    captureLayout->addWidget(m_replaySpeedCombo);
+    captureLayout->addWidget(m_captureLabel, 1);
+    leftLayout->addWidget(captureGroup);
+
     // === 4x4 Beat Display Grid ===
-    auto *beatGroup = new QGroupBox(QString("16-Beat Sequencer (%1 BPS, %2ms/beat)")
-                                       .arg(BEATS_PER_SECOND)
-                                       .arg(MS_PER_BEAT), leftPanel);
-    auto *beatLayout = new QGridLayout(beatGroup);
-    beatLayout->setSpacing(10);
+    auto *beatGroup = new QGroupBox(leftPanel);
+    m_beatGroup = beatGroup;
+    auto *beatLayout = new QVBoxLayout(beatGroup);
+
+    // Tempo and length: must match the board's NUM_BEATS; the period is only
+    // a starting point once SYNC markers arrive
+    auto *timingLayout = new QHBoxLayout();
+    m_beatsSpin = new QSpinBox(beatGroup);
+    m_beatsSpin->setRange(1, SequencerModel::MAX_BEATS);
+    m_beatsSpin->setValue(m_model->numBeats());
+    m_periodSpin = new QDoubleSpinBox(beatGroup);
+    m_periodSpin->setRange(BeatClock::MIN_PERIOD_NS / 1e9, BeatClock::MAX_PERIOD_NS / 1e9);
+    m_periodSpin->setDecimals(3);
+    m_periodSpin->setSingleStep(0.25);
+    m_periodSpin->setSuffix(" s");
+    m_periodSpin->setValue(m_clock.periodNs() / 1e9);
+    m_clockLabel = new QLabel(beatGroup);
+    m_clockLabel->setStyleSheet("color: #888;");
+    connect(m_beatsSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::onBeatsChanged);
+    connect(m_periodSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::onPeriodChanged);
+    timingLayout->addWidget(new QLabel("Beats:"));
+    timingLayout->addWidget(m_beatsSpin);
+    timingLayout->addWidget(new QLabel("Period:"));
+    timingLayout->addWidget(m_periodSpin);
+    timingLayout->addWidget(m_clockLabel, 1);
+    beatLayout->addLayout(timingLayout);
     
-    // Create 4x4 grid of buttons
-    for (int i = 0; i < 16; ++i) {
-        QPushButton *btn = new QPushButton(QString::number(i), beatGroup);
-        btn->setFixedSize(120, 120);  // Larger buttons
-        btn->setEnabled(false);
-        btn->setStyleSheet("font-size: 20px; font-weight: bold;");
-        int row = i / 4;  // 4 buttons per row
-        int col = i % 4;
-        beatLayout->addWidget(btn, row, col);
-        m_beatButtons.push_back(btn);
-    }
+    // 4x4 grid painted directly from the model
+    m_beatGrid = new BeatGridWidget(m_model.get(), beatGroup);
+    m_beatGrid->setColumns(4);
+    m_beatGrid->setStats(&m_stats);
+    beatLayout->addWidget(m_beatGrid);
     leftLayout->addWidget(beatGroup);
+    updateTimingDisplay();
 
-    // === Save and Reset Buttons ===
-    m_saveBtn = new QPushButton("Save Sequence to File", leftPanel);
-    m_saveBtn->setFixedHeight(40);
+    // === Patterns: save to and switch between banks or lists ===
+    auto *patternGroup = new QGroupBox("Patterns", leftPanel);
+    auto *patternRows = new QVBoxLayout(patternGroup);
+    auto *patternLayout = new QHBoxLayout();
+    m_saveBtn = new QPushButton("Save Pattern...", patternGroup);
     connect(m_saveBtn, &QPushButton::clicked, this, &MainWindow::onSaveClicked);
-    leftLayout->addWidget(m_saveBtn);
+    m_loadBtn = new QPushButton("Load Patterns...", patternGroup);
+    connect(m_loadBtn, &QPushButton::clicked, this, &MainWindow::onLoadClicked);
+    m_patternSpin = new QSpinBox(patternGroup);
+    m_patternSpin->setEnabled(false);
+    m_patternSpin->setToolTip("Pattern number in the loaded file");
+    connect(m_patternSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::onPatternIndexChanged);
+    m_patternFind = new QLineEdit(patternGroup);
+    m_patternFind->setPlaceholderText("Find by name");
+    m_patternFind->setEnabled(false);
+    connect(m_patternFind, &QLineEdit::returnPressed, this, &MainWindow::onPatternFindEntered);
+    m_patternLabel = new QLabel(patternGroup);
+    m_patternLabel->setStyleSheet("color: #888;");
+    patternLayout->addWidget(m_saveBtn);
+    patternLayout->addWidget(m_loadBtn);
+    patternLayout->addWidget(m_patternSpin);
+    patternLayout->addWidget(m_patternFind);
+    patternLayout->addWidget(m_patternLabel, 1);
+    patternRows->addLayout(patternLayout);
+
+    // Nearest patterns in the loaded file to what the model holds now
+    auto *similarLayout = new QHBoxLayout();
+    m_similarMetric = new QComboBox(patternGroup);
+    m_similarMetric->addItem("Pitch distance", static_cast<int>(PatternIndex::Metric::Pitch));
+    m_similarMetric->addItem("Active steps", static_cast<int>(PatternIndex::Metric::Steps));
+    m_similarMetric->addItem("Any rotation", static_cast<int>(PatternIndex::Metric::Rotation));
+    m_similarBtn = new QPushButton("Find Similar", patternGroup);
+    m_similarBtn->setEnabled(false);
+    connect(m_similarBtn, &QPushButton::clicked, this, &MainWindow::onFindSimilarClicked);
+    m_similarResults = new QComboBox(patternGroup);
+    m_similarResults->setEnabled(false);
+    connect(m_similarResults, QOverload<int>::of(&QComboBox::activated),
+            this, &MainWindow::onSimilarChosen);
+    similarLayout->addWidget(m_similarMetric);
+    similarLayout->addWidget(m_similarBtn);
+    similarLayout->addWidget(m_similarResults, 1);
+    patternRows->addLayout(similarLayout);
+    leftLayout->addWidget(patternGroup);
     
+    m_statsPanel = new StatsPanel(&m_stats, leftPanel);
+    leftLayout->addWidget(m_statsPanel);
+
     m_resetBtn = new QPushButton("Reset All Beats", leftPanel);
     m_resetBtn->setFixedHeight(40);
     m_resetBtn->setStyleSheet("QPushButton { background-color: #d9534f; color: white; font-weight: bold; }");
@@ -145,9 +354,30 @@ void MainWindow::buildUI() {
     auto *graphGroup = new QGroupBox("Pitch Visualization", rightPanel);
     auto *graphLayout = new QVBoxLayout(graphGroup);
     m_pitchGraph = new PitchGraphWidget(graphGroup);
+    m_pitchGraph->setHistoryBudget(m_options.historyBudget);
+    m_pitchGraph->setStats(&m_stats);
     m_pitchGraph->setMinimumSize(400, 500);
     graphLayout->addWidget(m_pitchGraph);
     rightLayout->addWidget(graphGroup);
+
+    // === Other boards, one row each ===
+    auto *boardsGroup = new QGroupBox("Boards", rightPanel);
+    auto *boardsLayout = new QVBoxLayout(boardsGroup);
+    m_boardOverview = new BoardOverviewWidget(boardsGroup);
+    boardsLayout->addWidget(m_boardOverview);
+    auto *boardButtons = new QHBoxLayout();
+    QPushButton *addBoardBtn = new QPushButton("Add Board...", boardsGroup);
+    connect(addBoardBtn, &QPushButton::clicked, this, &MainWindow::onAddBoardClicked);
+    m_removeBoardBtn = new QPushButton("Remove", boardsGroup);
+    m_removeBoardBtn->setEnabled(false);
+    connect(m_removeBoardBtn, &QPushButton::clicked, this, &MainWindow::onRemoveBoardClicked);
+    connect(m_boardOverview, &BoardOverviewWidget::boardSelected, this,
+            [this](int id) { m_removeBoardBtn->setEnabled(id >= 0); });
+    boardButtons->addWidget(addBoardBtn);
+    boardButtons->addWidget(m_removeBoardBtn);
+    boardButtons->addStretch();
+    boardsLayout->addLayout(boardButtons);
+    rightLayout->addWidget(boardsGroup);
     
     mainLayout->addWidget(rightPanel, 1);  // Give right side stretch factor
 
@@ -155,278 +385,868 @@ void MainWindow::buildUI() {
 }
 
 void MainWindow::refreshSerialPorts() {
-    m_portCombo->clear();
-    m_portCombo->addItem("(Mock stdin for testing)");
-    
 #ifdef HAVE_QSERIALPORT
-    for (const auto &info : QSerialPortInfo::availablePorts()) {
-        m_portCombo->addItem(info.portName() + " - " + info.description(), 
-                             info.portName());
-    }
+    // Listed on the watcher's thread; onPortsListed() fills the combo
+    if (m_portWatcher) m_portWatcher->rescan();
 #else
+    m_portCombo->clear();
+    m_portCombo->addItem("(Mock stdin for testing)");
     m_portCombo->addItem("(Serial ports disabled - Qt5SerialPort not installed)");
     m_portCombo->setEnabled(false);
+    m_formatCombo->setEnabled(false);
+    m_baudCombo->setEnabled(false);
     m_connectBtn->setEnabled(false);
 #endif
 }
 
+namespace {
+
+// A listed port by name ("ttyUSB0") or by device path
+const SerialPortInfo *findPort(const std::vector<SerialPortInfo> &ports, const QString &portName) {
+    std::string name = portName.toStdString();
+    for (const SerialPortInfo &port : ports) {
+        if (port.name == name || port.path == name) return &port;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void MainWindow::onPortsListed(const std::vector<SerialPortInfo> &ports) {
+    // Only a port that was listed can be seen to go; a typed pty never is
+    bool lost = m_isConnected && findPort(m_ports, m_reconnect.portName) && !findPort(ports, m_reconnect.portName);
+    m_ports = ports;
+
+    // Keep what was chosen or typed across the rebuild
+    QString current = m_portCombo->currentText();
+    {
+        QSignalBlocker blocker(m_portCombo);
+        m_portCombo->clear();
+        m_portCombo->addItem("(Mock stdin for testing)");
+        for (const SerialPortInfo &port : ports) {
+            QString name = QString::fromStdString(port.name);
+            QString text = port.description.empty() ? name : name + " - " + QString::fromStdString(port.description);
+            m_portCombo->addItem(text, name);
+        }
+        int index = m_portCombo->findText(current);
+        if (index >= 0) {
+            m_portCombo->setCurrentIndex(index);
+        } else {
+            m_portCombo->setEditText(current);
+        }
+    }
+
+    if (lost) onPortLost();
+    if (m_reconnect.pending) onReconnectTimer();
+}
+
 void MainWindow::onConnectClicked() {
 #ifdef HAVE_QSERIALPORT
-    if (m_isConnected) {
-        // Disconnect
-        if (m_serialPort) {
-            m_serialPort->close();
-            m_serialPort.reset();
-        }
-        m_isConnected = false;
+    if (m_reconnect.pending) {
+        // Stop waiting for an unplugged board
+        m_reconnect.pending = false;
+        m_reconnectTimer->stop();
         m_connectBtn->setText("Connect");
         m_statusLabel->setText("Disconnected (using stdin)");
         m_statusLabel->setStyleSheet("color: #888;");
-        m_stdinNotifier->setEnabled(true);
+    } else if (m_isConnected) {
+        disconnectPort();
     } else {
-        // Connect
-        if (m_portCombo->currentIndex() == 0) {
+        QString portName = m_portCombo->currentText().trimmed();
+        int portIndex = m_portCombo->findText(portName);
+        if (portIndex == 0 || portName.isEmpty()) {
             QMessageBox::information(this, "Mock Mode", 
                 "Using stdin for mock UART. Pipe data or use mock_uart_sender.");
             return;
         }
-        
-        QString portName = m_portCombo->currentData().toString();
+        if (portIndex > 0) portName = m_portCombo->itemData(portIndex).toString();
+        if (m_replay) {
+            QMessageBox::information(this, "Replay Running", "Stop the replay before connecting.");
+            return;
+        }
+        auto format = static_cast<UARTParser::Format>(m_formatCombo->currentData().toInt());
+        int baud = m_baudCombo->currentData().toInt();
+        QString error;
+        if (!connectPort(portName, format, baud, &error)) {
+            QMessageBox::critical(this, "Connection Error", error);
+        }
+    }
+#else
+    QMessageBox::information(this, "Not Available", 
+        "Serial port support not compiled. Install Qt5SerialPort and rebuild.");
+#endif
+}
+
+bool MainWindow::connectPort(const QString &portName, UARTParser::Format format, int baud, QString *error) {
+#ifdef HAVE_QSERIALPORT
+    stopCapture("source changed");
+
+    if (m_options.ioThread) {
+        // Bypass QSerialPort: the I/O thread owns the descriptor
+        QString path = portName.startsWith('/') ? portName : "/dev/" + portName;
+        std::string message;
+        int fd = openSerialDevice(path.toStdString(), baud, &message);
+        if (fd < 0) {
+            *error = QString::fromStdString(message);
+            return false;
+        }
+        startIngestThread(fd, format, true);
+    } else {
         m_serialPort = std::make_unique<QSerialPort>(portName);
-        m_serialPort->setBaudRate(QSerialPort::Baud9600);  // Match FPGA baud rate
+        m_serialPort->setBaudRate(baud);  // Match BAUD_RATE in top.sv
         m_serialPort->setDataBits(QSerialPort::Data8);
         m_serialPort->setParity(QSerialPort::NoParity);
         m_serialPort->setStopBits(QSerialPort::OneStop);
         m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
-        
-        if (m_serialPort->open(QIODevice::ReadOnly)) {
-            connect(m_serialPort.get(), &QSerialPort::readyRead, 
-                    this, &MainWindow::onSerialDataReady);
-            m_isConnected = true;
-            m_connectBtn->setText("Disconnect");
-            m_statusLabel->setText("Connected to " + portName);
-            m_statusLabel->setStyleSheet("color: green;");
-            m_stdinNotifier->setEnabled(false);
-            std::cout << "[Serial] Connected to " << portName.toStdString() 
-                      << " at 9600 baud\n";
-        } else {
-            QMessageBox::critical(this, "Connection Error", 
-                "Failed to open " + portName + ": " + m_serialPort->errorString());
+        if (!m_serialPort->open(QIODevice::ReadOnly)) {
+            *error = "Failed to open " + portName + ": " + m_serialPort->errorString();
+            m_serialPort.reset();
+            return false;
         }
+        m_serialBuffer.clear();
+        m_parser->setFormat(format);
+        connect(m_serialPort.get(), &QSerialPort::readyRead, 
+                this, &MainWindow::onSerialDataReady);
+        // Unplugged: tear down after the port has finished reporting it
+        connect(m_serialPort.get(), &QSerialPort::errorOccurred, this, [this](QSerialPort::SerialPortError e) {
+            if (e == QSerialPort::ResourceError) {
+                QMetaObject::invokeMethod(this, &MainWindow::onPortLost, Qt::QueuedConnection);
+            }
+        });
+        m_stdinNotifier->setEnabled(false);
     }
+
+    m_reconnect.pending = false;
+    m_reconnect.portName = portName;
+    const SerialPortInfo *listed = findPort(m_ports, portName);
+    m_reconnect.port = listed ? *listed : SerialPortInfo();
+    m_reconnect.format = format;
+    m_reconnect.baud = baud;
+
+    m_isConnected = true;
+    m_connectBtn->setText("Disconnect");
+    m_statusLabel->setText("Connected to " + portName + (m_options.ioThread ? " (I/O thread)" : ""));
+    m_statusLabel->setStyleSheet("color: green;");
+    LOG_INFO_MSG("[Serial] Connected to {} at {} baud{}", portName.toStdString(), baud,
+                 m_options.ioThread ? " on I/O thread" : "");
+    return true;
 #else
-    QMessageBox::information(this, "Not Available", 
-        "Serial port support not compiled. Install Qt5SerialPort and rebuild.");
+    (void)portName;
+    (void)format;
+    (void)baud;
+    *error = "Serial port support not compiled";
+    return false;
+#endif
+}
+
+void MainWindow::disconnectPort() {
+#ifdef HAVE_QSERIALPORT
+    stopCapture("source changed");
+    if (m_serialPort) {
+        m_serialPort->close();
+        m_serialPort.reset();
+    }
+    m_isConnected = false;
+    m_parser->setFormat(UARTParser::Format::Text);
+    m_connectBtn->setText("Connect");
+    m_statusLabel->setText("Disconnected (using stdin)");
+    m_statusLabel->setStyleSheet("color: #888;");
+    if (m_options.ioThread) {
+        startIngestThread(STDIN_FILENO, UARTParser::Format::Text, false);
+    } else {
+        m_stdinNotifier->setEnabled(true);
+    }
 #endif
 }
 
+void MainWindow::onPortLost() {
+    if (!m_isConnected) return;
+    LOG_WARN_MSG("[Serial] {} went away; reconnecting when it returns", m_reconnect.portName.toStdString());
+    disconnectPort();
+    m_reconnect.pending = true;
+    m_connectBtn->setText("Cancel");
+    m_statusLabel->setText(m_reconnect.portName + " unplugged, waiting for it");
+    m_statusLabel->setStyleSheet("color: #d9534f;");
+    m_reconnectTimer->start();
+}
+
+// Also retried once a second while waiting: udev may not have given the
+// node its permissions yet when it first appears
+void MainWindow::onReconnectTimer() {
+    if (!m_reconnect.pending) {
+        m_reconnectTimer->stop();
+        return;
+    }
+    if (m_replay) return;
+
+    // The same adapter under whatever name it came back as; otherwise the
+    // same name
+    QString portName = m_reconnect.portName;
+    const SerialPortInfo &previous = m_reconnect.port;
+    if (!previous.serialNumber.empty()) {
+        auto it = std::find_if(m_ports.begin(), m_ports.end(), [&](const SerialPortInfo &port) {
+            return port.serialNumber == previous.serialNumber && port.usbId == previous.usbId;
+        });
+        if (it == m_ports.end()) return;
+        portName = QString::fromStdString(it->name);
+    } else if (!previous.name.empty()) {
+        if (!findPort(m_ports, portName)) return;
+    } else {
+        QString path = portName.startsWith('/') ? portName : "/dev/" + portName;
+        if (!QFileInfo::exists(path)) return;
+    }
+
+    QString error;
+    if (!connectPort(portName, m_reconnect.format, m_reconnect.baud, &error)) {
+        LOG_DEBUG_MSG("[Serial] Reconnect: {}", error.toStdString());
+        return;
+    }
+    m_reconnectTimer->stop();
+    LOG_INFO_MSG("[Serial] Reconnected to {}", portName.toStdString());
+}
+
 void MainWindow::onSerialDataReady() {
 #ifdef HAVE_QSERIALPORT
     if (!m_serialPort) return;
     
-    QByteArray data = m_serialPort->readAll();
-    
-    // Debug: Print all incoming bytes to stdout
-    std::cout << "[Serial] Received " << data.size() << " bytes: ";
-    for (unsigned char byte : data) {
-        // Print as hex and decimal
-        std::cout << "0x" << std::hex << (int)byte << std::dec 
-                  << "(" << (int)byte << ") ";
-    }
-    std::cout << "\n";
-    
-    // Also print as ASCII if printable
-    std::cout << "[Serial] ASCII interpretation: ";
-    for (unsigned char byte : data) {
-        if (byte >= 32 && byte <= 126) {
-            std::cout << (char)byte;
-        } else {
-            std::cout << ".";
-        }
+    // Read straight into the ring buffer's free space
+    uint64_t readStart = monotonicNanos();
+    size_t received = 0;
+    ByteRingBuffer::Span spans[2];
+    int count = m_serialBuffer.writableSpans(spans);
+    for (int i = 0; i < count; ++i) {
+        qint64 n = m_serialPort->read(reinterpret_cast<char *>(spans[i].data), spans[i].size);
+        if (n <= 0) break;
+        m_serialBuffer.commit(static_cast<size_t>(n));
+        received += static_cast<size_t>(n);
+        if (static_cast<size_t>(n) < spans[i].size) break;
     }
-    std::cout << "\n";
-    
-    // Extract upper/lower nibbles (rotary position and button index)
-    for (unsigned char byte : data) {
-        int upper_nibble = (byte >> 4) & 0x0F;  // Rotary position (pitch)
-        int lower_nibble = byte & 0x0F;         // Button index (beat)
-        
-        // Check for sync message (0xFF = period complete)
-        if (byte == 0xFF) {
-            std::cout << "[Serial] SYNC: Period completed, resetting to beat 0\n";
-            m_model->setCurrentBeat(0);
-            continue;
-        }
-        
-        std::cout << "[Serial] Parsed: Rotary=" << upper_nibble 
-                  << ", Button=" << lower_nibble << "\n";
-        
-        // Update the model with the new pitch for this beat
-        if (lower_nibble < 16) {  // Valid beat index
-            m_model->setBeatPitch(lower_nibble, upper_nibble);
-            std::cout << "[Serial] Set beat " << lower_nibble 
-                      << " to pitch " << upper_nibble << "\n";
-        }
+    if (received == 0) return;
+    uint64_t readDone = monotonicNanos();
+    m_stats.record(IngestStats::STAGE_READ, readDone - readStart);
+    m_stats.addBytes(received);
+
+    // Opt-in byte dump: compiled out below SEQ_LOG_MIN_LEVEL, one branch otherwise
+    ByteRingBuffer::ConstSpan buffered[2];
+    int bufferedCount = m_serialBuffer.readableSpans(buffered);
+    for (int i = 0; i < bufferedCount; ++i) {
+        LOG_TRACE_HEX("[Serial] RX {}", buffered[i].data, buffered[i].size);
     }
-    
-    m_serialBuffer += data;
-    
-    int pos;
-    while ((pos = m_serialBuffer.indexOf('\n')) != -1) {
-        QString line = m_serialBuffer.left(pos).trimmed();
-        m_serialBuffer.remove(0, pos + 1);
-        
-        if (!line.isEmpty()) {
-            std::cout << "[Serial Line] " << line.toStdString() << "\n";
-            m_parser->parseLine(line.toStdString());
-        }
+
+    // Single pass: the parser decodes raw bytes or text lines per its format
+    drainBuffer(m_serialBuffer, readDone);
+
+    // More data than free space: come back for the rest after the UI breathes
+    if (m_serialPort->bytesAvailable() > 0) {
+        QMetaObject::invokeMethod(this, &MainWindow::onSerialDataReady, Qt::QueuedConnection);
     }
 #endif
 }
 
 void MainWindow::onStdinReady() {
-    char buf[256];
-    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf) - 1);
-    if (n > 0) {
-        buf[n] = '\0';
-        m_stdinBuffer += buf;
-
-        size_t pos;
-        while ((pos = m_stdinBuffer.find('\n')) != std::string::npos) {
-            std::string line = m_stdinBuffer.substr(0, pos);
-            m_stdinBuffer.erase(0, pos + 1);
-            if (!line.empty()) {
-                std::cout << "[Stdin] " << line << "\n";
-                m_parser->parseLine(line);
-            }
-        }
+    // EOF: stop polling a closed descriptor
+    if (!readSource(STDIN_FILENO, m_stdinBuffer)) m_stdinNotifier->setEnabled(false);
+}
+
+void MainWindow::onReplayReady() {
+    if (!readSource(m_replayFd, m_replayBuffer)) stopReplay();
+}
+
+bool MainWindow::readSource(int fd, ByteRingBuffer &buffer) {
+    uint64_t readStart = monotonicNanos();
+    ssize_t n = buffer.readFrom(fd);
+    uint64_t readDone = monotonicNanos();
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EINTR;
+    m_stats.record(IngestStats::STAGE_READ, readDone - readStart);
+    m_stats.addBytes(static_cast<uint64_t>(n));
+
+    drainBuffer(buffer, readDone);
+    return true;
+}
+
+void MainWindow::drainBuffer(ByteRingBuffer &buffer, uint64_t readTimestamp) {
+    SequencerModel::Batch batch(*m_model);
+    m_parser->setSourceTimestamp(readTimestamp);
+    ByteRingBuffer::ConstSpan spans[2];
+    int count = buffer.readableSpans(spans);
+    for (int i = 0; i < count; ++i) {
+        if (m_capture) m_capture->append(readTimestamp, spans[i].data, spans[i].size);
+        m_parser->feed(spans[i].data, spans[i].size);
     }
+    buffer.consume(buffer.size());
 }
 
-void MainWindow::onTimerTick() {
-    int nextBeat = (m_model->currentBeat() + 1) % 16;
-    m_model->setCurrentBeat(nextBeat);
+void MainWindow::startIngestThread(int fd, UARTParser::Format format, bool ownsFd) {
+    stopIngestThread();
+    m_ingest = std::make_unique<IngestThread>(fd, format, ownsFd, &m_stats);
+    m_ingest->setCapture(m_capture.get());
+    if (!m_ingest->start()) {
+        LOG_ERROR_MSG("[Ingest] Failed to start I/O thread");
+        m_ingest.reset();
+        return;
+    }
+    m_lastDropped = 0;
+    m_drainTimer->start();
 }
 
-void MainWindow::updateBeatDisplay(int beat) {
-    if (m_beatButtons.empty()) return; // Safety check
-    
-    // Map pitches 1-8 to musical notes C4-C5
-    const char* noteNames[9] = {
-        "REST",  // pitch 0
-        "C4",    // pitch 1
-        "D4",    // pitch 2
-        "E4",    // pitch 3
-        "F4",    // pitch 4
-        "G4",    // pitch 5
-        "A5",    // pitch 6
-        "B5",    // pitch 7
-        "C5"     // pitch 8
-    };
-    
-    for (size_t i = 0; i < m_beatButtons.size(); ++i) {
-        if (!m_beatButtons[i]) continue; // Skip null pointers
-        
-        int pitch = m_model->getBeatPitch(i);
-        bool isCurrent = ((int)i == beat);
-        
-        QString style = "font-size: 20px; font-weight: bold;";
-        QString text = QString::number(i);
-        
-        if (pitch > 0 && pitch <= 8) {
-            text += QString("\n%1").arg(noteNames[pitch]);
-        } else if (pitch == 0) {
-            // Don't show REST text to keep it clean
-        }
-        
-        // HSV color mapping: pitch 1-8 maps across the color spectrum
-        QString bgColor;
-        if (pitch == 0) {
-            bgColor = "#333";  // Dark gray for no pitch (rest)
-        } else if (pitch >= 1 && pitch <= 8) {
-            // Map pitch 1-8 to 8 evenly spaced hues across 360 degrees
-            // Pitch 1=0°, 2=45°, 3=90°, 4=135°, 5=180°, 6=225°, 7=270°, 8=315°
-            int hue = ((pitch - 1) * 360) / 8;  // 0, 45, 90, 135, 180, 225, 270, 315
-            int saturation = 200;  // High saturation for vivid colors
-            int value = 180;       // Medium-high brightness
-            
-            QColor color = QColor::fromHsv(hue, saturation, value);
-            bgColor = color.name();
-        } else {
-            // Invalid pitch value - show as dark gray
-            bgColor = "#333";
+void MainWindow::stopIngestThread() {
+    if (!m_ingest) return;
+    m_ingest->stop();
+    m_ingest->setCapture(nullptr);
+    onDrainTimer();  // apply whatever was already decoded
+    m_drainTimer->stop();
+    m_ingest.reset();
+}
+
+void MainWindow::onDrainTimer() {
+    if (!m_ingest) return;
+
+    SequencerModel::Batch batch(*m_model);
+    IngestEvent event;
+    while (m_ingest->tryPop(event)) {
+        m_model->noteSourceTimestamp(event.timestampNs);
+        switch (event.kind) {
+        case IngestEvent::Kind::Pitch:
+            m_model->setBeatPitch(event.beat, event.pitch);
+            break;
+        case IngestEvent::Kind::CurrentBeat:
+            m_model->setCurrentBeat(event.beat);
+            break;
+        case IngestEvent::Kind::Sync:
+            LOG_DEBUG_MSG("[Serial] SYNC: Period completed, resetting to beat 0");
+            m_model->setCurrentBeat(0);
+            onClockSync(event.timestampNs);
+            break;
+        case IngestEvent::Kind::BeatCount:
+            applyBoardBeatCount(event.beat ? event.beat : 256);
+            break;
         }
-        
-        if (isCurrent) {
-            // Current beat: add yellow border and brighten color
-            if (pitch > 0) {
-                style += QString(" background-color: %1; color: white; border: 4px solid yellow;").arg(bgColor);
-            } else {
-                style += " background-color: #444; color: white; border: 4px solid yellow;";
-            }
-        } else {
-            // Not current beat
-            if (pitch > 0) {
-                style += QString(" background-color: %1; color: white;").arg(bgColor);
-            } else {
-                style += " background-color: #222; color: #666;";
-            }
+    }
+
+    // Overflow accounting: the queue only drops when the UI falls behind
+    uint64_t dropped = m_ingest->droppedEvents();
+    if (dropped != m_lastDropped || m_ingestLabel->text().isEmpty()) {
+        m_lastDropped = dropped;
+        m_ingestLabel->setText(QString("Dropped: %1").arg(dropped));
+        m_ingestLabel->setStyleSheet(dropped > 0 ? "color: #d9534f;" : "color: #888;");
+    }
+
+    // Threaded replay ends when the I/O thread sees EOF, a device when
+    // it is unplugged
+    if (m_replay && m_ingest->finished()) {
+        stopReplay();
+    } else if (m_isConnected && m_ingest->finished()) {
+        onPortLost();
+    }
+}
+
+void MainWindow::onStatsDumpTimer() {
+    std::string line = m_stats.toJsonLine(monotonicNanos());
+    line += '\n';
+    m_statsFile.write(line.data(), static_cast<qint64>(line.size()));
+    m_statsFile.flush();
+}
+
+void MainWindow::onCaptureClicked() {
+    if (m_capture) {
+        stopCapture("stopped");
+        return;
+    }
+
+    QString filename = QFileDialog::getSaveFileName(this, "Capture UART Input",
+        "session.seqcap", "Capture Files (*.seqcap);;All Files (*)");
+    if (filename.isEmpty()) return;
+
+    // Record in the format the active source is decoded with
+    UARTParser::Format format = m_ingest ? m_ingest->format() : m_parser->format();
+    auto capture = std::make_unique<CaptureWriter>();
+    std::string error;
+    if (!capture->open(filename.toStdString(), format, &error)) {
+        QMessageBox::critical(this, "Capture Error", QString::fromStdString(error));
+        return;
+    }
+    m_capture = std::move(capture);
+    if (m_ingest) m_ingest->setCapture(m_capture.get());
+
+    m_captureBtn->setText("Stop Capture");
+    m_captureLabel->setText("Capturing to " + QFileInfo(filename).fileName());
+    LOG_INFO_MSG("[Capture] Recording to {}", filename.toStdString());
+}
+
+void MainWindow::stopCapture(const char *reason) {
+    if (!m_capture) return;
+    if (m_ingest) m_ingest->setCapture(nullptr);
+    m_capture->close();
+    LOG_INFO_MSG("[Capture] {}: {} bytes in {} reads{}", reason,
+                 m_capture->bytesCaptured(), m_capture->recordsCaptured(),
+                 m_capture->failed() ? " (write error)" : "");
+    m_captureLabel->setText(QString("Captured %1 bytes%2")
+                                .arg(m_capture->bytesCaptured())
+                                .arg(m_capture->failed() ? " (write error)" : ""));
+    m_capture.reset();
+    m_captureBtn->setText("Start Capture...");
+}
+
+void MainWindow::onReplayClicked() {
+    if (m_replay) {
+        stopReplay();
+        return;
+    }
+    if (m_isConnected) {
+        QMessageBox::information(this, "Serial Connected", "Disconnect before replaying a capture.");
+        return;
+    }
+
+    QString filename = QFileDialog::getOpenFileName(this, "Replay Capture",
+        "", "Capture Files (*.seqcap);;All Files (*)");
+    if (filename.isEmpty()) return;
+    startReplay(filename, m_replaySpeedCombo->currentData().toDouble());
+}
+
+bool MainWindow::startReplay(const QString &path, double speed) {
+    auto replay = std::make_unique<ReplaySource>();
+    std::string error;
+    if (!replay->open(path.toStdString(), &error)) {
+        QMessageBox::critical(this, "Replay Error", QString::fromStdString(error));
+        return false;
+    }
+    int fd = replay->start(speed);
+    if (fd < 0) {
+        QMessageBox::critical(this, "Replay Error", "Could not start the replay feeder.");
+        return false;
+    }
+
+    // The replay replaces stdin as the input, through the same read path
+    stopCapture("source changed");
+    m_replay = std::move(replay);
+    m_replayFramesStart = m_stats.frames();
+    if (m_options.ioThread) {
+        startIngestThread(fd, m_replay->format(), true);
+    } else {
+        m_stdinNotifier->setEnabled(false);
+        m_parser->setFormat(m_replay->format());
+        m_replayBuffer.clear();
+        m_replayFd = fd;
+        m_replayNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(m_replayNotifier, &QSocketNotifier::activated, this, &MainWindow::onReplayReady);
+    }
+
+    QString speedText = speed > 0 ? QString("%1x").arg(speed) : QString("max speed");
+    m_replayBtn->setText("Stop Replay");
+    m_captureBtn->setEnabled(false);
+    m_connectBtn->setEnabled(false);
+    m_captureLabel->setText("Replaying " + QFileInfo(path).fileName() + " at " + speedText);
+    LOG_INFO_MSG("[Replay] {} at {}", path.toStdString(), speedText.toStdString());
+    return true;
+}
+
+void MainWindow::onAddBoardClicked() {
+    bool ok = false;
+    QString path = QInputDialog::getText(this, "Add Board",
+        "Serial device, pipe or capture file (.seqcap):", QLineEdit::Normal,
+        m_portCombo->currentIndex() > 0 ? m_portCombo->currentText() : QString(), &ok);
+    if (!ok || path.trimmed().isEmpty()) return;
+    addBoard(path.trimmed(), static_cast<UARTParser::Format>(m_formatCombo->currentData().toInt()),
+             m_baudCombo->currentData().toInt());
+}
+
+bool MainWindow::addBoard(const QString &path, UARTParser::Format format, int baud) {
+    // Started on first use, so a single-board session costs no threads
+    if (!m_boards) {
+        auto boards = std::make_unique<SessionManager>(0);
+        if (!boards->start()) {
+            QMessageBox::critical(this, "Board Error", "Could not start the board reactor.");
+            return false;
         }
-        
-        m_beatButtons[i]->setText(text);
-        m_beatButtons[i]->setStyleSheet(style);
+        m_boards = std::move(boards);
+        // Overview refresh at ~30 Hz; idle rows are not repainted
+        m_boardsTimer = new QTimer(this);
+        connect(m_boardsTimer, &QTimer::timeout, this, &MainWindow::onBoardsRefresh);
+        m_boardsTimer->start(33);
+    }
+
+    BoardSession::Config config;
+    config.name = path.toStdString();
+    config.format = format;
+    config.beats = m_model->numBeats();
+    config.periodNs = m_clock.periodNs();
+
+    std::string error;
+    int id = path.endsWith(".seqcap")
+                 ? m_boards->addReplay(config, config.name, m_replaySpeedCombo->currentData().toDouble(), &error)
+                 : m_boards->addDevice(config, config.name, baud, &error);
+    if (id < 0) {
+        QMessageBox::critical(this, "Board Error", QString::fromStdString(error));
+        return false;
+    }
+    LOG_INFO_MSG("[Boards] Added {} as board {}", config.name, id);
+    onBoardsRefresh();
+    return true;
+}
+
+void MainWindow::onRemoveBoardClicked() {
+    int id = m_boardOverview->selectedBoard();
+    if (!m_boards || id < 0) return;
+    m_boards->removeBoard(id);
+    m_removeBoardBtn->setEnabled(false);
+    onBoardsRefresh();
+}
+
+void MainWindow::onBoardsRefresh() {
+    m_boardOverview->setSnapshots(m_boards->snapshots());
+}
+
+void MainWindow::stopReplay() {
+    // Moved out first: stopIngestThread() drains, which can land back here
+    std::unique_ptr<ReplaySource> replay = std::move(m_replay);
+    if (!replay) return;
+    replay->stop();
+
+    if (m_replayNotifier) {
+        // May be running inside this notifier's own activated() slot
+        m_replayNotifier->setEnabled(false);
+        m_replayNotifier->deleteLater();
+        m_replayNotifier = nullptr;
+        ::close(m_replayFd);
+        m_replayFd = -1;
+    }
+    if (m_options.ioThread) stopIngestThread();  // closes the read end
+
+    // Throughput of the whole read/decode/model path for this replay
+    double seconds = replay->elapsedNs() / 1e9;
+    uint64_t frames = m_stats.frames() - m_replayFramesStart;
+    double mbPerSecond = seconds > 0 ? replay->bytesSent() / seconds / (1024.0 * 1024.0) : 0.0;
+    LOG_INFO_MSG("[Replay] {} bytes, {} frames in {} s ({} MB/s){}", replay->bytesSent(), frames,
+                 seconds, mbPerSecond, replay->truncated() ? ", capture truncated" : "");
+    m_captureLabel->setText(QString("Replayed %1 bytes, %2 frames in %3 s (%4 MB/s)%5")
+                                .arg(replay->bytesSent())
+                                .arg(frames)
+                                .arg(seconds, 0, 'f', 3)
+                                .arg(mbPerSecond, 0, 'f', 2)
+                                .arg(replay->truncated() ? ", capture truncated" : ""));
+
+    // Back to stdin
+    m_parser->setFormat(UARTParser::Format::Text);
+    if (m_options.ioThread) {
+        startIngestThread(STDIN_FILENO, UARTParser::Format::Text, false);
+    } else {
+        m_stdinNotifier->setEnabled(true);
+    }
+    m_replayBtn->setText("Replay...");
+    m_captureBtn->setEnabled(true);
+#ifdef HAVE_QSERIALPORT
+    m_connectBtn->setEnabled(true);
+#endif
+}
+
+void MainWindow::onTimerTick() {
+    m_beatDeadline.acknowledge();
+    uint64_t now = monotonicNanos();
+    m_model->setCurrentBeat(m_clock.beatAt(now));
+    scheduleNextBeat(now);
+}
+
+void MainWindow::scheduleNextBeat(uint64_t nowNs) {
+    uint64_t next = m_clock.nextBeatAt(nowNs);
+    if (m_beatDeadline.arm(next)) return;
+    // Millisecond fallback, still re-aimed at the clock every beat
+    m_beatTimer->start(static_cast<int>((next - nowNs + 999999) / 1000000));
+}
+
+void MainWindow::onClockSync(uint64_t timestampNs) {
+    bool wasLocked = m_clock.locked();
+    uint64_t oldPeriod = m_clock.periodNs();
+    m_clock.sync(timestampNs);
+    scheduleNextBeat(monotonicNanos());
+
+    if (m_clock.locked() != wasLocked) {
+        LOG_INFO_MSG("[Clock] {} SYNC, period {} s", m_clock.locked() ? "Locked to" : "Lost",
+                     m_clock.periodNs() / 1e9);
+    }
+    // Once per period; only touch the widgets when the text changes
+    if (m_clock.locked() != wasLocked || m_clock.periodNs() / 1000000 != oldPeriod / 1000000 ||
+        m_clock.syncs() % 8 == 0) {
+        updateTimingDisplay();
+    }
+
+    // The monitor restarts its period here, whichever path the SYNC took
+    ++m_syncSerial;
+    updateMonitor();
+}
+
+void MainWindow::onBeatsChanged(int beats) {
+    m_model->setNumBeats(beats);
+    m_clock.setNumBeats(m_model->numBeats());
+    scheduleNextBeat(monotonicNanos());
+    updateTimingDisplay();
+}
+
+void MainWindow::onPeriodChanged(double seconds) {
+    m_clock.setPeriod(static_cast<uint64_t>(seconds * 1e9));
+    scheduleNextBeat(monotonicNanos());
+    updateTimingDisplay();
+    updateMonitor();
+}
+
+void MainWindow::startMonitor(const QString &out) {
+    std::unique_ptr<AudioSink> sink;
+    if (out == "null") sink = std::make_unique<NullAudioSink>();
+    else sink = std::make_unique<WavFileSink>(out.toStdString());
+    auto audio = std::make_unique<AudioEngine>(std::move(sink), AudioEngine::Config());
+    std::string error;
+    if (!audio->start(&error)) {
+        LOG_WARN_MSG("[Audio] {}", error);
+        return;
+    }
+    m_audio = std::move(audio);
+    updateMonitor();
+    LOG_INFO_MSG("[Audio] Monitoring into {} ({} ms blocks{})", out.toStdString(),
+                 m_audio->latencyNs() / 1e6, m_audio->realTimePriority() ? ", SCHED_FIFO" : "");
+}
+
+// Whole pattern to the audio thread; never blocks
+void MainWindow::updateMonitor() {
+    if (!m_audio) return;
+    SynthPattern pattern;
+    pattern.pitches = m_model->pitches();
+    pattern.beats = m_model->numBeats();
+    pattern.periodNs = m_clock.periodNs();
+    pattern.syncSerial = m_syncSerial;
+    m_audio->setPattern(pattern);
+}
+
+void MainWindow::applyBoardBeatCount(int beats) {
+    if (beats == m_beatsSpin->value()) return;
+    LOG_INFO_MSG("[Serial] Board reports {} beats", beats);
+    m_beatsSpin->setValue(beats);  // resizes the model and clock
+}
+
+void MainWindow::updateTimingDisplay() {
+    double period = m_clock.periodNs() / 1e9;
+    int beats = m_clock.numBeats();
+    m_beatGroup->setTitle(QString("%1-Beat Sequencer (%2 BPS, %3ms/beat)")
+                              .arg(beats)
+                              .arg(beats / period, 0, 'g', 3)
+                              .arg(period * 1000.0 / beats, 0, 'f', 1));
+    if (m_clock.locked()) {
+        m_clockLabel->setText(QString("SYNC locked: %1 s, jitter %2 ms")
+                                  .arg(period, 0, 'f', 4)
+                                  .arg(m_clock.jitterNs() / 1e6, 0, 'f', 2));
+    } else {
+        m_clockLabel->setText(m_clock.syncs() ? "Acquiring SYNC..." : "Free-running (no SYNC)");
     }
 }
 
 void MainWindow::onResetClicked() {
-    std::cout << "[GUI] Resetting all beats to 0\n";
+    LOG_INFO_MSG("[GUI] Resetting all beats to 0");
     
-    // Clear all beat pitches in the model
-    for (int i = 0; i < NUM_BEATS; ++i) {
-        m_model->setBeatPitch(i, 0);
+    {
+        // Clear all beats and rewind as one transaction: a single redraw
+        SequencerModel::Batch batch(*m_model);
+        for (int i = 0; i < m_model->numBeats(); ++i) {
+            m_model->setBeatPitch(i, 0);
+        }
+        m_model->setCurrentBeat(0);
     }
     
-    // Reset current beat to 0
-    m_model->setCurrentBeat(0);
-    
-    // Update display
-    updateBeatDisplay(0);
-    
-    std::cout << "[GUI] Reset complete\n";
+    LOG_INFO_MSG("[GUI] Reset complete");
 }
 
 void MainWindow::onSaveClicked() {
-    QString filename = QFileDialog::getSaveFileName(this, "Save Sequence", 
-        "", "Text Files (*.txt);;All Files (*)");
-    
+    const QString reportFilter = "Sequencer Report (*.txt)";
+    QString filter;
+    QString filename = QFileDialog::getSaveFileName(this, "Save Pattern", m_patternSource,
+        "Pattern Bank (*.seqbank);;Pattern List (*.txt);;" + reportFilter + ";;All Files (*)", &filter);
     if (filename.isEmpty()) return;
-    
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, "Save Error", "Could not open file for writing.");
+    if (filename.endsWith(".seqcap")) {
+        QMessageBox::critical(this, "Save Error", "Captures are read-only; save into a .seqbank or .txt file.");
         return;
     }
-    
-    QTextStream out(&file);
-    out << "FPGA Sequencer State\n";
-    out << "====================\n\n";
-    
-    out << "Beat Data (3 bits per beat for pitch):\n";
-    for (int i = 0; i < 16; ++i) {
-        int pitch = m_model->getBeatPitch(i);
-        out << QString("  Beat %1: Pitch %2 %3\n")
-            .arg(i, 2)
-            .arg(pitch)
-            .arg(pitch > 0 ? QString("(0b%1)").arg(pitch, 3, 2, QChar('0')) : "(OFF)");
+
+    Pattern pattern;
+    pattern.pitches = m_model->pitches();
+    pattern.beats = m_model->numBeats();
+    const std::string path = filename.toStdString();
+    std::string error;
+
+    // A report holds the one pattern, unnamed; saving over one keeps it a
+    // report rather than turning it into a list
+    if (filter == reportFilter || (!filename.endsWith(".seqbank") && isReport(path))) {
+        if (!saveReport(path, pattern, &error)) {
+            QMessageBox::critical(this, "Save Error", QString::fromStdString(error));
+            return;
+        }
+        LOG_INFO_MSG("[GUI] Saved report to {}", path);
+        if (filename == m_patternSource) openPatterns(filename, false);
+        m_patternLabel->setText(QString("Saved report to %1").arg(QFileInfo(filename).fileName()));
+        return;
     }
-    
-    out << "\nActive Beats:\n";
-    for (int i = 0; i < 16; ++i) {
-        if (m_model->isBeatActive(i)) {
-            out << QString("  Beat %1: Pitch %2\n").arg(i).arg(m_model->getBeatPitch(i));
+
+    bool ok = false;
+    QString name = QInputDialog::getText(this, "Save Pattern", "Pattern name:", QLineEdit::Normal,
+                                         QString("pattern-%1").arg(loadedPatternCount() + 1), &ok);
+    // One word, as pattern lists need
+    name = name.simplified().replace(' ', '_');
+    if (!ok || name.isEmpty()) return;
+    pattern.name = name.toStdString();
+
+    // Added to what the file holds, replacing a pattern of the same name
+    std::vector<Pattern> patterns;
+    if (QFileInfo(filename).size() > 0 && !loadPatterns(path, patterns, &error)) {
+        QMessageBox::critical(this, "Save Error", QString::fromStdString(error));
+        return;
+    }
+    auto same = std::find_if(patterns.begin(), patterns.end(),
+                             [&](const Pattern &p) { return p.name == pattern.name; });
+    if (same != patterns.end()) *same = pattern;
+    else patterns.push_back(pattern);
+
+    bool bank = filename.endsWith(".seqbank") || PatternBank::isBank(path);
+    if (!(bank ? writePatternBank(path, patterns, &error) : savePatternList(path, patterns, &error))) {
+        QMessageBox::critical(this, "Save Error", QString::fromStdString(error));
+        return;
+    }
+    LOG_INFO_MSG("[GUI] Saved pattern {} to {} ({} patterns)", pattern.name, path, patterns.size());
+
+    // The file was replaced; browse the new one if it was being browsed
+    if (filename == m_patternSource) openPatterns(filename, false);
+    m_patternLabel->setText(QString("Saved %1 to %2").arg(name, QFileInfo(filename).fileName()));
+}
+
+void MainWindow::onLoadClicked() {
+    QString filename = QFileDialog::getOpenFileName(this, "Load Patterns", m_patternSource,
+        "Patterns (*.seqbank *.txt *.seqcap);;All Files (*)");
+    if (filename.isEmpty()) return;
+    openPatterns(filename);
+}
+
+// A bank is mapped and only its header read, however many patterns it
+// holds; other sources go through loadPatterns()
+bool MainWindow::openPatterns(const QString &path, bool applyFirst) {
+    const std::string file = path.toStdString();
+    auto bank = std::make_unique<PatternBank>();
+    std::vector<Pattern> patterns;
+    std::string error;
+    bool ok;
+    if (PatternBank::isBank(file)) {
+        ok = bank->open(file, &error);
+        if (ok && bank->size() == 0) {
+            error = file + ": no patterns";
+            ok = false;
         }
+    } else {
+        bank.reset();
+        ok = loadPatterns(file, patterns, &error);
     }
-    
-    file.close();
-    QMessageBox::information(this, "Saved", "Sequence saved to " + filename);
+    if (!ok) {
+        LOG_WARN_MSG("[GUI] {}", error);
+        QMessageBox::critical(this, "Load Error", QString::fromStdString(error));
+        return false;
+    }
+
+    m_bank = std::move(bank);
+    m_patterns = std::move(patterns);
+    m_patternSource = path;
+    m_searchIndex.reset();  // built on the first search
+    m_similarResults->clear();
+    m_similarResults->setEnabled(false);
+    const size_t count = loadedPatternCount();
+    LOG_INFO_MSG("[GUI] {} patterns in {}", count, file);
+    {
+        QSignalBlocker blocker(m_patternSpin);
+        m_patternSpin->setRange(0, int(std::min<size_t>(count, INT_MAX) - 1));
+        if (applyFirst) m_patternSpin->setValue(0);
+    }
+    m_patternSpin->setEnabled(true);
+    m_patternFind->setEnabled(true);
+    m_similarBtn->setEnabled(true);
+    if (applyFirst) onPatternIndexChanged(0);
+    return true;
+}
+
+size_t MainWindow::loadedPatternCount() const {
+    return m_bank ? m_bank->size() : m_patterns.size();
+}
+
+bool MainWindow::loadedPattern(size_t index, Pattern &out) const {
+    if (index >= loadedPatternCount()) return false;
+    if (m_bank) return m_bank->get(index, out);
+    out = m_patterns[index];
+    return true;
+}
+
+void MainWindow::onPatternIndexChanged(int index) {
+    Pattern pattern;
+    if (!loadedPattern(size_t(index), pattern)) {
+        m_patternLabel->setText(QString("Pattern %1 is damaged").arg(index));
+        return;
+    }
+    applyPattern(pattern);
+    m_patternLabel->setText(QString("%1 of %2: %3")
+                                .arg(index + 1)
+                                .arg(loadedPatternCount())
+                                .arg(QString::fromStdString(pattern.name)));
+}
+
+void MainWindow::onPatternFindEntered() {
+    const std::string name = m_patternFind->text().trimmed().toStdString();
+    long index = -1;
+    if (m_bank) {
+        index = m_bank->find(name);
+    } else {
+        for (size_t i = 0; i < m_patterns.size() && index < 0; ++i) {
+            if (m_patterns[i].name == name) index = long(i);
+        }
+    }
+    if (index < 0 || index > m_patternSpin->maximum()) {
+        m_patternLabel->setText(QString("No pattern named %1").arg(QString::fromStdString(name)));
+        return;
+    }
+    if (index == m_patternSpin->value()) onPatternIndexChanged(int(index));
+    else m_patternSpin->setValue(int(index));
+}
+
+void MainWindow::onFindSimilarClicked() {
+    const size_t count = loadedPatternCount();
+    if (count == 0) return;
+    if (!m_searchIndex) {
+        m_searchIndex = std::make_unique<PatternIndex>();
+        if (m_bank) {
+            m_searchIndex->add(*m_bank);
+        } else {
+            for (const Pattern &pattern : m_patterns) m_searchIndex->add(pattern.pitches);
+        }
+    }
+
+    auto metric = static_cast<PatternIndex::Metric>(m_similarMetric->currentData().toInt());
+    uint64_t start = monotonicNanos();
+    std::vector<PatternIndex::Match> matches =
+        m_searchIndex->search(m_model->pitches(), m_model->numBeats(), SIMILAR_RESULTS, metric);
+    double ms = (monotonicNanos() - start) / 1e6;
+
+    m_similarResults->clear();
+    for (const PatternIndex::Match &match : matches) {
+        Pattern pattern;
+        QString name = loadedPattern(match.index, pattern) ? QString::fromStdString(pattern.name)
+                                                           : QString("#%1").arg(match.index);
+        m_similarResults->addItem(QString("%1 (distance %2)").arg(name).arg(match.distance),
+                                  static_cast<qulonglong>(match.index));
+    }
+    m_similarResults->setEnabled(!matches.empty());
+    m_patternLabel->setText(QString("%1 nearest of %2 in %3 ms").arg(matches.size()).arg(count).arg(ms, 0, 'f', 2));
+    LOG_INFO_MSG("[GUI] Similar patterns: {} of {} searched in {} ms", matches.size(), count, ms);
+}
+
+void MainWindow::onSimilarChosen(int row) {
+    if (row < 0) return;
+    const int index = int(m_similarResults->itemData(row).toULongLong());
+    if (index == m_patternSpin->value()) onPatternIndexChanged(index);
+    else m_patternSpin->setValue(index);
+}
+
+// Length first, so the pitches are not cut to the old length
+void MainWindow::applyPattern(const Pattern &pattern) {
+    m_beatsSpin->setValue(pattern.beats);  // resizes the model and clock
+    m_model->setPitches(pattern.pitches);
 }
@@ -2,8 +2,10 @@
 
 #include <QMainWindow>
 #include <QString>
+#include <QStringList>
 #include <QTimer>
 #include <QSocketNotifier>
+#include <QFile>
 #ifdef HAVE_QSERIALPORT
 #include <QSerialPort>
 #endif
@@ -11,16 +13,51 @@
 #include <memory>
 #include "sequencer_model.h"
 #include "uart_parser.h"
+#include "ring_buffer.h"
+#include "ingest_thread.h"
+#include "ingest_stats.h"
+#include "capture_file.h"
+#include "replay_source.h"
+#include "beat_clock.h"
+#include "deadline_timer.h"
+#include "session_manager.h"
+#include "audio_engine.h"
+#include "pattern_bank.h"
+#include "pattern_search.h"
+#include "port_watcher.h"
 
 class QPushButton;
 class QComboBox;
 class QLabel;
+class QGroupBox;
+class QSpinBox;
+class QDoubleSpinBox;
+class QLineEdit;
 class PitchGraphWidget;
+class BeatGridWidget;
+class StatsPanel;
+class BoardOverviewWidget;
+
+// Start-up options, filled from the command line in main.cpp
+struct GuiOptions {
+    bool ioThread = false;  // read and decode input on a dedicated thread
+    size_t historyBudget = 4 * 1024 * 1024;  // bytes of pitch graph history
+    QString statsFile;          // JSON-lines latency dump, empty = off
+    int statsIntervalMs = 1000;
+    int numBeats = 16;           // beats per period until changed in the UI
+    double periodSeconds = 4.0;  // nominal period; SYNC markers refine it
+    int baudRate = 1000000;      // must match BAUD_RATE in hdl/top.sv
+    QString replayFile;         // capture to play back on start-up
+    double replaySpeed = 1.0;   // 0 = as fast as possible
+    QStringList boards;         // extra boards for the overview (devices or captures)
+    QString audioOut;           // PWM synth monitor: "null" or a .wav path, empty = off
+    QString patternFile;        // bank or pattern list to browse from start-up
+};
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
-    explicit MainWindow(QWidget *parent = nullptr);
+    explicit MainWindow(const GuiOptions &options = GuiOptions(), QWidget *parent = nullptr);
 
 private slots:
     void onStdinReady();
@@ -29,18 +66,49 @@ private slots:
     void onSaveClicked();
     void onResetClicked();
     void onTimerTick();
+    void onBeatsChanged(int beats);
+    void onPeriodChanged(double seconds);
+    void onDrainTimer();
+    void onStatsDumpTimer();
+    void onCaptureClicked();
+    void onReplayClicked();
+    void onReplayReady();
     void refreshSerialPorts();
+    void onAddBoardClicked();
+    void onRemoveBoardClicked();
+    void onBoardsRefresh();
+    void onLoadClicked();
+    void onPatternIndexChanged(int index);
+    void onPatternFindEntered();
+    void onFindSimilarClicked();
+    void onSimilarChosen(int row);
+    void onReconnectTimer();
 
 private:
     void buildUI();
-    void updateBeatDisplay(int beat);
     void updateStateDisplay(uint16_t state);
-    
-    // Timing parameters
-    static constexpr int NUM_BEATS = 16;
-    static constexpr int PERIOD = 4;  // Period in seconds for all 16 beats
-    static constexpr int BEATS_PER_SECOND = NUM_BEATS / PERIOD;  // 4 BPS
-    static constexpr int MS_PER_BEAT = (PERIOD * 1000) / NUM_BEATS;  // 250ms per beat
+    void drainBuffer(ByteRingBuffer &buffer, uint64_t readTimestamp);
+    void startIngestThread(int fd, UARTParser::Format format, bool ownsFd);
+    void stopIngestThread();
+    bool readSource(int fd, ByteRingBuffer &buffer);
+    void stopCapture(const char *reason);
+    bool startReplay(const QString &path, double speed);
+    void stopReplay();
+    void onClockSync(uint64_t timestampNs);
+    void scheduleNextBeat(uint64_t nowNs);
+    void updateTimingDisplay();
+    void applyBoardBeatCount(int beats);
+    bool addBoard(const QString &path, UARTParser::Format format, int baud);
+    void startMonitor(const QString &out);
+    void updateMonitor();
+    bool openPatterns(const QString &path, bool applyFirst = true);
+    size_t loadedPatternCount() const;
+    bool loadedPattern(size_t index, Pattern &out) const;
+    void applyPattern(const Pattern &pattern);
+    void onPortsListed(const std::vector<SerialPortInfo> &ports);
+    bool connectPort(const QString &portName, UARTParser::Format format, int baud, QString *error);
+    void disconnectPort();
+    void onPortLost();
     
     std::unique_ptr<SequencerModel> m_model;
     std::unique_ptr<UARTParser> m_parser;
@@ -48,18 +116,94 @@ private:
     std::unique_ptr<QSerialPort> m_serialPort;
 #endif
     
-    std::vector<QPushButton*> m_beatButtons;
+    BeatGridWidget *m_beatGrid;
     PitchGraphWidget *m_pitchGraph;
     QComboBox *m_portCombo;
+    QComboBox *m_formatCombo;
+    QComboBox *m_baudCombo;
     QPushButton *m_connectBtn;
     QPushButton *m_saveBtn;
     QPushButton *m_resetBtn;
     QLabel *m_statusLabel;
-    QTimer *m_beatTimer;
+
+    // Serial ports, listed and watched for hotplug off the GUI thread. A
+    // connected board that goes away is reconnected with the same settings
+    // when it comes back, found by its USB serial number when it has one.
+    std::unique_ptr<PortWatcher> m_portWatcher;
+    std::vector<SerialPortInfo> m_ports;
+    struct Reconnect {
+        bool pending = false;
+        QString portName;
+        SerialPortInfo port;  // as last listed; name only for typed paths
+        UARTParser::Format format = UARTParser::Format::Framed;
+        int baud = 0;
+    };
+    Reconnect m_reconnect;  // the current connection's settings while connected
+    QTimer *m_reconnectTimer;
+    QTimer *m_beatTimer;  // fallback when the deadline timer is unavailable
+
+    // Playhead clock: locked to the board's SYNC markers, free-running
+    // at the configured period without them
+    BeatClock m_clock;
+    DeadlineTimer m_beatDeadline;
+    QSocketNotifier *m_beatNotifier;
+    QGroupBox *m_beatGroup;
+    QSpinBox *m_beatsSpin;
+    QDoubleSpinBox *m_periodSpin;
+    QLabel *m_clockLabel;
     
+    GuiOptions m_options;
+    IngestStats m_stats;  // outlives m_ingest, which records into it
+    std::unique_ptr<CaptureWriter> m_capture;  // likewise, m_ingest appends to it
+    StatsPanel *m_statsPanel;
+    QTimer *m_statsDumpTimer;
+    QFile m_statsFile;
+    std::unique_ptr<IngestThread> m_ingest;
+    QTimer *m_drainTimer;
+    QLabel *m_ingestLabel;
+    uint64_t m_lastDropped;
+
     QSocketNotifier *m_stdinNotifier;
-    std::string m_stdinBuffer;
-    QString m_serialBuffer;
+    ByteRingBuffer m_stdinBuffer;
+    ByteRingBuffer m_serialBuffer;
+
+    // Playback of a previous capture
+    std::unique_ptr<ReplaySource> m_replay;
+    QSocketNotifier *m_replayNotifier;  // non-threaded replay only
+    int m_replayFd;
+    ByteRingBuffer m_replayBuffer;
+    uint64_t m_replayFramesStart;
+    QPushButton *m_captureBtn;
+    QPushButton *m_replayBtn;
+    QComboBox *m_replaySpeedCombo;
+    QLabel *m_captureLabel;
     
+    // Further boards, decoded off the GUI thread and shown as one row each
+    std::unique_ptr<SessionManager> m_boards;
+    BoardOverviewWidget *m_boardOverview;
+    QPushButton *m_removeBoardBtn;
+    QTimer *m_boardsTimer;
+
+    // Patterns to switch the model to: a bank stays mapped and is read a
+    // record at a time, any other source is loaded whole
+    std::unique_ptr<PatternBank> m_bank;
+    std::vector<Pattern> m_patterns;
+    QString m_patternSource;
+    QPushButton *m_loadBtn;
+    QSpinBox *m_patternSpin;
+    QLineEdit *m_patternFind;
+    QLabel *m_patternLabel;
+
+    // Nearest patterns in the loaded file to the model's
+    static constexpr size_t SIMILAR_RESULTS = 20;
+    std::unique_ptr<PatternIndex> m_searchIndex;
+    QComboBox *m_similarMetric;
+    QPushButton *m_similarBtn;
+    QComboBox *m_similarResults;
+
+    // Software copy of the board's PWM voice, fed the model's pattern
+    std::unique_ptr<AudioEngine> m_audio;
+    uint64_t m_syncSerial;
+
     bool m_isConnected;
 };
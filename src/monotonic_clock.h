@@ -0,0 +1,14 @@
+#ifndef MONOTONIC_CLOCK_H
+#define MONOTONIC_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// Nanoseconds on the steady clock. All ingest timestamps use this base so
+// they can be compared across threads.
+inline uint64_t monotonicNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#endif // MONOTONIC_CLOCK_H
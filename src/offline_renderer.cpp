@@ -0,0 +1,76 @@
+#include "offline_renderer.h"
+#include "audio_sink.h"
+#include "monotonic_clock.h"
+#include "pwm_synth.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+// Large blocks: the synth fills held notes edge to edge, so per-block
+// overhead is all that bigger blocks save, and 64K frames keeps that nil
+constexpr int RENDER_BLOCK_FRAMES = 65536;
+
+} // namespace
+
+OfflineRenderResult renderPatternWav(const Pattern &pattern, const OfflineRenderConfig &config,
+                                     const std::string &path) {
+    OfflineRenderResult result;
+    result.path = path;
+    uint64_t start = monotonicNanos();
+
+    PwmSynth synth(config.sampleRate);
+    synth.setGain(config.gain);
+    SynthPattern synthPattern;
+    synthPattern.pitches = pattern.pitches;
+    synthPattern.beats = pattern.beats;
+    synthPattern.periodNs = config.periodNs;
+    synthPattern.syncSerial = 1;  // start at beat 0
+    synth.setPattern(synthPattern);
+
+    WavFileSink wav(path);
+    if (!wav.open(config.sampleRate, 1, &result.error)) return result;
+
+    uint64_t total = uint64_t(std::llround(synth.periodFrames() * std::max(1, config.loops)));
+    std::vector<float> block(size_t(std::min<uint64_t>(total, RENDER_BLOCK_FRAMES)));
+    for (uint64_t done = 0; done < total;) {
+        int frames = int(std::min<uint64_t>(total - done, block.size()));
+        synth.render(block.data(), frames);
+        if (!wav.write(block.data(), frames)) break;
+        done += uint64_t(frames);
+    }
+    wav.close();
+    if (wav.failed()) {
+        result.error = "Write error on " + path;
+        return result;
+    }
+    result.ok = true;
+    result.frames = total;
+    result.renderNs = monotonicNanos() - start;
+    return result;
+}
+
+std::vector<OfflineRenderResult> renderPatternBatch(const std::vector<Pattern> &patterns,
+                                                    const std::vector<std::string> &paths,
+                                                    const OfflineRenderConfig &config, int threads) {
+    size_t count = std::min(patterns.size(), paths.size());
+    std::vector<OfflineRenderResult> results(count);
+    if (threads <= 0) threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    threads = int(std::min<size_t>(size_t(threads), std::max<size_t>(count, 1)));
+
+    // Workers take the next pattern as they finish one, so a long pattern
+    // does not hold up a fixed share of the batch
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i; (i = next.fetch_add(1)) < count;) {
+            results[i] = renderPatternWav(patterns[i], config, paths[i]);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool) thread.join();
+    return results;
+}
@@ -0,0 +1,37 @@
+#ifndef OFFLINE_RENDERER_H
+#define OFFLINE_RENDERER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pattern_file.h"
+
+// Renders patterns to WAV files as fast as the CPU allows, with the same
+// PwmSynth (note table and beat timing) the live monitor uses. Patterns are
+// independent, so a batch is spread over worker threads, one pattern at a
+// time per worker.
+struct OfflineRenderConfig {
+    int sampleRate = 48000;
+    int loops = 1;                      // passes through each pattern
+    uint64_t periodNs = 4000000000ull;  // PERIOD in audio_controller.sv
+    float gain = 0.25f;
+};
+
+struct OfflineRenderResult {
+    std::string path;
+    bool ok = false;
+    std::string error;
+    uint64_t frames = 0;
+    uint64_t renderNs = 0;  // wall time for this file
+};
+
+// One pattern, `loops` periods from beat 0
+OfflineRenderResult renderPatternWav(const Pattern &pattern, const OfflineRenderConfig &config,
+                                     const std::string &path);
+
+// patterns[i] goes to paths[i]; threads 0 = one per core
+std::vector<OfflineRenderResult> renderPatternBatch(const std::vector<Pattern> &patterns,
+                                                    const std::vector<std::string> &paths,
+                                                    const OfflineRenderConfig &config, int threads = 0);
+
+#endif // OFFLINE_RENDERER_H
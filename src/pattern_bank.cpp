@@ -0,0 +1,282 @@
+#include "pattern_bank.h"
+#include "capture_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+using Word = SequencerModel::Pitches::Word;
+constexpr int BEATS_PER_WORD = SequencerModel::Pitches::BEATS_PER_WORD;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+uint32_t headerChecksum(const bank::FileHeader &header) {
+    return capture::checksum(reinterpret_cast<const uint8_t *>(&header), offsetof(bank::FileHeader, headerChecksum));
+}
+
+} // namespace
+
+bool writePatternBank(const std::string &path, const std::vector<Pattern> &patterns, std::string *error) {
+    auto fail = [&](const std::string &what) {
+        if (error) *error = what;
+        return false;
+    };
+
+    int maxBeats = 1;
+    size_t namesBytes = 0;
+    for (const Pattern &pattern : patterns) {
+        maxBeats = std::max(maxBeats, pattern.beats);
+        if (pattern.name.size() > UINT16_MAX) return fail("pattern name longer than 65535 bytes: " + pattern.name);
+        namesBytes += pattern.name.size();
+    }
+    if (namesBytes > UINT32_MAX) return fail("pattern names exceed 4 GB");
+    const int words = (maxBeats + BEATS_PER_WORD - 1) / BEATS_PER_WORD;
+    const size_t recordBytes = sizeof(bank::RecordHeader) + size_t(words) * sizeof(Word);
+
+    bank::FileHeader header{};
+    std::memcpy(header.magic, bank::MAGIC, sizeof(header.magic));
+    header.version = bank::VERSION;
+    header.wordsPerRecord = uint32_t(words);
+    header.patterns = patterns.size();
+    header.recordsOffset = sizeof(bank::FileHeader);
+    header.namesOffset = header.recordsOffset + patterns.size() * recordBytes;
+    header.namesBytes = namesBytes;
+    header.indexOffset = alignUp(header.namesOffset + namesBytes, sizeof(uint32_t));
+
+    std::vector<uint8_t> file(header.indexOffset + patterns.size() * sizeof(uint32_t), 0);
+    uint32_t nameOffset = 0;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        const Pattern &pattern = patterns[i];
+        uint8_t *rec = file.data() + header.recordsOffset + i * recordBytes;
+        bank::RecordHeader recHeader{};
+        recHeader.nameOffset = nameOffset;
+        recHeader.nameLength = uint16_t(pattern.name.size());
+        recHeader.beats = uint16_t(pattern.beats);
+        std::memcpy(rec, &recHeader, sizeof(recHeader));
+        std::memcpy(rec + sizeof(recHeader), pattern.pitches.words().data(), size_t(words) * sizeof(Word));
+        recHeader.checksum = capture::checksum(rec + sizeof(uint32_t), recordBytes - sizeof(uint32_t));
+        std::memcpy(rec, &recHeader.checksum, sizeof(uint32_t));
+
+        std::memcpy(file.data() + header.namesOffset + nameOffset, pattern.name.data(), pattern.name.size());
+        nameOffset += uint32_t(pattern.name.size());
+    }
+
+    std::vector<uint32_t> order(patterns.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return patterns[a].name < patterns[b].name; });
+    std::memcpy(file.data() + header.indexOffset, order.data(), order.size() * sizeof(uint32_t));
+
+    header.namesChecksum = capture::checksum(file.data() + header.namesOffset, namesBytes);
+    header.indexChecksum = capture::checksum(file.data() + header.indexOffset, order.size() * sizeof(uint32_t));
+    header.headerChecksum = headerChecksum(header);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return fail("Failed to open " + temp + ": " + std::strerror(errno));
+    const uint8_t *p = file.data();
+    size_t left = file.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            std::string message = "Failed to write " + temp + ": " + std::strerror(errno);
+            ::close(fd);
+            unlink(temp.c_str());
+            return fail(message);
+        }
+        p += n;
+        left -= size_t(n);
+    }
+    ::close(fd);
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::string message = "Failed to replace " + path + ": " + std::strerror(errno);
+        unlink(temp.c_str());
+        return fail(message);
+    }
+    return true;
+}
+
+// --- PatternBank ---
+
+PatternBank::PatternBank()
+    : m_base(nullptr), m_size(0), m_count(0), m_words(0), m_recordBytes(0), m_records(nullptr), m_names(nullptr),
+      m_namesBytes(0), m_index(nullptr), m_header{} {}
+
+PatternBank::~PatternBank() { close(); }
+
+bool PatternBank::isBank(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char magic[sizeof(bank::MAGIC)];
+    bool match = ::read(fd, magic, sizeof(magic)) == ssize_t(sizeof(magic)) &&
+                 std::memcmp(magic, bank::MAGIC, sizeof(magic)) == 0;
+    ::close(fd);
+    return match;
+}
+
+bool PatternBank::open(const std::string &path, std::string *error) {
+    auto fail = [&](const std::string &what) {
+        if (error) *error = what;
+        close();
+        return false;
+    };
+
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return fail("Failed to open " + path + ": " + std::strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(bank::FileHeader))) {
+        ::close(fd);
+        return fail(path + " is not a pattern bank");
+    }
+    void *mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return fail("Failed to map " + path + ": " + std::strerror(errno));
+    m_base = static_cast<const uint8_t *>(mapping);
+    m_size = static_cast<size_t>(st.st_size);
+    // Patterns are picked out of order
+    madvise(mapping, m_size, MADV_RANDOM);
+
+    bank::FileHeader &h = m_header;
+    std::memcpy(&h, m_base, sizeof(h));
+    if (std::memcmp(h.magic, bank::MAGIC, sizeof(h.magic)) != 0) return fail(path + " is not a pattern bank");
+    if (h.version != bank::VERSION) {
+        return fail(path + ": unsupported pattern bank version " + std::to_string(h.version));
+    }
+    if (h.headerChecksum != headerChecksum(h)) return fail(path + ": pattern bank header is damaged");
+
+    // Every section inside the file, so reads need no further bounds checks
+    const uint64_t maxWords = SequencerModel::Pitches::WORDS;
+    if (h.wordsPerRecord == 0 || h.wordsPerRecord > maxWords) {
+        return fail(path + ": bad record width " + std::to_string(h.wordsPerRecord));
+    }
+    const uint64_t recordBytes = sizeof(bank::RecordHeader) + h.wordsPerRecord * sizeof(Word);
+    const uint64_t size = m_size;
+    if (h.patterns > size / recordBytes || h.patterns > UINT32_MAX || h.recordsOffset % alignof(Word) ||
+        h.recordsOffset > size || h.patterns * recordBytes > size - h.recordsOffset ||
+        h.namesOffset > size || h.namesBytes > size - h.namesOffset ||
+        h.indexOffset % sizeof(uint32_t) || h.indexOffset > size ||
+        h.patterns * sizeof(uint32_t) > size - h.indexOffset) {
+        return fail(path + ": pattern bank is cut short or damaged");
+    }
+
+    m_count = size_t(h.patterns);
+    m_words = int(h.wordsPerRecord);
+    m_recordBytes = size_t(recordBytes);
+    m_records = m_base + h.recordsOffset;
+    m_names = reinterpret_cast<const char *>(m_base + h.namesOffset);
+    m_namesBytes = size_t(h.namesBytes);
+    m_index = reinterpret_cast<const uint32_t *>(m_base + h.indexOffset);
+    return true;
+}
+
+void PatternBank::close() {
+    if (m_base) munmap(const_cast<uint8_t *>(m_base), m_size);
+    m_base = nullptr;
+    m_size = 0;
+    m_count = 0;
+    m_words = 0;
+    m_recordBytes = 0;
+    m_records = nullptr;
+    m_names = nullptr;
+    m_namesBytes = 0;
+    m_index = nullptr;
+}
+
+const bank::RecordHeader *PatternBank::record(size_t index) const {
+    return reinterpret_cast<const bank::RecordHeader *>(m_records + index * m_recordBytes);
+}
+
+bool PatternBank::recordIntact(const bank::RecordHeader *rec) const {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(rec);
+    if (rec->checksum != capture::checksum(bytes + sizeof(uint32_t), m_recordBytes - sizeof(uint32_t)) ||
+        rec->beats < 1 || rec->beats > SequencerModel::MAX_BEATS) {
+        return false;
+    }
+    // Another writer may have stored nibbles no board sends
+    static_assert(SequencerModel::MAX_PITCH == 8, "pitchesAbove8() checks for pitches above 8");
+    for (int w = 0; w < m_words; ++w) {
+        Word word;
+        std::memcpy(&word, bytes + sizeof(bank::RecordHeader) + size_t(w) * sizeof(Word), sizeof(Word));
+        if (SequencerModel::Pitches::pitchesAbove8(word)) return false;
+    }
+    return true;
+}
+
+std::string_view PatternBank::name(size_t index) const {
+    const bank::RecordHeader *rec = record(index);
+    if (rec->nameOffset > m_namesBytes || rec->nameLength > m_namesBytes - rec->nameOffset) return {};
+    return std::string_view(m_names + rec->nameOffset, rec->nameLength);
+}
+
+int PatternBank::beats(size_t index) const {
+    return record(index)->beats;
+}
+
+bool PatternBank::pitches(size_t index, SequencerModel::Pitches &out) const {
+    const bank::RecordHeader *rec = record(index);
+    if (!recordIntact(rec)) return false;
+    Word words[SequencerModel::Pitches::WORDS];
+    std::memcpy(words, rec + 1, size_t(m_words) * sizeof(Word));
+    out.loadRegister(words, m_words);
+    out.clearFrom(rec->beats);
+    return true;
+}
+
+bool PatternBank::get(size_t index, Pattern &out) const {
+    if (!pitches(index, out.pitches)) return false;
+    out.name = std::string(name(index));
+    out.beats = beats(index);
+    return true;
+}
+
+long PatternBank::find(std::string_view wanted) const {
+    size_t lo = 0, hi = m_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t at = m_index[mid];
+        if (at >= m_count) return -1;  // damaged index
+        if (name(at) < wanted) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == m_count || m_index[lo] >= m_count || name(m_index[lo]) != wanted) return -1;
+    return long(m_index[lo]);
+}
+
+bool PatternBank::verify(std::string *error) const {
+    auto fail = [&](const std::string &what) {
+        if (error) *error = what;
+        return false;
+    };
+    if (!isOpen()) return fail("no pattern bank open");
+    if (capture::checksum(reinterpret_cast<const uint8_t *>(m_names), m_namesBytes) != m_header.namesChecksum) {
+        return fail("pattern names are damaged");
+    }
+    if (capture::checksum(reinterpret_cast<const uint8_t *>(m_index), m_count * sizeof(uint32_t)) !=
+        m_header.indexChecksum) {
+        return fail("name index is damaged");
+    }
+    for (size_t i = 0; i < m_count; ++i) {
+        const bank::RecordHeader *rec = record(i);
+        if (!recordIntact(rec)) return fail("pattern " + std::to_string(i) + " is damaged");
+        if (rec->nameOffset > m_namesBytes || rec->nameLength > m_namesBytes - rec->nameOffset) {
+            return fail("pattern " + std::to_string(i) + " has its name out of bounds");
+        }
+        if (m_index[i] >= m_count) return fail("name index entry " + std::to_string(i) + " out of range");
+        if (i > 0 && name(m_index[i - 1]) > name(m_index[i])) return fail("name index is out of order");
+    }
+    return true;
+}
@@ -0,0 +1,115 @@
+#ifndef PATTERN_BANK_H
+#define PATTERN_BANK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "pattern_file.h"
+
+// Binary pattern bank: a library of patterns in one file that is mapped and
+// read in place. Opening checks the header only and fetching a pattern is a
+// copy of its record, so both cost the same for ten patterns or a million.
+//
+// Layout (little-endian):
+//   file header  "SEQBNK01", u32 version, u32 words per record, u64 patterns,
+//                u64 offsets of the records, names and index, u64 names bytes,
+//                u32 FNV-1a of the names, u32 of the index, u32 0,
+//                u32 FNV-1a of the header before it
+//   record       u32 FNV-1a of the rest of the record, u32 name offset,
+//                u16 name length, u16 beats, u32 0, then the pitch words,
+//                beat 0 in the low nibble of the first (as model.sv's register)
+//   names        back to back, not terminated
+//   index        u32 record number per pattern, sorted by name
+//
+// Records are as wide as the longest pattern needs, so a bank of 16-beat
+// patterns spends 24 bytes on each.
+namespace bank {
+
+constexpr char MAGIC[8] = {'S', 'E', 'Q', 'B', 'N', 'K', '0', '1'};
+constexpr uint32_t VERSION = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t wordsPerRecord;
+    uint64_t patterns;
+    uint64_t recordsOffset;
+    uint64_t namesOffset;
+    uint64_t indexOffset;
+    uint64_t namesBytes;
+    uint32_t namesChecksum;
+    uint32_t indexChecksum;
+    uint32_t reserved;
+    uint32_t headerChecksum;
+};
+
+struct RecordHeader {
+    uint32_t checksum;
+    uint32_t nameOffset;
+    uint16_t nameLength;
+    uint16_t beats;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 72, "bank file header must be packed");
+static_assert(sizeof(RecordHeader) == 16, "bank record header must be packed");
+
+} // namespace bank
+
+// Writes `patterns` to a new file and renames it over `path`, so a bank that
+// is open elsewhere keeps its old contents until reopened
+bool writePatternBank(const std::string &path, const std::vector<Pattern> &patterns, std::string *error = nullptr);
+
+class PatternBank {
+public:
+    PatternBank();
+    ~PatternBank();
+
+    PatternBank(const PatternBank &) = delete;
+    PatternBank &operator=(const PatternBank &) = delete;
+
+    // Maps `path` and checks the header and that the sections fit the file
+    bool open(const std::string &path, std::string *error = nullptr);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+
+    // True if `path` starts with the bank magic
+    static bool isBank(const std::string &path);
+
+    size_t size() const { return m_count; }
+    int wordsPerRecord() const { return m_words; }
+
+    // Pattern `index` (< size()), read in place. A record whose checksum
+    // fails, or that holds a pitch above MAX_PITCH, is not returned: get()
+    // and pitches() give false.
+    std::string_view name(size_t index) const;
+    int beats(size_t index) const;
+    bool pitches(size_t index, SequencerModel::Pitches &out) const;
+    bool get(size_t index, Pattern &out) const;
+
+    // Binary search of the name index: the first pattern called `name`, or -1
+    long find(std::string_view name) const;
+
+    // Every record and section checksum, and every pitch's range; a walk
+    // of the whole file
+    bool verify(std::string *error = nullptr) const;
+
+private:
+    const bank::RecordHeader *record(size_t index) const;
+    bool recordIntact(const bank::RecordHeader *rec) const;
+
+    const uint8_t *m_base;
+    size_t m_size;
+    size_t m_count;
+    int m_words;
+    size_t m_recordBytes;
+    const uint8_t *m_records;
+    const char *m_names;
+    size_t m_namesBytes;
+    const uint32_t *m_index;
+    bank::FileHeader m_header;
+};
+
+#endif // PATTERN_BANK_H
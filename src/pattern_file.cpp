@@ -0,0 +1,249 @@
+#include "pattern_file.h"
+#include "capture_file.h"
+#include "pattern_bank.h"
+#include "uart_parser.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+const char REPORT_TITLE[] = "FPGA Sequencer State";
+
+std::string baseName(const std::string &path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool endsWith(const std::string &s, const char *suffix) {
+    std::string tail(suffix);
+    return s.size() >= tail.size() && s.compare(s.size() - tail.size(), tail.size(), tail) == 0;
+}
+
+bool loadCapture(const std::string &path, std::vector<Pattern> &out, std::string *error) {
+    CaptureReader reader;
+    if (!reader.open(path, error)) return false;
+    SequencerModel model;
+    UARTParser parser(&model, reader.format());
+    // Follow the board's length as the live session does
+    parser.onBeatCount = [&model](int beats) { model.setNumBeats(beats); };
+    CaptureReader::Record record;
+    while (reader.next(record)) parser.feed(record.data, record.size);
+
+    Pattern pattern;
+    pattern.name = baseName(path);
+    pattern.pitches = model.pitches();
+    pattern.beats = model.numBeats();
+    out.push_back(pattern);
+    return true;
+}
+
+// "  Beat 3: Pitch 5 (0b101)" lines up to the "Active Beats" summary
+bool loadGuiSave(const std::string &path, std::istream &in, std::vector<Pattern> &out,
+                 std::string *error) {
+    Pattern pattern;
+    pattern.name = baseName(path);
+    pattern.beats = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 12, "Active Beats") == 0) break;
+        int beat, pitch;
+        if (std::sscanf(line.c_str(), " Beat %d: Pitch %d", &beat, &pitch) != 2) continue;
+        if (beat < 0 || beat >= SequencerModel::MAX_BEATS || pitch < 0 || pitch > SequencerModel::MAX_PITCH) {
+            if (error) *error = path + ": bad line: " + line;
+            return false;
+        }
+        pattern.pitches.setPitch(beat, pitch);
+        pattern.beats = std::max(pattern.beats, beat + 1);
+    }
+    if (pattern.beats == 0) {
+        if (error) *error = path + ": no beats found";
+        return false;
+    }
+    out.push_back(pattern);
+    return true;
+}
+
+bool loadBank(const std::string &path, std::vector<Pattern> &out, std::string *error) {
+    PatternBank bank;
+    if (!bank.open(path, error)) return false;
+    if (bank.size() == 0) {
+        if (error) *error = path + ": no patterns";
+        return false;
+    }
+    out.reserve(out.size() + bank.size());
+    for (size_t i = 0; i < bank.size(); ++i) {
+        Pattern pattern;
+        if (!bank.get(i, pattern)) {
+            if (error) *error = path + ": pattern " + std::to_string(i) + " is damaged";
+            return false;
+        }
+        out.push_back(std::move(pattern));
+    }
+    return true;
+}
+
+} // namespace
+
+bool parsePattern(const std::string &text, Pattern &out, std::string *error) {
+    out.pitches.clear();
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        // Register dump: one hex digit per beat, highest beat first
+        std::string digits = text.substr(2);
+        int beats = int(digits.size());
+        if (beats > SequencerModel::MAX_BEATS) {
+            if (error) *error = "register wider than " + std::to_string(SequencerModel::MAX_BEATS) + " beats";
+            return false;
+        }
+        for (int i = 0; i < beats; ++i) {
+            char c = digits[size_t(beats - 1 - i)];
+            if (!std::isxdigit(static_cast<unsigned char>(c))) {
+                if (error) *error = std::string("not a hex digit: ") + c;
+                return false;
+            }
+            int pitch = std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : std::tolower(c) - 'a' + 10;
+            if (pitch > SequencerModel::MAX_PITCH) {
+                if (error) *error = "pitch out of range in beat " + std::to_string(i);
+                return false;
+            }
+            out.pitches.setPitch(i, pitch);
+        }
+        out.beats = beats;
+        return beats > 0;
+    }
+
+    int beats = int(text.size());
+    if (beats == 0 || beats > SequencerModel::MAX_BEATS) {
+        if (error) *error = "a pattern has 1-" + std::to_string(SequencerModel::MAX_BEATS) + " beats";
+        return false;
+    }
+    for (int i = 0; i < beats; ++i) {
+        char c = text[size_t(i)];
+        if (c < '0' || c > '0' + SequencerModel::MAX_PITCH) {
+            if (error) *error = std::string("pitch must be 0-8, got '") + c + "'";
+            return false;
+        }
+        out.pitches.setPitch(i, c - '0');
+    }
+    out.beats = beats;
+    return true;
+}
+
+std::string formatPattern(const Pattern &pattern) {
+    std::string out = pattern.name.empty() ? std::string() : pattern.name + ' ';
+    for (int i = 0; i < pattern.beats; ++i) out += char('0' + pattern.pitches[i]);
+    return out;
+}
+
+bool loadPatterns(const std::string &path, std::vector<Pattern> &out, std::string *error) {
+    if (endsWith(path, ".seqcap")) return loadCapture(path, out, error);
+    if (PatternBank::isBank(path)) return loadBank(path, out, error);
+
+    std::ifstream in(path);
+    if (!in) {
+        if (error) *error = "Cannot open " + path;
+        return false;
+    }
+    std::string line;
+    int lineNo = 0;
+    size_t first = out.size();
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (lineNo == 1 && line.compare(0, sizeof(REPORT_TITLE) - 1, REPORT_TITLE) == 0) {
+            return loadGuiSave(path, in, out, error);
+        }
+        std::istringstream fields(line);
+        std::string a, b, extra;
+        if (!(fields >> a) || a[0] == '#') continue;
+        fields >> b >> extra;
+        if (!extra.empty() && extra[0] != '#') {
+            if (error) *error = path + ":" + std::to_string(lineNo) + ": expected [name] pattern";
+            return false;
+        }
+
+        Pattern pattern;
+        std::string message;
+        bool named = !b.empty() && b[0] != '#';
+        if (!parsePattern(named ? b : a, pattern, &message)) {
+            if (error) *error = path + ":" + std::to_string(lineNo) + ": " + message;
+            return false;
+        }
+        pattern.name = named ? a : baseName(path) + ":" + std::to_string(lineNo);
+        out.push_back(pattern);
+    }
+    if (out.size() == first) {
+        if (error) *error = path + ": no patterns";
+        return false;
+    }
+    return true;
+}
+
+bool savePatternList(const std::string &path, const std::vector<Pattern> &patterns, std::string *error) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        if (error) *error = "Cannot write " + path;
+        return false;
+    }
+    out << "# " << patterns.size() << " patterns: name, then one pitch 0-8 per beat\n";
+    for (const Pattern &pattern : patterns) {
+        Pattern line = pattern;
+        for (char &c : line.name) {
+            if (std::isspace(static_cast<unsigned char>(c))) c = '_';
+        }
+        if (!line.name.empty() && line.name[0] == '#') line.name[0] = '_';
+        out << formatPattern(line) << '\n';
+    }
+    out.flush();
+    if (!out) {
+        if (error) *error = "Failed to write " + path;
+        return false;
+    }
+    return true;
+}
+
+std::string formatReport(const Pattern &pattern) {
+    std::string out = std::string(REPORT_TITLE) + "\n====================\n\n";
+    out += "Beat Data (4 bits per beat for pitch):\n";
+    char line[64];
+    for (int i = 0; i < pattern.beats; ++i) {
+        int pitch = pattern.pitches[i];
+        if (pitch > 0) {
+            std::snprintf(line, sizeof(line), "  Beat %2d: Pitch %d (0b%d%d%d%d)\n", i, pitch, (pitch >> 3) & 1,
+                          (pitch >> 2) & 1, (pitch >> 1) & 1, pitch & 1);
+        } else {
+            std::snprintf(line, sizeof(line), "  Beat %2d: Pitch 0 (OFF)\n", i);
+        }
+        out += line;
+    }
+
+    out += "\nActive Beats:\n";
+    for (int i = 0; i < pattern.beats; ++i) {
+        if (pattern.pitches[i] == 0) continue;
+        std::snprintf(line, sizeof(line), "  Beat %d: Pitch %d\n", i, pattern.pitches[i]);
+        out += line;
+    }
+    return out;
+}
+
+bool saveReport(const std::string &path, const Pattern &pattern, std::string *error) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        if (error) *error = "Cannot write " + path;
+        return false;
+    }
+    out << formatReport(pattern);
+    out.flush();
+    if (!out) {
+        if (error) *error = "Failed to write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool isReport(const std::string &path) {
+    std::ifstream in(path);
+    std::string line;
+    return std::getline(in, line) && line.compare(0, sizeof(REPORT_TITLE) - 1, REPORT_TITLE) == 0;
+}
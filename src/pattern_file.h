@@ -0,0 +1,47 @@
+#ifndef PATTERN_FILE_H
+#define PATTERN_FILE_H
+
+#include <string>
+#include <vector>
+#include "sequencer_model.h"
+
+// A saved sequence: the beats register and its length
+struct Pattern {
+    std::string name;
+    SequencerModel::Pitches pitches;
+    int beats = 16;
+};
+
+// Pattern sources, picked by content:
+//
+//   Pattern lists, one pattern per line, optionally named:
+//       # comment
+//       intro   3000500070008000     one digit 0-8 per beat, beat 0 first
+//       0x8000000000000301           model.sv register, beat 0 in the last digit
+//   Sequencer reports, the GUI's text format (a single pattern)
+//   Capture files (.seqcap): the state left after decoding the whole capture
+//   Pattern banks (pattern_bank.h): every pattern, in the bank's order
+//
+// Unnamed patterns are called <file>:<line> (or just <file>).
+bool loadPatterns(const std::string &path, std::vector<Pattern> &out, std::string *error = nullptr);
+
+// Parse one pattern list line's data field (digits or 0x register)
+bool parsePattern(const std::string &text, Pattern &out, std::string *error = nullptr);
+
+// "name digits", the inverse of a pattern list line
+std::string formatPattern(const Pattern &pattern);
+
+// Writes a pattern list loadPatterns() reads back. Whitespace in names
+// becomes '_', which the list format cannot hold.
+bool savePatternList(const std::string &path, const std::vector<Pattern> &patterns,
+                     std::string *error = nullptr);
+
+// The sequencer report: "FPGA Sequencer State", every beat's pitch and the
+// active beats, one pattern per file and no name. loadPatterns() reads it back.
+std::string formatReport(const Pattern &pattern);
+bool saveReport(const std::string &path, const Pattern &pattern, std::string *error = nullptr);
+
+// True if `path` starts as a sequencer report does
+bool isReport(const std::string &path);
+
+#endif // PATTERN_FILE_H
@@ -0,0 +1,266 @@
+#include "pattern_search.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+using Pitches = SequencerModel::Pitches;
+
+constexpr uint64_t LOW_NIBBLES = 0x0F0F0F0F0F0F0F0Full;  // even beats, one per byte
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ull;
+constexpr uint64_t NIBBLE_LOW_BITS = 0x1111111111111111ull;
+
+// Patterns a block holds: its distances stay in L1 between the two passes
+constexpr size_t BLOCK = 512;
+// Below this many patterns per thread, starting threads costs more than it saves
+constexpr size_t MIN_PATTERNS_PER_THREAD = 32768;
+
+// One bit per beat with a note
+inline uint64_t activeBeats(uint64_t w) {
+    return (w | (w >> 1) | (w >> 2) | (w >> 3)) & NIBBLE_LOW_BITS;
+}
+
+// |x - y| in each byte, for bytes 0-15. Setting the high bit first keeps
+// each byte's subtraction from borrowing from the next.
+inline uint64_t absDiffBytes(uint64_t x, uint64_t y) {
+    uint64_t xy = (x | HIGH_BITS) - y;  // x - y + 128 per byte
+    uint64_t yx = (y | HIGH_BITS) - x;
+    uint64_t sign = xy & HIGH_BITS;     // x >= y
+    uint64_t mask = sign | (sign - (sign >> 7));
+    return ((xy ^ HIGH_BITS) & mask) | ((yx ^ HIGH_BITS) & ~mask);
+}
+
+// Sum of the eight bytes, each at most 30
+inline int sumBytes(uint64_t v) {
+    v += v >> 8;
+    v += v >> 16;
+    v += v >> 32;
+    return int(v & 0xFF);
+}
+
+// Sum over sixteen beats of the pitch difference
+inline int pitchDistance(uint64_t a, uint64_t b) {
+    return sumBytes(absDiffBytes(a & LOW_NIBBLES, b & LOW_NIBBLES) +
+                    absDiffBytes((a >> 4) & LOW_NIBBLES, (b >> 4) & LOW_NIBBLES));
+}
+
+// Counted by adding nibbles rather than popcount, which the baseline
+// instruction set only has as a scalar library call
+inline int stepDistance(uint64_t activeA, uint64_t b) {
+    uint64_t differ = activeA ^ activeBeats(b);
+    return sumBytes((differ + (differ >> 4)) & LOW_NIBBLES);
+}
+
+Pitches rotate(const Pitches &pitches, int beats, int by) {
+    Pitches out = pitches;
+    for (int i = 0; i < beats; ++i) out.setPitch(i, pitches[(i + by) % beats]);
+    return out;
+}
+
+bool worse(const PatternIndex::Match &a, const PatternIndex::Match &b) {
+    return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+}
+
+} // namespace
+
+PatternIndex::PatternIndex() : m_words(1), m_count(0) {}
+
+void PatternIndex::clear() {
+    m_words = 1;
+    m_count = 0;
+    m_packed.clear();
+    m_damaged.clear();
+}
+
+// Widen every pattern to `words`; only when a longer pattern arrives
+void PatternIndex::ensureWords(int words) {
+    if (words <= m_words) return;
+    std::vector<uint64_t> packed(m_count * size_t(words), 0);
+    for (size_t i = 0; i < m_count; ++i) {
+        std::copy_n(&m_packed[i * size_t(m_words)], m_words, &packed[i * size_t(words)]);
+    }
+    m_packed.swap(packed);
+    m_words = words;
+}
+
+void PatternIndex::add(const Pitches &pitches) {
+    int words = 1;
+    for (int w = Pitches::WORDS - 1; w > 0; --w) {
+        if (pitches.word(w)) {
+            words = w + 1;
+            break;
+        }
+    }
+    ensureWords(words);
+    for (int w = 0; w < m_words; ++w) m_packed.push_back(pitches.word(w));
+    if (!m_damaged.empty()) m_damaged.push_back(false);
+    ++m_count;
+}
+
+void PatternIndex::add(const PatternBank &bank) {
+    ensureWords(bank.wordsPerRecord());
+    m_packed.reserve(m_packed.size() + bank.size() * size_t(m_words));
+    for (size_t i = 0; i < bank.size(); ++i) {
+        Pitches pitches;
+        bool intact = bank.pitches(i, pitches);
+        if (!intact && m_damaged.empty()) m_damaged.assign(m_count, false);
+        if (!m_damaged.empty()) m_damaged.push_back(!intact);
+        for (int w = 0; w < m_words; ++w) m_packed.push_back(pitches.word(w));
+        ++m_count;
+    }
+}
+
+Pitches PatternIndex::pitches(size_t index) const {
+    Pitches out;
+    out.loadRegister(&m_packed[index * size_t(m_words)], m_words);
+    return out;
+}
+
+int PatternIndex::distance(const Pitches &a, const Pitches &b, int queryBeats, Metric metric) {
+    auto pitchSum = [](const Pitches &x, const Pitches &y) {
+        int sum = 0;
+        for (int w = 0; w < Pitches::WORDS; ++w) sum += pitchDistance(x.word(w), y.word(w));
+        return sum;
+    };
+    switch (metric) {
+    case Metric::Steps: {
+        int sum = 0;
+        for (int w = 0; w < Pitches::WORDS; ++w) sum += stepDistance(activeBeats(a.word(w)), b.word(w));
+        return sum;
+    }
+    case Metric::Pitch:
+        return pitchSum(a, b);
+    case Metric::Rotation: {
+        int best = pitchSum(a, b);
+        for (int r = 1; r < queryBeats; ++r) best = std::min(best, pitchSum(rotate(a, queryBeats, r), b));
+        return best;
+    }
+    }
+    return 0;
+}
+
+// Patterns [begin, end) into a max-heap of the k best seen so far.
+// `queries` holds the query as the scan compares it: m_words words (active
+// beats for Steps), then for Rotation the same for every rotation.
+void PatternIndex::scan(const std::vector<uint64_t> &queries, size_t begin, size_t end, size_t k, Metric metric,
+                        std::vector<Match> &heap) const {
+    const size_t words = size_t(m_words);
+    const size_t rotations = queries.size() / words;
+    int distances[BLOCK];
+
+    for (size_t block = begin; block < end; block += BLOCK) {
+        const size_t n = std::min(BLOCK, end - block);
+        const uint64_t *p = &m_packed[block * words];
+
+        // Pass 1: distances only, no branches on the data
+        if (words == 1) {
+            const uint64_t q = queries[0];
+            switch (metric) {
+            case Metric::Steps:
+                for (size_t j = 0; j < n; ++j) distances[j] = stepDistance(q, p[j]);
+                break;
+            case Metric::Pitch:
+                for (size_t j = 0; j < n; ++j) distances[j] = pitchDistance(q, p[j]);
+                break;
+            case Metric::Rotation:
+                for (size_t j = 0; j < n; ++j) distances[j] = pitchDistance(q, p[j]);
+                for (size_t r = 1; r < rotations; ++r) {
+                    const uint64_t qr = queries[r];
+                    for (size_t j = 0; j < n; ++j) distances[j] = std::min(distances[j], pitchDistance(qr, p[j]));
+                }
+                break;
+            }
+        } else {
+            for (size_t j = 0; j < n; ++j) {
+                const uint64_t *pattern = p + j * words;
+                int best = INT32_MAX;
+                for (size_t r = 0; r < rotations; ++r) {
+                    const uint64_t *q = &queries[r * words];
+                    int sum = 0;
+                    for (size_t w = 0; w < words; ++w) {
+                        sum += metric == Metric::Steps ? stepDistance(q[w], pattern[w]) : pitchDistance(q[w], pattern[w]);
+                    }
+                    best = std::min(best, sum);
+                }
+                distances[j] = best;
+            }
+        }
+
+        // Pass 2: the few that beat the current k-th
+        for (size_t j = 0; j < n; ++j) {
+            if (heap.size() == k && distances[j] >= heap.front().distance) continue;
+            size_t index = block + j;
+            if (!m_damaged.empty() && m_damaged[index]) continue;
+            if (heap.size() == k) {
+                std::pop_heap(heap.begin(), heap.end(), worse);
+                heap.pop_back();
+            }
+            heap.push_back({index, distances[j]});
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+    }
+}
+
+std::vector<PatternIndex::Match> PatternIndex::search(const Pitches &query, int queryBeats, size_t k,
+                                                      Metric metric, int threads) const {
+    if (k == 0 || m_count == 0) return {};
+    queryBeats = std::clamp(queryBeats, 1, SequencerModel::MAX_BEATS);
+
+    // Query words past the library's width meet rests only: a constant,
+    // except under rotation where it differs per rotation and is folded in
+    // by widening instead
+    const int queryWords = (queryBeats + Pitches::BEATS_PER_WORD - 1) / Pitches::BEATS_PER_WORD;
+    if (queryWords > m_words) {
+        Pitches clipped = query;
+        clipped.clearFrom(m_words * Pitches::BEATS_PER_WORD);
+        if (metric == Metric::Rotation) {
+            PatternIndex wide;
+            wide.m_words = queryWords;
+            wide.m_count = m_count;
+            wide.m_damaged = m_damaged;
+            wide.m_packed.assign(m_count * size_t(queryWords), 0);
+            for (size_t i = 0; i < m_count; ++i) {
+                std::copy_n(&m_packed[i * size_t(m_words)], m_words, &wide.m_packed[i * size_t(queryWords)]);
+            }
+            return wide.search(query, queryBeats, k, metric, threads);
+        }
+        const int tail = distance(query, clipped, queryBeats, metric);
+        std::vector<Match> matches = search(clipped, m_words * Pitches::BEATS_PER_WORD, k, metric, threads);
+        for (Match &match : matches) match.distance += tail;
+        return matches;
+    }
+
+    std::vector<uint64_t> queries;
+    const int rotations = metric == Metric::Rotation ? queryBeats : 1;
+    for (int r = 0; r < rotations; ++r) {
+        Pitches rotated = r ? rotate(query, queryBeats, r) : query;
+        for (int w = 0; w < m_words; ++w) {
+            uint64_t word = rotated.word(w);
+            queries.push_back(metric == Metric::Steps ? activeBeats(word) : word);
+        }
+    }
+
+    if (threads <= 0) threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    threads = int(std::clamp<size_t>(m_count / MIN_PATTERNS_PER_THREAD, 1, size_t(threads)));
+    k = std::min(k, m_count);
+
+    // Equal slices: every pattern costs the same
+    const size_t slices = size_t(threads);
+    std::vector<std::vector<Match>> heaps(slices);
+    auto worker = [&](int t) {
+        size_t begin = m_count * size_t(t) / slices;
+        size_t end = m_count * size_t(t + 1) / slices;
+        heaps[size_t(t)].reserve(k + 1);
+        scan(queries, begin, end, k, metric, heaps[size_t(t)]);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto &thread : pool) thread.join();
+
+    std::vector<Match> matches;
+    for (const auto &heap : heaps) matches.insert(matches.end(), heap.begin(), heap.end());
+    std::sort(matches.begin(), matches.end(), worse);
+    if (matches.size() > k) matches.resize(k);
+    return matches;
+}
@@ -0,0 +1,65 @@
+#ifndef PATTERN_SEARCH_H
+#define PATTERN_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "pattern_bank.h"
+#include "sequencer_model.h"
+
+// Nearest-pattern search over a library. Patterns are held packed as the
+// bank and model.sv store them, one 64-bit word per 16 beats, back to back.
+// A distance is a few word operations on all sixteen nibbles at once, with
+// no per-beat loop. The library is scanned in blocks the compiler can
+// vectorise, and large libraries are split across threads, each keeping
+// its own top k.
+//
+// Patterns are numbered in the order added, so an index built from a bank
+// or a loadPatterns() list answers with positions in it.
+class PatternIndex {
+public:
+    enum class Metric {
+        Steps,     // beats where one has a note and the other a rest
+        Pitch,     // sum over beats of the pitch difference, a rest being 0
+        Rotation,  // Pitch against the best rotation of the query
+    };
+
+    struct Match {
+        size_t index;
+        int distance;
+    };
+
+    PatternIndex();
+
+    void clear();
+    size_t size() const { return m_count; }
+    int wordsPerPattern() const { return m_words; }
+
+    void add(const SequencerModel::Pitches &pitches);
+    // Every record of `bank`; damaged ones keep their place but never match
+    void add(const PatternBank &bank);
+    // Pattern `index` (< size()) as stored
+    SequencerModel::Pitches pitches(size_t index) const;
+
+    // The k nearest to `query`, nearest first, ties by position. Rotation
+    // turns the query's first `queryBeats` beats. threads 0 = one per core,
+    // fewer for small libraries.
+    std::vector<Match> search(const SequencerModel::Pitches &query, int queryBeats, size_t k, Metric metric,
+                              int threads = 0) const;
+
+    // One pair, the same measure search() ranks by
+    static int distance(const SequencerModel::Pitches &a, const SequencerModel::Pitches &b, int queryBeats,
+                        Metric metric);
+
+private:
+    void ensureWords(int words);
+    void scan(const std::vector<uint64_t> &queries, size_t begin, size_t end, size_t k, Metric metric,
+              std::vector<Match> &heap) const;
+
+    int m_words;                   // per pattern
+    size_t m_count;
+    std::vector<uint64_t> m_packed;  // m_count * m_words
+    std::vector<bool> m_damaged;     // empty unless a bank had damaged records
+};
+
+#endif // PATTERN_SEARCH_H
@@ -1,103 +1,338 @@
 #include "pitch_graph_widget.h"
+#include "ingest_stats.h"
+#include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QPen>
+#include <QResizeEvent>
 #include <QScrollBar>
+#include <QVBoxLayout>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const QColor TRACE_COLOR(0, 200, 255);
+
+} // namespace
 
 // Canvas that draws the pitch graph
-PitchGraphCanvas::PitchGraphCanvas(QWidget *parent) : QWidget(parent) {
+PitchGraphCanvas::PitchGraphCanvas(QWidget *parent)
+    : QWidget(parent), m_samplesPerPixel(NATIVE_SPP), m_viewEnd(0.0),
+      m_followTail(true), m_traceSlots(0), m_stats(nullptr), m_pendingTimestamp(0) {
     setMinimumHeight(150);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+bool PitchGraphCanvas::isLiveView() const {
+    return m_followTail && m_samplesPerPixel == NATIVE_SPP;
+}
+
+int PitchGraphCanvas::pitchToY(int pitch) const {
+    return height() - (pitch * height() / 8);
+}
+
+double PitchGraphCanvas::visibleSamples() const {
+    return width() * m_samplesPerPixel;
+}
+
+double PitchGraphCanvas::viewEnd() const {
+    return m_followTail ? static_cast<double>(m_history.size()) : m_viewEnd;
 }
 
-void PitchGraphCanvas::addPitchSample(int pitch, int beat) {
-    m_samples.push_back({beat, pitch});
-    
-    // Keep only last 4 seconds of data (64 beats at 62.5ms each = 4 seconds)
-    // Use MAX_SAMPLES for buffer
-    if (m_samples.size() > MAX_SAMPLES) {
-        m_samples.erase(m_samples.begin(), m_samples.begin() + (m_samples.size() - MAX_SAMPLES));
+void PitchGraphCanvas::addPitchSample(int pitch, int /*beat*/) {
+    m_history.append(pitch);
+    drawSegment(m_history.size() - 1);
+
+    if (isLiveView()) {
+        if (m_history.size() == 1) {
+            update();  // replace the placeholder text
+        } else {
+            // Everything already on screen moves one slot left: let Qt blit
+            // it and only repaint the newest segment and the fixed labels.
+            QRect traceArea(LABEL_WIDTH, 0, width() - LABEL_WIDTH, height());
+            scroll(-SAMPLE_WIDTH, 0, traceArea);
+            update(QRect(width() - 2 * SAMPLE_WIDTH, 0, 2 * SAMPLE_WIDTH, height()));
+            update(QRect(width() - CURRENT_LABEL_WIDTH, 0, CURRENT_LABEL_WIDTH, 30));
+            update(QRect(0, 0, LABEL_WIDTH, height()));
+        }
+    } else if (m_followTail) {
+        update();  // zoomed out: one pyramid query per column
     }
-    
-    // Resize canvas to fit all samples
-    int totalWidth = m_samples.size() * SAMPLE_WIDTH;
-    setMinimumWidth(totalWidth);
-    
-    update();
+    emit viewChanged();
 }
 
 void PitchGraphCanvas::clear() {
-    m_samples.clear();
-    setMinimumWidth(200); // Reset to default
+    m_history.clear();
+    m_trace.fill(Qt::transparent);
+    followTail();
+}
+
+void PitchGraphCanvas::setHistoryBudget(size_t bytes) {
+    m_history = PitchHistory(bytes);
+    clear();
+}
+
+void PitchGraphCanvas::noteSourceTimestamp(uint64_t ns) {
+    if (ns != 0 && (m_pendingTimestamp == 0 || ns < m_pendingTimestamp)) m_pendingTimestamp = ns;
+}
+
+void PitchGraphCanvas::setViewEnd(double end) {
+    double total = static_cast<double>(m_history.size());
+    if (end >= total) {
+        m_followTail = true;
+    } else {
+        m_followTail = false;
+        m_viewEnd = std::max(end, std::min(visibleSamples(), total));
+    }
     update();
+    emit viewChanged();
 }
 
-void PitchGraphCanvas::paintEvent(QPaintEvent *) {
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+void PitchGraphCanvas::zoom(double factor, int anchorX) {
+    double total = static_cast<double>(m_history.size());
+    double maxSpp = std::max(NATIVE_SPP, total / std::max(1, width()));
+    double spp = std::clamp(m_samplesPerPixel * factor, MIN_SPP, maxSpp);
+    // Steps are powers of two from native, so native is hit exactly; snap
+    // anyway when clamping lands close to it
+    if (std::abs(spp - NATIVE_SPP) < NATIVE_SPP * 1e-6) spp = NATIVE_SPP;
 
-    // Background
-    painter.fillRect(rect(), QColor(30, 30, 40));
+    double anchorSample = viewEnd() - (width() - anchorX) * m_samplesPerPixel;
+    m_samplesPerPixel = spp;
+    if (m_followTail) {
+        update();
+        emit viewChanged();
+    } else {
+        setViewEnd(anchorSample + (width() - anchorX) * spp);
+    }
+}
 
-    if (m_samples.empty()) {
-        painter.setPen(Qt::gray);
-        painter.drawText(rect(), Qt::AlignCenter, "Pitch Graph (0-7)\nScroll to see history");
-        return;
+void PitchGraphCanvas::followTail() {
+    m_followTail = true;
+    m_samplesPerPixel = NATIVE_SPP;
+    update();
+    emit viewChanged();
+}
+
+void PitchGraphCanvas::wheelEvent(QWheelEvent *event) {
+    QPoint delta = event->angleDelta();
+    bool horizontal = (event->modifiers() & Qt::ShiftModifier) || delta.x() != 0;
+    int steps = (horizontal ? (delta.x() != 0 ? delta.x() : delta.y()) : delta.y()) / 120;
+    if (steps == 0) return;
+
+    if (horizontal) {
+        setViewEnd(viewEnd() - steps * visibleSamples() / 10.0);
+    } else {
+        zoom(steps > 0 ? 0.5 : 2.0, event->position().toPoint().x());
     }
+    event->accept();
+}
+
+void PitchGraphCanvas::mouseDoubleClickEvent(QMouseEvent *) {
+    followTail();
+}
+
+void PitchGraphCanvas::drawSegment(uint64_t index) {
+    if (m_trace.isNull() || m_traceSlots == 0) return;
+
+    // Slot s spans [s, s+1] * SAMPLE_WIDTH; reuse it by clearing first
+    int slot = static_cast<int>(index % m_traceSlots);
+    QRect slotRect(slot * SAMPLE_WIDTH, 0, SAMPLE_WIDTH, m_trace.height());
+    QPainter painter(&m_trace);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(slotRect, Qt::transparent);
+
+    int from, to;
+    if (index == 0 || !m_history.sampleAt(index - 1, from) || !m_history.sampleAt(index, to)) return;
+
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setClipRect(slotRect);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(TRACE_COLOR, 2));
+    painter.drawLine(slotRect.left(), pitchToY(from),
+                     slotRect.left() + SAMPLE_WIDTH, pitchToY(to));
+}
+
+void PitchGraphCanvas::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    // Pitch scale depends on height, strip length on width
+    rebuildBackground();
+    rebuildTrace();
+    emit viewChanged();
+}
+
+void PitchGraphCanvas::rebuildBackground() {
+    m_background = QPixmap(size());
+    m_background.fill(QColor(30, 30, 40));
+
+    QPainter painter(&m_background);
+    painter.setRenderHint(QPainter::Antialiasing);
 
     // Draw grid lines for pitch levels
-    painter.setPen(QPen(QColor(60, 60, 70), 1, Qt::DashLine));
+    QPen gridPen(QColor(60, 60, 70), 1, Qt::DashLine);
     for (int i = 0; i <= 7; ++i) {
-        int y = height() - (i * height() / 8);
+        int y = pitchToY(i);
+        painter.setPen(gridPen);
         painter.drawLine(0, y, width(), y);
         
         // Label pitch levels on left
         painter.setPen(QColor(100, 100, 110));
         painter.drawText(5, y - 2, QString::number(i));
-        painter.setPen(QPen(QColor(60, 60, 70), 1, Qt::DashLine));
     }
+}
 
-    // Draw pitch line
-    if (m_samples.size() > 1) {
-        painter.setPen(QPen(QColor(0, 200, 255), 2));
-        
-        for (size_t i = 1; i < m_samples.size(); ++i) {
-            int x1 = (i - 1) * SAMPLE_WIDTH;
-            int x2 = i * SAMPLE_WIDTH;
-            int y1 = height() - (m_samples[i - 1].pitch * height() / 8);
-            int y2 = height() - (m_samples[i].pitch * height() / 8);
-            painter.drawLine(x1, y1, x2, y2);
-        }
+void PitchGraphCanvas::rebuildTrace() {
+    m_traceSlots = width() / SAMPLE_WIDTH + 2;
+    m_trace = QImage(m_traceSlots * SAMPLE_WIDTH, std::max(1, height()),
+                     QImage::Format_ARGB32_Premultiplied);
+    m_trace.fill(Qt::transparent);
+
+    uint64_t total = m_history.size();
+    uint64_t first = total > uint64_t(m_traceSlots) ? total - m_traceSlots : 0;
+    for (uint64_t i = first; i < total; ++i) drawSegment(i);
+}
+
+void PitchGraphCanvas::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    const QRect dirty = event->rect();
+
+    painter.drawPixmap(dirty, m_background, dirty);
+
+    if (m_history.empty()) {
+        painter.setPen(Qt::gray);
+        painter.drawText(rect(), Qt::AlignCenter,
+                         "Pitch Graph (0-7)\nWheel to zoom, Shift+wheel to scroll");
+        return;
+    }
+
+    painter.save();
+    painter.setClipRect(dirty.intersected(QRect(LABEL_WIDTH, 0, width(), height())));
+    if (isLiveView()) {
+        paintLive(painter, dirty);
+    } else {
+        paintHistory(painter, dirty);
     }
+    painter.restore();
 
-    // Draw current pitch label in top-right
-    if (!m_samples.empty()) {
-        int currentPitch = m_samples.back().pitch;
+    // Current pitch (or scroll position) label in top-right
+    QRect labelRect(width() - CURRENT_LABEL_WIDTH, 0, CURRENT_LABEL_WIDTH, 30);
+    if (labelRect.intersects(dirty)) {
         painter.setPen(Qt::white);
         QFont font = painter.font();
         font.setBold(true);
         painter.setFont(font);
-        painter.drawText(width() - 120, 20, QString("Pitch: %1").arg(currentPitch));
+        QString label = m_followTail
+            ? QString("Pitch: %1").arg(m_history.latest())
+            : QString("@ %1 / %2").arg(qint64(viewEnd())).arg(qint64(m_history.size()));
+        painter.drawText(width() - CURRENT_LABEL_WIDTH, 20, label);
+    }
+
+    if (m_stats && m_pendingTimestamp) {
+        m_stats->recordSince(IngestStats::STAGE_GRAPH_PAINT, m_pendingTimestamp);
+        m_pendingTimestamp = 0;
     }
 }
 
-// Scrollable container
-PitchGraphWidget::PitchGraphWidget(QWidget *parent) : QScrollArea(parent) {
+void PitchGraphCanvas::paintLive(QPainter &painter, const QRect &) {
+    // The newest slot ends at the right edge. The strip is circular, so the
+    // part after the newest slot is older and goes to the left of the part up
+    // to and including it.
+    int stripWidth = m_traceSlots * SAMPLE_WIDTH;
+    int newestEnd = static_cast<int>(m_history.size() % m_traceSlots) * SAMPLE_WIDTH;
+    int origin = width() - newestEnd;  // canvas x of strip x = 0
+    // (a source width of 0 would mean "to the edge", hence the guards)
+    if (newestEnd > 0) {
+        painter.drawImage(origin, 0, m_trace, 0, 0, newestEnd, -1);
+    }
+    if (newestEnd < stripWidth) {
+        painter.drawImage(origin - (stripWidth - newestEnd), 0, m_trace, newestEnd, 0, -1, -1);
+    }
+}
+
+void PitchGraphCanvas::paintHistory(QPainter &painter, const QRect &dirty) {
+    // One min/max column per pixel, from the coarsest pyramid level that
+    // still resolves a pixel
+    int columns = dirty.width() + 1;  // one extra on the left for continuity
+    if (static_cast<int>(m_columns.size()) < columns) m_columns.resize(columns);
+
+    double viewStart = viewEnd() - visibleSamples();
+    int x0 = dirty.left() - 1;
+    m_history.query(viewStart + x0 * m_samplesPerPixel, m_samplesPerPixel, columns, m_columns.data());
+
+    painter.setPen(QPen(TRACE_COLOR, 2));
+    const PitchHistory::Column *prev = nullptr;
+    for (int c = 0; c < columns; ++c) {
+        const PitchHistory::Column &col = m_columns[c];
+        if (!col.valid) {
+            prev = nullptr;
+            continue;
+        }
+        // Stretch the bar to meet the previous column so steps stay joined
+        int lo = col.min, hi = col.max;
+        if (prev) {
+            lo = std::min<int>(lo, prev->max);
+            hi = std::max<int>(hi, prev->min);
+        }
+        if (c > 0) painter.drawLine(x0 + c, pitchToY(lo), x0 + c, pitchToY(hi));
+        prev = &col;
+    }
+}
+
+// Container: canvas above a scroll bar spanning the entire session
+PitchGraphWidget::PitchGraphWidget(QWidget *parent)
+    : QWidget(parent), m_syncing(false) {
     m_canvas = new PitchGraphCanvas(this);
-    setWidget(m_canvas);
-    setWidgetResizable(false);
-    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
-    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    m_scrollBar = new QScrollBar(Qt::Horizontal, this);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    layout->addWidget(m_canvas, 1);
+    layout->addWidget(m_scrollBar);
     setMinimumHeight(180);
     setMaximumHeight(220);
+
+    connect(m_canvas, &PitchGraphCanvas::viewChanged, this, &PitchGraphWidget::syncScrollBar);
+    connect(m_scrollBar, &QScrollBar::valueChanged, this, [this](int value) {
+        if (m_syncing) return;
+        m_canvas->setViewEnd(value >= m_scrollBar->maximum()
+                                 ? static_cast<double>(m_canvas->sampleCount())
+                                 : static_cast<double>(value));
+    });
 }
 
 void PitchGraphWidget::addPitchSample(int pitch, int beat) {
     m_canvas->addPitchSample(pitch, beat);
-    
-    // Auto-scroll to show the "tail" (most recent samples)
-    QScrollBar *hbar = horizontalScrollBar();
-    hbar->setValue(hbar->maximum());
 }
 
 void PitchGraphWidget::clear() {
     m_canvas->clear();
 }
+
+void PitchGraphWidget::setHistoryBudget(size_t bytes) {
+    m_canvas->setHistoryBudget(bytes);
+}
+
+void PitchGraphWidget::setStats(IngestStats *stats) {
+    m_canvas->setStats(stats);
+}
+
+void PitchGraphWidget::noteSourceTimestamp(uint64_t ns) {
+    m_canvas->noteSourceTimestamp(ns);
+}
+
+void PitchGraphWidget::syncScrollBar() {
+    // Scroll bar value is the sample index at the right edge
+    int visible = static_cast<int>(std::ceil(m_canvas->visibleSamples()));
+    int total = static_cast<int>(std::min<uint64_t>(m_canvas->sampleCount(), std::numeric_limits<int>::max()));
+
+    m_syncing = true;
+    m_scrollBar->setRange(std::min(visible, total), total);
+    m_scrollBar->setPageStep(std::max(1, visible));
+    m_scrollBar->setSingleStep(std::max(1, visible / 10));
+    m_scrollBar->setValue(static_cast<int>(m_canvas->viewEnd()));
+    m_syncing = false;
+}
@@ -1,10 +1,22 @@
 #ifndef PITCH_GRAPH_WIDGET_H
 #define PITCH_GRAPH_WIDGET_H
 
-#include <QScrollArea>
+#include <QImage>
+#include <QPixmap>
 #include <QWidget>
 #include <vector>
+#include "pitch_history.h"
 
+class QScrollBar;
+class IngestStats;
+
+// Draws the whole-session pitch history held in a PitchHistory pyramid.
+//
+// Live view (following the tail at the native zoom): the newest sample sits
+// at the right edge, the grid is a cached pixmap, and each segment is drawn
+// once into a circular backing image, so a new sample costs O(1).
+// History view (zoomed or scrolled back): each paint queries one min/max
+// column per pixel, so the cost follows the width, not the session length.
 class PitchGraphCanvas : public QWidget {
     Q_OBJECT
 public:
@@ -13,30 +25,81 @@ public:
     void addPitchSample(int pitch, int beat);
     void clear();
 
+    // Memory bound for the history pyramid; clears the graph
+    void setHistoryBudget(size_t bytes);
+
+    // Latency instrumentation: the next paint is timed against the earliest
+    // source timestamp noted since the previous one
+    void setStats(IngestStats *stats) { m_stats = stats; }
+    void noteSourceTimestamp(uint64_t ns);
+
+    uint64_t sampleCount() const { return m_history.size(); }
+    double samplesPerPixel() const { return m_samplesPerPixel; }
+    double visibleSamples() const;
+    double viewEnd() const;          // sample index at the right edge
+    void setViewEnd(double end);     // scrolling to the end resumes following
+    void zoom(double factor, int anchorX);
+    void followTail();               // back to the live view
+    bool isFollowingTail() const { return m_followTail; }
+
+signals:
+    void viewChanged();
+
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
 
 private:
-    struct Sample {
-        int beat;
-        int pitch;
-    };
-    std::vector<Sample> m_samples;
-    static constexpr int SAMPLE_WIDTH = 4; // pixels per sample
-    static constexpr int VISIBLE_SAMPLES = 50; // samples in "tail" view
-    static constexpr int MAX_SAMPLES = 250; // 4 seconds at 62.5ms = ~64 samples, give buffer
+    bool isLiveView() const;
+    int pitchToY(int pitch) const;
+    void drawSegment(uint64_t index);
+    void rebuildBackground();
+    void rebuildTrace();
+    void paintLive(QPainter &painter, const QRect &dirty);
+    void paintHistory(QPainter &painter, const QRect &dirty);
+
+    static constexpr int SAMPLE_WIDTH = 4; // pixels per sample at native zoom
+    static constexpr double NATIVE_SPP = 1.0 / SAMPLE_WIDTH;
+    static constexpr double MIN_SPP = NATIVE_SPP / 4; // deepest zoom-in
+    static constexpr int LABEL_WIDTH = 20;  // pitch level labels on the left
+    static constexpr int CURRENT_LABEL_WIDTH = 120;
+
+    PitchHistory m_history;
+    double m_samplesPerPixel;
+    double m_viewEnd;    // used when not following the tail
+    bool m_followTail;
+
+    QPixmap m_background;  // fill, grid lines and level labels
+    QImage m_trace;        // circular strip, one SAMPLE_WIDTH slot per sample
+    int m_traceSlots;
+    std::vector<PitchHistory::Column> m_columns; // scratch for history paints
+
+    IngestStats *m_stats;
+    uint64_t m_pendingTimestamp;
 };
 
-class PitchGraphWidget : public QScrollArea {
+// Canvas plus a scroll bar spanning the entire session.
+// Wheel zooms around the cursor, Shift+wheel scrolls, double-click returns
+// to the live tail.
+class PitchGraphWidget : public QWidget {
     Q_OBJECT
 public:
     explicit PitchGraphWidget(QWidget *parent = nullptr);
 
     void addPitchSample(int pitch, int beat);
     void clear();
+    void setHistoryBudget(size_t bytes);
+    void setStats(IngestStats *stats);
+    void noteSourceTimestamp(uint64_t ns);
 
 private:
+    void syncScrollBar();
+
     PitchGraphCanvas *m_canvas;
+    QScrollBar *m_scrollBar;
+    bool m_syncing;
 };
 
 #endif // PITCH_GRAPH_WIDGET_H
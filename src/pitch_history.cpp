@@ -0,0 +1,127 @@
+#include "pitch_history.h"
+#include <algorithm>
+#include <cmath>
+
+PitchHistory::PitchHistory(size_t budgetBytes) : m_total(0) {
+    // One byte per raw sample, two per summary entry on every other level
+    size_t bytesPerSlot = 1 + 2 * (LEVELS - 1);
+    m_capacity = std::max<size_t>(budgetBytes / bytesPerSlot, 64);
+
+    uint64_t bucket = 1;
+    for (int k = 0; k < LEVELS; ++k) {
+        m_bucketSize[k] = bucket;
+        bucket *= FAN_OUT;
+        m_levels[k].min.resize(m_capacity);
+        if (k > 0) m_levels[k].max.resize(m_capacity);
+    }
+}
+
+void PitchHistory::append(int pitch) {
+    uint8_t p = static_cast<uint8_t>(std::clamp(pitch, 0, 255));
+
+    Level &raw = m_levels[0];
+    raw.min[raw.completed % m_capacity] = p;
+    ++raw.completed;
+    ++m_total;
+
+    for (int k = 1; k < LEVELS; ++k) {
+        Level &level = m_levels[k];
+        if (level.pendingCount == 0) {
+            level.pendingMin = level.pendingMax = p;
+        } else {
+            level.pendingMin = std::min(level.pendingMin, p);
+            level.pendingMax = std::max(level.pendingMax, p);
+        }
+        if (++level.pendingCount == m_bucketSize[k]) {
+            size_t slot = level.completed % m_capacity;
+            level.min[slot] = level.pendingMin;
+            level.max[slot] = level.pendingMax;
+            ++level.completed;
+            level.pendingCount = 0;
+        }
+    }
+}
+
+void PitchHistory::clear() {
+    m_total = 0;
+    for (Level &level : m_levels) {
+        level.completed = 0;
+        level.pendingCount = 0;
+    }
+}
+
+int PitchHistory::latest() const {
+    int pitch = 0;
+    if (m_total > 0) sampleAt(m_total - 1, pitch);
+    return pitch;
+}
+
+uint64_t PitchHistory::firstRawIndex() const {
+    return m_total > m_capacity ? m_total - m_capacity : 0;
+}
+
+bool PitchHistory::sampleAt(uint64_t index, int &pitch) const {
+    if (index >= m_total || index < firstRawIndex()) return false;
+    pitch = m_levels[0].min[index % m_capacity];
+    return true;
+}
+
+bool PitchHistory::entry(int k, uint64_t index, uint8_t &mn, uint8_t &mx) const {
+    const Level &level = m_levels[k];
+    if (index < level.completed) {
+        if (level.completed - index > m_capacity) return false;  // evicted
+        size_t slot = index % m_capacity;
+        mn = level.min[slot];
+        mx = (k == 0) ? mn : level.max[slot];
+        return true;
+    }
+    if (index == level.completed && level.pendingCount > 0) {
+        mn = level.pendingMin;
+        mx = level.pendingMax;
+        return true;
+    }
+    return false;
+}
+
+void PitchHistory::query(double first, double samplesPerColumn, int columns, Column *out) const {
+    samplesPerColumn = std::max(samplesPerColumn, 1e-9);
+
+    // Finest level whose buckets are no wider than a column
+    int baseLevel = 0;
+    while (baseLevel + 1 < LEVELS && m_bucketSize[baseLevel + 1] <= samplesPerColumn) ++baseLevel;
+
+    for (int c = 0; c < columns; ++c) {
+        Column &col = out[c];
+        col.valid = false;
+
+        double a = first + c * samplesPerColumn;
+        double b = a + samplesPerColumn;
+        if (b <= 0.0 || a >= static_cast<double>(m_total)) continue;
+        uint64_t lo = static_cast<uint64_t>(std::max(0.0, std::floor(a)));
+        uint64_t hi = std::min<uint64_t>(m_total, static_cast<uint64_t>(std::ceil(b)));
+        if (hi <= lo) hi = lo + 1;
+
+        // Fall back to coarser levels where the fine data was evicted
+        for (int k = baseLevel; k < LEVELS && !col.valid; ++k) {
+            uint64_t firstEntry = lo / m_bucketSize[k];
+            uint64_t lastEntry = (hi - 1) / m_bucketSize[k];
+            uint8_t mn, mx;
+            if (!entry(k, firstEntry, mn, mx)) continue;
+
+            col.min = mn;
+            col.max = mx;
+            col.valid = true;
+            for (uint64_t e = firstEntry + 1; e <= lastEntry; ++e) {
+                if (!entry(k, e, mn, mx)) break;
+                col.min = std::min(col.min, mn);
+                col.max = std::max(col.max, mx);
+            }
+        }
+    }
+}
+
+size_t PitchHistory::memoryUsage() const {
+    size_t bytes = sizeof(*this);
+    for (const Level &level : m_levels) bytes += level.min.capacity() + level.max.capacity();
+    return bytes;
+}
@@ -0,0 +1,66 @@
+#ifndef PITCH_HISTORY_H
+#define PITCH_HISTORY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Whole-session pitch history as a min/max decimation pyramid.
+// Level 0 holds raw samples; each level above summarises FAN_OUT^level
+// samples per entry as (min, max). Every level is a ring of the same length,
+// sized from a memory budget, so recent history is kept at full resolution
+// and older history only at coarser levels. Appending is O(LEVELS); a query
+// touches at most FAN_OUT + 2 entries per output column, so rendering cost
+// follows the pixel width rather than the number of samples.
+class PitchHistory {
+public:
+    static constexpr int FAN_OUT = 4;
+    static constexpr int LEVELS = 12;
+
+    struct Column {
+        uint8_t min;
+        uint8_t max;
+        bool valid;  // false where no data is retained or the range is empty
+    };
+
+    explicit PitchHistory(size_t budgetBytes = 4 * 1024 * 1024);
+
+    void append(int pitch);
+    void clear();
+
+    // Samples appended since construction/clear()
+    uint64_t size() const { return m_total; }
+    bool empty() const { return m_total == 0; }
+    int latest() const;
+
+    // Oldest sample still kept at full resolution
+    uint64_t firstRawIndex() const;
+    bool sampleAt(uint64_t index, int &pitch) const;
+
+    // Min/max for `columns` consecutive ranges of `samplesPerColumn` samples
+    // starting at sample `first` (fractional values allowed).
+    void query(double first, double samplesPerColumn, int columns, Column *out) const;
+
+    size_t entriesPerLevel() const { return m_capacity; }
+    size_t memoryUsage() const;
+
+private:
+    struct Level {
+        std::vector<uint8_t> min;  // ring of completed buckets
+        std::vector<uint8_t> max;  // unused at level 0 (min == max)
+        uint64_t completed = 0;    // buckets ever completed
+        uint64_t pendingCount = 0; // samples in the bucket being filled
+        uint8_t pendingMin = 0;
+        uint8_t pendingMax = 0;
+    };
+
+    bool entry(int level, uint64_t index, uint8_t &mn, uint8_t &mx) const;
+
+    size_t m_capacity;
+    uint64_t m_total;
+    std::array<uint64_t, LEVELS> m_bucketSize;
+    std::array<Level, LEVELS> m_levels;
+};
+
+#endif // PITCH_HISTORY_H
@@ -0,0 +1,215 @@
+#include "port_watcher.h"
+#include "logger.h"
+#include "monotonic_clock.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// One line of a sysfs attribute, without the newline
+std::string readAttribute(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::string();
+    char buf[256];
+    ssize_t n = ::read(fd, buf, sizeof(buf) - 1);
+    ::close(fd);
+    if (n <= 0) return std::string();
+    std::string value(buf, size_t(n));
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) value.pop_back();
+    return value;
+}
+
+std::string linkTarget(const std::string &path) {
+    char buf[PATH_MAX];
+    ssize_t n = ::readlink(path.c_str(), buf, sizeof(buf) - 1);
+    if (n <= 0) return std::string();
+    std::string target(buf, size_t(n));
+    size_t slash = target.rfind('/');
+    return slash == std::string::npos ? target : target.substr(slash + 1);
+}
+
+// The 8250 driver registers ttyS0-31 whether or not a UART is there; only
+// ports whose type was detected are real
+bool uartPresent(const std::string &devPath) {
+    int fd = ::open(devPath.c_str(), O_RDONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0) return false;
+    serial_struct info;
+    bool present = ::ioctl(fd, TIOCGSERIAL, &info) == 0 && info.type != PORT_UNKNOWN;
+    ::close(fd);
+    return present;
+}
+
+// USB attributes live on the device a few levels above the tty's interface
+void readUsbAttributes(const std::string &devicePath, SerialPortInfo &port) {
+    char resolved[PATH_MAX];
+    if (!::realpath(devicePath.c_str(), resolved)) return;
+    std::string dir = resolved;
+    for (int level = 0; level < 4 && dir.size() > 1; ++level) {
+        std::string vendor = readAttribute(dir + "/idVendor");
+        if (!vendor.empty()) {
+            port.usbId = vendor + ":" + readAttribute(dir + "/idProduct");
+            port.serialNumber = readAttribute(dir + "/serial");
+            std::string product = readAttribute(dir + "/product");
+            if (product.empty()) product = readAttribute(dir + "/manufacturer");
+            if (!product.empty()) port.description = product;
+            return;
+        }
+        dir.resize(dir.rfind('/'));
+    }
+}
+
+// ttyUSB2 before ttyUSB10
+bool nameLess(const std::string &a, const std::string &b) {
+    auto split = [](const std::string &s) {
+        size_t digits = s.size();
+        while (digits > 0 && std::isdigit(static_cast<unsigned char>(s[digits - 1]))) --digits;
+        long number = digits < s.size() ? std::strtol(s.c_str() + digits, nullptr, 10) : -1;
+        return std::make_pair(s.substr(0, digits), number);
+    };
+    return split(a) < split(b);
+}
+
+bool isTtyName(const char *name) {
+    return std::strncmp(name, "tty", 3) == 0 || std::strncmp(name, "rfcomm", 6) == 0;
+}
+
+} // namespace
+
+std::vector<SerialPortInfo> listSerialPorts(const std::string &sysDir, const std::string &devDir) {
+    std::vector<SerialPortInfo> ports;
+    DIR *dir = ::opendir(sysDir.c_str());
+    if (!dir) return ports;
+    while (dirent *entry = ::readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        const std::string name = entry->d_name;
+        const std::string device = sysDir + "/" + name + "/device";
+
+        // No device link: a virtual console or pty
+        struct stat st;
+        if (::stat(device.c_str(), &st) != 0) continue;
+        SerialPortInfo port;
+        port.name = name;
+        port.path = devDir + "/" + name;
+        if (::stat(port.path.c_str(), &st) != 0 || !S_ISCHR(st.st_mode)) continue;
+
+        std::string driver = linkTarget(device + "/driver");
+        if (driver == "serial8250" && !uartPresent(port.path)) continue;
+        port.description = driver;
+        readUsbAttributes(device, port);
+        ports.push_back(std::move(port));
+    }
+    ::closedir(dir);
+    std::sort(ports.begin(), ports.end(),
+              [](const SerialPortInfo &a, const SerialPortInfo &b) { return nameLess(a.name, b.name); });
+    return ports;
+}
+
+PortWatcher::PortWatcher(const std::string &sysDir, const std::string &devDir)
+    : m_sysDir(sysDir), m_devDir(devDir), m_inotifyFd(-1), m_running(false), m_scanned(false) {}
+
+PortWatcher::~PortWatcher() {
+    stop();
+}
+
+bool PortWatcher::start() {
+    if (m_running) return true;
+    if (!m_loop.isValid() || !m_settle.isValid()) return false;
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd >= 0 &&
+        inotify_add_watch(m_inotifyFd, m_devDir.c_str(),
+                          IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+        int saved = errno;
+        ::close(m_inotifyFd);
+        m_inotifyFd = -1;
+        errno = saved;
+    }
+    if (m_inotifyFd >= 0) {
+        m_loop.addFd(m_inotifyFd, EPOLLIN, [this](uint32_t) { onInotify(); });
+        m_loop.addFd(m_settle.fd(), EPOLLIN, [this](uint32_t) {
+            m_settle.acknowledge();
+            scan();
+        });
+    } else {
+        LOG_WARN_MSG("[Ports] Cannot watch {}: {}; polling every {} s", m_devDir, std::strerror(errno),
+                     POLL_NS / 1000000000);
+        m_loop.addTimer(POLL_NS, [this]() { scan(); });
+    }
+
+    m_loop.post([this]() { scan(); });
+    m_thread = std::thread([this]() { m_loop.run(); });
+    m_running = true;
+    return true;
+}
+
+void PortWatcher::stop() {
+    if (!m_running) return;
+    m_loop.stop();
+    if (m_thread.joinable()) m_thread.join();
+    m_running = false;
+    if (m_inotifyFd >= 0) {
+        m_loop.removeFd(m_settle.fd());
+        m_loop.removeFd(m_inotifyFd);
+        ::close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+    m_settle.disarm();
+}
+
+void PortWatcher::rescan() {
+    m_loop.post([this]() { scan(); });
+}
+
+std::vector<SerialPortInfo> PortWatcher::ports() const {
+    std::lock_guard<std::mutex> lock(m_portsMutex);
+    return m_ports;
+}
+
+bool PortWatcher::scanned() const {
+    std::lock_guard<std::mutex> lock(m_portsMutex);
+    return m_scanned;
+}
+
+void PortWatcher::onInotify() {
+    // Names only matter to tell tty nodes from the rest of /dev
+    alignas(inotify_event) char buf[4096];
+    bool relevant = false;
+    for (;;) {
+        ssize_t n = ::read(m_inotifyFd, buf, sizeof(buf));
+        if (n <= 0) break;
+        for (ssize_t at = 0; at < n;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(buf + at);
+            if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && isTtyName(event->name))) relevant = true;
+            at += ssize_t(sizeof(inotify_event) + event->len);
+        }
+    }
+    // Each event pushes the deadline back, so a burst costs one scan
+    if (relevant) m_settle.arm(monotonicNanos() + SETTLE_NS);
+}
+
+void PortWatcher::scan() {
+    uint64_t start = monotonicNanos();
+    std::vector<SerialPortInfo> ports = listSerialPorts(m_sysDir, m_devDir);
+    bool changed;
+    {
+        std::lock_guard<std::mutex> lock(m_portsMutex);
+        changed = !m_scanned || ports != m_ports;
+        if (changed) m_ports = ports;
+        m_scanned = true;
+    }
+    if (!changed) return;
+    LOG_DEBUG_MSG("[Ports] {} serial ports, listed in {} us", ports.size(), (monotonicNanos() - start) / 1000);
+    if (onPortsChanged) onPortsChanged(ports);
+}
@@ -0,0 +1,84 @@
+#ifndef PORT_WATCHER_H
+#define PORT_WATCHER_H
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "deadline_timer.h"
+#include "event_loop.h"
+
+// A serial port as sysfs describes it. USB adapters carry a serial number
+// and vendor:product, which identify the board again if it comes back under
+// another name (ttyUSB0 replugged as ttyUSB1).
+struct SerialPortInfo {
+    std::string name;          // ttyUSB0
+    std::string path;          // /dev/ttyUSB0
+    std::string description;   // USB product string, else the driver
+    std::string serialNumber;  // empty unless USB
+    std::string usbId;         // "0403:6010", empty unless USB
+
+    bool operator==(const SerialPortInfo &other) const {
+        return name == other.name && description == other.description && serialNumber == other.serialNumber &&
+               usbId == other.usbId;
+    }
+    bool operator!=(const SerialPortInfo &other) const { return !(*this == other); }
+};
+
+// The serial ports under `sysDir` (a /sys/class/tty layout) with a node in
+// `devDir`, sorted by name. Terminals without hardware behind them (virtual
+// consoles, ptys) and the legacy 8250 ports no UART answers on are left out.
+// Reads sysfs only; no udev.
+std::vector<SerialPortInfo> listSerialPorts(const std::string &sysDir = "/sys/class/tty",
+                                            const std::string &devDir = "/dev");
+
+// Keeps the serial port list current without blocking its caller. Ports are
+// listed on a thread of its own at start(), then again whenever a tty node
+// appears in, leaves or changes permissions in /dev (inotify). A burst of
+// events, as udev makes when a board is plugged in, settles for SETTLE_NS
+// before the one rescan. Without inotify it rescans every POLL_NS instead.
+class PortWatcher {
+public:
+    static constexpr uint64_t SETTLE_NS = 250'000'000;
+    static constexpr uint64_t POLL_NS = 2'000'000'000;
+
+    explicit PortWatcher(const std::string &sysDir = "/sys/class/tty", const std::string &devDir = "/dev");
+    ~PortWatcher();
+
+    PortWatcher(const PortWatcher &) = delete;
+    PortWatcher &operator=(const PortWatcher &) = delete;
+
+    bool start();
+    void stop();
+    bool hotplug() const { return m_inotifyFd >= 0; }  // false: polling
+
+    // List again now, e.g. for a Refresh button. Safe from any thread.
+    void rescan();
+
+    // The last list; empty until the first scan finishes
+    std::vector<SerialPortInfo> ports() const;
+    bool scanned() const;
+
+    // The list changed, or the first scan finished. Called on the watcher's
+    // thread; hand the list to your own before touching any UI.
+    std::function<void(const std::vector<SerialPortInfo> &ports)> onPortsChanged;
+
+private:
+    void scan();
+    void onInotify();
+
+    std::string m_sysDir;
+    std::string m_devDir;
+    EventLoop m_loop;
+    DeadlineTimer m_settle;
+    std::thread m_thread;
+    int m_inotifyFd;
+    bool m_running;
+
+    mutable std::mutex m_portsMutex;  // guards m_ports and m_scanned
+    std::vector<SerialPortInfo> m_ports;
+    bool m_scanned;
+};
+
+#endif // PORT_WATCHER_H
@@ -0,0 +1,44 @@
+#include "pty_device.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+int openPty(std::string &slaveName, std::string *error) {
+    auto fail = [&](const char *what, int fd) {
+        int saved = errno;
+        if (fd >= 0) ::close(fd);
+        if (error) *error = std::string(what) + ": " + std::strerror(saved);
+        errno = saved;
+        return -1;
+    };
+
+    int fd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0) return fail("Cannot create a pseudo-terminal", -1);
+    if (grantpt(fd) != 0 || unlockpt(fd) != 0) return fail("Cannot unlock the pseudo-terminal", fd);
+    const char *name = ptsname(fd);
+    if (!name) return fail("Cannot name the pseudo-terminal", fd);
+    slaveName = name;
+
+    // Raw until the receiver configures it, so no byte is translated
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    // Until the slave has been opened once the master never hangs up, so
+    // ptyPeerClosed() would see a receiver before there is one
+    int slave = ::open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slave < 0) return fail("Cannot open the pseudo-terminal", fd);
+    ::close(slave);
+    return fd;
+}
+
+bool ptyPeerClosed(int masterFd) {
+    pollfd pfd{masterFd, 0, 0};
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLHUP);
+}
@@ -0,0 +1,16 @@
+#ifndef PTY_DEVICE_H
+#define PTY_DEVICE_H
+
+#include <string>
+
+// A pseudo-terminal a receiver can open like a serial port, for senders that
+// stand in for the board (mock_uart_sender --pty, top_cosim --pty). The
+// master is returned in raw mode, the slave's name written to `slaveName`;
+// -1 with a message in *error on failure.
+int openPty(std::string &slaveName, std::string *error = nullptr);
+
+// True while nobody has the slave open. openPty() opens and closes the slave
+// once, since a master that has never had a peer reports no hangup.
+bool ptyPeerClosed(int masterFd);
+
+#endif // PTY_DEVICE_H
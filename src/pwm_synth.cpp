@@ -0,0 +1,111 @@
+#include "pwm_synth.h"
+#include <algorithm>
+#include <cmath>
+
+namespace pwm {
+
+uint16_t interval(int pitch) {
+    // Mirrors pwm_decoder in hdl/pwm.sv
+    static const uint16_t TABLE[16] = {
+        0,      // REST
+        22940,  // C4
+        20434,  // D4
+        18204,  // E4
+        17190,  // F4
+        15306,  // G4
+        13636,  // A4
+        12148,  // B4
+        11471,  // C5
+        5000, 5000, 5000, 5000, 5000, 5000, 5000,  // default case
+    };
+    return TABLE[pitch & 0x0F];
+}
+
+double frequencyHz(int pitch) {
+    uint16_t half = interval(pitch);
+    return half ? CLK_HZ / (2.0 * half) : 0.0;
+}
+
+} // namespace pwm
+
+PwmSynth::PwmSynth(int sampleRate)
+    : m_sampleRate(std::max(1, sampleRate)), m_step(double(pwm::CLK_HZ) / m_sampleRate),
+      m_beatClocks(0), m_gain(0.25f), m_beat(0), m_beatPos(0), m_interval(0), m_wavePos(0),
+      m_frames(0) {
+    setPattern(SynthPattern());
+}
+
+void PwmSynth::setPattern(const SynthPattern &pattern) {
+    bool resync = pattern.syncSerial != m_pattern.syncSerial;
+    m_pattern = pattern;
+    m_pattern.beats = std::clamp(m_pattern.beats, 1, SequencerModel::MAX_BEATS);
+    // Integer division as in audio_controller: CLK_FREQ / NUM_BEATS first
+    m_beatClocks = (m_pattern.periodNs / 1e9) * double(pwm::CLK_HZ / uint32_t(m_pattern.beats));
+    m_beatClocks = std::max(m_beatClocks, m_step);
+
+    if (resync) {
+        m_beatPos = 0;
+        startBeat(0);
+    } else {
+        if (m_beatPos >= m_beatClocks) m_beatPos = 0;
+        startBeat(m_beat < m_pattern.beats ? m_beat : 0);
+    }
+}
+
+void PwmSynth::startBeat(int beat) {
+    m_beat = beat;
+    uint16_t interval = pwm::interval(m_pattern.pitches[beat]);
+    // pwm_generator clears its counter and output while the interval is 0;
+    // between notes the counter runs on
+    if (interval == 0) m_wavePos = 0;
+    else if (m_wavePos >= 2.0 * interval) m_wavePos = 0;
+    m_interval = interval;
+}
+
+void PwmSynth::render(float *out, int frames) {
+    m_frames += uint64_t(frames);
+    while (frames > 0) {
+        // Beat changes land on the first sample at or after the boundary
+        int run = int(std::ceil((m_beatClocks - m_beatPos) / m_step));
+        run = std::clamp(run, 1, frames);
+        renderNote(out, run);
+        out += run;
+        frames -= run;
+        m_beatPos += run * m_step;
+        if (m_beatPos >= m_beatClocks) {
+            m_beatPos -= m_beatClocks;
+            startBeat(m_beat + 1 < m_pattern.beats ? m_beat + 1 : 0);
+        }
+    }
+}
+
+void PwmSynth::renderNote(float *out, int frames) {
+    if (m_interval == 0) {
+        std::fill(out, out + frames, 0.0f);
+        return;
+    }
+    // The wave is low for the first half-period and high for the second
+    const double half = m_interval;
+    const double period = 2.0 * half;
+    const float low = -m_gain, high = m_gain;
+    double pos = m_wavePos;
+    int i = 0;
+    while (i < frames) {
+        double edge = pos < half ? half : period;
+        float level = pos < half ? low : high;
+        // Whole samples before the next edge are constant
+        int whole = int((edge - pos) / m_step);
+        whole = std::min(whole, frames - i);
+        std::fill(out + i, out + i + whole, level);
+        i += whole;
+        pos += whole * m_step;
+        if (i == frames) break;
+
+        // The sample that straddles the edge
+        double before = (edge - pos) / m_step;
+        out[i++] = float(level * before - level * (1.0 - before));
+        pos += m_step;
+        if (pos >= period) pos -= period;
+    }
+    m_wavePos = pos;
+}
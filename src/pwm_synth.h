@@ -0,0 +1,79 @@
+#ifndef PWM_SYNTH_H
+#define PWM_SYNTH_H
+
+#include <cstdint>
+#include "sequencer_model.h"
+
+// Software copy of the board's audio path: audio_controller steps through
+// the beats register once per PERIOD, pwm_decoder turns each pitch into a
+// half-period in 12 MHz clocks, and pwm_generator toggles a square wave on
+// it. Everything here counts in those same clocks, so the pitches match the
+// board exactly.
+namespace pwm {
+
+constexpr uint32_t CLK_HZ = 12000000;  // CLK_FREQ in hdl/top.sv
+
+// pwm_decoder's table: clocks per half-period, 0 for a rest
+uint16_t interval(int pitch);
+
+// Frequency the board plays for `pitch`, 0 for a rest
+double frequencyHz(int pitch);
+
+} // namespace pwm
+
+// What the synth plays: a whole pattern, handed over in one piece
+struct SynthPattern {
+    SequencerModel::Pitches pitches;
+    int beats = 16;
+    uint64_t periodNs = 4000000000ull;
+    // Bumped by the producer at every SYNC; the synth restarts at beat 0
+    uint64_t syncSerial = 0;
+};
+
+// One voice plus the beat counter. render() never allocates or locks, and
+// fills each run of a held note with straight stores between the edges of
+// the square wave, so it can be called from a real-time audio callback.
+//
+// Samples are the PWM output box-filtered over each sample period: a sample
+// straddling an edge takes the fraction of high time, which keeps the worst
+// of the aliasing out without changing the pitch.
+class PwmSynth {
+public:
+    explicit PwmSynth(int sampleRate = 48000);
+
+    int sampleRate() const { return m_sampleRate; }
+
+    // Takes effect from the next rendered sample. The beat position is kept
+    // unless the pattern carries a new SYNC serial.
+    void setPattern(const SynthPattern &pattern);
+    const SynthPattern &pattern() const { return m_pattern; }
+
+    // Peak output level, 0-1
+    void setGain(float gain) { m_gain = gain; }
+
+    void render(float *out, int frames);
+
+    // Output frames in one pass through the pattern, as timed by the board
+    double periodFrames() const { return m_beatClocks * m_pattern.beats / m_step; }
+
+    int currentBeat() const { return m_beat; }
+    uint64_t framesRendered() const { return m_frames; }
+
+private:
+    void startBeat(int beat);
+    void renderNote(float *out, int frames);
+
+    int m_sampleRate;
+    double m_step;        // 12 MHz clocks per sample
+    SynthPattern m_pattern;
+    double m_beatClocks;  // clocks per beat: PERIOD * (CLK_FREQ / NUM_BEATS)
+    float m_gain;
+
+    int m_beat;
+    double m_beatPos;     // clocks into the current beat
+    uint16_t m_interval;  // half-period of the current note, 0 = rest
+    double m_wavePos;     // clocks into the current wave period
+    uint64_t m_frames;
+};
+
+#endif // PWM_SYNTH_H
@@ -0,0 +1,132 @@
+#include "replay_source.h"
+#include "monotonic_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Granularity at which a sleeping or blocked feeder notices stop()
+constexpr int STOP_POLL_MS = 50;
+
+// Unpaced replay coalesces records into writes of about this size
+constexpr size_t UNPACED_BATCH = 16 * 1024;
+
+} // namespace
+
+ReplaySource::ReplaySource() : m_speed(1.0), m_writeFd(-1) {}
+
+ReplaySource::~ReplaySource() { stop(); }
+
+bool ReplaySource::open(const std::string &path, std::string *error) {
+    stop();
+    return m_reader.open(path, error);
+}
+
+int ReplaySource::start(double speed) {
+    stop();
+    if (!m_reader.isOpen()) return -1;
+
+    // A socket rather than a pipe so a reader that goes away yields EPIPE
+    // (MSG_NOSIGNAL) instead of SIGPIPE
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) return -1;
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    shutdown(fds[0], SHUT_WR);
+
+    m_reader.rewind();
+    m_speed = std::max(0.0, speed);
+    m_writeFd = fds[1];
+    m_stop.store(false, std::memory_order_relaxed);
+    m_finished.store(false, std::memory_order_relaxed);
+    m_bytesSent.store(0, std::memory_order_relaxed);
+    m_startNs.store(monotonicNanos(), std::memory_order_relaxed);
+    m_endNs.store(0, std::memory_order_relaxed);
+    m_thread = std::thread(&ReplaySource::run, this);
+    return fds[0];
+}
+
+void ReplaySource::stop() {
+    if (!m_thread.joinable()) return;
+    m_stop.store(true, std::memory_order_relaxed);
+    m_thread.join();
+}
+
+uint64_t ReplaySource::elapsedNs() const {
+    uint64_t start = m_startNs.load(std::memory_order_relaxed);
+    uint64_t end = m_endNs.load(std::memory_order_relaxed);
+    if (start == 0) return 0;
+    return (end ? end : monotonicNanos()) - start;
+}
+
+void ReplaySource::run() {
+    CaptureReader::Record record;
+    uint64_t firstTimestamp = 0;
+    bool haveFirst = false;
+    uint64_t wallStart = m_startNs.load(std::memory_order_relaxed);
+
+    std::vector<uint8_t> batch;
+    if (m_speed == 0) batch.reserve(UNPACED_BATCH + capture::CHUNK_BYTES);
+
+    while (!m_stop.load(std::memory_order_relaxed) && m_reader.next(record)) {
+        if (m_speed == 0) {
+            batch.insert(batch.end(), record.data, record.data + record.size);
+            if (batch.size() < UNPACED_BATCH) continue;
+            if (!writeAll(batch.data(), batch.size())) break;
+            batch.clear();
+            continue;
+        }
+
+        // Paced: each record leaves when it arrived, scaled by speed
+        if (!haveFirst) {
+            firstTimestamp = record.timestampNs;
+            haveFirst = true;
+        }
+        uint64_t offset = record.timestampNs - firstTimestamp;
+        if (!waitUntil(wallStart + static_cast<uint64_t>(offset / m_speed))) break;
+        if (!writeAll(record.data, record.size)) break;
+    }
+    if (!batch.empty() && !m_stop.load(std::memory_order_relaxed)) {
+        writeAll(batch.data(), batch.size());
+    }
+
+    m_endNs.store(monotonicNanos(), std::memory_order_relaxed);
+    ::close(m_writeFd);  // the reader sees EOF
+    m_writeFd = -1;
+    m_finished.store(true, std::memory_order_release);
+}
+
+bool ReplaySource::waitUntil(uint64_t deadlineNs) {
+    for (;;) {
+        if (m_stop.load(std::memory_order_relaxed)) return false;
+        uint64_t now = monotonicNanos();
+        if (now >= deadlineNs) return true;
+        uint64_t remaining = std::min<uint64_t>(deadlineNs - now, STOP_POLL_MS * 1000000ull);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(remaining));
+    }
+}
+
+bool ReplaySource::writeAll(const uint8_t *data, size_t len) {
+    while (len > 0) {
+        if (m_stop.load(std::memory_order_relaxed)) return false;
+        ssize_t n = send(m_writeFd, data, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            len -= static_cast<size_t>(n);
+            m_bytesSent.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return false;  // reader gone
+
+        // Reader is behind: wait for room
+        pollfd pfd = {m_writeFd, POLLOUT, 0};
+        poll(&pfd, 1, STOP_POLL_MS);
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef REPLAY_SOURCE_H
+#define REPLAY_SOURCE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "capture_file.h"
+
+// Plays a capture file back as if it were a serial port. A feeder thread
+// writes the recorded chunks into a local socket, paced by their original
+// arrival times, and the read end goes through the same ingest path as a
+// live device (IngestThread or the GUI's ring buffer and parser).
+//
+// Speed 1 reproduces the original timing, N plays N times faster, and 0
+// writes as fast as the reader drains, which makes a capture double as a
+// throughput benchmark.
+class ReplaySource {
+public:
+    ReplaySource();
+    ~ReplaySource();
+
+    ReplaySource(const ReplaySource &) = delete;
+    ReplaySource &operator=(const ReplaySource &) = delete;
+
+    bool open(const std::string &path, std::string *error = nullptr);
+    UARTParser::Format format() const { return m_reader.format(); }
+
+    // Start feeding. Returns the non-blocking read end, owned by the caller,
+    // or -1. EOF on it means the replay is over.
+    int start(double speed);
+    void stop();
+
+    bool finished() const { return m_finished.load(std::memory_order_acquire); }
+    bool truncated() const { return m_reader.truncated(); }
+    uint64_t bytesSent() const { return m_bytesSent.load(std::memory_order_relaxed); }
+    // Wall time from start() until the last byte was written
+    uint64_t elapsedNs() const;
+
+private:
+    void run();
+    bool waitUntil(uint64_t deadlineNs);
+    bool writeAll(const uint8_t *data, size_t len);
+
+    CaptureReader m_reader;
+    double m_speed;
+    int m_writeFd;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::atomic<bool> m_finished{false};
+    std::atomic<uint64_t> m_bytesSent{0};
+    std::atomic<uint64_t> m_startNs{0};
+    std::atomic<uint64_t> m_endNs{0};
+};
+
+#endif // REPLAY_SOURCE_H
@@ -0,0 +1,102 @@
+#include "ring_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+
+ByteRingBuffer::ByteRingBuffer(size_t capacity)
+    : m_storage(capacity), m_scratch(capacity), m_head(0), m_size(0),
+      m_scanned(0), m_overlongFrames(0) {}
+
+int ByteRingBuffer::writableSpans(Span spans[2]) {
+    size_t cap = capacity();
+    size_t free = cap - m_size;
+    if (free == 0) return 0;
+
+    size_t tail = (m_head + m_size) % cap;
+    size_t first = std::min(free, cap - tail);
+    spans[0] = {m_storage.data() + tail, first};
+    if (first == free) return 1;
+    spans[1] = {m_storage.data(), free - first};
+    return 2;
+}
+
+void ByteRingBuffer::commit(size_t n) {
+    m_size += std::min(n, freeSpace());
+}
+
+ssize_t ByteRingBuffer::readFrom(int fd) {
+    Span spans[2];
+    int count = writableSpans(spans);
+    if (count == 0) return 0;
+
+    iovec iov[2];
+    for (int i = 0; i < count; ++i) {
+        iov[i].iov_base = spans[i].data;
+        iov[i].iov_len = spans[i].size;
+    }
+    ssize_t n = readv(fd, iov, count);
+    if (n > 0) commit(static_cast<size_t>(n));
+    return n;
+}
+
+int ByteRingBuffer::readableSpans(ConstSpan spans[2]) const {
+    if (m_size == 0) return 0;
+
+    size_t cap = capacity();
+    size_t first = std::min(m_size, cap - m_head);
+    spans[0] = {m_storage.data() + m_head, first};
+    if (first == m_size) return 1;
+    spans[1] = {m_storage.data(), m_size - first};
+    return 2;
+}
+
+void ByteRingBuffer::consume(size_t n) {
+    n = std::min(n, m_size);
+    m_head = (m_head + n) % capacity();
+    m_size -= n;
+    m_scanned = (m_scanned > n) ? m_scanned - n : 0;
+}
+
+bool ByteRingBuffer::nextLine(std::string_view &line) {
+    ConstSpan spans[2];
+    int count = readableSpans(spans);
+
+    // Only look at bytes we have not scanned on a previous call, so a long
+    // partial frame is searched once rather than on every read.
+    size_t offset = 0;
+    for (int i = 0; i < count; ++i) {
+        size_t begin = (m_scanned > offset) ? m_scanned - offset : 0;
+        if (begin < spans[i].size) {
+            const void *hit = std::memchr(spans[i].data + begin, '\n', spans[i].size - begin);
+            if (hit) {
+                size_t pos = offset + (static_cast<const uint8_t *>(hit) - spans[i].data);
+                if (i == 0) {
+                    line = std::string_view(reinterpret_cast<const char *>(spans[0].data), pos);
+                } else {
+                    // Frame wraps around the end of storage: stitch it.
+                    std::memcpy(m_scratch.data(), spans[0].data, spans[0].size);
+                    std::memcpy(m_scratch.data() + spans[0].size, spans[1].data, pos - spans[0].size);
+                    line = std::string_view(m_scratch.data(), pos);
+                }
+                consume(pos + 1);
+                m_scanned = 0;
+                return true;
+            }
+        }
+        offset += spans[i].size;
+    }
+
+    m_scanned = m_size;
+    if (full()) {
+        ++m_overlongFrames;
+        clear();
+    }
+    return false;
+}
+
+void ByteRingBuffer::clear() {
+    m_head = 0;
+    m_size = 0;
+    m_scanned = 0;
+}
@@ -0,0 +1,64 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+
+// Fixed-capacity byte FIFO used by both the stdin and serial ingest paths.
+// Input is read straight into the free space (at most two spans), and complete
+// '\n'-terminated frames are handed out as views into the storage. Nothing is
+// allocated after construction; a frame that wraps around the end of the
+// storage is stitched into a preallocated scratch area.
+class ByteRingBuffer {
+public:
+    struct Span {
+        uint8_t *data;
+        size_t size;
+    };
+    struct ConstSpan {
+        const uint8_t *data;
+        size_t size;
+    };
+
+    explicit ByteRingBuffer(size_t capacity = 64 * 1024);
+
+    size_t capacity() const { return m_storage.size(); }
+    size_t size() const { return m_size; }
+    size_t freeSpace() const { return capacity() - m_size; }
+    bool empty() const { return m_size == 0; }
+    bool full() const { return m_size == capacity(); }
+
+    // Free region as up to two spans. Fill them in order, then commit().
+    int writableSpans(Span spans[2]);
+    void commit(size_t n);
+
+    // readv() from fd directly into the free region. Returns readv's result,
+    // or 0 without reading when the buffer is full.
+    ssize_t readFrom(int fd);
+
+    // Buffered bytes as up to two spans, oldest first.
+    int readableSpans(ConstSpan spans[2]) const;
+    void consume(size_t n);
+
+    // Pop the next complete frame, without its '\n'. The view stays valid
+    // until the next commit()/readFrom()/clear(). If the buffer fills up with
+    // no terminator in sight the contents are discarded as an overlong frame.
+    bool nextLine(std::string_view &line);
+
+    void clear();
+
+    uint64_t overlongFrames() const { return m_overlongFrames; }
+
+private:
+    std::vector<uint8_t> m_storage;
+    std::vector<char> m_scratch;
+    size_t m_head;      // index of the oldest buffered byte
+    size_t m_size;      // number of buffered bytes
+    size_t m_scanned;   // leading bytes already known to hold no '\n'
+    uint64_t m_overlongFrames;
+};
+
+#endif // RING_BUFFER_H
@@ -1,13 +1,36 @@
 #include "sequencer_model.h"
+#include "ingest_stats.h"
+#include <algorithm>
 
 SequencerModel::SequencerModel(int beats)
-    : m_beats(beats), m_current(0), m_pitches(beats, 0) {}
+    : m_beats(std::clamp(beats, 1, MAX_BEATS)), m_current(0),
+      m_batchDepth(0), m_moveCount(0), m_stats(nullptr), m_sourceTimestamp(0) {}
+
+void SequencerModel::noteSourceTimestamp(uint64_t ns) {
+    if (ns != 0 && (m_sourceTimestamp == 0 || ns < m_sourceTimestamp)) m_sourceTimestamp = ns;
+}
 
 void SequencerModel::setBeatPitch(int beat, int pitch) {
     if (beat < 0 || beat >= m_beats) return;
-    if (pitch < 0 || pitch > 8) return; // 4 bits = 0-8 (0=rest, 1-8=C4-C5)
-    m_pitches[beat] = pitch;
-    if (onBeatPitchChanged) onBeatPitchChanged(beat, pitch);
+    if (pitch < 0 || pitch > MAX_PITCH) return;
+    if (m_pitches[beat] == pitch) return;
+
+    Batch batch(*this);
+    m_pitches.setPitch(beat, pitch);
+}
+
+void SequencerModel::setPitches(const Pitches &pitches) {
+    static_assert(MAX_PITCH == 8, "pitchesAbove8() checks for pitches above 8");
+    Batch batch(*this);
+    Pitches old = m_pitches;
+    m_pitches = pitches;
+    m_pitches.clearFrom(m_beats);
+    for (int w = 0; w < Pitches::WORDS; ++w) {
+        for (uint64_t bad = Pitches::pitchesAbove8(m_pitches.word(w)); bad; bad &= bad - 1) {
+            int beat = w * Pitches::BEATS_PER_WORD + __builtin_ctzll(bad) / 4;
+            m_pitches.setPitch(beat, old[beat]);
+        }
+    }
 }
 
 int SequencerModel::getBeatPitch(int beat) const {
@@ -21,8 +44,80 @@ bool SequencerModel::isBeatActive(int beat) const {
 
 void SequencerModel::setCurrentBeat(int beat) {
     if (beat < 0 || beat >= m_beats) return;
+    Batch batch(*this);
     m_current = beat;
-    if (onBeatChanged) onBeatChanged(m_current);
+    noteMove(beat);
+}
+
+// A beat visited twice in one transaction is reported once
+void SequencerModel::noteMove(int beat) {
+    if (m_visited.test(size_t(beat))) return;
+    m_visited.set(size_t(beat));
+    m_moves[size_t(m_moveCount++)] = static_cast<uint16_t>(beat);
 }
 
 int SequencerModel::currentBeat() const { return m_current; }
+
+void SequencerModel::setNumBeats(int beats) {
+    beats = std::clamp(beats, 1, MAX_BEATS);
+    if (beats == m_beats) return;
+
+    Batch batch(*this);
+    // Dropped beats are no longer reported; added ones are rests on both
+    // sides of the transaction
+    m_pitches.clearFrom(beats);
+    m_before.clearFrom(beats);
+    m_beats = beats;
+    if (m_current >= m_beats) {
+        m_current = 0;
+        noteMove(0);
+    }
+    if (onBeatCountChanged) onBeatCountChanged(m_beats);
+}
+
+void SequencerModel::beginBatch() {
+    if (m_batchDepth++ == 0) {
+        m_before = m_pitches; // 128 bytes, no allocation
+    }
+}
+
+void SequencerModel::commitBatch() {
+    if (m_batchDepth == 0 || --m_batchDepth > 0) return;
+
+    // Everything the callbacks report is copied out first: a callback may
+    // open and commit a transaction of its own, which starts from scratch
+    const std::array<uint16_t, MAX_BEATS> moves = m_moves;
+    const int count = m_moveCount;
+    const int current = m_current;
+    const uint64_t sourceTimestamp = m_sourceTimestamp;
+    m_moveCount = 0;
+    m_visited.reset();
+    m_sourceTimestamp = 0;
+
+    // Word-wise diff: beats that were changed and changed back are not
+    // reported, and an unchanged state costs a compare
+    BeatMask dirty;
+    if (m_before != m_pitches) dirty = m_before.diff(m_pitches);
+
+    if (m_stats && (dirty.any() || count > 0)) {
+        m_stats->recordSince(IngestStats::STAGE_MODEL, sourceTimestamp);
+    }
+
+    if (dirty.any()) {
+        const Pitches before = m_before;
+        const Pitches after = m_pitches;
+        if (onPitchesChanged) onPitchesChanged({dirty, before, after});
+        if (onBeatPitchChanged) {
+            for (int i = 0; i < m_beats; ++i) {
+                if (dirty.test(i)) onBeatPitchChanged(i, after[i]);
+            }
+        }
+    }
+    if (count > 0 && onBeatChanged) {
+        for (int i = 0; i < count; ++i) {
+            if (moves[size_t(i)] < m_beats) onBeatChanged(moves[size_t(i)]);
+        }
+        // A wrap back onto a beat already reported still ends there
+        if (moves[size_t(count - 1)] != current) onBeatChanged(current);
+    }
+}
@@ -1,36 +1,110 @@
 #ifndef SEQUENCER_MODEL_H
 #define SEQUENCER_MODEL_H
 
-#include <vector>
+#include <array>
+#include <bitset>
 #include <functional>
 #include <cstdint>
+#include "static_sequencer_model.h"
+
+class IngestStats;
 
 // Passive model: stores state received from FPGA via UART
-// Protocol: Each beat has 3-bit pitch value (0-7, where 0=off, 1-7=pitches)
+// Protocol: Each beat has a 4-bit pitch value (0=off, 1-MAX_PITCH=pitches)
+// Runtime-sized, bounds-checked front end over a packed
+// StaticSequencerModel<MAX_BEATS>, which holds the pitches.
 class SequencerModel {
 public:
+    static constexpr int MAX_PITCH = 8; // 4 bits = 0-8 (0=rest, 1-8=C4-C5)
+    static constexpr int MAX_BEATS = 256;
+
+    using Pitches = StaticSequencerModel<MAX_BEATS>;
+    using BeatMask = Pitches::Mask;
+
+    // Net effect of one transaction. `before`/`after` are indexed by beat and
+    // only meaningful where `dirty` is set.
+    struct PitchChange {
+        const BeatMask &dirty;
+        const Pitches &before;
+        const Pitches &after;
+    };
+
+    // RAII transaction: notifications are held back until the outermost
+    // scope ends, then delivered once.
+    class Batch {
+    public:
+        explicit Batch(SequencerModel &model) : m_model(model) { m_model.beginBatch(); }
+        ~Batch() { m_model.commitBatch(); }
+        Batch(const Batch &) = delete;
+        Batch &operator=(const Batch &) = delete;
+    private:
+        SequencerModel &m_model;
+    };
+
     explicit SequencerModel(int beats = 16);
 
-    // Set pitch for a specific beat (0=off, 1-7=pitch)
+    // Set pitch for a specific beat (0=off, 1-8=pitch)
     void setBeatPitch(int beat, int pitch);
     int getBeatPitch(int beat) const;
 
     // Check if specific beat is active (pitch > 0)
     bool isBeatActive(int beat) const;
+    int activeBeatCount() const { return m_pitches.activeCount(); }
+
+    // Whole state at once. Beats past numBeats() are always rests, so two
+    // models compare equal exactly when their sequences do.
+    const Pitches &pitches() const { return m_pitches; }
+    // Replace every pitch in one transaction; beats past numBeats() are
+    // dropped, and beats above MAX_PITCH keep their pitch, as setBeatPitch()
+    // ignores them
+    void setPitches(const Pitches &pitches);
 
     void setCurrentBeat(int beat);
     int currentBeat() const;
 
     int numBeats() const { return m_beats; }
 
-    // Callbacks for GUI updates
+    // Resize the sequence at runtime (clamped to 1-MAX_BEATS). New beats
+    // start as rests; the playhead rewinds to 0 if it falls off the end.
+    void setNumBeats(int beats);
+
+    // Transactions nest; only the outermost commit notifies. A change made
+    // outside a transaction is committed on its own.
+    void beginBatch();
+    void commitBatch();
+    bool inBatch() const { return m_batchDepth > 0; }
+
+    // Instrumentation: the earliest source timestamp noted inside a batch is
+    // timed against its commit, and stays readable from the callbacks it
+    // triggers so widgets can time their paint. Every commit clears it.
+    void setStats(IngestStats *stats) { m_stats = stats; }
+    void noteSourceTimestamp(uint64_t ns);
+    uint64_t sourceTimestamp() const { return m_sourceTimestamp; }
+
+    // Callbacks for GUI updates. onBeatChanged comes once per distinct beat
+    // the playhead visited in the transaction, in visiting order, the last
+    // call always being the current beat.
     std::function<void(int)> onBeatChanged;
-    std::function<void(int beat, int pitch)> onBeatPitchChanged;
+    std::function<void(const PitchChange &)> onPitchesChanged; // once per commit
+    std::function<void(int beat, int pitch)> onBeatPitchChanged; // per changed beat
+    std::function<void(int beats)> onBeatCountChanged; // immediately, before the commit
 
 private:
     int m_beats;
     int m_current;
-    std::vector<int> m_pitches; // 3-bit pitch per beat (0-7)
+    Pitches m_pitches; // 4-bit pitch per beat (0-8)
+
+    void noteMove(int beat);
+
+    int m_batchDepth;
+    // Playhead moves held back by the open transaction
+    std::array<uint16_t, MAX_BEATS> m_moves;
+    int m_moveCount;
+    BeatMask m_visited;
+    Pitches m_before;  // the changed beats are found by diffing against this
+
+    IngestStats *m_stats;
+    uint64_t m_sourceTimestamp;
 };
 
 #endif // SEQUENCER_MODEL_H
@@ -0,0 +1,76 @@
+#include "serial_device.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+speed_t toSpeed(int baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    // High rates for the framed protocol; 1-3 Mbaud divide 12 MHz exactly
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+#ifdef B1000000
+    case 1000000: return B1000000;
+#endif
+#ifdef B1500000
+    case 1500000: return B1500000;
+#endif
+#ifdef B2000000
+    case 2000000: return B2000000;
+#endif
+#ifdef B3000000
+    case 3000000: return B3000000;
+#endif
+    default: return 0;
+    }
+}
+
+} // namespace
+
+int openSerialDevice(const std::string &path, int baud, std::string *error) {
+    auto fail = [&](const std::string &what) {
+        if (error) *error = what + ": " + std::strerror(errno);
+        return -1;
+    };
+
+    speed_t speed = toSpeed(baud);
+    if (speed == 0) {
+        errno = EINVAL;
+        return fail("Unsupported baud rate " + std::to_string(baud));
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) return fail("Failed to open " + path);
+
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+            int saved = errno;
+            ::close(fd);
+            errno = saved;
+            return fail("Failed to configure " + path);
+        }
+    }
+    // Not a tty (pipe, FIFO): nothing to configure
+    return fd;
+}
@@ -0,0 +1,11 @@
+#ifndef SERIAL_DEVICE_H
+#define SERIAL_DEVICE_H
+
+#include <string>
+
+// Open a tty read-only in raw 8N1 mode at the given baud rate without going
+// through QSerialPort, for readers that live off the GUI thread.
+// Returns the file descriptor, or -1 with a message in *error.
+int openSerialDevice(const std::string &path, int baud, std::string *error = nullptr);
+
+#endif // SERIAL_DEVICE_H
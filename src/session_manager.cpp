@@ -0,0 +1,291 @@
+#include "session_manager.h"
+#include "capture_file.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <sys/epoll.h>
+
+SessionManager::SessionManager(int threads) : m_running(false), m_nextId(1) {
+    if (threads <= 0) threads = static_cast<int>(std::min(4u, std::max(1u, std::thread::hardware_concurrency())));
+    for (int i = 0; i < threads; ++i) m_reactors.push_back(std::make_unique<Reactor>());
+}
+
+SessionManager::~SessionManager() {
+    stop();
+}
+
+bool SessionManager::start() {
+    if (m_running) return true;
+    for (auto &reactor : m_reactors) {
+        if (!reactor->loop.isValid()) return false;
+    }
+    for (auto &reactor : m_reactors) {
+        Reactor *r = reactor.get();
+        r->thread = std::thread([r]() { r->loop.run(); });
+    }
+    m_running = true;
+    return true;
+}
+
+void SessionManager::stop() {
+    if (!m_running) return;
+    for (auto &reactor : m_reactors) reactor->loop.stop();
+    for (auto &reactor : m_reactors) {
+        if (reactor->thread.joinable()) reactor->thread.join();
+    }
+    m_running = false;
+
+    // The reactors are gone, so sessions can be closed from here
+    std::lock_guard<std::mutex> lock(m_boardsMutex);
+    for (auto &entry : m_boards) {
+        Board &board = *entry.second;
+        if (const CaptureWriter *capture = board.session->capture()) {
+            LOG_INFO_MSG("[Capture] {}: {} bytes in {} records{}", board.session->name(),
+                         capture->bytesCaptured(), capture->recordsCaptured(),
+                         capture->failed() ? " (write error)" : "");
+        }
+        board.session->stopCapture();
+        if (board.session->isOpen()) {
+            board.reactor->loop.removeFd(board.session->fd());
+            board.session->close();
+            board.reactor->boards.fetch_sub(1);
+        }
+        publish(board);
+    }
+}
+
+int SessionManager::addDevice(const BoardSession::Config &config, const std::string &path, int baud,
+                              std::string *error) {
+    auto session = std::make_unique<BoardSession>(config);
+    if (!session->openDevice(path, baud, error)) return -1;
+    return adopt(std::move(session));
+}
+
+int SessionManager::addReplay(const BoardSession::Config &config, const std::string &path, double speed,
+                              std::string *error) {
+    auto session = std::make_unique<BoardSession>(config);
+    if (!session->openReplay(path, speed, error)) return -1;
+    return adopt(std::move(session));
+}
+
+int SessionManager::addFd(const BoardSession::Config &config, int fd, bool ownsFd) {
+    auto session = std::make_unique<BoardSession>(config);
+    session->attach(fd, ownsFd);
+    return adopt(std::move(session));
+}
+
+int SessionManager::adopt(std::unique_ptr<BoardSession> session) {
+    auto board = std::make_shared<Board>();
+    board->session = std::move(session);
+
+    // Least loaded reactor; ties go to the first
+    Reactor *reactor = m_reactors.front().get();
+    for (auto &r : m_reactors) {
+        if (r->boards.load() < reactor->boards.load()) reactor = r.get();
+    }
+    board->reactor = reactor;
+    reactor->boards.fetch_add(1);
+
+    {
+        std::lock_guard<std::mutex> lock(m_boardsMutex);
+        board->id = m_nextId++;
+        board->snapshot.id = board->id;
+        publish(*board);
+        m_boards[board->id] = board;
+    }
+    // Runs once the reactor is (or gets) going
+    reactor->loop.post([this, board]() { watch(board); });
+    return board->id;
+}
+
+void SessionManager::watch(const std::shared_ptr<Board> &board) {
+    BoardSession &session = *board->session;
+    if (!session.isOpen()) return;  // removed before the reactor got to it
+
+    Board *raw = board.get();
+    std::weak_ptr<Board> weak = board;
+    bool watched = board->reactor->loop.addFd(session.fd(), EPOLLIN, [this, raw, weak](uint32_t) {
+        if (raw->session->readAvailable()) {
+            if (publish(*raw) && onBoardChanged) {
+                // Copied, so the callback runs unlocked and may call back in
+                {
+                    std::lock_guard<std::mutex> lock(raw->mutex);
+                    raw->changed = raw->snapshot;
+                }
+                onBoardChanged(raw->changed);
+            }
+        } else if (auto self = weak.lock()) {
+            closeBoard(self, "end of input");
+        }
+    });
+    if (watched) return;
+
+    if (errno == EPERM) {
+        // Regular files cannot be watched and are always readable
+        while (session.readAvailable()) {}
+        closeBoard(board, "end of input");
+    } else {
+        closeBoard(board, std::string("cannot watch: ") + std::strerror(errno));
+    }
+}
+
+bool SessionManager::publish(Board &board) {
+    std::lock_guard<std::mutex> lock(board.mutex);
+    uint64_t revision = board.session->revision();
+    bool changed = revision != board.publishedRevision;
+    board.session->snapshot(board.snapshot, changed);
+    board.publishedRevision = revision;
+    return changed;
+}
+
+void SessionManager::closeBoard(const std::shared_ptr<Board> &board, const std::string &reason) {
+    BoardSession &session = *board->session;
+    if (session.isOpen()) {
+        board->reactor->loop.removeFd(session.fd());
+        session.close();
+        board->reactor->boards.fetch_sub(1);
+    }
+    publish(*board);
+    {
+        std::lock_guard<std::mutex> lock(board->mutex);
+        board->snapshot.error = reason;
+    }
+    LOG_INFO_MSG("[Boards] {} closed: {}", session.name(), reason);
+    if (onBoardClosed) onBoardClosed(board->id);
+}
+
+void SessionManager::removeBoard(int id) {
+    std::shared_ptr<Board> board;
+    {
+        std::lock_guard<std::mutex> lock(m_boardsMutex);
+        auto it = m_boards.find(id);
+        if (it == m_boards.end()) return;
+        board = it->second;
+        m_boards.erase(it);
+    }
+
+    auto teardown = [board]() {
+        BoardSession &session = *board->session;
+        if (session.isOpen()) {
+            board->reactor->loop.removeFd(session.fd());
+            board->reactor->boards.fetch_sub(1);
+        }
+        session.stopCapture();
+        session.close();
+    };
+    if (m_running) {
+        board->reactor->loop.post(teardown);
+    } else {
+        teardown();
+    }
+}
+
+bool SessionManager::startCapture(int id, const std::string &path, std::string *error) {
+    std::shared_ptr<Board> board = find(id);
+    if (!board) {
+        if (error) *error = "No such board";
+        return false;
+    }
+    auto task = [this, board, path]() {
+        std::string message;
+        bool ok = board->session->startCapture(path, &message);
+        publish(*board);
+        return std::make_pair(ok, message);
+    };
+    std::pair<bool, std::string> result;
+    const std::thread::id caller = std::this_thread::get_id();
+    if (m_running && caller != board->reactor->thread.get_id() && onReactorThread(caller)) {
+        // Waiting here on another reactor could wait on one waiting on us
+        if (error) *error = "Cannot start a capture from another board's reactor thread";
+        return false;
+    }
+    if (m_running && caller != board->reactor->thread.get_id()) {
+        std::packaged_task<std::pair<bool, std::string>()> packaged(task);
+        auto future = packaged.get_future();
+        board->reactor->loop.post([&packaged]() { packaged(); });
+        result = future.get();
+    } else {
+        // Stopped, or called from the board's own reactor (a session
+        // callback): posting and waiting there would never return
+        result = task();
+    }
+    if (!result.first && error) *error = result.second;
+    return result.first;
+}
+
+void SessionManager::stopCapture(int id) {
+    std::shared_ptr<Board> board = find(id);
+    if (!board) return;
+    auto task = [this, board]() {
+        board->session->stopCapture();
+        publish(*board);
+    };
+    if (m_running) {
+        board->reactor->loop.post(task);
+    } else {
+        task();
+    }
+}
+
+bool SessionManager::onReactorThread(std::thread::id id) const {
+    for (const auto &reactor : m_reactors) {
+        if (reactor->thread.get_id() == id) return true;
+    }
+    return false;
+}
+
+std::shared_ptr<SessionManager::Board> SessionManager::find(int id) const {
+    std::lock_guard<std::mutex> lock(m_boardsMutex);
+    auto it = m_boards.find(id);
+    return it == m_boards.end() ? nullptr : it->second;
+}
+
+std::vector<int> SessionManager::boardIds() const {
+    std::lock_guard<std::mutex> lock(m_boardsMutex);
+    std::vector<int> ids;
+    ids.reserve(m_boards.size());
+    for (const auto &entry : m_boards) ids.push_back(entry.first);
+    return ids;
+}
+
+size_t SessionManager::boardCount() const {
+    std::lock_guard<std::mutex> lock(m_boardsMutex);
+    return m_boards.size();
+}
+
+size_t SessionManager::openBoardCount() const {
+    size_t open = 0;
+    for (const auto &reactor : m_reactors) open += static_cast<size_t>(reactor->boards.load());
+    return open;
+}
+
+bool SessionManager::snapshot(int id, BoardSnapshot &out) const {
+    std::shared_ptr<Board> board = find(id);
+    if (!board) return false;
+    std::lock_guard<std::mutex> lock(board->mutex);
+    out = board->snapshot;
+    return true;
+}
+
+std::vector<BoardSnapshot> SessionManager::snapshots() const {
+    std::vector<std::shared_ptr<Board>> boards;
+    {
+        std::lock_guard<std::mutex> lock(m_boardsMutex);
+        boards.reserve(m_boards.size());
+        for (const auto &entry : m_boards) boards.push_back(entry.second);
+    }
+    std::vector<BoardSnapshot> out(boards.size());
+    for (size_t i = 0; i < boards.size(); ++i) {
+        std::lock_guard<std::mutex> lock(boards[i]->mutex);
+        out[i] = boards[i]->snapshot;
+    }
+    return out;
+}
+
+std::string SessionManager::statsJson(int id, uint64_t nowNs) const {
+    std::shared_ptr<Board> board = find(id);
+    // IngestStats is all atomics, so reading it off the reactor is safe
+    return board ? board->session->stats().toJsonLine(nowNs) : std::string();
+}
@@ -0,0 +1,97 @@
+#ifndef SESSION_MANAGER_H
+#define SESSION_MANAGER_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "board_session.h"
+#include "event_loop.h"
+
+// Many boards in one process. Each board is a BoardSession serviced by one
+// of a few epoll reactor threads (boards are spread over the least loaded),
+// so a board costs a descriptor and its decode work rather than a process.
+//
+// Sessions are touched only by their reactor. After every read the reactor
+// copies the board's counters (and its pitches, when they changed) into a
+// snapshot under a per-board mutex, which is all other threads ever see.
+class SessionManager {
+public:
+    // 0 threads means one per core, capped at 4
+    explicit SessionManager(int threads = 1);
+    ~SessionManager();
+
+    SessionManager(const SessionManager &) = delete;
+    SessionManager &operator=(const SessionManager &) = delete;
+
+    bool start();
+    void stop();
+    int threadCount() const { return static_cast<int>(m_reactors.size()); }
+
+    // The source is opened on the calling thread, then handed to a reactor.
+    // Returns the board id, or -1 with a message in *error.
+    int addDevice(const BoardSession::Config &config, const std::string &path, int baud,
+                  std::string *error = nullptr);
+    int addReplay(const BoardSession::Config &config, const std::string &path, double speed,
+                  std::string *error = nullptr);
+    int addFd(const BoardSession::Config &config, int fd, bool ownsFd);
+    void removeBoard(int id);
+
+    // Blocks until the board's reactor has opened or closed the file. From
+    // the board's own reactor (its callbacks) it runs inline; from another
+    // reactor it fails rather than risk two reactors waiting on each other.
+    bool startCapture(int id, const std::string &path, std::string *error = nullptr);
+    void stopCapture(int id);
+
+    std::vector<int> boardIds() const;
+    size_t boardCount() const;
+    size_t openBoardCount() const;
+    bool snapshot(int id, BoardSnapshot &out) const;
+    std::vector<BoardSnapshot> snapshots() const;
+    // The board's pipeline stats line (IngestStats::toJsonLine)
+    std::string statsJson(int id, uint64_t nowNs) const;
+
+    // A board's source ended or failed. Called on its reactor thread.
+    std::function<void(int id)> onBoardClosed;
+    // A read changed a board's state (pitches, playhead or length). Called on
+    // its reactor thread with the fresh snapshot and no lock held; keep it
+    // short.
+    std::function<void(const BoardSnapshot &snapshot)> onBoardChanged;
+
+private:
+    struct Reactor {
+        EventLoop loop;
+        std::thread thread;
+        std::atomic<int> boards{0};
+    };
+
+    struct Board {
+        int id;
+        Reactor *reactor;
+        std::shared_ptr<BoardSession> session;  // reactor thread only
+        mutable std::mutex mutex;               // guards snapshot
+        BoardSnapshot snapshot;
+        uint64_t publishedRevision = UINT64_MAX;
+        BoardSnapshot changed;                  // reactor thread only: onBoardChanged's copy
+    };
+
+    int adopt(std::unique_ptr<BoardSession> session);
+    void watch(const std::shared_ptr<Board> &board);
+    bool publish(Board &board);  // true if the state changed
+    void closeBoard(const std::shared_ptr<Board> &board, const std::string &reason);
+    std::shared_ptr<Board> find(int id) const;
+    bool onReactorThread(std::thread::id id) const;
+
+    std::vector<std::unique_ptr<Reactor>> m_reactors;
+    bool m_running;
+
+    mutable std::mutex m_boardsMutex;
+    std::map<int, std::shared_ptr<Board>> m_boards;
+    int m_nextId;
+};
+
+#endif // SESSION_MANAGER_H
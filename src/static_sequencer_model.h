@@ -0,0 +1,117 @@
+#ifndef STATIC_SEQUENCER_MODEL_H
+#define STATIC_SEQUENCER_MODEL_H
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+// Compile-time sized sequence state laid out like the `beats` register in
+// hdl/model.sv: one 4-bit pitch per beat, beat i in bits [4i+3:4i], sixteen
+// beats to a 64-bit word. 256 beats are 128 bytes, two cache lines, so whole
+// states are copied, compared and diffed a word at a time.
+//
+// Accessors do no bounds checking; SequencerModel is the checked, runtime
+// sized wrapper used by the parser and the widgets.
+template <int NumBeats>
+class StaticSequencerModel {
+    static_assert(NumBeats > 0, "a sequence needs at least one beat");
+
+public:
+    static constexpr int BEATS = NumBeats;
+    static constexpr int BEATS_PER_WORD = 16;
+    static constexpr int WORDS = (NumBeats + BEATS_PER_WORD - 1) / BEATS_PER_WORD;
+
+    using Word = uint64_t;
+    using Mask = std::bitset<NumBeats>;
+
+    int pitch(int beat) const {
+        return int((m_words[beat / BEATS_PER_WORD] >> shift(beat)) & 0xF);
+    }
+    int operator[](int beat) const { return pitch(beat); }
+
+    // Only the low 4 bits of `pitch` are stored, as on the board
+    void setPitch(int beat, int pitch) {
+        Word &w = m_words[beat / BEATS_PER_WORD];
+        w = (w & ~(Word(0xF) << shift(beat))) | (Word(pitch & 0xF) << shift(beat));
+    }
+
+    void clear() { m_words.fill(0); }
+
+    // Rest every beat from `beat` on
+    void clearFrom(int beat) {
+        if (beat >= NumBeats) return;
+        int word = beat / BEATS_PER_WORD;
+        m_words[word] &= ~(~Word(0) << shift(beat));
+        for (int i = word + 1; i < WORDS; ++i) m_words[i] = 0;
+    }
+
+    bool operator==(const StaticSequencerModel &other) const { return m_words == other.m_words; }
+    bool operator!=(const StaticSequencerModel &other) const { return m_words != other.m_words; }
+
+    // Beats with a non-zero pitch
+    int activeCount() const {
+        int count = 0;
+        for (Word w : m_words) count += popcount(nonZeroNibbles(w));
+        return count;
+    }
+
+    // Beats whose pitch differs from `other`
+    int diffCount(const StaticSequencerModel &other) const {
+        int count = 0;
+        for (int i = 0; i < WORDS; ++i) count += popcount(nonZeroNibbles(m_words[i] ^ other.m_words[i]));
+        return count;
+    }
+
+    // Same, as a mask; the cost is per word plus per changed beat
+    Mask diff(const StaticSequencerModel &other) const {
+        Mask mask;
+        for (int i = 0; i < WORDS; ++i) {
+            for (Word bits = nonZeroNibbles(m_words[i] ^ other.m_words[i]); bits; bits &= bits - 1) {
+                mask.set(size_t(i * BEATS_PER_WORD + __builtin_ctzll(bits) / 4));
+            }
+        }
+        return mask;
+    }
+
+    Mask activeMask() const { return diff(StaticSequencerModel()); }
+
+    // One bit (the low bit of the nibble) per beat of `w` holding 9-15,
+    // above the highest pitch the board plays
+    static Word pitchesAbove8(Word w) {
+        constexpr Word LOW_BITS = 0x1111111111111111ull;
+        return (w >> 3) & (w | (w >> 1) | (w >> 2)) & LOW_BITS;
+    }
+
+    // Raw words, beat 0 in the low nibble of word 0
+    const std::array<Word, WORDS> &words() const { return m_words; }
+    Word word(int index) const { return m_words[index]; }
+
+    // Load the register as dumped from model.sv (or a snapshot of it); words
+    // past `count` are cleared and nibbles past NumBeats dropped
+    void loadRegister(const Word *words, int count) {
+        for (int i = 0; i < WORDS; ++i) m_words[i] = i < count ? words[i] : 0;
+        if (NumBeats % BEATS_PER_WORD) m_words[WORDS - 1] &= ~(~Word(0) << shift(NumBeats));
+    }
+    void loadRegister(Word reg) { loadRegister(&reg, 1); }
+
+    static StaticSequencerModel fromRegister(Word reg) {
+        StaticSequencerModel model;
+        model.loadRegister(reg);
+        return model;
+    }
+
+private:
+    static constexpr int shift(int beat) { return (beat % BEATS_PER_WORD) * 4; }
+
+    // One bit (the low bit of each nibble) per non-zero nibble
+    static Word nonZeroNibbles(Word w) {
+        constexpr Word LOW_BITS = 0x1111111111111111ull;
+        return (w | (w >> 1) | (w >> 2) | (w >> 3)) & LOW_BITS;
+    }
+    static int popcount(Word w) { return __builtin_popcountll(w); }
+
+    std::array<Word, WORDS> m_words{};
+};
+
+#endif // STATIC_SEQUENCER_MODEL_H
@@ -0,0 +1,60 @@
+#include "stats_panel.h"
+#include <QGridLayout>
+#include <QLabel>
+
+namespace {
+
+QString formatMicros(uint64_t ns) {
+    return QString::number(ns / 1000.0, 'f', ns < 10000 ? 1 : 0);
+}
+
+} // namespace
+
+StatsPanel::StatsPanel(const IngestStats *stats, QWidget *parent)
+    : QGroupBox("Pipeline Latency (µs since read)", parent), m_stats(stats) {
+    auto *layout = new QGridLayout(this);
+    layout->setHorizontalSpacing(12);
+    layout->setVerticalSpacing(2);
+
+    const char *headers[] = {"Stage", "Count", "p50", "p99", "Max"};
+    for (int c = 0; c < 5; ++c) {
+        auto *header = new QLabel(headers[c], this);
+        header->setStyleSheet("color: #888; font-weight: bold;");
+        layout->addWidget(header, 0, c, c == 0 ? Qt::AlignLeft : Qt::AlignRight);
+    }
+
+    for (int s = 0; s < IngestStats::NUM_STAGES; ++s) {
+        layout->addWidget(new QLabel(IngestStats::stageName(static_cast<IngestStats::Stage>(s)), this),
+                          s + 1, 0);
+        for (int c = 0; c < 4; ++c) {
+            m_stageLabels[s][c] = new QLabel("-", this);
+            layout->addWidget(m_stageLabels[s][c], s + 1, c + 1, Qt::AlignRight);
+        }
+    }
+
+    m_counters = new QLabel(this);
+    m_counters->setStyleSheet("color: #888;");
+    layout->addWidget(m_counters, IngestStats::NUM_STAGES + 1, 0, 1, 5);
+
+    m_timer = new QTimer(this);
+    m_timer->setInterval(500);
+    connect(m_timer, &QTimer::timeout, this, &StatsPanel::refresh);
+    m_timer->start();
+    refresh();
+}
+
+void StatsPanel::refresh() {
+    for (int s = 0; s < IngestStats::NUM_STAGES; ++s) {
+        const LatencyHistogram &h = m_stats->stage(static_cast<IngestStats::Stage>(s));
+        if (h.count() == 0) continue;
+        m_stageLabels[s][0]->setText(QString::number(h.count()));
+        m_stageLabels[s][1]->setText(formatMicros(h.percentile(0.50)));
+        m_stageLabels[s][2]->setText(formatMicros(h.percentile(0.99)));
+        m_stageLabels[s][3]->setText(formatMicros(h.max()));
+    }
+    m_counters->setText(QString("Bytes %1 · Frames %2 · Errors %3 · Drops %4")
+                            .arg(m_stats->bytes())
+                            .arg(m_stats->frames())
+                            .arg(m_stats->errors())
+                            .arg(m_stats->drops()));
+}
@@ -0,0 +1,29 @@
+#ifndef STATS_PANEL_H
+#define STATS_PANEL_H
+
+#include <QGroupBox>
+#include <QTimer>
+#include "ingest_stats.h"
+
+class QLabel;
+
+// Compact table of per-stage p50/p99/max latency plus pipeline counters,
+// refreshed from an IngestStats on a timer.
+class StatsPanel : public QGroupBox {
+    Q_OBJECT
+public:
+    explicit StatsPanel(const IngestStats *stats, QWidget *parent = nullptr);
+
+    void setRefreshInterval(int ms) { m_timer->setInterval(ms); }
+
+private slots:
+    void refresh();
+
+private:
+    const IngestStats *m_stats;
+    QTimer *m_timer;
+    QLabel *m_stageLabels[IngestStats::NUM_STAGES][4]; // count, p50, p99, max
+    QLabel *m_counters;
+};
+
+#endif // STATS_PANEL_H
@@ -0,0 +1,177 @@
+#include "timing_checker.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <istream>
+#include <sstream>
+
+TimingChecker::TimingChecker(const TimingParams &params, size_t maxReported)
+    : m_params(params), m_maxReported(maxReported), m_audio(params), m_beat(0), m_pwm(false), m_tx(true),
+      m_inByte(false), m_byteStart(0), m_nextStart(0), m_lastCycle(0) {
+    m_audio.onBeat = [this](uint64_t cycle, int beat) { m_beatQueue.push_back({cycle, beat}); };
+    m_audio.onPwmEdge = [this](uint64_t cycle, bool level) { m_pwmQueue.push_back({cycle, level}); };
+}
+
+void TimingChecker::diverge(uint64_t cycle, std::string what) {
+    ++m_counters.divergences;
+    if (m_divergences.size() < m_maxReported) m_divergences.push_back({cycle, std::move(what)});
+}
+
+void TimingChecker::expect(std::deque<Expected> &queue, uint64_t cycle, int value, const char *signal) {
+    m_audio.run(cycle);
+    m_lastCycle = cycle;
+    while (!queue.empty() && queue.front().cycle < cycle) {
+        diverge(queue.front().cycle,
+                std::string(signal) + " should have gone to " + std::to_string(queue.front().value));
+        queue.pop_front();
+    }
+    if (!queue.empty() && queue.front().cycle == cycle && queue.front().value == value) {
+        queue.pop_front();
+        if (&queue == &m_beatQueue) {
+            ++m_counters.beats;
+        } else {
+            ++m_counters.pwmEdges;
+        }
+        return;
+    }
+    diverge(cycle, std::string(signal) + " went to " + std::to_string(value) + " unpredicted");
+}
+
+void TimingChecker::beatsRegister(uint64_t cycle, const Pitches &beats) {
+    m_lastCycle = cycle;
+    m_audio.setBeats(cycle, beats);
+}
+
+void TimingChecker::beatCount(uint64_t cycle, int beat) {
+    if (beat == m_beat) return;
+    m_beat = beat;
+    expect(m_beatQueue, cycle, beat, "beat_count");
+}
+
+void TimingChecker::pwm(uint64_t cycle, bool level) {
+    if (level == m_pwm) return;
+    m_pwm = level;
+    expect(m_pwmQueue, cycle, level, "pwm_out");
+}
+
+void TimingChecker::byteEnded(uint64_t start) {
+    m_inByte = false;
+    m_nextStart = start + m_params.byteCycles();
+    ++m_counters.bytes;
+}
+
+void TimingChecker::tx(uint64_t cycle, bool level) {
+    if (level == m_tx) return;
+    m_tx = level;
+    m_lastCycle = cycle;
+    uint64_t pulse = m_params.pulseWidth();
+
+    if (m_inByte) {
+        uint64_t offset = cycle - m_byteStart;
+        if (offset < 9 * pulse) {
+            if (offset % pulse) {
+                diverge(cycle, "UART edge " + std::to_string(offset % pulse) + " cycles off a bit boundary");
+            }
+            return;
+        }
+        if (level) {
+            // Rising at or after the stop bit: on time only if exactly at it
+            if (offset != 9 * pulse) {
+                diverge(cycle, "UART stop bit " + std::to_string(offset - 9 * pulse) + " cycles late");
+            }
+            byteEnded(m_byteStart);
+            return;
+        }
+        // Falling with the line high since its last edge, so the stop bit
+        // was in place; this starts the next byte
+        byteEnded(m_byteStart);
+    }
+
+    if (!level) {
+        if (cycle < m_nextStart) {
+            diverge(cycle, "UART start bit " + std::to_string(m_nextStart - cycle) +
+                               " cycles before uart_tx could accept a byte");
+        }
+        m_inByte = true;
+        m_byteStart = cycle;
+    }
+}
+
+void TimingChecker::finish(uint64_t cycle) {
+    m_audio.run(cycle);
+    for (const Expected &e : m_beatQueue) {
+        if (e.cycle <= cycle) diverge(e.cycle, "beat_count should have gone to " + std::to_string(e.value));
+    }
+    for (const Expected &e : m_pwmQueue) {
+        if (e.cycle <= cycle) diverge(e.cycle, "pwm_out should have gone to " + std::to_string(e.value));
+    }
+    m_beatQueue.clear();
+    m_pwmQueue.clear();
+    // A byte still on the wire is fine if its stop bit has not come due
+    if (m_inByte && m_tx && cycle >= m_byteStart + 9ull * m_params.pulseWidth()) byteEnded(m_byteStart);
+}
+
+bool TimingChecker::feedLine(const std::string &line, std::string *error) {
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') return true;
+
+    std::istringstream in(line);
+    uint64_t cycle;
+    std::string signal, value;
+    if (!(in >> cycle >> signal >> value)) {
+        if (error) *error = "Malformed trace line: " + line;
+        return false;
+    }
+    if (cycle < m_lastCycle) {
+        if (error) *error = "Trace goes back in time at: " + line;
+        return false;
+    }
+    if (signal == "beats") {
+        // Beat 0 in the last digit, as the register prints
+        Pitches beats;
+        int beat = 0;
+        for (auto it = value.rbegin(); it != value.rend() && beat < Pitches::BEATS; ++it, ++beat) {
+            int digit = std::isdigit(static_cast<unsigned char>(*it)) ? *it - '0'
+                                                                       : std::tolower(static_cast<unsigned char>(*it)) - 'a' + 10;
+            if (digit < 0 || digit > 15) {
+                if (error) *error = "Bad register value in trace line: " + line;
+                return false;
+            }
+            beats.setPitch(beat, digit);
+        }
+        beatsRegister(cycle, beats);
+    } else if (signal == "beat") {
+        beatCount(cycle, std::atoi(value.c_str()));
+    } else if (signal == "pwm") {
+        pwm(cycle, value != "0");
+    } else if (signal == "tx") {
+        tx(cycle, value != "0");
+    } else {
+        if (error) *error = "Unknown signal in trace line: " + line;
+        return false;
+    }
+    return true;
+}
+
+bool TimingChecker::readTraceParams(std::istream &in, TimingParams &params) {
+    std::string line;
+    while (in.peek() == '#' && std::getline(in, line)) {
+        TimingParams p;
+        unsigned long long clk, baud;
+        if (std::sscanf(line.c_str(), "# clk %llu baud %llu beats %d period %d", &clk, &baud, &p.numBeats,
+                        &p.period) == 4) {
+            p.clkFreq = uint32_t(clk);
+            p.baudRate = uint32_t(baud);
+            params = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string TimingChecker::traceHeader(const TimingParams &params) {
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "# clk %u baud %u beats %d period %d", params.clkFreq, params.baudRate,
+                  params.numBeats, params.period);
+    return buf;
+}
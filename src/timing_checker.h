@@ -0,0 +1,92 @@
+#ifndef TIMING_CHECKER_H
+#define TIMING_CHECKER_H
+
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "timing_model.h"
+
+// Compares a simulator's trace of the board with the event-level models.
+// The trace supplies the beats register as it changes (the models' only
+// input) and the outputs to check: beat_count, the PWM pin and the UART TX
+// pin. Every output change must land on the cycle the models predict.
+//
+// PWM and beat changes are checked edge for edge. UART bytes depend on the
+// framer, which is not modelled, so each byte is checked against uart_tx's
+// rules instead: edges only on bit boundaries from its start bit, the stop
+// bit on time, and no start before uart_tx could have accepted the byte.
+//
+// Events must arrive in cycle order across all signals.
+class TimingChecker {
+public:
+    using Pitches = SequencerModel::Pitches;
+
+    struct Divergence {
+        uint64_t cycle;
+        std::string what;
+    };
+
+    struct Counters {
+        uint64_t beats = 0;     // beat_count changes matched
+        uint64_t pwmEdges = 0;  // PWM edges matched
+        uint64_t bytes = 0;     // UART bytes framed correctly
+        uint64_t divergences = 0;
+    };
+
+    explicit TimingChecker(const TimingParams &params, size_t maxReported = 20);
+
+    const TimingParams &params() const { return m_params; }
+
+    // The beats register took a new value after edge `cycle`
+    void beatsRegister(uint64_t cycle, const Pitches &beats);
+    void beatCount(uint64_t cycle, int beat);
+    void pwm(uint64_t cycle, bool level);
+    void tx(uint64_t cycle, bool level);
+
+    // End of trace: every change predicted up to `cycle` must have been seen
+    void finish(uint64_t cycle);
+
+    const Counters &counters() const { return m_counters; }
+    // The first maxReported, in the order found
+    const std::vector<Divergence> &divergences() const { return m_divergences; }
+    bool ok() const { return m_counters.divergences == 0; }
+
+    // Trace text, one change per line: "CYCLE SIGNAL VALUE" with SIGNAL one
+    // of beats (hex register), beat, pwm or tx, and '#' comments
+    bool feedLine(const std::string &line, std::string *error = nullptr);
+    // The "# clk HZ baud BAUD beats N period S" header a trace starts with;
+    // false (and `params` untouched) without one
+    static bool readTraceParams(std::istream &in, TimingParams &params);
+    static std::string traceHeader(const TimingParams &params);
+
+private:
+    struct Expected {
+        uint64_t cycle;
+        int value;
+    };
+
+    void expect(std::deque<Expected> &queue, uint64_t cycle, int value, const char *signal);
+    void diverge(uint64_t cycle, std::string what);
+    void byteEnded(uint64_t cycle);
+
+    TimingParams m_params;
+    size_t m_maxReported;
+    AudioControllerModel m_audio;
+    std::deque<Expected> m_beatQueue;
+    std::deque<Expected> m_pwmQueue;
+
+    int m_beat;
+    bool m_pwm;
+    bool m_tx;
+    bool m_inByte;
+    uint64_t m_byteStart;
+    uint64_t m_nextStart;   // earliest start bit uart_tx allows
+    uint64_t m_lastCycle;
+
+    Counters m_counters;
+    std::vector<Divergence> m_divergences;
+};
+
+#endif // TIMING_CHECKER_H
@@ -0,0 +1,117 @@
+#include "timing_model.h"
+#include <algorithm>
+#include "pwm_synth.h"
+
+uint64_t TimingParams::beatCycles() const {
+    uint64_t cycles = uint64_t(period) * (clkFreq / uint32_t(std::max(1, numBeats)));
+    return std::max<uint64_t>(cycles, 1);
+}
+
+uint32_t TimingParams::pulseWidth() const {
+    uint32_t baud = std::max<uint32_t>(baudRate, 1);
+    return std::max<uint32_t>((clkFreq + baud / 2) / baud, 1);
+}
+
+AudioControllerModel::AudioControllerModel(const TimingParams &params)
+    : m_params(params), m_beatCycles(params.beatCycles()), m_cycle(0), m_counter(0), m_beat(0), m_pitch(0),
+      m_count(0), m_wave(false), m_edges(0), m_stalls(0), m_longestStall(0) {
+    m_params.numBeats = std::clamp(m_params.numBeats, 1, SequencerModel::MAX_BEATS);
+}
+
+void AudioControllerModel::setBeats(uint64_t cycle, const Pitches &beats) {
+    run(cycle);
+    m_beats = beats;
+}
+
+void AudioControllerModel::run(uint64_t cycle) {
+    while (m_cycle < cycle) {
+        // The pitch register samples the beat one edge after it changes
+        if (m_pitch != m_beats[m_beat]) {
+            step();
+            continue;
+        }
+        // From here the interval holds until the edge after the next beat
+        // boundary, so everything up to that boundary is one stretch
+        uint64_t end = std::min(cycle, nextBeatCycle());
+        uint64_t edges = end - m_cycle;
+        runPwm(edges);
+        advanceCounter(edges);
+    }
+}
+
+void AudioControllerModel::step() {
+    runPwm(1);
+    m_pitch = m_beats[m_beat];
+    advanceCounter(1);
+}
+
+void AudioControllerModel::advanceCounter(uint64_t edges) {
+    // Callers never cross a beat boundary except on their last edge
+    m_cycle += edges;
+    m_counter += edges;
+    if (m_counter >= m_beatCycles) {
+        m_counter = 0;
+        int next = m_beat + 1 < m_params.numBeats ? m_beat + 1 : 0;
+        if (next != m_beat && onBeat) onBeat(m_cycle, next);
+        m_beat = next;
+    }
+}
+
+void AudioControllerModel::runPwm(uint64_t edges) {
+    if (edges == 0) return;
+    uint16_t interval = pwm::interval(m_pitch);
+    if (interval == 0) {
+        // A rest holds the counter and the output at 0
+        m_count = 0;
+        if (m_wave) {
+            m_wave = false;
+            ++m_edges;
+            if (onPwmEdge) onPwmEdge(m_cycle + 1, false);
+        }
+        return;
+    }
+
+    // The counter toggles on interval - 1, counting round its 16 bits to
+    // get there if it is already past
+    uint64_t toEnd = uint16_t(interval - 1 - m_count);
+    uint64_t first = toEnd + 1;
+    if (first > edges) {
+        m_count = uint16_t(m_count + edges);
+        return;
+    }
+    if (m_count >= interval) {
+        ++m_stalls;
+        m_longestStall = std::max(m_longestStall, first);
+    }
+
+    uint64_t toggles = 1 + (edges - first) / interval;
+    if (onPwmEdge) {
+        for (uint64_t i = 0; i < toggles; ++i) {
+            m_wave = !m_wave;
+            onPwmEdge(m_cycle + first + i * interval, m_wave);
+        }
+    } else if (toggles & 1) {
+        m_wave = !m_wave;
+    }
+    m_edges += toggles;
+    m_count = uint16_t(edges - first - (toggles - 1) * interval);
+}
+
+UartTxModel::UartTxModel(const TimingParams &params) : m_params(params), m_ready(0), m_line(true), m_bytes(0) {}
+
+uint64_t UartTxModel::send(uint64_t cycle, uint8_t byte) {
+    uint64_t start = std::max(cycle, m_ready);
+    uint64_t pulse = m_params.pulseWidth();
+    drive(start, false);
+    for (int bit = 0; bit < 8; ++bit) drive(start + (bit + 1) * pulse, (byte >> bit) & 1);
+    drive(start + 9 * pulse, true);
+    m_ready = start + m_params.byteCycles();
+    ++m_bytes;
+    return start;
+}
+
+void UartTxModel::drive(uint64_t cycle, bool level) {
+    if (level == m_line) return;
+    m_line = level;
+    if (onEdge) onEdge(cycle, level);
+}
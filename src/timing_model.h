@@ -0,0 +1,120 @@
+#ifndef TIMING_MODEL_H
+#define TIMING_MODEL_H
+
+#include <cstdint>
+#include <functional>
+#include "sequencer_model.h"
+
+// Event-level models of the board's timed modules. Rather than clocking
+// every cycle they jump from one event to the next (a beat boundary, a PWM
+// toggle, a UART bit edge), yet land on exactly the cycle the HDL does, so
+// hours of device time cost milliseconds and their output can be compared
+// edge for edge with a simulator's.
+//
+// Cycles count rising clock edges since power-on; "at cycle N" means the
+// value a register holds after edge N, as a simulator samples it.
+
+// The parameters of hdl/top.sv and its modules that set the timing
+struct TimingParams {
+    uint32_t clkFreq = 12000000;  // CLK_FREQ
+    uint32_t baudRate = 1000000;  // BAUD_RATE
+    int numBeats = 16;            // NUM_BEATS
+    int period = 4;               // PERIOD, seconds per pass
+
+    // audio_controller's beat_clock_interval: PERIOD * (CLK_FREQ / NUM_BEATS)
+    uint64_t beatCycles() const;
+    uint64_t periodCycles() const { return beatCycles() * uint64_t(numBeats); }
+    // uart_tx's PULSE_WIDTH and HALF_PULSE_WIDTH
+    uint32_t pulseWidth() const;
+    uint32_t halfPulseWidth() const { return pulseWidth() / 2; }
+    // uart_tx: from accepting a byte to the first edge it can accept another
+    uint64_t byteCycles() const { return 10ull * pulseWidth() + halfPulseWidth() + 1; }
+};
+
+// audio_controller, pwm_decoder and pwm_generator: the beat counter, the
+// pitch register that follows it one cycle later, and the square wave.
+//
+// pwm_generator's counter is not cleared when a note follows a note, so a
+// change to a shorter interval that finds the counter already past it runs
+// the counter round its 16 bits before the next toggle. The model keeps
+// that, and counts it in stalledToggles().
+class AudioControllerModel {
+public:
+    using Pitches = SequencerModel::Pitches;
+
+    explicit AudioControllerModel(const TimingParams &params = TimingParams());
+
+    const TimingParams &params() const { return m_params; }
+
+    // Load the beats register at cycle `cycle` (>= cycle()), as model.sv
+    // would; the model is run up to it first
+    void setBeats(uint64_t cycle, const Pitches &beats);
+    const Pitches &beats() const { return m_beats; }
+
+    // Advance to cycle `cycle`, calling the listeners for every event on the way
+    void run(uint64_t cycle);
+
+    uint64_t cycle() const { return m_cycle; }
+    int beatCount() const { return m_beat; }
+    int pitch() const { return m_pitch; }
+    bool pwmOut() const { return m_wave; }
+    uint64_t nextBeatCycle() const { return m_cycle + (m_beatCycles - m_counter); }
+
+    uint64_t pwmEdges() const { return m_edges; }
+    uint64_t stalledToggles() const { return m_stalls; }
+    // Longest wait for a toggle that needed a counter wrap, in cycles
+    uint64_t longestStall() const { return m_longestStall; }
+
+    // Optional; with neither set, run() costs one step per beat boundary
+    std::function<void(uint64_t cycle, int beat)> onBeat;
+    std::function<void(uint64_t cycle, bool level)> onPwmEdge;
+
+private:
+    void step();
+    void runPwm(uint64_t edges);
+    void advanceCounter(uint64_t edges);
+
+    TimingParams m_params;
+    uint64_t m_beatCycles;
+    Pitches m_beats;
+
+    uint64_t m_cycle;
+    uint64_t m_counter;  // clk_counter
+    int m_beat;          // beat_count
+    int m_pitch;         // pitch register
+    uint16_t m_count;    // pwm_count
+    bool m_wave;
+
+    uint64_t m_edges;
+    uint64_t m_stalls;
+    uint64_t m_longestStall;
+};
+
+// uart_tx: one byte per valid/ready handshake, 8N1, LSB first, followed by
+// a PULSE_WIDTH + HALF_PULSE_WIDTH guard before ready rises again
+class UartTxModel {
+public:
+    explicit UartTxModel(const TimingParams &params = TimingParams());
+
+    // `valid` is first sampled high, with `byte`, at edge `cycle`. Returns the
+    // edge the byte is accepted at, which starts its start bit.
+    uint64_t send(uint64_t cycle, uint8_t byte);
+
+    // First edge a new byte can be accepted at
+    uint64_t readyCycle() const { return m_ready; }
+    bool line() const { return m_line; }
+    uint64_t bytes() const { return m_bytes; }
+
+    // Every change of the TX line, with the cycle it takes effect
+    std::function<void(uint64_t cycle, bool level)> onEdge;
+
+private:
+    void drive(uint64_t cycle, bool level);
+
+    TimingParams m_params;
+    uint64_t m_ready;
+    bool m_line;
+    uint64_t m_bytes;
+};
+
+#endif // TIMING_MODEL_H
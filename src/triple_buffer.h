@@ -0,0 +1,47 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer "latest value" slot. The
+// producer writes into a back buffer and publishes it with one exchange;
+// the consumer swaps in the newest published buffer, if any. Neither side
+// ever waits, and intermediate values the consumer did not get to are
+// simply skipped, which is what a real-time reader of a state wants.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    explicit TripleBuffer(const T &initial) {
+        for (T &slot : m_slots) slot = initial;
+    }
+
+    // Producer thread only
+    void publish(const T &value) {
+        m_slots[m_back] = value;
+        uint8_t previous = m_middle.exchange(uint8_t(m_back | FRESH), std::memory_order_acq_rel);
+        m_back = previous & INDEX;
+    }
+
+    // Consumer thread only. True if a new value was published since the
+    // last call; current() is that value afterwards.
+    bool update() {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX;
+        return true;
+    }
+    const T &current() const { return m_slots[m_front]; }
+
+private:
+    static constexpr uint8_t INDEX = 0x03;
+    static constexpr uint8_t FRESH = 0x04;
+
+    T m_slots[3]{};
+    alignas(64) std::atomic<uint8_t> m_middle{1};
+    alignas(64) uint8_t m_back = 2;    // producer side
+    alignas(64) uint8_t m_front = 0;   // consumer side
+};
+
+#endif // TRIPLE_BUFFER_H
@@ -0,0 +1,46 @@
+#include "uart_bit_decoder.h"
+#include <cmath>
+
+UartBitDecoder::UartBitDecoder(double bitTime)
+    : m_bitTime(bitTime > 0 ? bitTime : 1.0), m_level(true), m_receiving(false), m_start(0), m_bit(0),
+      m_shift(0) {}
+
+void UartBitDecoder::advance(uint64_t time) {
+    // Samples falling strictly before `time` see the current level
+    while (m_receiving) {
+        double sampleAt = double(m_start) + (m_bit + 0.5) * m_bitTime;
+        if (!(sampleAt < double(time))) break;
+        if (m_bit == 0) {
+            if (m_level) {
+                // Start bit did not last to its centre: noise, not a byte
+                ++m_counters.glitches;
+                m_receiving = false;
+                break;
+            }
+        } else if (m_bit <= 8) {
+            m_shift = uint8_t((m_shift >> 1) | (m_level ? 0x80 : 0));
+        } else {
+            m_receiving = false;
+            if (!m_level) {
+                ++m_counters.framingErrors;
+                break;
+            }
+            ++m_counters.bytes;
+            if (onByte) onByte(m_shift, m_start);
+            break;
+        }
+        ++m_bit;
+    }
+}
+
+void UartBitDecoder::edge(uint64_t time, bool level) {
+    advance(time);
+    if (level == m_level) return;
+    m_level = level;
+    if (!m_receiving && !level) {
+        m_receiving = true;
+        m_start = time;
+        m_bit = 0;
+        m_shift = 0;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef UART_BIT_DECODER_H
+#define UART_BIT_DECODER_H
+
+#include <cstdint>
+#include <functional>
+
+// Recovers bytes from a UART line given only its transitions, as a
+// simulator or a waveform dump reports them: feed each change of level with
+// its time (in clock cycles, or any unit `bitTime` is expressed in). Bits are
+// sampled at their centres from the falling edge of the start bit, 8N1, LSB
+// first, the way a real receiver would; nothing is assumed about the
+// transmitter's own timing.
+class UartBitDecoder {
+public:
+    struct Counters {
+        uint64_t bytes = 0;
+        uint64_t framingErrors = 0;  // stop bit sampled low
+        uint64_t glitches = 0;       // start bit gone by its centre
+    };
+
+    // `bitTime` in the same unit as the times passed in, e.g. CLK_FREQ /
+    // BAUD_RATE cycles
+    explicit UartBitDecoder(double bitTime);
+
+    // The line changed to `level` at `time`; times must not go backwards
+    void edge(uint64_t time, bool level);
+    // Resolve any bit sampled before `time` without a new edge (end of
+    // trace, or periodically from a simulation loop)
+    void advance(uint64_t time);
+
+    bool level() const { return m_level; }
+    const Counters &counters() const { return m_counters; }
+
+    // byte, time of the start bit's falling edge
+    std::function<void(uint8_t byte, uint64_t startTime)> onByte;
+
+private:
+    double m_bitTime;
+    bool m_level;        // idle high
+    bool m_receiving;
+    uint64_t m_start;    // falling edge of the start bit
+    int m_bit;           // next sample: 0 = start bit centre, 1-8 data, 9 stop
+    uint8_t m_shift;
+    Counters m_counters;
+};
+
+#endif // UART_BIT_DECODER_H
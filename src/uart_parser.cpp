@@ -1,34 +1,425 @@
 #include "uart_parser.h"
 #include "sequencer_model.h"
-#include <sstream>
-#include <iostream>
+#include "ingest_stats.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
 
-UARTParser::UARTParser(SequencerModel *model) : m_model(model) {}
+namespace {
 
-void UARTParser::parseLine(const std::string &line) {
-    if (line.empty()) return;
+constexpr uint8_t SYNC_BYTE = 0xFF;
+constexpr int BINARY_BITS = 7;      // 4-bit beat index + 3-bit pitch
+constexpr int NUMBER_LIMIT = 100000; // clamp for runaway decimal fields
 
-    std::istringstream iss(line);
-    std::string cmd;
-    iss >> cmd;
+enum ByteClass : uint8_t {
+    C_ZERO, C_ONE, C_DIGIT, C_SPACE, C_EOL,
+    C_B, C_E, C_A, C_T, C_SYNC, C_OTHER,
+    NUM_CLASSES
+};
 
-    if (cmd == "BEAT") {
-        // Format: BEAT <beat_index> <pitch>
-        // pitch is 3 bits: 0=off, 1-7=pitch values
-        int beat, pitch;
-        if (iss >> beat >> pitch) {
-            m_model->setBeatPitch(beat, pitch);
-            m_model->setCurrentBeat(beat);
+enum State : uint8_t {
+    S_LINE_START,   // skipping leading whitespace
+    S_KW_B, S_KW_BE, S_KW_BEA, S_KW_BEAT,
+    S_BEAT_SPACE,   // "BEAT " waiting for the index
+    S_BEAT_NUM,
+    S_PITCH_SPACE,
+    S_PITCH_NUM,
+    S_BEAT_TAIL,    // complete BEAT frame, ignore rest of line
+    S_BINARY,
+    S_BINARY_TAIL,  // complete binary frame, ignore rest of line
+    S_GARBAGE,      // malformed, skip to end of line
+    NUM_STATES
+};
+
+enum Action : uint8_t {
+    A_NONE,
+    A_BEAT_DIGIT,
+    A_PITCH_DIGIT,
+    A_BINARY_BIT,
+    A_BINARY_END,   // whitespace after the bits: only valid after exactly 7
+    A_END_LINE,
+    A_SYNC
+};
+
+struct Transition {
+    uint8_t next;
+    uint8_t action;
+};
+
+constexpr std::array<uint8_t, 256> makeClassTable() {
+    std::array<uint8_t, 256> t{};
+    for (int i = 0; i < 256; ++i) t[i] = C_OTHER;
+    for (int c = '2'; c <= '9'; ++c) t[c] = C_DIGIT;
+    t['0'] = C_ZERO;
+    t['1'] = C_ONE;
+    t[' '] = t['\t'] = t['\r'] = t['\v'] = t['\f'] = C_SPACE;
+    t['\n'] = C_EOL;
+    t['B'] = C_B;
+    t['E'] = C_E;
+    t['A'] = C_A;
+    t['T'] = C_T;
+    t[SYNC_BYTE] = C_SYNC;
+    return t;
+}
+
+using TransitionTable = std::array<std::array<Transition, NUM_CLASSES>, NUM_STATES>;
+
+constexpr TransitionTable makeTransitionTable() {
+    TransitionTable t{};
+    // Defaults: unexpected bytes poison the line, EOL ends it, SYNC is
+    // out-of-band and leaves the line state untouched.
+    for (int s = 0; s < NUM_STATES; ++s) {
+        for (int c = 0; c < NUM_CLASSES; ++c) t[s][c] = {S_GARBAGE, A_NONE};
+        t[s][C_EOL] = {S_LINE_START, A_END_LINE};
+        t[s][C_SYNC] = {uint8_t(s), A_SYNC};
+    }
+
+    t[S_LINE_START][C_SPACE] = {S_LINE_START, A_NONE};
+    t[S_LINE_START][C_B] = {S_KW_B, A_NONE};
+    t[S_LINE_START][C_ZERO] = {S_BINARY, A_BINARY_BIT};
+    t[S_LINE_START][C_ONE] = {S_BINARY, A_BINARY_BIT};
+
+    t[S_KW_B][C_E] = {S_KW_BE, A_NONE};
+    t[S_KW_BE][C_A] = {S_KW_BEA, A_NONE};
+    t[S_KW_BEA][C_T] = {S_KW_BEAT, A_NONE};
+    t[S_KW_BEAT][C_SPACE] = {S_BEAT_SPACE, A_NONE};
+
+    const uint8_t digits[] = {C_ZERO, C_ONE, C_DIGIT};
+    t[S_BEAT_SPACE][C_SPACE] = {S_BEAT_SPACE, A_NONE};
+    t[S_BEAT_NUM][C_SPACE] = {S_PITCH_SPACE, A_NONE};
+    t[S_PITCH_SPACE][C_SPACE] = {S_PITCH_SPACE, A_NONE};
+    for (uint8_t d : digits) {
+        t[S_BEAT_SPACE][d] = {S_BEAT_NUM, A_BEAT_DIGIT};
+        t[S_BEAT_NUM][d] = {S_BEAT_NUM, A_BEAT_DIGIT};
+        t[S_PITCH_SPACE][d] = {S_PITCH_NUM, A_PITCH_DIGIT};
+        t[S_PITCH_NUM][d] = {S_PITCH_NUM, A_PITCH_DIGIT};
+    }
+
+    // Like `iss >> beat >> pitch`, anything after the pitch is ignored
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        if (c == C_EOL || c == C_SYNC) continue;
+        if (c != C_ZERO && c != C_ONE && c != C_DIGIT) t[S_PITCH_NUM][c] = {S_BEAT_TAIL, A_NONE};
+        t[S_BEAT_TAIL][c] = {S_BEAT_TAIL, A_NONE};
+        t[S_BINARY_TAIL][c] = {S_BINARY_TAIL, A_NONE};
+    }
+
+    t[S_BINARY][C_ZERO] = {S_BINARY, A_BINARY_BIT};
+    t[S_BINARY][C_ONE] = {S_BINARY, A_BINARY_BIT};
+    t[S_BINARY][C_SPACE] = {S_BINARY_TAIL, A_BINARY_END};
+    return t;
+}
+
+constexpr std::array<uint8_t, 256> CLASS_TABLE = makeClassTable();
+constexpr TransitionTable TRANSITIONS = makeTransitionTable();
+
+constexpr size_t FRAME_HEADER = 3;  // sync, type, length
+
+constexpr std::array<uint8_t, 256> makeCrcTable() {
+    std::array<uint8_t, 256> t{};
+    for (int i = 0; i < 256; ++i) {
+        uint8_t c = uint8_t(i);
+        for (int bit = 0; bit < 8; ++bit) c = (c & 0x80) ? uint8_t((c << 1) ^ 0x07) : uint8_t(c << 1);
+        t[i] = c;
+    }
+    return t;
+}
+
+constexpr std::array<uint8_t, 256> CRC8_TABLE = makeCrcTable();
+
+// Plausible header: rejecting bad ones at once keeps a false sync from
+// swallowing the frames behind it while waiting for a bogus length
+bool validFrameHeader(uint8_t type, size_t length) {
+    switch (type) {
+    case UARTParser::FRAME_EDIT:
+    case UARTParser::FRAME_TICK:
+        return length == 2;
+    case UARTParser::FRAME_SNAPSHOT:
+        return length >= 3 && length <= 2 + (SequencerModel::MAX_BEATS * 4) / 8;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+uint8_t UARTParser::crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; ++i) crc = CRC8_TABLE[crc ^ data[i]];
+    return crc;
+}
+
+size_t UARTParser::encodeFrame(uint8_t type, const uint8_t *payload, size_t len, uint8_t *out) {
+    len = std::min(len, MAX_FRAME_PAYLOAD);
+    std::memmove(out + FRAME_HEADER, payload, len);
+    out[0] = FRAME_SYNC;
+    out[1] = type;
+    out[2] = uint8_t(len);
+    out[FRAME_HEADER + len] = crc8(out + 1, len + 2);
+    return FRAME_HEADER + len + 1;
+}
+
+UARTParser::UARTParser(SequencerModel *model, Format format)
+    : m_model(model), m_format(format), m_state(S_LINE_START), m_digits(0),
+      m_beat(0), m_pitch(0), m_stats(nullptr), m_sourceTimestamp(0),
+      m_frameSize(0), m_boardBeats(0) {}
+
+void UARTParser::setFormat(Format format) {
+    m_format = format;
+    reset();
+}
+
+void UARTParser::reset() {
+    m_state = S_LINE_START;
+    m_digits = 0;
+    m_beat = 0;
+    m_pitch = 0;
+    m_frameSize = 0;
+    m_boardBeats = 0;
+}
+
+void UARTParser::feed(const uint8_t *data, size_t len) {
+    m_counters.bytes += len;
+    switch (m_format) {
+    case Format::Raw:
+        feedRaw(data, len);
+        break;
+    case Format::Framed:
+        feedFramed(data, len);
+        break;
+    case Format::Text:
+        feedText(data, len);
+        break;
+    }
+}
+
+void UARTParser::parseLine(std::string_view line) {
+    static const uint8_t eol = '\n';
+    reset();
+    feed(reinterpret_cast<const uint8_t *>(line.data()), line.size());
+    if (m_format == Format::Text) feed(&eol, 1);
+}
+
+void UARTParser::feedText(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t byte = data[i];
+        const Transition &tr = TRANSITIONS[m_state][CLASS_TABLE[byte]];
+
+        switch (tr.action) {
+        case A_NONE:
+            break;
+        case A_BEAT_DIGIT:
+            if (m_state != S_BEAT_NUM) m_beat = 0;
+            if (m_beat < NUMBER_LIMIT) m_beat = m_beat * 10 + (byte - '0');
+            break;
+        case A_PITCH_DIGIT:
+            if (m_state != S_PITCH_NUM) m_pitch = 0;
+            if (m_pitch < NUMBER_LIMIT) m_pitch = m_pitch * 10 + (byte - '0');
+            break;
+        case A_BINARY_BIT:
+            if (m_state != S_BINARY) m_digits = 0;
+            if (m_digits == BINARY_BITS) {
+                m_state = S_GARBAGE;  // token longer than 7 bits
+                continue;
+            }
+            // First 4 bits are the beat index, last 3 the pitch
+            if (m_digits < 4) {
+                m_beat = (m_digits == 0 ? 0 : m_beat << 1) | (byte - '0');
+            } else {
+                m_pitch = (m_digits == 4 ? 0 : m_pitch << 1) | (byte - '0');
+            }
+            ++m_digits;
+            break;
+        case A_BINARY_END:
+            if (m_digits != BINARY_BITS) {
+                m_state = S_GARBAGE;
+                continue;
+            }
+            break;
+        case A_END_LINE:
+            endLine();
+            break;
+        case A_SYNC:
+            emitSync();
+            break;
+        }
+        m_state = tr.next;
+    }
+}
+
+void UARTParser::endLine() {
+    switch (m_state) {
+    case S_LINE_START:
+        break;  // blank line
+    case S_PITCH_NUM:
+    case S_BEAT_TAIL:
+        emitBeat(m_beat, m_pitch, true);
+        break;
+    case S_BINARY:
+        if (m_digits != BINARY_BITS) {
+            countError(m_counters.malformed);
+            break;
+        }
+        emitBeat(m_beat, m_pitch, false);
+        break;
+    case S_BINARY_TAIL:
+        emitBeat(m_beat, m_pitch, false);
+        break;
+    default:
+        countError(m_counters.malformed);
+        break;
+    }
+}
+
+void UARTParser::feedRaw(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t byte = data[i];
+        if (byte == SYNC_BYTE) {
+            emitSync();
+            continue;
+        }
+        // Upper nibble: rotary position (pitch), lower nibble: button index (beat)
+        emitBeat(byte & 0x0F, (byte >> 4) & 0x0F, false);
+    }
+}
+
+void UARTParser::feedFramed(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        // Between frames only the sync byte matters
+        if (m_frameSize == 0 && data[i] != FRAME_SYNC) continue;
+        m_frame[m_frameSize++] = data[i];
+
+        // Usually exactly one complete frame; after a CRC failure the tail
+        // of the rejected bytes may hold more
+        while (m_frameSize >= FRAME_HEADER) {
+            size_t total = FRAME_HEADER + m_frame[2] + 1;
+            bool header = validFrameHeader(m_frame[1], m_frame[2]);
+            if (header && m_frameSize < total) break;
+
+            size_t consumed;
+            if (header && crc8(m_frame.data() + 1, total - 2) == m_frame[total - 1]) {
+                dispatchFrame();
+                consumed = total;
+            } else {
+                // False sync or damaged frame: restart at the next 0xA5
+                countError(header ? m_counters.crcErrors : m_counters.malformed);
+                const void *next = std::memchr(m_frame.data() + 1, FRAME_SYNC, m_frameSize - 1);
+                consumed = next ? static_cast<const uint8_t *>(next) - m_frame.data() : m_frameSize;
+            }
+            m_frameSize -= consumed;
+            std::memmove(m_frame.data(), m_frame.data() + consumed, m_frameSize);
+        }
+    }
+}
+
+void UARTParser::dispatchFrame() {
+    const uint8_t type = m_frame[1];
+    const size_t length = m_frame[2];
+    const uint8_t *payload = m_frame.data() + FRAME_HEADER;
+
+    switch (type) {
+    case FRAME_EDIT:
+        if (length != 2) break;
+        emitBeat(payload[0], payload[1], false);
+        return;
+    case FRAME_TICK:
+        if (length != 2) break;
+        noteBeatCount(payload[1] ? payload[1] : 256);
+        emitPosition(payload[0]);
+        return;
+    case FRAME_SNAPSHOT: {
+        if (length < 2) break;
+        int beats = payload[1] ? payload[1] : 256;
+        if (length != 2 + size_t(beats * 4 + 7) / 8) break;
+        noteBeatCount(beats);
+
+        // The whole register in one transaction
+        countFrame();
+        int limit = m_model ? m_model->numBeats() : SequencerModel::MAX_BEATS;
+        if (m_model) {
+            m_model->beginBatch();
+            m_model->noteSourceTimestamp(m_sourceTimestamp);
+        }
+        for (int beat = 0; beat < beats && beat < limit; ++beat) {
+            int pitch = (payload[2 + beat / 2] >> ((beat & 1) * 4)) & 0x0F;
+            if (pitch > SequencerModel::MAX_PITCH) {
+                countError(m_counters.outOfRange);
+                continue;
+            }
+            if (m_model) m_model->setBeatPitch(beat, pitch);
             if (onBeatReceived) onBeatReceived(beat, pitch);
         }
-    } else if (cmd.length() == 7 && (cmd.find_first_not_of("01") == std::string::npos)) {
-        // Binary format: 7 bits = 4-bit beat index + 3-bit pitch
-        // Example: "0000011" = beat 0, pitch 3
-        //          "0100000" = beat 4, pitch 0 (off)
-        int beat = std::stoi(cmd.substr(0, 4), nullptr, 2);  // First 4 bits
-        int pitch = std::stoi(cmd.substr(4, 3), nullptr, 2); // Last 3 bits
-        
+        emitPosition(payload[0], false);  // counted above
+        if (m_model) m_model->commitBatch();
+        return;
+    }
+    }
+    countError(m_counters.malformed);
+}
+
+void UARTParser::noteBeatCount(int beats) {
+    if (beats <= 0 || beats == m_boardBeats) return;
+    m_boardBeats = beats;
+    if (onBeatCount) onBeatCount(beats);
+}
+
+void UARTParser::emitPosition(int beat, bool ownFrame) {
+    // Position 0 is the period boundary
+    if (beat == 0) {
+        emitSync(ownFrame);
+        return;
+    }
+    int numBeats = m_model ? m_model->numBeats() : SequencerModel::MAX_BEATS;
+    if (beat >= numBeats) {
+        countError(m_counters.outOfRange);
+        return;
+    }
+    if (ownFrame) countFrame();
+    if (m_model) {
+        SequencerModel::Batch batch(*m_model);
+        m_model->noteSourceTimestamp(m_sourceTimestamp);
+        m_model->setCurrentBeat(beat);
+    }
+    if (onCurrentBeat) onCurrentBeat(beat);
+}
+
+void UARTParser::countFrame() {
+    ++m_counters.frames;
+    if (m_stats) {
+        m_stats->addFrames(1);
+        m_stats->recordSince(IngestStats::STAGE_DECODE, m_sourceTimestamp);
+    }
+}
+
+void UARTParser::emitBeat(int beat, int pitch, bool setCurrent) {
+    // Without a model the consumer applies the beat count
+    int numBeats = m_model ? m_model->numBeats() : SequencerModel::MAX_BEATS;
+    if (beat >= numBeats || pitch > SequencerModel::MAX_PITCH) {
+        countError(m_counters.outOfRange);
+        return;
+    }
+    countFrame();
+    if (m_model) {
+        SequencerModel::Batch batch(*m_model);
+        m_model->noteSourceTimestamp(m_sourceTimestamp);
         m_model->setBeatPitch(beat, pitch);
-        if (onBeatReceived) onBeatReceived(beat, pitch);
+        if (setCurrent) m_model->setCurrentBeat(beat);
     }
+    if (onBeatReceived) onBeatReceived(beat, pitch);
+    if (setCurrent && onCurrentBeat) onCurrentBeat(beat);
+}
+
+void UARTParser::emitSync(bool ownFrame) {
+    ++m_counters.syncs;
+    if (ownFrame) countFrame();
+    if (m_model) {
+        SequencerModel::Batch batch(*m_model);
+        m_model->noteSourceTimestamp(m_sourceTimestamp);
+        m_model->setCurrentBeat(0);
+    }
+    if (onSync) onSync();
+}
+
+void UARTParser::countError(uint64_t &counter) {
+    ++counter;
+    if (m_stats) m_stats->addErrors(1);
 }
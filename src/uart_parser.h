@@ -1,24 +1,113 @@
 #ifndef UART_PARSER_H
 #define UART_PARSER_H
 
-#include <string>
+#include <array>
+#include <string_view>
 #include <functional>
+#include <cstddef>
 #include <cstdint>
 
 class SequencerModel;
+class IngestStats;
 
+// Incremental, allocation-free decoder for everything the GUI can receive.
+// Bytes are classified through a 256-entry table and pushed through a small
+// transition table, so each byte is looked at exactly once.
+//
+// Text format (stdin, mock_uart_sender):
+//   BEAT <index> <pitch>\n   set pitch and current beat
+//   <4-bit beat><3-bit pitch>\n  e.g. "0000011" = beat 0, pitch 3
+// Raw format (FPGA uart_tx, legacy bitstreams):
+//   one byte {rotary_position, button_index} per button press
+// Text and Raw treat 0xFF as the end-of-period SYNC marker.
+// Framed format (hdl/uart_framer.sv):
+//   0xA5 type len payload[len] crc8, CRC-8/ATM over type, len and payload
+//   EDIT(1) beat pitch, SNAPSHOT(2) beat count register..., TICK(3) beat count
+//   Position 0 in a TICK or SNAPSHOT is the SYNC. A frame is only accepted
+//   once its CRC checks, and after a bad one decoding restarts at the next
+//   0xA5 inside it, so a reconnect resynchronises within one frame.
 class UARTParser {
 public:
-    explicit UARTParser(SequencerModel *model);
+    enum class Format { Text, Raw, Framed };  // values are stored in captures
 
-    // Parse a single line of UART message
-    void parseLine(const std::string &line);
+    // Framed protocol, see hdl/uart_framer.sv
+    static constexpr uint8_t FRAME_SYNC = 0xA5;
+    enum FrameType : uint8_t { FRAME_EDIT = 0x01, FRAME_SNAPSHOT = 0x02, FRAME_TICK = 0x03 };
+    static constexpr size_t MAX_FRAME_PAYLOAD = 255;
+    static constexpr size_t MAX_FRAME_SIZE = 4 + MAX_FRAME_PAYLOAD;  // sync, type, length, payload, crc
+
+    // CRC-8/ATM (polynomial 0x07, init 0) as uart_framer.sv computes it
+    static uint8_t crc8(const uint8_t *data, size_t len);
+
+    // Writes one frame to `out`, which needs room for len + 4 bytes, and
+    // returns its size. `payload` may already sit at out + 3.
+    static size_t encodeFrame(uint8_t type, const uint8_t *payload, size_t len, uint8_t *out);
+
+    struct Counters {
+        uint64_t bytes = 0;       // bytes fed
+        uint64_t frames = 0;      // updates decoded, SYNC markers included (as IngestStats counts them)
+        uint64_t syncs = 0;       // SYNC markers
+        uint64_t malformed = 0;   // lines that matched neither text form
+        uint64_t outOfRange = 0;  // well-formed frames with bad beat/pitch
+        uint64_t crcErrors = 0;   // framed: sync and length found, CRC wrong
+    };
+
+    explicit UARTParser(SequencerModel *model, Format format = Format::Text);
+
+    // Switching format discards any partially decoded frame
+    void setFormat(Format format);
+    Format format() const { return m_format; }
+
+    void feed(const uint8_t *data, size_t len);
+
+    // Decode a single complete line (no terminator needed)
+    void parseLine(std::string_view line);
+
+    // Drop any partially decoded frame
+    void reset();
+
+    const Counters &counters() const { return m_counters; }
+
+    // Optional instrumentation: frames, errors and decode latency are
+    // reported against the timestamp of the read that produced the bytes
+    void setStats(IngestStats *stats) { m_stats = stats; }
+    void setSourceTimestamp(uint64_t ns) { m_sourceTimestamp = ns; }
+    uint64_t sourceTimestamp() const { return m_sourceTimestamp; }
 
     // Callbacks for external handling (optional)
     std::function<void(int beat, int pitch)> onBeatReceived;
+    std::function<void(int beat)> onCurrentBeat; // BEAT frames move the playhead
+    std::function<void()> onSync;
+    std::function<void(int beats)> onBeatCount; // framed: board's NUM_BEATS, when it changes
 
 private:
+    void feedText(const uint8_t *data, size_t len);
+    void feedRaw(const uint8_t *data, size_t len);
+    void feedFramed(const uint8_t *data, size_t len);
+    void dispatchFrame();
+    void noteBeatCount(int beats);
+    // ownFrame false: the position is part of a frame already counted
+    void emitPosition(int beat, bool ownFrame = true);
+    void countFrame();
+    void endLine();
+    void emitBeat(int beat, int pitch, bool setCurrent);
+    void emitSync(bool ownFrame = true);
+    void countError(uint64_t &counter);
+
     SequencerModel *m_model;
+    Format m_format;
+    uint8_t m_state;
+    uint8_t m_digits;   // binary form: bits seen so far
+    int m_beat;
+    int m_pitch;
+    Counters m_counters;
+    IngestStats *m_stats;
+    uint64_t m_sourceTimestamp;
+
+    // Framed decoder: bytes of the frame being assembled, from the sync byte
+    std::array<uint8_t, MAX_FRAME_SIZE> m_frame;
+    size_t m_frameSize;
+    int m_boardBeats;
 };
 
 #endif // UART_PARSER_H
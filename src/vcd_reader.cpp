@@ -0,0 +1,346 @@
+#include "vcd_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Chunk size for pipes, and how much of a mapping is read before the pages
+// behind the cursor are given back
+constexpr size_t READ_CHUNK_BYTES = 1 << 20;
+constexpr size_t RELEASE_BYTES = 64u << 20;
+
+// Identifier codes are printable ASCII, '!' to '~'. Simulators hand out
+// the short ones first, so one or two characters covers most designs.
+constexpr int ID_CHARS = 94;
+constexpr int SHORT_ID_CODES = ID_CHARS + ID_CHARS * ID_CHARS;
+
+// Index into the short-id table, or -1 for a longer id
+inline int shortIdCode(std::string_view id) {
+    if (id.empty() || id.size() > 2) return -1;
+    unsigned first = unsigned(id[0]) - 33u;
+    if (first >= unsigned(ID_CHARS)) return -1;
+    if (id.size() == 1) return int(first);
+    unsigned second = unsigned(id[1]) - 33u;
+    if (second >= unsigned(ID_CHARS)) return -1;
+    return ID_CHARS + int(first) * ID_CHARS + int(second);
+}
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// "1ns", "10 ps", "100us" -> seconds per unit
+bool parseTimescale(const std::string &text, double &seconds) {
+    char *end = nullptr;
+    double number = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || number <= 0) return false;
+    while (*end == ' ') ++end;
+    static const struct { const char *unit; double scale; } UNITS[] = {
+        {"s", 1.0}, {"ms", 1e-3}, {"us", 1e-6}, {"ns", 1e-9}, {"ps", 1e-12}, {"fs", 1e-15},
+    };
+    for (const auto &u : UNITS) {
+        if (std::strcmp(end, u.unit) == 0) {
+            seconds = number * u.scale;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+VcdReader::VcdReader()
+    : m_fd(-1), m_map(nullptr), m_mapSize(0), m_pos(nullptr), m_end(nullptr), m_released(nullptr), m_eof(false),
+      m_timescale(1e-9), m_time(0), m_bytesRead(0), m_changes(0) {}
+
+VcdReader::~VcdReader() {
+    close();
+}
+
+bool VcdReader::open(const std::string &path, std::string *error) {
+    close();
+    int fd = path == "-" ? dup(STDIN_FILENO) : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (error) *error = "Failed to open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            ::close(fd);
+            m_map = static_cast<const char *>(mapping);
+            m_mapSize = static_cast<size_t>(st.st_size);
+            madvise(mapping, m_mapSize, MADV_SEQUENTIAL);
+            m_pos = m_released = m_map;
+            m_end = m_map + m_mapSize;
+            m_bytesRead = m_mapSize;
+            m_eof = true;  // nothing to fill
+        }
+    }
+    if (!m_map) {
+        m_fd = fd;
+        m_buffer.resize(READ_CHUNK_BYTES);
+    }
+
+    if (!readHeader(error)) {
+        if (error && !error->empty()) *error = path + ": " + *error;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void VcdReader::close() {
+    if (m_map) munmap(const_cast<char *>(m_map), m_mapSize);
+    if (m_fd >= 0) ::close(m_fd);
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_fd = -1;
+    m_buffer.clear();
+    m_pos = m_end = m_released = nullptr;
+    m_carry.clear();
+    m_eof = false;
+    m_variables.clear();
+    m_selected.clear();
+    m_watchLists.clear();
+    m_watch.clear();
+    m_shortWatch.clear();
+    m_timescale = 1e-9;
+    m_time = m_bytesRead = m_changes = 0;
+}
+
+bool VcdReader::fill() {
+    if (m_eof) return false;
+    for (;;) {
+        ssize_t n = read(m_fd, m_buffer.data(), m_buffer.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            m_eof = true;
+            return false;
+        }
+        m_pos = m_buffer.data();
+        m_end = m_pos + n;
+        m_bytesRead += uint64_t(n);
+        return true;
+    }
+}
+
+bool VcdReader::nextToken(std::string_view &token) {
+    for (;;) {
+        while (m_pos < m_end && isSpace(*m_pos)) ++m_pos;
+        if (m_pos == m_end) {
+            if (!fill()) return false;
+            continue;
+        }
+        const char *start = m_pos;
+        while (m_pos < m_end && !isSpace(*m_pos)) ++m_pos;
+        if (m_pos < m_end || m_map) {
+            token = std::string_view(start, size_t(m_pos - start));
+            return true;
+        }
+        // Runs off the end of the chunk: piece it together
+        m_carry.assign(start, size_t(m_pos - start));
+        while (fill()) {
+            const char *more = m_pos;
+            while (m_pos < m_end && !isSpace(*m_pos)) ++m_pos;
+            m_carry.append(more, size_t(m_pos - more));
+            if (m_pos < m_end) break;
+        }
+        token = m_carry;
+        return true;
+    }
+}
+
+bool VcdReader::skipToEnd() {
+    std::string_view token;
+    while (nextToken(token)) {
+        if (token == "$end") return true;
+    }
+    return false;
+}
+
+bool VcdReader::readHeader(std::string *error) {
+    auto fail = [&](const std::string &what) {
+        if (error) *error = what;
+        return false;
+    };
+
+    std::vector<std::string> scopes;
+    std::string_view token;
+    while (nextToken(token)) {
+        if (token == "$enddefinitions") {
+            if (!skipToEnd()) break;
+            // Ids point into the table, which is complete now
+            return true;
+        }
+        if (token == "$scope") {
+            std::string_view kind, name;
+            if (!nextToken(kind) || !nextToken(name)) break;
+            scopes.emplace_back(name);
+            if (!skipToEnd()) break;
+        } else if (token == "$upscope") {
+            if (!scopes.empty()) scopes.pop_back();
+            if (!skipToEnd()) break;
+        } else if (token == "$var") {
+            // $var kind width id reference [range] $end
+            std::string_view kind, width, id, reference;
+            if (!nextToken(kind) || !nextToken(width) || !nextToken(id) || !nextToken(reference)) break;
+            Variable var;
+            var.width = 1;
+            std::from_chars(width.data(), width.data() + width.size(), var.width);
+            var.id = std::string(id);
+            for (const std::string &scope : scopes) var.name += scope + '.';
+            var.name += std::string(reference);
+            // Some writers fold a vector's range into its name
+            size_t bracket = var.name.find('[', var.name.size() - reference.size());
+            if (var.width > 1 && bracket != std::string::npos) var.name.erase(bracket);
+            m_variables.push_back(std::move(var));
+            if (!skipToEnd()) break;
+        } else if (token == "$timescale") {
+            std::string text;
+            while (nextToken(token) && token != "$end") text += std::string(token);
+            if (!parseTimescale(text, m_timescale)) return fail("unsupported timescale '" + text + "'");
+        } else if (!token.empty() && token[0] == '$') {
+            // $date, $version, $comment and anything newer
+            if (!skipToEnd()) break;
+        } else {
+            return fail("unexpected '" + std::string(token) + "' in the header");
+        }
+    }
+    return fail("not a VCD file, or its header is cut short");
+}
+
+int VcdReader::select(const std::string &name, std::string *error) {
+    int match = -1;
+    for (size_t i = 0; i < m_variables.size(); ++i) {
+        const std::string &full = m_variables[i].name;
+        bool matches = full == name || (full.size() > name.size() && full[full.size() - name.size() - 1] == '.' &&
+                                        full.compare(full.size() - name.size(), name.size(), name) == 0);
+        if (!matches) continue;
+        if (match >= 0 && m_variables[size_t(match)].id != m_variables[i].id) {
+            if (error) *error = "'" + name + "' is ambiguous: " + m_variables[size_t(match)].name + ", " + full;
+            return -1;
+        }
+        // The same net seen from two scopes shares its id; either will do
+        if (match < 0) match = int(i);
+    }
+    if (match < 0) {
+        if (error) *error = "No signal named '" + name + "'";
+        return -1;
+    }
+    int index = int(m_selected.size());
+    m_selected.push_back(size_t(match));
+
+    const std::string &id = m_variables[size_t(match)].id;
+    auto inserted = m_watch.emplace(id, m_watchLists.size());
+    if (inserted.second) {
+        m_watchLists.emplace_back();
+        int code = shortIdCode(id);
+        if (code >= 0) {
+            if (m_shortWatch.empty()) m_shortWatch.assign(SHORT_ID_CODES, -1);
+            m_shortWatch[size_t(code)] = int(inserted.first->second);
+        }
+    }
+    m_watchLists[inserted.first->second].push_back(index);
+    return index;
+}
+
+const std::vector<int> *VcdReader::watched(std::string_view id) const {
+    int code = shortIdCode(id);
+    if (code >= 0) {
+        if (m_shortWatch.empty() || m_shortWatch[size_t(code)] < 0) return nullptr;
+        return &m_watchLists[size_t(m_shortWatch[size_t(code)])];
+    }
+    auto it = m_watch.find(id);
+    return it == m_watch.end() ? nullptr : &m_watchLists[it->second];
+}
+
+void VcdReader::deliver(std::string_view id, const Value &value) {
+    const std::vector<int> *selections = watched(id);
+    if (selections) deliver(*selections, value);
+}
+
+void VcdReader::deliver(const std::vector<int> &selections, const Value &value) {
+    ++m_changes;
+    if (onChange) {
+        for (int index : selections) onChange(m_time, index, value);
+    }
+}
+
+void VcdReader::releaseConsumed() {
+    // Clean file pages come back from the page cache anyway; dropping them
+    // keeps a multi-GB dump from showing up as resident
+    const long page = sysconf(_SC_PAGESIZE);
+    size_t consumed = size_t(m_pos - m_released) & ~size_t(page - 1);
+    madvise(const_cast<char *>(m_released), consumed, MADV_DONTNEED);
+    m_released += consumed;
+}
+
+bool VcdReader::run(std::string *error) {
+    std::string_view token;
+    std::string vector;
+    while (nextToken(token)) {
+        if (m_map && size_t(m_pos - m_released) >= RELEASE_BYTES) releaseConsumed();
+
+        switch (token[0]) {
+        case '#':
+            std::from_chars(token.data() + 1, token.data() + token.size(), m_time);
+            break;
+        case '0':
+        case '1':
+            deliver(token.substr(1), Value{uint64_t(token[0] - '0'), true});
+            break;
+        case 'x':
+        case 'X':
+        case 'z':
+        case 'Z':
+            deliver(token.substr(1), Value{0, false});
+            break;
+        case 'b':
+        case 'B': {
+            // From a pipe the value may sit in the carry the id is about to
+            // replace; a mapping stays put
+            std::string_view bits = token.substr(1);
+            if (!m_map) {
+                vector.assign(bits);
+                bits = vector;
+            }
+            std::string_view id;
+            if (!nextToken(id)) break;
+            const std::vector<int> *selections = watched(id);
+            if (!selections) break;
+            Value value{0, true};
+            for (char bit : bits) {
+                value.bits = (value.bits << 1) | (bit == '1');
+                if (bit != '0' && bit != '1') value.known = false;
+            }
+            deliver(*selections, value);
+            break;
+        }
+        case 'r':
+        case 'R': {
+            std::string_view id;
+            nextToken(id);  // real values are not decoded
+            break;
+        }
+        case '$':
+            // $dumpvars/$dumpon/... wrap ordinary changes; comments are skipped
+            if (token == "$comment") skipToEnd();
+            break;
+        default:
+            if (error) *error = "unexpected '" + std::string(token) + "' at time " + std::to_string(m_time);
+            return false;
+        }
+    }
+    return true;
+}
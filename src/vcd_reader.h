@@ -0,0 +1,99 @@
+#ifndef VCD_READER_H
+#define VCD_READER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Streaming reader for Value Change Dump files as iverilog, Verilator and
+// the vendor simulators write them. A regular file is memory-mapped and
+// pages behind the cursor are dropped as it goes, anything else (a pipe
+// from a running simulation) is read in chunks, so memory stays bounded by
+// the signal table however long the dump.
+//
+// Only selected signals are decoded; every other change costs a table miss.
+//
+//   VcdReader vcd;
+//   vcd.open("top_tb.vcd", &error);
+//   int tx = vcd.select("_13b", &error);
+//   vcd.onChange = [&](uint64_t time, int signal, const VcdReader::Value &v) { ... };
+//   vcd.run(&error);
+class VcdReader {
+public:
+    struct Variable {
+        std::string name;  // hierarchical, scopes joined with '.'
+        std::string id;    // identifier code in the dump
+        int width;
+    };
+
+    // Vectors wider than 64 bits keep their low 64
+    struct Value {
+        uint64_t bits;
+        bool known;        // no x or z bit
+    };
+
+    VcdReader();
+    ~VcdReader();
+
+    VcdReader(const VcdReader &) = delete;
+    VcdReader &operator=(const VcdReader &) = delete;
+
+    // Opens `path` ("-" for stdin) and reads the header
+    bool open(const std::string &path, std::string *error = nullptr);
+    void close();
+
+    const std::vector<Variable> &variables() const { return m_variables; }
+    // Seconds per time unit, from $timescale (1 ns if absent)
+    double timescale() const { return m_timescale; }
+
+    // A full hierarchical name, or a trailing part of one after a '.'
+    // ("_13b", "uut._13b"). Returns the selection index passed to
+    // onChange, or -1 with a message if nothing or more than one matches.
+    int select(const std::string &name, std::string *error = nullptr);
+    const Variable &selected(int index) const { return m_variables[m_selected[index]]; }
+
+    // Streams the value changes to onChange, in dump order
+    bool run(std::string *error = nullptr);
+
+    std::function<void(uint64_t time, int signal, const Value &value)> onChange;
+
+    uint64_t bytesRead() const { return m_bytesRead; }
+    uint64_t changes() const { return m_changes; }
+    uint64_t time() const { return m_time; }
+
+private:
+    bool fill();
+    bool nextToken(std::string_view &token);
+    bool skipToEnd();
+    bool readHeader(std::string *error);
+    const std::vector<int> *watched(std::string_view id) const;
+    void deliver(std::string_view id, const Value &value);
+    void deliver(const std::vector<int> &selections, const Value &value);
+    void releaseConsumed();
+
+    int m_fd;
+    const char *m_map;
+    size_t m_mapSize;
+    std::vector<char> m_buffer;    // chunked reads
+    const char *m_pos;
+    const char *m_end;
+    const char *m_released;        // mapped pages before this were dropped
+    std::string m_carry;           // a token split across chunks
+    bool m_eof;
+
+    std::vector<Variable> m_variables;
+    std::vector<size_t> m_selected;                        // index into m_variables
+    std::vector<std::vector<int>> m_watchLists;                 // selections per watched id
+    std::unordered_map<std::string_view, size_t> m_watch;      // id -> m_watchLists
+    std::vector<int> m_shortWatch;  // the same for ids of 1-2 characters, by code; -1 if unwatched
+    double m_timescale;
+
+    uint64_t m_time;
+    uint64_t m_bytesRead;
+    uint64_t m_changes;
+};
+
+#endif // VCD_READER_H
@@ -0,0 +1,71 @@
+// BoardSnapshot::toJson, as the daemon writes it to --state-file.
+
+#include <cstdint>
+#include <string>
+#include "board_session.h"
+#include "test_check.h"
+
+namespace {
+
+// Objects and arrays balance outside strings, and nothing follows the end
+bool wellFormed(const std::string &json) {
+    int depth = 0;
+    bool inString = false;
+    for (size_t i = 0; i < json.size(); ++i) {
+        char c = json[i];
+        if (inString) {
+            if (c == '\\') ++i;
+            else if (c == '"') inString = false;
+            continue;
+        }
+        if (c == '"') inString = true;
+        else if (c == '{' || c == '[') ++depth;
+        else if (c == '}' || c == ']') {
+            if (--depth < 0) return false;
+            if (depth == 0 && i + 1 != json.size()) return false;
+        }
+    }
+    return depth == 0 && !inString;
+}
+
+BoardSnapshot widestSnapshot(const std::string &name) {
+    BoardSnapshot snap;
+    snap.name = name;
+    snap.error = "device unplugged";
+    snap.open = true;
+    snap.beats = SequencerModel::MAX_BEATS;
+    snap.current = SequencerModel::MAX_BEATS - 1;
+    for (int beat = 0; beat < snap.beats; ++beat) snap.pitches.setPitch(beat, SequencerModel::MAX_PITCH);
+    snap.bytes = snap.frames = snap.syncs = snap.errors = UINT64_MAX;
+    snap.periodNs = UINT64_MAX;
+    snap.locked = true;
+    return snap;
+}
+
+void testLongNameStaysWellFormed() {
+    const std::string name = "/dev/serial/by-id/" + std::string(400, 'x') + "\"quoted\\";
+    std::string json = widestSnapshot(name).toJson(UINT64_MAX);
+    CHECK(wellFormed(json));
+    CHECK(json.find("\"name\":\"/dev/serial/by-id/" + std::string(400, 'x') + "\\\"quoted\\\\\"") !=
+          std::string::npos);
+    CHECK(json.find("\"syncs\":18446744073709551615,\"errors\":18446744073709551615") != std::string::npos);
+    CHECK(json.find("\"error\":\"device unplugged\"}") == json.size() - 27);
+}
+
+void testShortNameStaysWellFormed() {
+    BoardSnapshot snap;
+    snap.name = "ttyUSB0";
+    snap.beats = 4;
+    std::string json = snap.toJson(1);
+    CHECK(wellFormed(json));
+    CHECK(json.rfind("{\"t_ns\":1,\"name\":\"ttyUSB0\",\"format\":\"framed\"", 0) == 0);
+    CHECK(json.find("\"pitches\":[0,0,0,0]}") != std::string::npos);
+}
+
+} // namespace
+
+int main() {
+    testLongNameStaysWellFormed();
+    testShortNameStaysWellFormed();
+    return testResult();
+}
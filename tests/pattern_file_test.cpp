@@ -0,0 +1,69 @@
+// Text pattern formats: sequencer reports and pattern lists each read back
+// as what was written, and neither is mistaken for the other.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "pattern_file.h"
+#include "test_check.h"
+
+namespace {
+
+Pattern makePattern(const std::string &name, const std::string &digits) {
+    Pattern pattern;
+    CHECK(parsePattern(digits, pattern));
+    pattern.name = name;
+    return pattern;
+}
+
+bool samePitches(const Pattern &a, const Pattern &b) {
+    if (a.beats != b.beats) return false;
+    for (int beat = 0; beat < a.beats; ++beat) {
+        if (a.pitches[beat] != b.pitches[beat]) return false;
+    }
+    return true;
+}
+
+void testReportRoundTrip() {
+    const std::string path = "pattern_file_test_report.txt";
+    Pattern saved = makePattern("", "3000500070008001");
+    CHECK(saveReport(path, saved));
+    CHECK(isReport(path));
+
+    std::vector<Pattern> loaded;
+    std::string error;
+    CHECK(loadPatterns(path, loaded, &error));
+    CHECK(loaded.size() == 1);
+    if (loaded.size() == 1) CHECK(samePitches(loaded[0], saved));
+
+    std::string report = formatReport(saved);
+    CHECK(report.rfind("FPGA Sequencer State\n", 0) == 0);
+    CHECK(report.find("  Beat 12: Pitch 8 (0b1000)\n") != std::string::npos);
+    CHECK(report.find("  Beat  1: Pitch 0 (OFF)\n") != std::string::npos);
+    CHECK(report.find("\nActive Beats:\n  Beat 0: Pitch 3\n") != std::string::npos);
+    std::remove(path.c_str());
+}
+
+void testListRoundTrip() {
+    const std::string path = "pattern_file_test_list.txt";
+    std::vector<Pattern> saved = {makePattern("intro", "10203040"), makePattern("two words", "8")};
+    CHECK(savePatternList(path, saved));
+    CHECK(!isReport(path));
+
+    std::vector<Pattern> loaded;
+    CHECK(loadPatterns(path, loaded));
+    CHECK(loaded.size() == 2);
+    if (loaded.size() == 2) {
+        CHECK(loaded[0].name == "intro" && samePitches(loaded[0], saved[0]));
+        CHECK(loaded[1].name == "two_words" && samePitches(loaded[1], saved[1]));
+    }
+    std::remove(path.c_str());
+}
+
+} // namespace
+
+int main() {
+    testReportRoundTrip();
+    testListRoundTrip();
+    return testResult();
+}
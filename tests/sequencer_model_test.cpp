@@ -0,0 +1,74 @@
+// SequencerModel transactions: what a commit reports, including commits
+// made from inside the callbacks of another.
+
+#include <vector>
+#include "sequencer_model.h"
+#include "test_check.h"
+
+namespace {
+
+void testBatchReportsEveryVisitedBeat() {
+    SequencerModel model(8);
+    std::vector<int> beats;
+    model.onBeatChanged = [&beats](int beat) { beats.push_back(beat); };
+    {
+        SequencerModel::Batch batch(model);
+        for (int beat = 1; beat < 8; ++beat) model.setCurrentBeat(beat);
+        model.setCurrentBeat(0);
+        model.setCurrentBeat(1);
+    }
+    CHECK((beats == std::vector<int>{1, 2, 3, 4, 5, 6, 7, 0, 1}));
+}
+
+// A handler that commits a transaction of its own resets the model's move
+// list; the outer commit must still report its own moves
+void testNestedBatchFromPitchCallback() {
+    SequencerModel model(8);
+    std::vector<int> beats;
+    std::vector<int> pitchedBeats;
+    int nested = 0;
+    model.onBeatChanged = [&beats](int beat) { beats.push_back(beat); };
+    model.onBeatPitchChanged = [&pitchedBeats](int beat, int) { pitchedBeats.push_back(beat); };
+    model.onPitchesChanged = [&model, &nested](const SequencerModel::PitchChange &change) {
+        if (nested++ > 0) return;
+        CHECK(change.dirty.test(2));
+        SequencerModel::Batch batch(model);
+        model.setBeatPitch(5, 3);
+        CHECK(change.before[2] == 0);
+        CHECK(change.after[2] == 7);
+        CHECK(change.after[5] == 0);
+    };
+    {
+        SequencerModel::Batch batch(model);
+        model.setCurrentBeat(3);
+        model.setCurrentBeat(4);
+        model.setBeatPitch(2, 7);
+    }
+    CHECK(nested == 2);
+    CHECK((beats == std::vector<int>{3, 4}));
+    CHECK((pitchedBeats == std::vector<int>{5, 2}));
+    CHECK(model.getBeatPitch(2) == 7);
+    CHECK(model.getBeatPitch(5) == 3);
+    CHECK(model.currentBeat() == 4);
+}
+
+// Only pitches changed: no move to report, and no last move to look at
+void testPitchOnlyCommitFromBeatCallback() {
+    SequencerModel model(8);
+    int moves = 0;
+    model.onBeatChanged = [&model, &moves](int) {
+        if (moves++ == 0) model.setBeatPitch(1, 4);
+    };
+    model.setCurrentBeat(6);
+    CHECK(moves == 1);
+    CHECK(model.getBeatPitch(1) == 4);
+}
+
+} // namespace
+
+int main() {
+    testBatchReportsEveryVisitedBeat();
+    testNestedBatchFromPitchCallback();
+    testPitchOnlyCommitFromBeatCallback();
+    return testResult();
+}
@@ -0,0 +1,26 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <cstdio>
+
+// Minimal checks for the test executables: a failure is reported with its
+// location and the test keeps going, then main() returns testResult().
+inline int &testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                      \
+    do {                                                                                 \
+        if (!(cond)) {                                                                   \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++testFailures();                                                            \
+        }                                                                                \
+    } while (0)
+
+inline int testResult() {
+    if (testFailures() > 0) std::fprintf(stderr, "%d check(s) failed\n", testFailures());
+    return testFailures() > 0 ? 1 : 0;
+}
+
+#endif // TEST_CHECK_H
@@ -1,11 +1,27 @@
 // Mock UART Sender - Simulates FPGA sending UART messages to GUI
 // Usage: ./mock_uart_sender | ../build/bin/fpga_sequencer_gui
+//        ./mock_uart_sender --load --rate 50000 --pty   (then connect the GUI to the pty)
 
 #include <iostream>
+#include <iomanip>
 #include <thread>
 #include <chrono>
 #include <string>
 #include <bitset>
+#include <random>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "pty_device.h"
+#include "uart_parser.h"
 
 void sendCommand(const std::string &cmd) {
     std::cout << cmd << std::endl;
@@ -97,6 +113,410 @@ void interactiveMode() {
     }
 }
 
+// ---------------------------------------------------------------------------
+// Load generator / fuzzer
+//
+// Emits a seeded random stream at a target event or byte rate and reports
+// what was actually achieved. Time spent blocked in write() is the receiver
+// pushing back, so ramping --rate until the achieved rate stops following it
+// (and the blocked share climbs) finds the ingest pipeline's saturation point.
+// The byte stream depends only on the seed and options, never on timing.
+
+namespace {
+
+enum TrafficKind { KIND_TEXT, KIND_BINARY, KIND_RAW, KIND_FRAMED, KIND_SYNC, KIND_COUNT };
+
+const char *const KIND_NAMES[KIND_COUNT] = {"text", "binary", "raw", "framed", "sync"};
+
+constexpr int MAX_PITCH = 8;      // matches SequencerModel::MAX_PITCH
+constexpr uint8_t SYNC_BYTE = 0xFF;
+
+struct LoadOptions {
+    double eventRate = 1000.0;    // events/s, 0 = unthrottled
+    double byteRate = 0.0;        // bytes/s, 0 = no byte limit
+    int burst = 1;                // events released together
+    double duration = 10.0;       // seconds, 0 = until --count or interrupted
+    uint64_t count = 0;           // events, 0 = no limit
+    uint64_t seed = 0;
+    bool seedGiven = false;
+    std::array<double, KIND_COUNT> mix{};
+    bool mixGiven = false;
+    double corruptPct = 0.0;      // bit flips, garbage, out-of-range values
+    double truncatePct = 0.0;     // event cut short
+    int beats = 16;
+    std::string output = "-";     // "-" = stdout, otherwise a path (FIFO or file)
+    bool pty = false;
+    double reportInterval = 1.0;
+};
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void onStopSignal(int) { g_stop = 1; }
+
+class TrafficGenerator {
+public:
+    struct Counts {
+        uint64_t events = 0;
+        uint64_t bytes = 0;
+        uint64_t corrupted = 0;
+        uint64_t truncated = 0;
+        std::array<uint64_t, KIND_COUNT> perKind{};
+    };
+
+    explicit TrafficGenerator(const LoadOptions &opts)
+        : m_opts(opts), m_rng(opts.seed), m_kinds(opts.mix.begin(), opts.mix.end()),
+          m_pattern(opts.beats, 0), m_position(0) {}
+
+    // Appends one event to `out`
+    void next(std::string &out) {
+        size_t begin = out.size();
+        int kind = m_kinds(m_rng);
+        bool outOfRange = chance(m_opts.corruptPct) && uniform(0, 2) == 0;
+
+        switch (kind) {
+        case KIND_TEXT: {
+            int beat = outOfRange ? uniform(m_opts.beats, 999) : uniform(0, m_opts.beats - 1);
+            int pitch = outOfRange ? uniform(MAX_PITCH + 1, 99) : uniform(0, MAX_PITCH);
+            out += "BEAT " + std::to_string(beat) + ' ' + std::to_string(pitch) + '\n';
+            break;
+        }
+        case KIND_BINARY: {
+            // 7-bit form cannot encode an out-of-range value; only corruption applies
+            out += toBinary(uniform(0, std::min(m_opts.beats, 16) - 1), uniform(0, 7));
+            out += '\n';
+            break;
+        }
+        case KIND_RAW: {
+            int beat = uniform(0, std::min(m_opts.beats, 16) - 1);
+            int pitch = outOfRange ? uniform(MAX_PITCH + 1, 14) : uniform(0, MAX_PITCH);
+            out += char((pitch << 4) | beat);
+            break;
+        }
+        case KIND_FRAMED:
+            nextFrame(out, outOfRange);
+            break;
+        case KIND_SYNC:
+            out += char(SYNC_BYTE);
+            break;
+        }
+
+        size_t len = out.size() - begin;
+        if (len > 1 && chance(m_opts.truncatePct)) {
+            out.resize(begin + size_t(uniform(1, int(len) - 1)));
+            ++m_counts.truncated;
+        } else if (!outOfRange && chance(m_opts.corruptPct)) {
+            corrupt(out, begin);
+        }
+        if (outOfRange) ++m_counts.corrupted;
+
+        ++m_counts.events;
+        ++m_counts.perKind[kind];
+        m_counts.bytes += out.size() - begin;
+    }
+
+    const Counts &counts() const { return m_counts; }
+
+private:
+    int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(m_rng); }
+    bool chance(double pct) { return pct > 0.0 && std::uniform_real_distribution<double>(0.0, 100.0)(m_rng) < pct; }
+
+    // Mostly edits; otherwise the playhead advances like the board's, with a
+    // full snapshot on the wrap to 0
+    void nextFrame(std::string &out, bool outOfRange) {
+        uint8_t frame[UARTParser::MAX_FRAME_SIZE];
+        uint8_t *payload = frame + 3;  // built in place
+        uint8_t type;
+        size_t length;
+        if (uniform(0, 3) != 0) {
+            int beat = uniform(0, m_opts.beats - 1);
+            int pitch = outOfRange ? uniform(MAX_PITCH + 1, 15) : uniform(0, MAX_PITCH);
+            m_pattern[beat] = uint8_t(pitch);
+            type = UARTParser::FRAME_EDIT;
+            payload[0] = uint8_t(beat);
+            payload[1] = uint8_t(pitch);
+            length = 2;
+        } else {
+            m_position = (m_position + 1) % m_opts.beats;
+            payload[0] = uint8_t(m_position);
+            payload[1] = uint8_t(m_opts.beats);  // 256 wraps to 0, as on the wire
+            length = 2;
+            if (m_position == 0) {
+                type = UARTParser::FRAME_SNAPSHOT;
+                for (int beat = 0; beat < m_opts.beats; beat += 2) {
+                    uint8_t hi = beat + 1 < m_opts.beats ? m_pattern[beat + 1] : 0;
+                    payload[2 + beat / 2] = uint8_t((hi << 4) | (m_pattern[beat] & 0x0F));
+                }
+                length += size_t(m_opts.beats * 4 + 7) / 8;
+            } else {
+                type = UARTParser::FRAME_TICK;
+            }
+        }
+        size_t size = UARTParser::encodeFrame(type, payload, length, frame);
+        out.append(reinterpret_cast<const char *>(frame), size);
+    }
+
+    void corrupt(std::string &out, size_t begin) {
+        size_t len = out.size() - begin;
+        if (uniform(0, 1) == 0) {
+            size_t at = begin + size_t(uniform(0, int(len) - 1));
+            out[at] = char(out[at] ^ (1 << uniform(0, 7)));
+        } else {
+            // Line noise: random bytes spliced into the event
+            size_t at = begin + size_t(uniform(0, int(len)));
+            std::string noise(size_t(uniform(1, 8)), '\0');
+            for (char &c : noise) c = char(uniform(0, 255));
+            out.insert(at, noise);
+        }
+        ++m_counts.corrupted;
+    }
+
+    const LoadOptions &m_opts;
+    std::mt19937_64 m_rng;
+    std::discrete_distribution<int> m_kinds;
+    std::vector<uint8_t> m_pattern;  // what the framed receiver should hold
+    int m_position;
+    Counts m_counts;
+};
+
+bool parseMix(const std::string &spec, std::array<double, KIND_COUNT> &mix) {
+    mix.fill(0.0);
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(pos, end - pos);
+        size_t eq = item.find('=');
+        std::string name = item.substr(0, eq);
+        double weight = eq == std::string::npos ? 1.0 : std::atof(item.c_str() + eq + 1);
+        int kind = 0;
+        while (kind < KIND_COUNT && name != KIND_NAMES[kind]) ++kind;
+        if (kind == KIND_COUNT || weight < 0.0) return false;
+        mix[kind] = weight;
+        pos = end + 1;
+    }
+    for (double w : mix) {
+        if (w > 0.0) return true;
+    }
+    return false;
+}
+
+void reportProgress(double elapsed, uint64_t events, uint64_t bytes, double blocked, double window) {
+    std::cerr << std::fixed << std::setprecision(1)
+              << "[load] t=" << elapsed << "s  " << std::setprecision(0)
+              << double(events) / window << " events/s  " << double(bytes) / window << " B/s  "
+              << std::setprecision(1) << 100.0 * blocked / window << "% blocked\n";
+}
+
+} // namespace
+
+int runLoad(const LoadOptions &opts) {
+    using Clock = std::chrono::steady_clock;
+
+    int fd = STDOUT_FILENO;
+    bool ownFd = false;
+    if (opts.pty) {
+        std::string slave;
+        std::string error;
+        fd = openPty(slave, &error);
+        if (fd < 0) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        ownFd = true;
+        std::cerr << "[load] Serial device: " << slave << "\n"
+                  << "[load] Waiting for the receiver to open it...\n";
+        while (!g_stop && ptyPeerClosed(fd)) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    } else if (opts.output != "-") {
+        // Blocks until a reader opens a FIFO
+        fd = open(opts.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "Cannot open " << opts.output << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        ownFd = true;
+    }
+
+    TrafficGenerator generator(opts);
+    std::string pending;
+    pending.reserve(1 << 17);
+    constexpr size_t MAX_WRITE = 64 * 1024;
+
+    const auto start = Clock::now();
+    auto lastReport = start;
+    uint64_t lastEvents = 0, lastBytes = 0;
+    double blocked = 0.0, lastBlocked = 0.0;
+    uint64_t written = 0;
+    bool receiverGone = false;
+
+    auto seconds = [](Clock::duration d) { return std::chrono::duration<double>(d).count(); };
+
+    while (!g_stop && !receiverGone) {
+        const auto now = Clock::now();
+        const double elapsed = seconds(now - start);
+        const auto &counts = generator.counts();
+        if (opts.duration > 0.0 && elapsed >= opts.duration) break;
+        if (opts.count > 0 && counts.events >= opts.count) break;
+
+        // Everything due by now goes out in one write, so a late wakeup
+        // catches up instead of falling further behind
+        uint64_t dueEvents = UINT64_MAX;
+        if (opts.eventRate > 0.0) {
+            uint64_t bursts = uint64_t(elapsed * opts.eventRate / opts.burst) + 1;
+            dueEvents = bursts * uint64_t(opts.burst);
+        }
+        if (opts.count > 0) dueEvents = std::min(dueEvents, opts.count);
+        const double dueBytes = opts.byteRate > 0.0 ? elapsed * opts.byteRate : INFINITY;
+
+        while (counts.events < dueEvents && double(counts.bytes) <= dueBytes &&
+               pending.size() < MAX_WRITE) {
+            generator.next(pending);
+        }
+
+        if (!pending.empty()) {
+            const auto writeStart = Clock::now();
+            size_t off = 0;
+            while (off < pending.size()) {
+                ssize_t n = write(fd, pending.data() + off, pending.size() - off);
+                if (n < 0) {
+                    if (errno == EINTR && !g_stop) continue;
+                    if (errno != EINTR) std::cerr << "[load] Receiver gone: " << std::strerror(errno) << "\n";
+                    receiverGone = true;
+                    break;
+                }
+                off += size_t(n);
+            }
+            written += off;
+            blocked += seconds(Clock::now() - writeStart);
+            pending.clear();
+        }
+        if (opts.pty && ptyPeerClosed(fd)) {
+            std::cerr << "[load] Receiver closed the pseudo-terminal\n";
+            receiverGone = true;
+        }
+
+        const auto after = Clock::now();
+        if (opts.reportInterval > 0.0 && seconds(after - lastReport) >= opts.reportInterval) {
+            reportProgress(seconds(after - start), counts.events - lastEvents, counts.bytes - lastBytes,
+                           blocked - lastBlocked, seconds(after - lastReport));
+            lastReport = after;
+            lastEvents = counts.events;
+            lastBytes = counts.bytes;
+            lastBlocked = blocked;
+        }
+
+        // Sleep until the next burst or byte budget is due
+        if (counts.events >= dueEvents || double(counts.bytes) > dueBytes) {
+            double wake = 0.0;
+            if (opts.eventRate > 0.0 && counts.events >= dueEvents) {
+                wake = double(counts.events / opts.burst) * opts.burst / opts.eventRate;
+            }
+            if (opts.byteRate > 0.0) wake = std::max(wake, double(counts.bytes) / opts.byteRate);
+            if (opts.duration > 0.0) wake = std::min(wake, opts.duration);
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                                      std::chrono::duration<double>(wake)));
+        }
+    }
+
+    const double elapsed = seconds(Clock::now() - start);
+    const auto &counts = generator.counts();
+    std::cerr << std::fixed << std::setprecision(3)
+              << "\n=== Load summary ===\n"
+              << "seed:        " << opts.seed << "\n"
+              << "elapsed:     " << elapsed << " s\n"
+              << "events:      " << counts.events << " (";
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        std::cerr << (kind ? ", " : "") << KIND_NAMES[kind] << ' ' << counts.perKind[kind];
+    }
+    std::cerr << ")\n"
+              << "damaged:     " << counts.corrupted << " corrupted, " << counts.truncated << " truncated\n"
+              << "written:     " << written << " bytes\n" << std::setprecision(0)
+              << "throughput:  " << double(counts.events) / elapsed << " events/s, "
+              << double(written) / elapsed << " B/s";
+    if (opts.eventRate > 0.0) std::cerr << " (target " << opts.eventRate << " events/s)";
+    if (opts.byteRate > 0.0) std::cerr << " (target " << opts.byteRate << " B/s)";
+    std::cerr << "\n" << std::setprecision(1)
+              << "blocked:     " << 100.0 * blocked / elapsed << "% of the time in write()\n";
+
+    if (ownFd) close(fd);
+    return receiverGone ? 2 : 0;
+}
+
+bool parseLoadOptions(int argc, char **argv, LoadOptions &opts) {
+    std::string format = "text";
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char *v = nullptr;
+        if (arg == "--pty") {
+            opts.pty = true;
+            continue;
+        }
+        if (!(v = value())) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return false;
+        }
+        if (arg == "--rate") opts.eventRate = std::atof(v);
+        else if (arg == "--byte-rate") opts.byteRate = std::atof(v);
+        else if (arg == "--burst") opts.burst = std::max(1, std::atoi(v));
+        else if (arg == "--duration") opts.duration = std::atof(v);
+        else if (arg == "--count") opts.count = std::strtoull(v, nullptr, 10);
+        else if (arg == "--seed") { opts.seed = std::strtoull(v, nullptr, 0); opts.seedGiven = true; }
+        else if (arg == "--format") format = v;
+        else if (arg == "--mix") {
+            if (!parseMix(v, opts.mix)) {
+                std::cerr << "Bad --mix '" << v << "' (kinds: text, binary, raw, framed, sync)\n";
+                return false;
+            }
+            opts.mixGiven = true;
+        }
+        else if (arg == "--corrupt") opts.corruptPct = std::atof(v);
+        else if (arg == "--truncate") opts.truncatePct = std::atof(v);
+        else if (arg == "--beats") opts.beats = std::atoi(v);
+        else if (arg == "--output") opts.output = v;
+        else if (arg == "--report") opts.reportInterval = std::atof(v);
+        else {
+            std::cerr << "Unknown load option " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (opts.beats < 1 || opts.beats > 256) {
+        std::cerr << "--beats must be 1-256\n";
+        return false;
+    }
+    if (!opts.mixGiven) {
+        // Traffic the receiver's format decodes; --mix adds foreign kinds as fuzz
+        if (format == "text") opts.mix = {4, 4, 0, 0, 1};
+        else if (format == "raw") opts.mix = {0, 0, 8, 0, 1};
+        else if (format == "framed") opts.mix = {0, 0, 0, 1, 0};
+        else {
+            std::cerr << "--format must be text, raw or framed\n";
+            return false;
+        }
+    }
+    if (!opts.seedGiven) opts.seed = std::random_device{}();
+    return true;
+}
+
+void printLoadUsage(const char *argv0) {
+    std::cerr << "  " << argv0 << " --load [options] | <path_to_gui>\n"
+              << "\nLoad options:\n"
+              << "  --rate N          target events/s (default 1000, 0 = as fast as possible)\n"
+              << "  --byte-rate N     cap on bytes/s (default none)\n"
+              << "  --burst N         release events in bursts of N at the same average rate\n"
+              << "  --duration S      stop after S seconds (default 10, 0 = no limit)\n"
+              << "  --count N         stop after N events\n"
+              << "  --seed N          RNG seed; the same seed and options give the same bytes\n"
+              << "  --format F        text | raw | framed: traffic the GUI's format decodes\n"
+              << "  --mix K=W,...     weighted kinds: text, binary, raw, framed, sync\n"
+              << "  --corrupt PCT     percent of events with flipped bits, noise or bad values\n"
+              << "  --truncate PCT    percent of events cut short\n"
+              << "  --beats N         sequence length (default 16)\n"
+              << "  --output PATH     write to a FIFO or file instead of stdout\n"
+              << "  --pty             create a pseudo-terminal and print its device for the GUI\n"
+              << "  --report S        progress interval in seconds (default 1, 0 = off)\n";
+}
+
 int main(int argc, char **argv) {
     if (argc > 1 && std::string(argv[1]) == "--demo") {
         demonstrateSequence();
@@ -104,16 +524,26 @@ int main(int argc, char **argv) {
         demonstrateBinarySequence();
     } else if (argc > 1 && std::string(argv[1]) == "--interactive") {
         interactiveMode();
+    } else if (argc > 1 && std::string(argv[1]) == "--load") {
+        LoadOptions opts;
+        if (!parseLoadOptions(argc, argv, opts)) return 1;
+        std::signal(SIGPIPE, SIG_IGN);  // a closed reader surfaces as EPIPE
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+        return runLoad(opts);
     } else {
         std::cerr << "Usage:\n";
         std::cerr << "  " << argv[0] << " --demo | <path_to_gui>\n";
         std::cerr << "  " << argv[0] << " --demo-binary | <path_to_gui>\n";
         std::cerr << "  " << argv[0] << " --interactive | <path_to_gui>\n";
+        printLoadUsage(argv[0]);
         std::cerr << "\nExamples:\n";
         std::cerr << "  " << argv[0] << " --demo | ./build/src/fpga_sequencer_gui\n";
         std::cerr << "  " << argv[0] << " --demo-binary | ./build/src/fpga_sequencer_gui\n";
         std::cerr << "  echo '0000011' | ./build/src/fpga_sequencer_gui  # beat 0, pitch 3\n";
         std::cerr << "  echo 'BEAT 3 7' | ./build/src/fpga_sequencer_gui\n";
+        std::cerr << "  " << argv[0] << " --load --rate 100000 --burst 64 --corrupt 1 --seed 7 | ./build/src/fpga_sequencer_gui\n";
+        std::cerr << "  " << argv[0] << " --load --format framed --rate 20000 --pty\n";
         std::cerr << "\nProtocol:\n";
         std::cerr << "  Text:   BEAT <index> <pitch>\n";
         std::cerr << "  Binary: <4-bit beat><3-bit pitch> (7 bits total)\n";
@@ -0,0 +1,173 @@
+// Builds and inspects binary pattern banks. Any pattern source goes in
+// (lists, the GUI's saves, captures, other banks) and comes out as a bank
+// or as a text pattern list, and a single pattern as the GUI's sequencer
+// report.
+//
+//   pattern_bank --out library.seqbank patterns.txt more.txt session.seqcap
+//   pattern_bank --export library.txt library.seqbank
+//   pattern_bank --report state.txt session.seqcap
+//   pattern_bank --verify library.seqbank
+//   pattern_bank --get intro --get 42 library.seqbank
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "monotonic_clock.h"
+#include "pattern_bank.h"
+#include "pattern_file.h"
+
+namespace {
+
+struct BankOptions {
+    std::string out;
+    std::string exportPath;
+    std::string reportPath;
+    bool verify = false;
+    std::vector<std::string> gets;
+    std::vector<std::string> inputs;
+};
+
+void printUsage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " --out BANK SOURCE...      pack patterns into a bank\n"
+              << "       " << argv0 << " --export FILE SOURCE...   write them as a pattern list ('-' for stdout)\n"
+              << "       " << argv0 << " --report FILE SOURCE...   write the one pattern as a sequencer report\n"
+              << "       " << argv0 << " --verify BANK...          check every checksum\n"
+              << "       " << argv0 << " --get NAME|N BANK         print patterns by name or number\n"
+              << "\nSources are pattern lists ('[name] digits' or '[name] 0x...' per line), the\n"
+              << "GUI's saved sequences, .seqcap captures (their final state) and banks.\n";
+}
+
+bool parseOptions(int argc, char **argv, BankOptions &opts) {
+    enum { OPT_OUT = 1000, OPT_EXPORT, OPT_REPORT, OPT_VERIFY, OPT_GET, OPT_HELP };
+    static const option longOptions[] = {
+        {"out", required_argument, nullptr, OPT_OUT},
+        {"export", required_argument, nullptr, OPT_EXPORT},
+        {"report", required_argument, nullptr, OPT_REPORT},
+        {"verify", no_argument, nullptr, OPT_VERIFY},
+        {"get", required_argument, nullptr, OPT_GET},
+        {"help", no_argument, nullptr, OPT_HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case OPT_OUT: opts.out = optarg; break;
+        case OPT_EXPORT: opts.exportPath = optarg; break;
+        case OPT_REPORT: opts.reportPath = optarg; break;
+        case OPT_VERIFY: opts.verify = true; break;
+        case OPT_GET: opts.gets.push_back(optarg); break;
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    for (int i = optind; i < argc; ++i) opts.inputs.push_back(argv[i]);
+    int modes = !opts.out.empty() + !opts.exportPath.empty() + !opts.reportPath.empty() + opts.verify +
+                !opts.gets.empty();
+    if (modes != 1 || opts.inputs.empty() || (!opts.gets.empty() && opts.inputs.size() != 1)) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+bool convert(const BankOptions &opts) {
+    std::vector<Pattern> patterns;
+    std::string error;
+    for (const std::string &input : opts.inputs) {
+        if (!loadPatterns(input, patterns, &error)) {
+            std::cerr << error << "\n";
+            return false;
+        }
+    }
+    bool ok;
+    if (!opts.reportPath.empty()) {
+        if (patterns.size() != 1) {
+            std::cerr << "A report holds one pattern; the sources hold " << patterns.size() << "\n";
+            return false;
+        }
+        ok = saveReport(opts.reportPath, patterns[0], &error);
+    } else if (!opts.out.empty()) {
+        ok = writePatternBank(opts.out, patterns, &error);
+    } else if (opts.exportPath == "-") {
+        ok = savePatternList("/dev/stdout", patterns, &error);
+    } else {
+        ok = savePatternList(opts.exportPath, patterns, &error);
+    }
+    if (!ok) {
+        std::cerr << error << "\n";
+        return false;
+    }
+    const std::string &written = !opts.reportPath.empty() ? opts.reportPath
+                                 : !opts.out.empty()      ? opts.out
+                                                          : opts.exportPath;
+    std::fprintf(stderr, "%zu patterns written to %s\n", patterns.size(), written.c_str());
+    return true;
+}
+
+bool verify(const std::string &path) {
+    PatternBank bank;
+    std::string error;
+    uint64_t start = monotonicNanos();
+    if (!bank.open(path, &error)) {
+        std::cerr << error << "\n";
+        return false;
+    }
+    uint64_t opened = monotonicNanos();
+    bool ok = bank.verify(&error);
+    uint64_t verified = monotonicNanos();
+    std::printf("%s: %zu patterns, %d word%s each; opened in %.1f us, verified in %.1f ms: %s\n", path.c_str(),
+                bank.size(), bank.wordsPerRecord(), bank.wordsPerRecord() == 1 ? "" : "s", (opened - start) / 1e3,
+                (verified - opened) / 1e6, ok ? "ok" : error.c_str());
+    return ok;
+}
+
+bool get(const BankOptions &opts) {
+    PatternBank bank;
+    std::string error;
+    if (!bank.open(opts.inputs[0], &error)) {
+        std::cerr << error << "\n";
+        return false;
+    }
+    bool ok = true;
+    for (const std::string &key : opts.gets) {
+        // A name first; a number only if no pattern is called that
+        long index = bank.find(key);
+        if (index < 0 && !key.empty() && std::all_of(key.begin(), key.end(), ::isdigit)) {
+            unsigned long long n = std::strtoull(key.c_str(), nullptr, 10);
+            if (n < bank.size()) index = long(n);
+        }
+        Pattern pattern;
+        if (index < 0) {
+            std::cerr << "No pattern " << key << "\n";
+            ok = false;
+        } else if (!bank.get(size_t(index), pattern)) {
+            std::cerr << "Pattern " << index << " is damaged\n";
+            ok = false;
+        } else {
+            std::printf("%ld %s\n", index, formatPattern(pattern).c_str());
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    BankOptions opts;
+    if (!parseOptions(argc, argv, opts)) return 1;
+
+    if (!opts.gets.empty()) return get(opts) ? 0 : 1;
+    if (opts.verify) {
+        bool ok = true;
+        for (const std::string &input : opts.inputs) ok = verify(input) && ok;
+        return ok ? 0 : 1;
+    }
+    return convert(opts) ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+// Offline renderer: plays saved patterns through the software copy of the
+// board's PWM voice and writes one WAV file per pattern, on all cores.
+//
+//   pattern_render --loops 4 --out-dir wav patterns.txt
+//   pattern_render --period 2 session.seqcap saved_sequence.txt
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <set>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "beat_clock.h"
+#include "monotonic_clock.h"
+#include "offline_renderer.h"
+
+namespace {
+
+struct RenderOptions {
+    OfflineRenderConfig config;
+    std::string outDir = ".";
+    int threads = 0;
+    std::vector<std::string> inputs;
+};
+
+void printUsage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " [options] PATTERN_FILE...\n"
+              << "  --loops N        passes through each pattern (default 1)\n"
+              << "  --period S       seconds per pass, PERIOD in audio_controller.sv (default 4)\n"
+              << "  --rate HZ        sample rate (default 48000)\n"
+              << "  --gain G         peak level 0-1 (default 0.25)\n"
+              << "  --out-dir DIR    where the WAV files go (default .)\n"
+              << "  --threads N      worker threads, 0 = one per core (default 0)\n"
+              << "\nPattern files hold one pattern per line, '[name] digits' with one pitch\n"
+              << "0-8 per beat or '[name] 0x...' as dumped from model.sv. The GUI's saved\n"
+              << "sequences and .seqcap captures (their final state) are read too.\n";
+}
+
+bool parseOptions(int argc, char **argv, RenderOptions &opts) {
+    enum { OPT_LOOPS = 1000, OPT_PERIOD, OPT_RATE, OPT_GAIN, OPT_OUT_DIR, OPT_THREADS, OPT_HELP };
+    static const option longOptions[] = {
+        {"loops", required_argument, nullptr, OPT_LOOPS},
+        {"period", required_argument, nullptr, OPT_PERIOD},
+        {"rate", required_argument, nullptr, OPT_RATE},
+        {"gain", required_argument, nullptr, OPT_GAIN},
+        {"out-dir", required_argument, nullptr, OPT_OUT_DIR},
+        {"threads", required_argument, nullptr, OPT_THREADS},
+        {"help", no_argument, nullptr, OPT_HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case OPT_LOOPS: opts.config.loops = std::clamp(std::atoi(optarg), 1, 100000); break;
+        case OPT_PERIOD: {
+            double seconds = std::clamp(std::atof(optarg), BeatClock::MIN_PERIOD_NS / 1e9,
+                                        BeatClock::MAX_PERIOD_NS / 1e9);
+            opts.config.periodNs = uint64_t(seconds * 1e9);
+            break;
+        }
+        case OPT_RATE: opts.config.sampleRate = std::clamp(std::atoi(optarg), 8000, 192000); break;
+        case OPT_GAIN: opts.config.gain = float(std::clamp(std::atof(optarg), 0.0, 1.0)); break;
+        case OPT_OUT_DIR: opts.outDir = optarg; break;
+        case OPT_THREADS: opts.threads = std::clamp(std::atoi(optarg), 0, 256); break;
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    for (int i = optind; i < argc; ++i) opts.inputs.push_back(argv[i]);
+    if (opts.inputs.empty()) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+// Pattern names become file names: keep them to a safe alphabet and unique
+std::string fileNameFor(const std::string &name, std::set<std::string> &used) {
+    std::string base;
+    for (char c : name) {
+        bool safe = std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.';
+        base += safe ? c : '_';
+    }
+    if (base.empty()) base = "pattern";
+    std::string file = base + ".wav";
+    for (int n = 2; !used.insert(file).second; ++n) file = base + "-" + std::to_string(n) + ".wav";
+    return file;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    RenderOptions opts;
+    if (!parseOptions(argc, argv, opts)) return 1;
+
+    std::vector<Pattern> patterns;
+    for (const std::string &input : opts.inputs) {
+        std::string error;
+        if (!loadPatterns(input, patterns, &error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+    if (::mkdir(opts.outDir.c_str(), 0777) != 0 && errno != EEXIST) {
+        std::cerr << "Cannot create " << opts.outDir << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::set<std::string> used;
+    std::vector<std::string> paths;
+    for (const Pattern &pattern : patterns) paths.push_back(opts.outDir + "/" + fileNameFor(pattern.name, used));
+
+    uint64_t start = monotonicNanos();
+    std::vector<OfflineRenderResult> results = renderPatternBatch(patterns, paths, opts.config, opts.threads);
+    double wall = (monotonicNanos() - start) / 1e9;
+
+    uint64_t frames = 0;
+    int failed = 0;
+    for (const OfflineRenderResult &result : results) {
+        if (!result.ok) {
+            std::cerr << result.path << ": " << result.error << "\n";
+            ++failed;
+            continue;
+        }
+        frames += result.frames;
+        std::printf("%s  %.1f s audio\n", result.path.c_str(), double(result.frames) / opts.config.sampleRate);
+    }
+    double audio = double(frames) / opts.config.sampleRate;
+    std::fprintf(stderr, "%zu patterns, %.1f s of audio in %.3f s (%.0fx real time)%s\n",
+                 results.size() - size_t(failed), audio, wall, wall > 0 ? audio / wall : 0.0,
+                 failed ? ", some failed" : "");
+    return failed ? 1 : 0;
+}
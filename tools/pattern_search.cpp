@@ -0,0 +1,238 @@
+// Finds the patterns in a library closest to a given one.
+//
+//   pattern_search --query 1030103010301030 library.seqbank
+//   pattern_search --like intro --metric rotation -k 20 library.seqbank more.txt
+//   pattern_search --random 1000000 --query 1030103010301030    (timing only)
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "monotonic_clock.h"
+#include "pattern_bank.h"
+#include "pattern_file.h"
+#include "pattern_search.h"
+
+namespace {
+
+struct SearchOptions {
+    std::string query;
+    std::string like;
+    PatternIndex::Metric metric = PatternIndex::Metric::Pitch;
+    size_t k = 10;
+    int threads = 0;
+    size_t random = 0;
+    uint64_t seed = 1;
+    int repeat = 1;
+    std::vector<std::string> inputs;
+};
+
+void printUsage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " (--query PATTERN | --like NAME) [options] SOURCE...\n"
+              << "  --query PATTERN  digits (one pitch 0-8 per beat) or a 0x register\n"
+              << "  --like NAME      the first pattern called NAME in the sources\n"
+              << "  --metric M       steps: beats that are a note in one and a rest in the other\n"
+              << "                   pitch: sum of the pitch differences, a rest being 0 (default)\n"
+              << "                   rotation: pitch, against the query's best rotation\n"
+              << "  -k N             matches to list (default 10)\n"
+              << "  --threads N      0 = one per core (default 0)\n"
+              << "  --random N       add N random 16-beat patterns, to time large libraries\n"
+              << "  --seed N         seed for --random (default 1)\n"
+              << "  --repeat N       run the query N times and report the best time (default 1)\n"
+              << "\nSources are pattern banks, pattern lists, the GUI's saved sequences and\n"
+              << ".seqcap captures, as pattern_bank reads them.\n";
+}
+
+bool parseOptions(int argc, char **argv, SearchOptions &opts) {
+    enum { OPT_QUERY = 1000, OPT_LIKE, OPT_METRIC, OPT_THREADS, OPT_RANDOM, OPT_SEED, OPT_REPEAT, OPT_HELP };
+    static const option longOptions[] = {
+        {"query", required_argument, nullptr, OPT_QUERY},
+        {"like", required_argument, nullptr, OPT_LIKE},
+        {"metric", required_argument, nullptr, OPT_METRIC},
+        {"threads", required_argument, nullptr, OPT_THREADS},
+        {"random", required_argument, nullptr, OPT_RANDOM},
+        {"seed", required_argument, nullptr, OPT_SEED},
+        {"repeat", required_argument, nullptr, OPT_REPEAT},
+        {"help", no_argument, nullptr, OPT_HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "k:", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case OPT_QUERY: opts.query = optarg; break;
+        case OPT_LIKE: opts.like = optarg; break;
+        case OPT_METRIC:
+            if (std::strcmp(optarg, "steps") == 0) {
+                opts.metric = PatternIndex::Metric::Steps;
+            } else if (std::strcmp(optarg, "pitch") == 0) {
+                opts.metric = PatternIndex::Metric::Pitch;
+            } else if (std::strcmp(optarg, "rotation") == 0) {
+                opts.metric = PatternIndex::Metric::Rotation;
+            } else {
+                printUsage(argv[0]);
+                return false;
+            }
+            break;
+        case 'k': opts.k = size_t(std::clamp(std::atol(optarg), 1L, 1000000L)); break;
+        case OPT_THREADS: opts.threads = std::clamp(std::atoi(optarg), 0, 256); break;
+        case OPT_RANDOM: opts.random = size_t(std::clamp(std::atoll(optarg), 0LL, 1000000000LL)); break;
+        case OPT_SEED: opts.seed = std::strtoull(optarg, nullptr, 0); break;
+        case OPT_REPEAT: opts.repeat = std::clamp(std::atoi(optarg), 1, 100000); break;
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    for (int i = optind; i < argc; ++i) opts.inputs.push_back(argv[i]);
+    if (opts.query.empty() == opts.like.empty() || (opts.inputs.empty() && opts.random == 0)) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+// The library as the index numbers it: each source's patterns in turn
+class Library {
+public:
+    bool load(const std::string &path, std::string *error) {
+        Source source;
+        source.first = m_index.size();
+        if (PatternBank::isBank(path)) {
+            source.bank = std::make_unique<PatternBank>();
+            if (!source.bank->open(path, error)) return false;
+            m_index.add(*source.bank);
+        } else {
+            if (!loadPatterns(path, source.patterns, error)) return false;
+            for (const Pattern &pattern : source.patterns) m_index.add(pattern.pitches);
+        }
+        m_sources.push_back(std::move(source));
+        return true;
+    }
+
+    void addRandom(size_t count, uint64_t seed) {
+        Source source;
+        source.first = m_index.size();
+        source.random = count;
+        std::mt19937_64 rng(seed);
+        for (size_t i = 0; i < count; ++i) {
+            SequencerModel::Pitches pitches;
+            for (int beat = 0; beat < 16; ++beat) pitches.setPitch(beat, int(rng() % 9));
+            m_index.add(pitches);
+        }
+        m_sources.push_back(std::move(source));
+    }
+
+    bool get(size_t index, Pattern &out) const {
+        for (auto it = m_sources.rbegin(); it != m_sources.rend(); ++it) {
+            if (index < it->first) continue;
+            size_t at = index - it->first;
+            if (it->bank) return it->bank->get(at, out);
+            if (it->random) {
+                out.name = "random:" + std::to_string(at);
+                out.pitches = m_index.pitches(index);
+                out.beats = 16;
+                return true;
+            }
+            out = it->patterns[at];
+            return true;
+        }
+        return false;
+    }
+
+    long find(const std::string &name) const {
+        for (const Source &source : m_sources) {
+            if (source.bank) {
+                long at = source.bank->find(name);
+                if (at >= 0) return long(source.first) + at;
+            }
+            for (size_t i = 0; i < source.patterns.size(); ++i) {
+                if (source.patterns[i].name == name) return long(source.first + i);
+            }
+        }
+        return -1;
+    }
+
+    const PatternIndex &index() const { return m_index; }
+
+private:
+    struct Source {
+        size_t first = 0;
+        std::unique_ptr<PatternBank> bank;
+        std::vector<Pattern> patterns;
+        size_t random = 0;  // patterns only kept in the index
+    };
+
+    PatternIndex m_index;
+    std::vector<Source> m_sources;
+};
+
+const char *metricName(PatternIndex::Metric metric) {
+    switch (metric) {
+    case PatternIndex::Metric::Steps: return "steps";
+    case PatternIndex::Metric::Pitch: return "pitch";
+    case PatternIndex::Metric::Rotation: return "rotation";
+    }
+    return "";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    SearchOptions opts;
+    if (!parseOptions(argc, argv, opts)) return 1;
+
+    Library library;
+    std::string error;
+    uint64_t start = monotonicNanos();
+    for (const std::string &input : opts.inputs) {
+        if (!library.load(input, &error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+    if (opts.random) library.addRandom(opts.random, opts.seed);
+    uint64_t loaded = monotonicNanos();
+
+    Pattern query;
+    if (!opts.query.empty()) {
+        if (!parsePattern(opts.query, query, &error)) {
+            std::cerr << "--query: " << error << "\n";
+            return 1;
+        }
+    } else {
+        long at = opts.like.empty() ? -1 : library.find(opts.like);
+        if (at < 0 || !library.get(size_t(at), query)) {
+            std::cerr << "No pattern called " << opts.like << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<PatternIndex::Match> matches;
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < opts.repeat; ++i) {
+        uint64_t t0 = monotonicNanos();
+        matches = library.index().search(query.pitches, query.beats, opts.k, opts.metric, opts.threads);
+        best = std::min(best, monotonicNanos() - t0);
+    }
+
+    for (size_t rank = 0; rank < matches.size(); ++rank) {
+        Pattern pattern;
+        if (!library.get(matches[rank].index, pattern)) continue;
+        std::string name;
+        name.swap(pattern.name);
+        std::printf("%3zu %4d %9zu  %s  %s\n", rank + 1, matches[rank].distance, matches[rank].index,
+                    formatPattern(pattern).c_str(), name.c_str());
+    }
+    std::fprintf(stderr, "%zu patterns (%d word%s each) loaded in %.1f ms; %s top %zu in %.3f ms\n",
+                 library.index().size(), library.index().wordsPerPattern(),
+                 library.index().wordsPerPattern() == 1 ? "" : "s", (loaded - start) / 1e6, metricName(opts.metric),
+                 opts.k, best / 1e6);
+    return 0;
+}
@@ -0,0 +1,225 @@
+// Timing checks for audio_controller, pwm and uart_tx without a waveform
+// viewer. Traces from a simulator are compared edge for edge with the
+// event-level models; --sweep runs the models alone over a grid of
+// CLK_FREQ/BAUD_RATE/NUM_BEATS/PERIOD and reports the properties that only
+// show over long runs.
+//
+//   timing_check run.trace                       (top_cosim --trace run.trace)
+//   timing_check --sweep --minutes 60
+//
+// Exits nonzero when a trace disagrees with the models or a sweep flags a
+// parameter set.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "monotonic_clock.h"
+#include "timing_checker.h"
+
+namespace {
+
+struct CheckOptions {
+    // 0: from the trace header, else TimingParams' default
+    uint32_t clkFreq = 0;
+    uint32_t baudRate = 0;
+    int numBeats = 0;
+    int period = 0;
+    bool sweep = false;
+    double minutes = 60.0;
+    uint64_t seed = 1;
+    size_t maxReported = 20;
+    std::vector<std::string> traces;
+};
+
+void printUsage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " [options] TRACE...\n"
+              << "       " << argv0 << " --sweep [--minutes M] [--seed N]\n"
+              << "  --clk HZ         CLK_FREQ (default: the trace header, else 12000000)\n"
+              << "  --baud BAUD      BAUD_RATE (default: the trace header, else 1000000)\n"
+              << "  --beats N        NUM_BEATS (default: the trace header, else 16)\n"
+              << "  --period S       PERIOD in seconds (default: the trace header, else 4)\n"
+              << "  --max-report N   divergences listed per trace (default 20)\n"
+              << "  --sweep          check the models alone over a grid of parameters\n"
+              << "  --minutes M      device time per grid point, random pattern each period (default 60)\n"
+              << "  --seed N         seed for the sweep's patterns (default 1)\n"
+              << "\nTraces hold one change per line, 'CYCLE SIGNAL VALUE' with SIGNAL one of\n"
+              << "beats (the register, hex), beat, pwm or tx; top_cosim --trace writes them.\n";
+}
+
+bool parseOptions(int argc, char **argv, CheckOptions &opts) {
+    enum { OPT_CLK = 1000, OPT_BAUD, OPT_BEATS, OPT_PERIOD, OPT_MAX_REPORT, OPT_SWEEP, OPT_MINUTES, OPT_SEED,
+           OPT_HELP };
+    static const option longOptions[] = {
+        {"clk", required_argument, nullptr, OPT_CLK},
+        {"baud", required_argument, nullptr, OPT_BAUD},
+        {"beats", required_argument, nullptr, OPT_BEATS},
+        {"period", required_argument, nullptr, OPT_PERIOD},
+        {"max-report", required_argument, nullptr, OPT_MAX_REPORT},
+        {"sweep", no_argument, nullptr, OPT_SWEEP},
+        {"minutes", required_argument, nullptr, OPT_MINUTES},
+        {"seed", required_argument, nullptr, OPT_SEED},
+        {"help", no_argument, nullptr, OPT_HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case OPT_CLK: opts.clkFreq = uint32_t(std::max(1L, std::atol(optarg))); break;
+        case OPT_BAUD: opts.baudRate = uint32_t(std::max(1L, std::atol(optarg))); break;
+        case OPT_BEATS: opts.numBeats = std::clamp(std::atoi(optarg), 1, SequencerModel::MAX_BEATS); break;
+        case OPT_PERIOD: opts.period = std::clamp(std::atoi(optarg), 1, 60); break;
+        case OPT_MAX_REPORT: opts.maxReported = size_t(std::max(0, std::atoi(optarg))); break;
+        case OPT_SWEEP: opts.sweep = true; break;
+        case OPT_MINUTES: opts.minutes = std::clamp(std::atof(optarg), 0.01, 1e6); break;
+        case OPT_SEED: opts.seed = std::strtoull(optarg, nullptr, 0); break;
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    for (int i = optind; i < argc; ++i) opts.traces.push_back(argv[i]);
+    if (opts.sweep == !opts.traces.empty()) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+bool checkTrace(const std::string &path, const CheckOptions &opts) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot read " << path << "\n";
+        return false;
+    }
+    TimingParams params;
+    TimingChecker::readTraceParams(in, params);
+    if (opts.clkFreq) params.clkFreq = opts.clkFreq;
+    if (opts.baudRate) params.baudRate = opts.baudRate;
+    if (opts.numBeats) params.numBeats = opts.numBeats;
+    if (opts.period) params.period = opts.period;
+
+    TimingChecker checker(params, opts.maxReported);
+    std::string line, error;
+    uint64_t lastCycle = 0;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (!checker.feedLine(line, &error)) {
+            std::cerr << path << ":" << lineNo << ": " << error << "\n";
+            return false;
+        }
+        lastCycle = std::max<uint64_t>(lastCycle, std::strtoull(line.c_str(), nullptr, 10));
+    }
+    checker.finish(lastCycle);
+
+    const TimingChecker::Counters &c = checker.counters();
+    std::printf("%s: %u Hz, %u baud, %d beats, %d s; %.3f s of device time\n", path.c_str(), params.clkFreq,
+                params.baudRate, params.numBeats, params.period, double(lastCycle) / params.clkFreq);
+    std::printf("  %llu beat changes, %llu PWM edges, %llu UART bytes matched; %llu divergences\n",
+                (unsigned long long)c.beats, (unsigned long long)c.pwmEdges, (unsigned long long)c.bytes,
+                (unsigned long long)c.divergences);
+    for (const TimingChecker::Divergence &d : checker.divergences()) {
+        std::printf("  cycle %llu (%.6f s): %s\n", (unsigned long long)d.cycle, double(d.cycle) / params.clkFreq,
+                    d.what.c_str());
+    }
+    return checker.ok();
+}
+
+// uart_framer's handshake around uart_tx: the first byte of a frame is taken
+// 5 cycles after the beat change that asked for it, each further byte 2
+// cycles after uart_tx is ready again
+constexpr uint64_t FRAMER_FIRST_CYCLES = 5;
+constexpr uint64_t FRAMER_NEXT_CYCLES = 2;
+
+// Cycles from a beat change until the last stop bit of the frame it sends
+uint64_t frameCycles(const TimingParams &params, int bytes) {
+    UartTxModel uart(params);
+    uint64_t offer = FRAMER_FIRST_CYCLES;
+    uint64_t start = 0;
+    for (int i = 0; i < bytes; ++i) {
+        start = uart.send(offer, 0);
+        offer = uart.readyCycle() + FRAMER_NEXT_CYCLES;
+    }
+    return start + 10ull * params.pulseWidth();
+}
+
+bool sweep(const CheckOptions &opts) {
+    static const uint32_t CLOCKS[] = {96000, 12000000, 25000000, 48000000};
+    static const uint32_t BAUDS[] = {9600, 24000, 115200, 1000000, 2000000, 3000000};
+    static const int BEATS[] = {8, 16, 32};
+    static const int PERIODS[] = {1, 2, 4};
+
+    std::mt19937_64 rng(opts.seed);
+    std::printf("%9s %8s %5s %6s %8s %10s %9s %9s %10s  %s\n", "clk", "baud", "beats", "period", "bit err",
+                "drift ms/h", "snap/beat", "stalls/h", "worst ms", "flags");
+    uint64_t start = monotonicNanos();
+    double deviceSeconds = 0;
+    int flagged = 0, points = 0;
+    for (uint32_t clk : CLOCKS) {
+        for (uint32_t baud : BAUDS) {
+            if (baud * 4ull > clk) continue;  // under 4 clocks a bit uart_tx is not meant to run
+            for (int beats : BEATS) {
+                for (int period : PERIODS) {
+                    TimingParams params;
+                    params.clkFreq = clk;
+                    params.baudRate = baud;
+                    params.numBeats = beats;
+                    params.period = period;
+
+                    // A random pattern every pass, as someone playing would
+                    AudioControllerModel audio(params);
+                    uint64_t end = uint64_t(opts.minutes * 60.0 * clk);
+                    for (uint64_t cycle = 0; cycle < end; cycle += params.periodCycles()) {
+                        AudioControllerModel::Pitches pattern;
+                        for (int beat = 0; beat < beats; ++beat) pattern.setPitch(beat, int(rng() % 9));
+                        audio.setBeats(cycle, pattern);
+                    }
+                    audio.run(end);
+                    deviceSeconds += double(end) / clk;
+
+                    double bitError = std::fabs(double(clk) / params.pulseWidth() - baud) / baud * 100.0;
+                    double periodsPerHour = 3600.0 / period;
+                    double drift = (double(params.periodCycles()) - double(period) * clk) / clk * periodsPerHour * 1e3;
+                    int snapshotBytes = 6 + (beats * 4 + 7) / 8;
+                    double snapshotShare = double(frameCycles(params, snapshotBytes)) / params.beatCycles();
+                    double hours = double(end) / clk / 3600.0;
+
+                    std::string flags;
+                    if (bitError > 2.0) flags += " baud";
+                    if (snapshotShare > 1.0) flags += " snapshot>beat";
+                    if (std::fabs(drift) > 1.0) flags += " drift";
+                    if (!flags.empty()) ++flagged;
+                    ++points;
+
+                    std::printf("%9u %8u %5d %6d %7.2f%% %10.3f %9.3f %9.0f %10.3f %s\n", clk, baud, beats, period,
+                                bitError, drift, snapshotShare, audio.stalledToggles() / hours,
+                                audio.longestStall() * 1e3 / clk, flags.c_str());
+                }
+            }
+        }
+    }
+    double wall = (monotonicNanos() - start) / 1e9;
+    std::fprintf(stderr, "%d parameter sets, %d flagged; %.1f h of device time in %.3f s\n", points, flagged,
+                 deviceSeconds / 3600.0, wall);
+    return flagged == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    CheckOptions opts;
+    if (!parseOptions(argc, argv, opts)) return 1;
+    if (opts.sweep) return sweep(opts) ? 0 : 1;
+
+    bool ok = true;
+    for (const std::string &trace : opts.traces) ok = checkTrace(trace, opts) && ok;
+    return ok ? 0 : 1;
+}
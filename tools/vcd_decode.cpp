@@ -0,0 +1,374 @@
+// Decodes a testbench's VCD dump the way the GUI decodes the board: the
+// UART TX line is sampled bit by bit into bytes, and the bytes go through
+// UARTParser into the sequencer model. Dumps of any size stream through in
+// bounded memory.
+//
+//   vcd_decode --events top_tb.vcd                      beat and pitch events
+//   vcd_decode --capture run.seqcap top_tb.vcd          replay it in the GUI or daemon
+//   vcd_decode --expect 1234000000000000 top_tb.vcd     exit 1 unless that is the final state
+//   vcd_decode --clk clk --trace run.trace top_tb.vcd   then: timing_check run.trace
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "capture_file.h"
+#include "monotonic_clock.h"
+#include "pattern_file.h"
+#include "sequencer_model.h"
+#include "timing_checker.h"
+#include "uart_bit_decoder.h"
+#include "uart_parser.h"
+#include "vcd_reader.h"
+
+namespace {
+
+struct DecodeOptions {
+    std::string input;
+    std::string tx;
+    uint32_t baud = 1000000;
+    std::string clk;
+    uint32_t clkFreq = 12000000;
+    UARTParser::Format format = UARTParser::Format::Framed;
+    std::vector<std::string> signals;
+    bool events = false;
+    bool list = false;
+    std::string bytesPath;
+    std::string capturePath;
+    std::string tracePath;
+    std::string expect;
+};
+
+void printUsage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " [options] DUMP.vcd   ('-' reads stdin)\n"
+              << "  --tx SIGNAL        UART TX line (default: _13b, uart_tx or tx)\n"
+              << "  --baud BAUD        its rate (default 1000000)\n"
+              << "  --clk SIGNAL       count this clock's rising edges and time everything in cycles\n"
+              << "  --clk-freq HZ      the clock's frequency (default 12000000)\n"
+              << "  --format FMT       framed, raw or text, as the GUI's setting (default framed)\n"
+              << "  --signal NAME      also print every change of NAME (repeatable)\n"
+              << "  --events           print the decoded events: pitch, beat and sync\n"
+              << "  --bytes FILE       write the UART bytes to FILE ('-' for stdout)\n"
+              << "  --capture FILE     write them as a .seqcap capture, timed by the simulation\n"
+              << "  --trace FILE       write a timing_check trace of beats, beat_count, _48b and TX\n"
+              << "                     (needs --clk)\n"
+              << "  --expect PATTERN   fail unless the final state is PATTERN (digits or 0x register)\n"
+              << "  --list             list the dump's signals and exit\n"
+              << "\nSignals are named by their full hierarchical name or its last parts,\n"
+              << "e.g. top_tb.uut._13b, uut._13b or _13b.\n";
+}
+
+bool parseOptions(int argc, char **argv, DecodeOptions &opts) {
+    enum { OPT_TX = 1000, OPT_BAUD, OPT_CLK, OPT_CLK_FREQ, OPT_FORMAT, OPT_SIGNAL, OPT_EVENTS, OPT_BYTES, OPT_CAPTURE,
+           OPT_TRACE, OPT_EXPECT, OPT_LIST, OPT_HELP };
+    static const option longOptions[] = {
+        {"tx", required_argument, nullptr, OPT_TX},
+        {"baud", required_argument, nullptr, OPT_BAUD},
+        {"clk", required_argument, nullptr, OPT_CLK},
+        {"clk-freq", required_argument, nullptr, OPT_CLK_FREQ},
+        {"format", required_argument, nullptr, OPT_FORMAT},
+        {"signal", required_argument, nullptr, OPT_SIGNAL},
+        {"events", no_argument, nullptr, OPT_EVENTS},
+        {"bytes", required_argument, nullptr, OPT_BYTES},
+        {"capture", required_argument, nullptr, OPT_CAPTURE},
+        {"trace", required_argument, nullptr, OPT_TRACE},
+        {"expect", required_argument, nullptr, OPT_EXPECT},
+        {"list", no_argument, nullptr, OPT_LIST},
+        {"help", no_argument, nullptr, OPT_HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case OPT_TX: opts.tx = optarg; break;
+        case OPT_BAUD: opts.baud = uint32_t(std::max(1L, std::atol(optarg))); break;
+        case OPT_CLK: opts.clk = optarg; break;
+        case OPT_CLK_FREQ: opts.clkFreq = uint32_t(std::max(1L, std::atol(optarg))); break;
+        case OPT_FORMAT:
+            if (std::strcmp(optarg, "framed") == 0) {
+                opts.format = UARTParser::Format::Framed;
+            } else if (std::strcmp(optarg, "raw") == 0) {
+                opts.format = UARTParser::Format::Raw;
+            } else if (std::strcmp(optarg, "text") == 0) {
+                opts.format = UARTParser::Format::Text;
+            } else {
+                printUsage(argv[0]);
+                return false;
+            }
+            break;
+        case OPT_SIGNAL: opts.signals.push_back(optarg); break;
+        case OPT_EVENTS: opts.events = true; break;
+        case OPT_BYTES: opts.bytesPath = optarg; break;
+        case OPT_CAPTURE: opts.capturePath = optarg; break;
+        case OPT_TRACE: opts.tracePath = optarg; break;
+        case OPT_EXPECT: opts.expect = optarg; break;
+        case OPT_LIST: opts.list = true; break;
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (optind + 1 != argc || (!opts.tracePath.empty() && opts.clk.empty())) {
+        printUsage(argv[0]);
+        return false;
+    }
+    opts.input = argv[optind];
+    return true;
+}
+
+// One decode run: the dump's changes in, bytes and events out
+class Decoder {
+public:
+    explicit Decoder(const DecodeOptions &opts)
+        : m_opts(opts), m_uart(1.0), m_model(16), m_parser(&m_model, opts.format), m_bytesOut(nullptr),
+          m_trace(nullptr), m_clkSignal(-1), m_txSignal(-1), m_beatsSignal(-1), m_beatSignal(-1), m_pwmSignal(-1),
+          m_time(0), m_cycle(0), m_clkLevel(false), m_byteNs(0), m_byteSeconds(0) {}
+
+    ~Decoder() {
+        if (m_bytesOut && m_bytesOut != stdout) std::fclose(m_bytesOut);
+        if (m_trace) std::fclose(m_trace);
+    }
+
+    bool open(std::string *error) {
+        if (!m_vcd.open(m_opts.input, error)) return false;
+        if (m_opts.list) return true;
+
+        if (!m_opts.tx.empty()) {
+            m_txSignal = m_vcd.select(m_opts.tx, error);
+        } else {
+            for (const char *name : {"_13b", "uart_tx", "tx"}) {
+                m_txSignal = m_vcd.select(name);
+                if (m_txSignal >= 0) break;
+            }
+            if (m_txSignal < 0 && error) *error = "No UART TX signal found; name it with --tx";
+        }
+        if (m_txSignal < 0) return false;
+        if (!m_opts.clk.empty() && (m_clkSignal = m_vcd.select(m_opts.clk, error)) < 0) return false;
+        for (const std::string &name : m_opts.signals) {
+            int index = m_vcd.select(name, error);
+            if (index < 0) return false;
+            m_printed.push_back(index);
+        }
+
+        // Bit time in the unit edges are timed in: clock cycles or dump units
+        double bitTime = m_clkSignal >= 0 ? double(m_opts.clkFreq) / m_opts.baud
+                                          : 1.0 / (double(m_opts.baud) * m_vcd.timescale());
+        m_uart = UartBitDecoder(bitTime);
+        m_uart.onByte = [this](uint8_t byte, uint64_t start) { onByte(byte, start); };
+
+        if (!m_opts.bytesPath.empty()) {
+            m_bytesOut = m_opts.bytesPath == "-" ? stdout : std::fopen(m_opts.bytesPath.c_str(), "wb");
+            if (!m_bytesOut) {
+                if (error) *error = "Cannot write " + m_opts.bytesPath;
+                return false;
+            }
+        }
+        if (!m_opts.capturePath.empty() && !m_capture.open(m_opts.capturePath, m_opts.format, error)) return false;
+        if (!m_opts.tracePath.empty() && !openTrace(error)) return false;
+
+        m_parser.onBeatCount = [this](int beats) { m_model.setNumBeats(beats); };
+        if (m_opts.events) {
+            m_model.onPitchesChanged = [this](const SequencerModel::PitchChange &change) {
+                for (int beat = 0; beat < m_model.numBeats(); ++beat) {
+                    if (change.dirty.test(size_t(beat))) {
+                        std::printf("%.9f pitch %d %d\n", m_byteSeconds, beat, change.after[beat]);
+                    }
+                }
+            };
+            m_model.onBeatChanged = [this](int beat) { std::printf("%.9f beat %d\n", m_byteSeconds, beat); };
+            m_parser.onSync = [this]() { std::printf("%.9f sync\n", m_byteSeconds); };
+        }
+        m_vcd.onChange = [this](uint64_t time, int signal, const VcdReader::Value &value) {
+            if (time != m_time) flushTimestep();
+            m_time = time;
+            m_step.push_back({signal, value});
+        };
+        return true;
+    }
+
+    bool run(std::string *error) {
+        if (m_opts.list) {
+            for (const VcdReader::Variable &var : m_vcd.variables()) {
+                std::printf("%s  %d\n", var.name.c_str(), var.width);
+            }
+            return true;
+        }
+        uint64_t start = monotonicNanos();
+        bool ok = m_vcd.run(error);
+        flushTimestep();
+        // The line holds its last level to the end of the dump
+        if (m_clkSignal < 0) m_time = m_vcd.time();
+        m_uart.advance(now() + 1);
+        m_capture.close();
+        m_wallSeconds = (monotonicNanos() - start) / 1e9;
+        return ok;
+    }
+
+    bool report() {
+        if (m_opts.list) return true;
+        double mb = m_vcd.bytesRead() / 1e6;
+        std::fprintf(stderr, "%s: %.1f MB in %.3f s (%.0f MB/s), %llu changes of %zu signals, %.6f s simulated\n",
+                     m_opts.input.c_str(), mb, m_wallSeconds, m_wallSeconds > 0 ? mb / m_wallSeconds : 0.0,
+                     (unsigned long long)m_vcd.changes(), m_printed.size() + 1 + (m_clkSignal >= 0),
+                     double(m_vcd.time()) * m_vcd.timescale());
+        const UartBitDecoder::Counters &u = m_uart.counters();
+        const UARTParser::Counters &c = m_parser.counters();
+        std::fprintf(stderr, "%llu UART bytes (%llu framing errors, %llu glitches); %llu frames, %llu syncs, "
+                             "%llu CRC errors, %llu malformed, %llu out of range\n",
+                     (unsigned long long)u.bytes, (unsigned long long)u.framingErrors,
+                     (unsigned long long)u.glitches, (unsigned long long)c.frames, (unsigned long long)c.syncs,
+                     (unsigned long long)c.crcErrors, (unsigned long long)c.malformed,
+                     (unsigned long long)c.outOfRange);
+
+        Pattern final;
+        final.name = "final";
+        final.pitches = m_model.pitches();
+        final.beats = m_model.numBeats();
+        std::fprintf(stderr, "%s\n", formatPattern(final).c_str());
+        if (m_opts.expect.empty()) return true;
+
+        Pattern expected;
+        std::string error;
+        if (!parsePattern(m_opts.expect, expected, &error)) {
+            std::fprintf(stderr, "--expect: %s\n", error.c_str());
+            return false;
+        }
+        for (int beat = 0; beat < expected.beats; ++beat) {
+            if (m_model.pitches()[beat] != expected.pitches[beat]) {
+                std::fprintf(stderr, "expected %s, beat %d differs\n", formatPattern(expected).c_str(), beat);
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Change {
+        int signal;
+        VcdReader::Value value;
+    };
+
+    bool openTrace(std::string *error) {
+        // The same names top_cosim traces under
+        if ((m_beatsSignal = m_vcd.select("beats", error)) < 0) return false;
+        if ((m_beatSignal = m_vcd.select("beat_count", error)) < 0) return false;
+        if ((m_pwmSignal = m_vcd.select("_48b", error)) < 0) return false;
+        m_trace = std::fopen(m_opts.tracePath.c_str(), "w");
+        if (!m_trace) {
+            if (error) *error = "Cannot write " + m_opts.tracePath;
+            return false;
+        }
+        TimingParams params;
+        params.clkFreq = m_opts.clkFreq;
+        params.baudRate = m_opts.baud;
+        params.numBeats = m_vcd.selected(m_beatsSignal).width / 4;
+        std::fprintf(m_trace, "# vcd_decode %s\n%s\n", m_opts.input.c_str(), TimingChecker::traceHeader(params).c_str());
+        return true;
+    }
+
+    // Edges and the values they clock in share a timestamp, in no set order:
+    // count the clock first so values land on the cycle they were clocked in
+    void flushTimestep() {
+        for (const Change &change : m_step) {
+            if (change.signal != m_clkSignal) continue;
+            bool level = change.value.known && change.value.bits;
+            if (level && !m_clkLevel) ++m_cycle;
+            m_clkLevel = level;
+        }
+        for (const Change &change : m_step) {
+            if (change.signal == m_clkSignal) continue;
+            const VcdReader::Value &v = change.value;
+            if (change.signal == m_txSignal) {
+                // An undriven line idles high
+                bool level = !v.known || v.bits;
+                if (level != m_uart.level()) m_uart.edge(now(), level);
+                if (m_trace) traceLine("tx", level, false);
+            } else if (change.signal == m_beatsSignal || change.signal == m_beatSignal ||
+                       change.signal == m_pwmSignal) {
+                if (!v.known) continue;
+                if (change.signal == m_beatsSignal) {
+                    traceLine("beats", v.bits, true);
+                } else {
+                    traceLine(change.signal == m_beatSignal ? "beat" : "pwm", v.bits, false);
+                }
+            }
+            for (int printed : m_printed) {
+                if (printed != change.signal) continue;
+                double seconds = double(m_time) * m_vcd.timescale();
+                if (v.known) {
+                    std::printf("%.9f %s %llx\n", seconds, m_vcd.selected(printed).name.c_str(),
+                                (unsigned long long)v.bits);
+                } else {
+                    std::printf("%.9f %s x\n", seconds, m_vcd.selected(printed).name.c_str());
+                }
+            }
+        }
+        m_step.clear();
+    }
+
+    void traceLine(const char *signal, uint64_t value, bool hex) {
+        std::fprintf(m_trace, hex ? "%llu %s %llx\n" : "%llu %s %llu\n", (unsigned long long)m_cycle, signal,
+                     (unsigned long long)value);
+    }
+
+    // Current time in the unit the UART decoder counts in
+    uint64_t now() const { return m_clkSignal >= 0 ? m_cycle : m_time; }
+
+    double toSeconds(uint64_t time) const {
+        return m_clkSignal >= 0 ? double(time) / m_opts.clkFreq : double(time) * m_vcd.timescale();
+    }
+
+    void onByte(uint8_t byte, uint64_t start) {
+        m_byteSeconds = toSeconds(start);
+        m_byteNs = uint64_t(std::llround(m_byteSeconds * 1e9));
+        if (m_bytesOut) std::fputc(byte, m_bytesOut);
+        if (m_capture.isOpen()) m_capture.append(m_byteNs, &byte, 1);
+        m_parser.setSourceTimestamp(m_byteNs);
+        m_parser.feed(&byte, 1);
+    }
+
+    const DecodeOptions &m_opts;
+    VcdReader m_vcd;
+    UartBitDecoder m_uart;
+    SequencerModel m_model;
+    UARTParser m_parser;
+    CaptureWriter m_capture;
+    std::FILE *m_bytesOut;
+    std::FILE *m_trace;
+
+    int m_clkSignal;
+    int m_txSignal;
+    int m_beatsSignal;
+    int m_beatSignal;
+    int m_pwmSignal;
+    std::vector<int> m_printed;
+
+    std::vector<Change> m_step;  // changes at m_time not yet handled
+    uint64_t m_time;
+    uint64_t m_cycle;
+    bool m_clkLevel;
+    uint64_t m_byteNs;
+    double m_byteSeconds;
+    double m_wallSeconds = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    DecodeOptions opts;
+    if (!parseOptions(argc, argv, opts)) return 1;
+
+    Decoder decoder(opts);
+    std::string error;
+    if (!decoder.open(&error) || !decoder.run(&error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    return decoder.report() ? 0 : 1;
+}